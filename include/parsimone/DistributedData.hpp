@@ -0,0 +1,569 @@
+/**
+ * @file DistributedData.hpp
+ * @brief Declaration of the functions used for querying data distributed across processors.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DISTRIBUTEDDATA_HPP_
+#define DISTRIBUTEDDATA_HPP_
+
+#include "mxx/comm.hpp"
+#include "mxx/distribution.hpp"
+#include "utils/Logging.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Class that provides functionality for querying raw data which is
+ *        distributed across the processors by variables, i.e., every
+ *        processor stores the observations of a block of variables.
+ *
+ * The observations of a variable stored on another processor are fetched
+ * using MPI-3 one-sided communication when they are queried for the first
+ * time, and are kept in a cache of the recently used variables. Therefore,
+ * the queries do not involve the processor which stores the variable.
+ * The cache is protected by a mutex, so that it can be queried by multiple
+ * threads if MPI supports MPI_THREAD_MULTIPLE. The mutex is only held while
+ * looking up or reserving the cache entries, and the variables are fetched
+ * outside of it; queries for a variable which is still being fetched by
+ * another thread wait for the fetch to complete. Loops over the observations
+ * of a variable should use row(), which looks up the cache only once and
+ * pins the row so that it is not evicted while it is being read.
+ *
+ * @tparam DataType Type of the underlying raw data, which is also the
+ *                  precision in which the split scores are computed.
+ * @tparam Var Type of the variables (expected to be an integral type).
+ * @tparam Obs Type of the observations (expected to be an integral type).
+ */
+template <typename DataType, typename Var, typename Obs>
+class DistributedData {
+public:
+  using Value = DataType;
+
+  /**
+   * @brief Class that provides access to the observations of a variable.
+   *        A remote variable stays in memory, even if it is evicted from
+   *        the cache, as long as an object of this class refers to it.
+   */
+  class Row {
+  public:
+    DataType
+    operator[](const Obs j) const
+    {
+      return m_values[j];
+    }
+
+  private:
+    Row(
+      std::shared_ptr<const std::vector<DataType>> pinned,
+      const DataType* const values
+    ) : m_pinned(std::move(pinned)),
+        m_values(values)
+    {
+    }
+
+  private:
+    std::shared_ptr<const std::vector<DataType>> m_pinned;
+    const DataType* m_values;
+
+    friend class DistributedData;
+  };
+
+  DistributedData(const mxx::comm&, std::vector<DataType>&&, const std::vector<std::string>&, const Var, const Obs, const uint32_t);
+
+  DistributedData(const DistributedData&) = delete;
+
+  DistributedData&
+  operator=(const DistributedData&) = delete;
+
+  const std::string&
+  varName(const Var) const;
+
+  const std::vector<std::string>&
+  varNames() const;
+
+  template <typename Set = std::set<Var>>
+  std::vector<std::string>
+  varNames(const Set&) const;
+
+  Var
+  varIndex(const std::string&) const;
+
+  Var
+  numVars() const;
+
+  Obs
+  numObs() const;
+
+  DataType
+  operator()(const Var, const Obs) const;
+
+  Row
+  row(const Var) const;
+
+  template <typename Func>
+  void
+  forEachStored(const Var, Func&&) const;
+
+  template <typename Set>
+  void
+  statistics(const Var, const Set&, std::tuple<double, double, uint32_t>&) const;
+
+  template <typename Set>
+  void
+  prefetch(const Set&) const;
+
+  ~DistributedData();
+
+private:
+  /**
+   * @brief Entry of a remote variable in the cache. The observations are
+   *        valid only after the fetch of the variable is ready.
+   */
+  struct CacheEntry {
+    std::shared_ptr<std::vector<DataType>> values;
+    std::shared_future<void> fetched;
+  };
+
+  using CacheList = std::list<std::pair<Var, CacheEntry>>;
+
+private:
+  bool
+  isLocal(const Var) const;
+
+  CacheEntry&
+  cacheSlot(const Var) const;
+
+  void
+  fetchRow(const Var, std::vector<DataType>&) const;
+
+private:
+  const std::vector<DataType> m_local;
+  const std::vector<std::string> m_varNames;
+  const mxx::blk_dist m_block;
+  const Var m_nvars;
+  const Obs m_nobs;
+  const uint32_t m_cacheRows;
+  MPI_Win m_window;
+  mutable CacheList m_cache;
+  mutable std::unordered_map<Var, typename CacheList::iterator> m_cacheIndex;
+  mutable std::mutex m_mutex;
+};
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Collectively constructs the data provider object.
+ *
+ * @param comm The communicator of the processors across which the data is distributed.
+ * @param local The observations of the block of variables stored on this processor,
+ *              in variable-major order. The block is determined by mxx::blk_dist.
+ * @param varNames Names of all the variables in the data set.
+ * @param n The number of variables in the data set.
+ * @param m The number of observations in the data set.
+ * @param cacheRows The maximum number of remote variables cached by this processor.
+ */
+DistributedData<DataType, Var, Obs>::DistributedData(
+  const mxx::comm& comm,
+  std::vector<DataType>&& local,
+  const std::vector<std::string>& varNames,
+  const Var n,
+  const Obs m,
+  const uint32_t cacheRows
+) : m_local(std::move(local)),
+    m_varNames(varNames),
+    m_block(n, comm.size(), comm.rank()),
+    m_nvars(n),
+    m_nobs(m),
+    m_cacheRows(std::max(cacheRows, 1u)),
+    m_window(MPI_WIN_NULL),
+    m_cache(),
+    m_cacheIndex(),
+    m_mutex()
+{
+  if (m_local.size() != m_block.local_size() * m_nobs) {
+    throw std::runtime_error("The size of the local block does not match the distribution of the variables.");
+  }
+  // Remote variables are never queried if there is only one processor
+  if (comm.size() > 1) {
+    MPI_Win_create(const_cast<DataType*>(m_local.data()), m_local.size() * sizeof(DataType), sizeof(DataType),
+                   MPI_INFO_NULL, comm, &m_window);
+    // The data is never modified; therefore, a shared lock is held on all the processors
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, m_window);
+  }
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Collectively frees the data provider object.
+ */
+DistributedData<DataType, Var, Obs>::~DistributedData(
+)
+{
+  if (m_window != MPI_WIN_NULL) {
+    MPI_Win_unlock_all(m_window);
+    MPI_Win_free(&m_window);
+  }
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the name of a variable.
+ *
+ * @param x The index of the query variable.
+ *
+ * @return The name of the query variable.
+ */
+const std::string&
+DistributedData<DataType, Var, Obs>::varName(
+  const Var x
+) const
+{
+  LOG_MESSAGE_IF(x >= m_varNames.size(), error, "Variable index %d out of range.", static_cast<uint32_t>(x));
+  return m_varNames[x];
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the names of all the variables in the data set.
+ */
+const std::vector<std::string>&
+DistributedData<DataType, Var, Obs>::varNames(
+) const
+{
+  return m_varNames;
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the names of all the variables in the given set.
+ *
+ * @tparam Set The type of container for the variable indices.
+ * @param vars The indices of all the query variable.
+ *
+ * @return The name of all the query variables.
+ */
+template <typename Set>
+std::vector<std::string>
+DistributedData<DataType, Var, Obs>::varNames(
+  const Set& vars
+) const
+{
+  std::vector<std::string> names(vars.size());
+  auto i = 0u;
+  for (const auto var : vars) {
+    LOG_MESSAGE_IF(var >= m_varNames.size(), error, "Variable index %d out of range.", static_cast<uint32_t>(var));
+    names[i++] = m_varNames[var];
+  }
+  return names;
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the index of a variable.
+ *
+ * @param name The name of the query variable.
+ *
+ * @return The index of the query variable.
+ */
+Var
+DistributedData<DataType, Var, Obs>::varIndex(
+  const std::string& name
+) const
+{
+  Var x = 0u;
+  for (const auto& var : m_varNames) {
+    if (var.compare(name) == 0) {
+      break;
+    }
+    ++x;
+  }
+  LOG_MESSAGE_IF(x == numVars(), error, "Variable with name %s not found.", name);
+  return x;
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the number of variables in the data set.
+ */
+Var
+DistributedData<DataType, Var, Obs>::numVars(
+) const
+{
+  return m_nvars;
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the number of observations in the data set.
+ */
+Obs
+DistributedData<DataType, Var, Obs>::numObs(
+) const
+{
+  return m_nobs;
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the data point at the given index.
+ *
+ * @param i The variable index.
+ * @param j The observation index.
+ */
+DataType
+DistributedData<DataType, Var, Obs>::operator()(
+  const Var i,
+  const Obs j
+) const
+{
+  return this->row(i)[j];
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the observations of a variable, fetching them
+ *        into the cache if the variable is not stored on this processor.
+ *
+ * @param x The index of the query variable.
+ */
+typename DistributedData<DataType, Var, Obs>::Row
+DistributedData<DataType, Var, Obs>::row(
+  const Var x
+) const
+{
+  if (this->isLocal(x)) {
+    return Row(nullptr, &m_local[(static_cast<size_t>(x) - m_block.eprefix_size()) * m_nobs]);
+  }
+  std::shared_ptr<std::vector<DataType>> values;
+  std::shared_future<void> fetched;
+  std::promise<void> fetching;
+  auto fetch = false;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_cacheIndex.find(x);
+    if (it != m_cacheIndex.end()) {
+      // Mark the variable as the most recently used
+      m_cache.splice(m_cache.begin(), m_cache, it->second);
+      const auto& cached = it->second->second;
+      values = cached.values;
+      fetched = cached.fetched;
+    }
+    else {
+      // Reserve the slot, so that the other threads querying the
+      // variable wait for this fetch instead of issuing their own
+      auto& slot = this->cacheSlot(x);
+      slot.fetched = fetching.get_future().share();
+      values = slot.values;
+      fetch = true;
+    }
+  }
+  if (fetch) {
+    this->fetchRow(x, *values);
+    MPI_Win_flush(m_block.rank_of(x), m_window);
+    fetching.set_value();
+  }
+  else {
+    fetched.wait();
+  }
+  const auto* data = values->data();
+  return Row(std::move(values), data);
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Calls the given function with the index and the value of every
+ *        observation of a variable, including the missing observations,
+ *        since all of them are stored.
+ *
+ * @tparam Func Type of the function.
+ * @param x The index of the query variable.
+ * @param func The function to be called.
+ */
+template <typename Func>
+void
+DistributedData<DataType, Var, Obs>::forEachStored(
+  const Var x,
+  Func&& func
+) const
+{
+  auto values = this->row(x);
+  for (Obs j = 0u; j < m_nobs; ++j) {
+    func(j, values[j]);
+  }
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Adds the sum, the sum of squares, and the count of the non-missing
+ *        data points of a variable over the given observations to the given
+ *        statistics.
+ *
+ * @tparam Set The type of container for the observation indices.
+ * @param x The index of the query variable.
+ * @param observations The indices of the observations.
+ * @param stats A tuple with the sum, the sum of squares, and the count.
+ */
+template <typename Set>
+void
+DistributedData<DataType, Var, Obs>::statistics(
+  const Var x,
+  const Set& observations,
+  std::tuple<double, double, uint32_t>& stats
+) const
+{
+  auto& sum = std::get<0>(stats);
+  auto& sum2 = std::get<1>(stats);
+  auto& count = std::get<2>(stats);
+  auto values = this->row(x);
+  for (const auto o : observations) {
+    auto d = values[o];
+    if (!std::isnan(d)) {
+      sum += d;
+      sum2 += d * d;
+      ++count;
+    }
+  }
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Fetches the observations of the given variables, which are not
+ *        stored on this processor, into the cache. This avoids one-sided
+ *        round trips for the individual variables when they are queried.
+ *
+ * @tparam Set The type of container for the variable indices.
+ * @param vars The indices of the variables expected to be queried.
+ */
+template <typename Set>
+void
+DistributedData<DataType, Var, Obs>::prefetch(
+  const Set& vars
+) const
+{
+  std::vector<std::pair<Var, std::shared_ptr<std::vector<DataType>>>> reserved;
+  std::promise<void> fetching;
+  auto fetched = 0u;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto ready = fetching.get_future().share();
+    for (const auto var : vars) {
+      // Only the first cacheRows variables are fetched, because fetching
+      // any more variables would evict the variables fetched before them
+      if (fetched == m_cacheRows) {
+        break;
+      }
+      if (this->isLocal(var)) {
+        continue;
+      }
+      auto it = m_cacheIndex.find(var);
+      if (it != m_cacheIndex.end()) {
+        m_cache.splice(m_cache.begin(), m_cache, it->second);
+      }
+      else {
+        auto& slot = this->cacheSlot(var);
+        slot.fetched = ready;
+        reserved.emplace_back(var, slot.values);
+      }
+      ++fetched;
+    }
+  }
+  // All the reserved variables are fetched outside of the mutex,
+  // and become ready together after the window is flushed
+  for (const auto& var : reserved) {
+    this->fetchRow(var.first, *var.second);
+  }
+  if (!reserved.empty()) {
+    MPI_Win_flush_all(m_window);
+  }
+  fetching.set_value();
+  LOG_MESSAGE(debug, "Prefetched %u remote variables", fetched);
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Checks if the given variable is stored on this processor.
+ */
+bool
+DistributedData<DataType, Var, Obs>::isLocal(
+  const Var x
+) const
+{
+  return (x >= m_block.eprefix_size()) && (x < m_block.iprefix_size());
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the most recently used slot in the cache for the given
+ *        variable, evicting the least recently used variable if required.
+ *        Expects that the caller holds the mutex, and sets the future of
+ *        the returned slot to the fetch of the variable.
+ */
+typename DistributedData<DataType, Var, Obs>::CacheEntry&
+DistributedData<DataType, Var, Obs>::cacheSlot(
+  const Var x
+) const
+{
+  if (m_cache.size() < m_cacheRows) {
+    m_cache.emplace_front(x, CacheEntry{std::make_shared<std::vector<DataType>>(m_nobs), std::shared_future<void>()});
+  }
+  else {
+    m_cacheIndex.erase(m_cache.back().first);
+    m_cache.splice(m_cache.begin(), m_cache, std::prev(m_cache.end()));
+    m_cache.front().first = x;
+    // Reuse the memory of the least recently used variable, unless it is
+    // still pinned or being fetched; new pins are only created while
+    // holding the mutex, therefore a count of one means neither
+    auto& values = m_cache.front().second.values;
+    if (values.use_count() > 1) {
+      values = std::make_shared<std::vector<DataType>>(m_nobs);
+    }
+  }
+  m_cacheIndex[x] = m_cache.begin();
+  return m_cache.front().second;
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Starts fetching the observations of the given variable from the
+ *        processor which stores it. The caller is expected to complete the
+ *        fetch by flushing the window.
+ */
+void
+DistributedData<DataType, Var, Obs>::fetchRow(
+  const Var x,
+  std::vector<DataType>& row
+) const
+{
+  auto owner = m_block.rank_of(x);
+  MPI_Aint disp = (static_cast<size_t>(x) - m_block.eprefix_size(owner)) * m_nobs;
+  MPI_Get(row.data(), m_nobs * sizeof(DataType), MPI_BYTE, owner, disp, m_nobs * sizeof(DataType), MPI_BYTE, m_window);
+}
+
+#endif // DISTRIBUTEDDATA_HPP_
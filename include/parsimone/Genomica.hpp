@@ -30,10 +30,12 @@
  *
  * @tparam Data Type of the object which is used for querying the data.
  * @tparam Var Type of variable indices (expected to be an integer type).
- * @tparam Set Type of set container.
+ * @tparam VarSet Type of set container for the variables.
+ * @tparam Obs Type of observation indices (expected to be an integer type).
+ * @tparam ObsSet Type of set container for the observations.
  */
-template <typename Data, typename Var, typename Set>
-class Genomica : public ModuleNetworkLearning<Data, Var, Set> {
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+class Genomica : public ModuleNetworkLearning<Data, Var, VarSet, Obs, ObsSet> {
 public:
   Genomica(const mxx::comm&, const Data&);
 
@@ -0,0 +1,186 @@
+/**
+ * @file HDF5BlockReader.hpp
+ * @brief Declaration of the functions used for reading a block of the
+ *        variables of a dense data set from HDF5 files.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDF5BLOCKREADER_HPP_
+#define HDF5BLOCKREADER_HPP_
+
+#include "HDF5Helpers.hpp"
+
+#include <hdf5.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Class that reads the observations of a contiguous block of
+ *        variables from a two-dimensional dataset in an HDF5 file, by
+ *        selecting only the corresponding hyperslab of the dataset.
+ *        The variables may be either the rows of the dataset, as in
+ *        loom files, or the columns of the dataset, as in h5ad files;
+ *        the variables are assumed to be the rows if the dataset is square.
+ *
+ * @tparam DataType Type of the values in the data set.
+ */
+template <typename DataType>
+class HDF5BlockReader {
+public:
+  HDF5BlockReader(const std::string&, const uint32_t, const uint32_t, const uint32_t, const uint32_t,
+                  const std::string&, const std::string&, const std::string&);
+
+  std::vector<DataType>&
+  data();
+
+  const std::vector<std::string>&
+  varNames() const;
+
+private:
+  std::vector<DataType> m_data;
+  std::vector<std::string> m_varNames;
+}; // class HDF5BlockReader
+
+template <typename DataType>
+/**
+ * @brief Reads the block of variables from the given file.
+ *
+ * @param fileName Name of the file.
+ * @param n The number of variables in the data set.
+ * @param m The number of observations in the data set.
+ * @param firstVar The index of the first variable in the block.
+ * @param numVars The number of variables in the block.
+ * @param root The root path of all the data in the file.
+ * @param matrixPath Path of the dataset which contains the matrix.
+ * @param varPath Path of the dataset which contains the names of the variables.
+ *                The variables are named by their indices if it does not exist.
+ */
+HDF5BlockReader<DataType>::HDF5BlockReader(
+  const std::string& fileName,
+  const uint32_t n,
+  const uint32_t m,
+  const uint32_t firstVar,
+  const uint32_t numVars,
+  const std::string& root,
+  const std::string& matrixPath,
+  const std::string& varPath
+) : m_data(static_cast<size_t>(numVars) * m),
+    m_varNames()
+{
+  static_assert(std::is_same<DataType, float>::value || std::is_same<DataType, double>::value,
+                "Only float and double values are supported");
+  H5Eset_auto(H5E_DEFAULT, nullptr, nullptr);
+  auto file = H5Fopen(fileName.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (file < 0) {
+    throw std::runtime_error("Could not open the file " + fileName);
+  }
+  auto matrix = hdf5JoinPath(root, matrixPath);
+  auto dataset = H5Dopen(file, matrix.c_str(), H5P_DEFAULT);
+  if (dataset < 0) {
+    H5Fclose(file);
+    throw std::runtime_error("Could not open the dataset " + matrix);
+  }
+  auto space = H5Dget_space(dataset);
+  hsize_t dims[2] = {0, 0};
+  auto rank = H5Sget_simple_extent_ndims(space);
+  if (rank == 2) {
+    H5Sget_simple_extent_dims(space, dims, nullptr);
+  }
+  bool varRows = (dims[0] == n) && (dims[1] == m);
+  bool varCols = (dims[0] == m) && (dims[1] == n);
+  herr_t status = -1;
+  if (varRows || varCols) {
+    hsize_t start[2] = {firstVar, 0};
+    hsize_t count[2] = {numVars, m};
+    if (varCols) {
+      std::swap(start[0], start[1]);
+      std::swap(count[0], count[1]);
+    }
+    H5Sselect_hyperslab(space, H5S_SELECT_SET, start, nullptr, count, nullptr);
+    auto memSpace = H5Screate_simple(2, count, nullptr);
+    auto valueType = std::is_same<DataType, float>::value ? H5T_NATIVE_FLOAT : H5T_NATIVE_DOUBLE;
+    if (varRows) {
+      // The block is already in variable-major order
+      status = H5Dread(dataset, valueType, memSpace, space, H5P_DEFAULT, m_data.data());
+    }
+    else {
+      std::vector<DataType> block(m_data.size());
+      status = H5Dread(dataset, valueType, memSpace, space, H5P_DEFAULT, block.data());
+      for (auto j = 0u; j < m; ++j) {
+        for (auto i = 0u; i < numVars; ++i) {
+          m_data[static_cast<size_t>(i) * m + j] = block[static_cast<size_t>(j) * numVars + i];
+        }
+      }
+    }
+    H5Sclose(memSpace);
+  }
+  H5Sclose(space);
+  H5Dclose(dataset);
+  try {
+    if (!varRows && !varCols) {
+      throw std::runtime_error("The dataset " + matrix + " does not match the given dimensions.");
+    }
+    if (status < 0) {
+      throw std::runtime_error("Could not read the dataset " + matrix);
+    }
+    auto names = hdf5JoinPath(root, varPath);
+    if (hdf5Exists(file, names)) {
+      m_varNames = hdf5ReadStrings(file, names);
+      if (m_varNames.size() != n) {
+        throw std::runtime_error("The dataset " + names + " does not contain the names of all the variables.");
+      }
+    }
+    else {
+      for (auto i = 0u; i < n; ++i) {
+        m_varNames.push_back("V" + std::to_string(i));
+      }
+    }
+  }
+  catch (...) {
+    H5Fclose(file);
+    throw;
+  }
+  H5Fclose(file);
+}
+
+template <typename DataType>
+/**
+ * @brief Returns the observations of the variables in the block, in variable-major order.
+ */
+std::vector<DataType>&
+HDF5BlockReader<DataType>::data(
+)
+{
+  return m_data;
+}
+
+template <typename DataType>
+/**
+ * @brief Returns the names of all the variables in the data set.
+ */
+const std::vector<std::string>&
+HDF5BlockReader<DataType>::varNames(
+) const
+{
+  return m_varNames;
+}
+
+#endif // HDF5BLOCKREADER_HPP_
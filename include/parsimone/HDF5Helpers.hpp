@@ -0,0 +1,116 @@
+/**
+ * @file HDF5Helpers.hpp
+ * @brief Declaration of the helper functions used for reading data sets
+ *        from HDF5 files.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDF5HELPERS_HPP_
+#define HDF5HELPERS_HPP_
+
+#include <hdf5.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Joins the given root path and the given relative path.
+ */
+inline
+std::string
+hdf5JoinPath(
+  const std::string& root,
+  const std::string& path
+)
+{
+  if (root.empty() || (root.back() == '/')) {
+    return root + path;
+  }
+  return root + "/" + path;
+}
+
+/**
+ * @brief Checks if all the links in the given path exist in the given file.
+ */
+inline
+bool
+hdf5Exists(
+  const hid_t file,
+  const std::string& path
+)
+{
+  for (auto pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+    if (H5Lexists(file, path.substr(0, pos).c_str(), H5P_DEFAULT) <= 0) {
+      return false;
+    }
+    if (pos == std::string::npos) {
+      return true;
+    }
+  }
+}
+
+/**
+ * @brief Reads the given one-dimensional dataset of strings, which
+ *        may be either of variable length or of fixed length.
+ */
+inline
+std::vector<std::string>
+hdf5ReadStrings(
+  const hid_t file,
+  const std::string& path
+)
+{
+  auto dataset = H5Dopen(file, path.c_str(), H5P_DEFAULT);
+  if (dataset < 0) {
+    throw std::runtime_error("Could not open the dataset " + path);
+  }
+  auto type = H5Dget_type(dataset);
+  auto space = H5Dget_space(dataset);
+  auto size = static_cast<size_t>(H5Sget_simple_extent_npoints(space));
+  std::vector<std::string> strings;
+  herr_t status = 0;
+  if (H5Tis_variable_str(type) > 0) {
+    std::vector<char*> buffer(size, nullptr);
+    auto memType = H5Tcopy(H5T_C_S1);
+    H5Tset_size(memType, H5T_VARIABLE);
+    status = H5Dread(dataset, memType, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer.data());
+    if (status >= 0) {
+      strings.assign(buffer.begin(), buffer.end());
+      H5Dvlen_reclaim(memType, space, H5P_DEFAULT, buffer.data());
+    }
+    H5Tclose(memType);
+  }
+  else {
+    auto length = H5Tget_size(type);
+    std::vector<char> buffer(size * length);
+    status = H5Dread(dataset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer.data());
+    for (size_t i = 0; (status >= 0) && (i < size); ++i) {
+      auto first = buffer.begin() + i * length;
+      strings.emplace_back(first, std::find(first, first + length, '\0'));
+    }
+  }
+  H5Sclose(space);
+  H5Tclose(type);
+  H5Dclose(dataset);
+  if (status < 0) {
+    throw std::runtime_error("Could not read the dataset " + path);
+  }
+  return strings;
+}
+
+#endif // HDF5HELPERS_HPP_
@@ -26,21 +26,29 @@
 #include "utils/Timer.hpp"
 
 #include <list>
+#include <map>
 
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 class Module;
 
+class OptimalBeta;
+
+template <typename Var, typename Obs>
+class SplitSampler;
+
 /**
  * @brief Class that implements learning of module networks
  *        using the approach of Lemon Tree.
  *
  * @tparam Data Type of the object which is used for querying the data.
  * @tparam Var Type of variable indices (expected to be an integer type).
- * @tparam Set Type of set container.
+ * @tparam VarSet Type of set container for the variables.
+ * @tparam Obs Type of observation indices (expected to be an integer type).
+ * @tparam ObsSet Type of set container for the observations.
  */
-template <typename Data, typename Var, typename Set>
-class LemonTree : public ModuleNetworkLearning<Data, Var, Set> {
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+class LemonTree : public ModuleNetworkLearning<Data, Var, VarSet, Obs, ObsSet> {
 public:
   LemonTree(const mxx::comm&, const Data&);
 
@@ -55,58 +63,78 @@ protected:
 
 private:
   template <typename Generator>
-  std::list<Set>
+  std::list<VarSet>
   singleGaneshRun(Generator&, const pt::ptree&, const mxx::comm&) const;
 
   template <typename Generator>
-  std::list<std::list<Set>>
+  std::list<std::list<VarSet>>
   clusterVarsGanesh(const pt::ptree&) const;
 
   void
-  writeVarClusters(const std::string&, const std::list<std::list<Set>>&) const;
+  writeVarClusters(const std::string&, const std::list<std::list<VarSet>>&) const;
 
   std::multimap<Var, Var>
-  clusterConsensus(const std::list<std::list<Set>>&&, const pt::ptree&) const;
+  clusterConsensus(const std::list<std::list<VarSet>>&&, const pt::ptree&) const;
 
   void
   writeConsensusCluster(const std::string&, const std::multimap<Var, Var>&) const;
 
   template <typename Generator>
-  std::list<std::list<Set>>
-  clusterObsGanesh(const uint32_t, const uint32_t, const uint32_t, const uint32_t, Generator&, const Set&) const;
+  std::list<std::list<ObsSet>>
+  clusterObsGanesh(const uint32_t, const uint32_t, const uint32_t, const uint32_t, Generator&, const VarSet&) const;
 
   void
-  readCandidateParents(const std::string&, Set&) const;
+  readCandidateParents(const std::string&, VarSet&) const;
+
+  OptimalBeta
+  optimalBeta(const pt::ptree&) const;
 
   template <typename Generator>
-  std::list<Module<Data, Var, Set>>
+  std::list<Module<Data, Var, VarSet, Obs, ObsSet>>
   constructModulesWithTrees(const std::multimap<Var, Var>&&, Generator&, const pt::ptree&) const;
 
   template <typename Generator>
   void
-  learnModulesParents(std::list<Module<Data, Var, Set>>&, Generator&, const pt::ptree&) const;
+  learnModulesParents(std::list<Module<Data, Var, VarSet, Obs, ObsSet>>&, Generator&, const pt::ptree&) const;
 
   template <typename Generator>
   void
-  learnModulesParents_nodes(std::list<Module<Data, Var, Set>>&, Generator&, const Set&&, const double, const uint32_t) const;
+  learnModulesParents_nodes(std::list<Module<Data, Var, VarSet, Obs, ObsSet>>&, Generator&, const VarSet&&, const OptimalBeta&, const uint32_t, const bool) const;
 
   template <typename Generator>
   void
-  learnModulesParents_splits(std::list<Module<Data, Var, Set>>&, Generator&, const Set&&, const double, const uint32_t) const;
+  learnModulesParents_splits(std::list<Module<Data, Var, VarSet, Obs, ObsSet>>&, Generator&, const VarSet&&, const OptimalBeta&, const uint32_t, const bool) const;
+
+  template <typename Generator>
+  void
+  learnModulesParents_dynamic(std::list<Module<Data, Var, VarSet, Obs, ObsSet>>&, Generator&, const VarSet&&, const OptimalBeta&, const uint32_t, const bool, const uint32_t, const uint64_t) const;
+
+  template <typename Timer>
+  void
+  timeSplits(const Timer&) const;
+
+  void
+  reportEvaluations(const OptimalBeta&, const bool) const;
+
+  void
+  estimateSplitCosts(std::list<Module<Data, Var, VarSet, Obs, ObsSet>>&, const VarSet&, const pt::ptree&) const;
+
+  void
+  syncSampledSplits(std::list<Module<Data, Var, VarSet, Obs, ObsSet>>&, const std::map<uint32_t, SplitSampler<Var, Obs>>&, const uint32_t, const uint32_t) const;
 
   template <typename Generator>
   void
-  learnModulesParents_parallel(std::list<Module<Data, Var, Set>>&, Generator&, const pt::ptree&) const;
+  learnModulesParents_parallel(std::list<Module<Data, Var, VarSet, Obs, ObsSet>>&, Generator&, const pt::ptree&) const;
 
   template <typename Generator>
-  std::list<Module<Data, Var, Set>>
+  std::list<Module<Data, Var, VarSet, Obs, ObsSet>>
   learnModules(const std::multimap<Var, Var>&&, const pt::ptree&, const bool = false) const;
 
   void
   writeParents(std::ofstream&, const std::unordered_map<Var, double>&, const uint32_t, const double = std::numeric_limits<double>::lowest()) const;
 
   void
-  writeModules(const std::string&, const std::list<Module<Data, Var, Set>>&, const double) const;
+  writeModules(const std::string&, const std::list<Module<Data, Var, VarSet, Obs, ObsSet>>&, const double) const;
 
 private:
   TIMER_DECLARE(m_tWrite, mutable);
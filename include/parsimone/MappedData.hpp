@@ -0,0 +1,387 @@
+/**
+ * @file MappedData.hpp
+ * @brief Declaration of the functions used for reading and writing
+ *        data sets in the native binary format.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MAPPEDDATA_HPP_
+#define MAPPEDDATA_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/**
+ * @brief Class that provides access to a data set in the native binary
+ *        format by mapping the file to memory, without parsing or copying.
+ *
+ * The file consists of the following parts, in the byte order of the machine:
+ *   1. The magic bytes, i.e., "PMNBIN01".
+ *   2. The header with a marker for detecting the byte order, the version
+ *      of the format, the type of the values, the dimensions, the size of
+ *      the table of the names, and the offset of the values from the start
+ *      of the file.
+ *   3. The names of the variables, each followed by '\0'.
+ *   4. The values, in variable-major order, starting at an offset which
+ *      is a multiple of 64. Missing values are stored as NaN.
+ * All the fields of the header are validated against the size of the
+ * file when it is mapped, and an exception is thrown for invalid files.
+ */
+class MappedData {
+public:
+  enum class ValueType : uint32_t {
+    Float32 = 1,
+    Float64 = 2
+  };
+
+public:
+  static
+  bool
+  isMapped(const std::string&);
+
+  template <typename DataType>
+  static
+  void
+  write(const std::string&, const DataType* const, const uint64_t, const uint64_t,
+        const std::vector<std::string>&);
+
+  MappedData(const std::string&);
+
+  MappedData(const MappedData&) = delete;
+
+  MappedData&
+  operator=(const MappedData&) = delete;
+
+  ValueType
+  valueType() const;
+
+  uint64_t
+  numVars() const;
+
+  uint64_t
+  numObs() const;
+
+  const std::vector<std::string>&
+  varNames() const;
+
+  template <typename DataType>
+  const DataType*
+  data() const;
+
+  ~MappedData();
+
+private:
+  struct Header {
+    uint32_t byteOrder;
+    uint32_t version;
+    ValueType valueType;
+    // Written as zero so that the header does not contain any
+    // uninitialized padding before the 64-bit fields
+    uint32_t reserved;
+    uint64_t numVars;
+    uint64_t numObs;
+    uint64_t varNamesSize;
+    uint64_t dataOffset;
+  };
+
+private:
+  template <typename DataType>
+  static
+  ValueType
+  typeOf();
+
+  void
+  validate(const std::string&) const;
+
+  static
+  std::vector<std::string>
+  splitNames(const char*, const uint64_t);
+
+private:
+  static constexpr char s_magic[8] = {'P', 'M', 'N', 'B', 'I', 'N', '0', '1'};
+  static constexpr uint32_t s_byteOrder = 0x01020304;
+  static constexpr uint32_t s_version = 1;
+  static constexpr uint64_t s_alignment = 64;
+
+  Header m_header;
+  std::vector<std::string> m_varNames;
+  void* m_map;
+  size_t m_size;
+}; // class MappedData
+
+/**
+ * @brief Checks if the given file is in the native binary format,
+ *        by checking the magic bytes at the start of the file.
+ */
+inline
+bool
+MappedData::isMapped(
+  const std::string& fileName
+)
+{
+  std::ifstream file(fileName, std::ios::binary);
+  char magic[sizeof(s_magic)];
+  if (!file.read(magic, sizeof(magic))) {
+    return false;
+  }
+  return std::memcmp(magic, s_magic, sizeof(s_magic)) == 0;
+}
+
+template <typename DataType>
+/**
+ * @brief Writes the given data set to a file in the native binary format.
+ *
+ * @tparam DataType Type of the values in the data set.
+ * @param fileName Name of the file to be written.
+ * @param data Pointer to the values, in variable-major order.
+ * @param n The number of variables in the data set.
+ * @param m The number of observations in the data set.
+ * @param varNames Names of the variables in the data set.
+ */
+void
+MappedData::write(
+  const std::string& fileName,
+  const DataType* const data,
+  const uint64_t n,
+  const uint64_t m,
+  const std::vector<std::string>& varNames
+)
+{
+  if (varNames.size() != n) {
+    throw std::runtime_error("The number of variable names does not match the number of variables.");
+  }
+  std::string varTable;
+  for (const auto& name : varNames) {
+    if (name.find('\0') != std::string::npos) {
+      throw std::runtime_error("The name of a variable contains a null character.");
+    }
+    varTable.append(name).push_back('\0');
+  }
+  Header header{s_byteOrder, s_version, typeOf<DataType>(), 0, n, m, varTable.size(), 0};
+  auto offset = sizeof(s_magic) + sizeof(Header) + varTable.size();
+  header.dataOffset = ((offset + s_alignment - 1) / s_alignment) * s_alignment;
+
+  std::ofstream file(fileName, std::ios::binary);
+  file.write(s_magic, sizeof(s_magic));
+  file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+  file.write(varTable.data(), varTable.size());
+  std::vector<char> padding(header.dataOffset - offset, 0);
+  file.write(padding.data(), padding.size());
+  file.write(reinterpret_cast<const char*>(data), n * m * sizeof(DataType));
+  if (!file) {
+    throw std::runtime_error("Could not write the file " + fileName);
+  }
+}
+
+/**
+ * @brief Maps the given file in the native binary format to memory.
+ *
+ * @param fileName Name of the file to be mapped.
+ */
+inline
+MappedData::MappedData(
+  const std::string& fileName
+) : m_header(),
+    m_varNames(),
+    m_map(MAP_FAILED),
+    m_size(0)
+{
+  auto fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Could not open the file " + fileName);
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0) {
+    m_size = st.st_size;
+    // The mapping is shared so that the processes on the same node use the same pages
+    m_map = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (m_map == MAP_FAILED) {
+    throw std::runtime_error("Could not map the file " + fileName);
+  }
+  const char* bytes = static_cast<const char*>(m_map);
+  if ((m_size < sizeof(s_magic) + sizeof(Header)) || (std::memcmp(bytes, s_magic, sizeof(s_magic)) != 0)) {
+    munmap(m_map, m_size);
+    throw std::runtime_error("The file " + fileName + " is not in the native binary format.");
+  }
+  std::memcpy(&m_header, bytes + sizeof(s_magic), sizeof(Header));
+  try {
+    this->validate(fileName);
+    m_varNames = splitNames(bytes + sizeof(s_magic) + sizeof(Header), m_header.varNamesSize);
+    if (m_varNames.size() != m_header.numVars) {
+      throw std::runtime_error("The file " + fileName + " does not contain the names of all the variables.");
+    }
+  }
+  catch (...) {
+    munmap(m_map, m_size);
+    throw;
+  }
+  // Start reading the file ahead of the first queries
+  madvise(m_map, m_size, MADV_WILLNEED);
+}
+
+/**
+ * @brief Returns the type of the values in the file.
+ */
+inline
+MappedData::ValueType
+MappedData::valueType(
+) const
+{
+  return m_header.valueType;
+}
+
+/**
+ * @brief Returns the number of variables in the data set.
+ */
+inline
+uint64_t
+MappedData::numVars(
+) const
+{
+  return m_header.numVars;
+}
+
+/**
+ * @brief Returns the number of observations in the data set.
+ */
+inline
+uint64_t
+MappedData::numObs(
+) const
+{
+  return m_header.numObs;
+}
+
+/**
+ * @brief Returns the names of all the variables in the data set.
+ */
+inline
+const std::vector<std::string>&
+MappedData::varNames(
+) const
+{
+  return m_varNames;
+}
+
+template <typename DataType>
+/**
+ * @brief Returns a pointer to the mapped values, in variable-major order.
+ *
+ * @tparam DataType Type of the values, which should match the type in the file.
+ */
+const DataType*
+MappedData::data(
+) const
+{
+  if (typeOf<DataType>() != m_header.valueType) {
+    throw std::runtime_error("The requested type does not match the type of the values in the file.");
+  }
+  return reinterpret_cast<const DataType*>(static_cast<const char*>(m_map) + m_header.dataOffset);
+}
+
+/**
+ * @brief Unmaps the file.
+ */
+inline
+MappedData::~MappedData(
+)
+{
+  munmap(m_map, m_size);
+}
+
+template <typename DataType>
+/**
+ * @brief Returns the value type corresponding to the given type.
+ */
+MappedData::ValueType
+MappedData::typeOf(
+)
+{
+  static_assert(std::is_same<DataType, float>::value || std::is_same<DataType, double>::value,
+                "Only float and double values are supported");
+  return std::is_same<DataType, float>::value ? ValueType::Float32 : ValueType::Float64;
+}
+
+/**
+ * @brief Validates the header of the mapped file against the size of the file.
+ *
+ * @param fileName Name of the mapped file, used in the error messages.
+ */
+inline
+void
+MappedData::validate(
+  const std::string& fileName
+) const
+{
+  if (m_header.byteOrder != s_byteOrder) {
+    throw std::runtime_error("The file " + fileName + " was written on a machine with a different byte order.");
+  }
+  if (m_header.version != s_version) {
+    throw std::runtime_error("The file " + fileName + " is in version " + std::to_string(m_header.version) +
+                             " of the native binary format, instead of the supported version " +
+                             std::to_string(s_version) + ".");
+  }
+  if ((m_header.valueType != ValueType::Float32) && (m_header.valueType != ValueType::Float64)) {
+    throw std::runtime_error("The file " + fileName + " contains values of an unknown type.");
+  }
+  // The sizes are compared without computing any sums or products which may overflow
+  uint64_t namesOffset = sizeof(s_magic) + sizeof(Header);
+  if ((m_header.dataOffset > m_size) || (m_header.dataOffset < namesOffset) ||
+      (m_header.varNamesSize > m_header.dataOffset - namesOffset)) {
+    throw std::runtime_error("The file " + fileName + " contains an invalid offset of the values.");
+  }
+  uint64_t valueSize = (m_header.valueType == ValueType::Float32) ? sizeof(float) : sizeof(double);
+  uint64_t maxValues = (m_size - m_header.dataOffset) / valueSize;
+  if ((m_header.numObs > 0) && (m_header.numVars > maxValues / m_header.numObs)) {
+    throw std::runtime_error("The file " + fileName + " is truncated.");
+  }
+}
+
+/**
+ * @brief Splits a table of names, each followed by '\0'.
+ */
+inline
+std::vector<std::string>
+MappedData::splitNames(
+  const char* table,
+  const uint64_t size
+)
+{
+  std::vector<std::string> names;
+  for (auto end = table + size; table < end; ) {
+    auto last = static_cast<const char*>(std::memchr(table, '\0', end - table));
+    if (last == nullptr) {
+      throw std::runtime_error("The table of the names is not terminated.");
+    }
+    names.emplace_back(table, last);
+    table = last + 1;
+  }
+  return names;
+}
+
+#endif // MAPPEDDATA_HPP_
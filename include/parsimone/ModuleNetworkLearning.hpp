@@ -45,9 +45,11 @@ public:
  *
  * @tparam Data Type of the object which is used for querying the data.
  * @tparam Var Type of variable indices (expected to be an integer type).
- * @tparam Set Type of set container.
+ * @tparam VarSet Type of set container for the variables.
+ * @tparam Obs Type of observation indices (expected to be an integer type).
+ * @tparam ObsSet Type of set container for the observations.
  */
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 class ModuleNetworkLearning {
 public:
   ModuleNetworkLearning(const mxx::comm&, const Data&);
@@ -70,8 +72,8 @@ protected:
 
 protected:
   const mxx::comm& m_comm;
-  const Data m_data;
-  Set m_allVars;
+  const Data& m_data;
+  VarSet m_allVars;
 }; // class ModuleNetworkLearning
 
 #include "detail/ModuleNetworkLearning.hpp"
@@ -48,6 +48,15 @@ public:
   bool
   parallelRead() const;
 
+  bool
+  sharedData() const;
+
+  bool
+  distributedData() const;
+
+  uint32_t
+  cacheRows() const;
+
   bool
   colObs() const;
 
@@ -57,6 +66,12 @@ public:
   bool
   obsIndices() const;
 
+  bool
+  singlePrecision() const;
+
+  bool
+  quantizeData() const;
+
   char
   separator() const;
 
@@ -81,6 +96,9 @@ public:
   bool
   warmupMPI() const;
 
+  uint32_t
+  numThreads() const;
+
   const std::string&
   logLevel() const;
 
@@ -115,11 +133,17 @@ private:
   std::string m_h5ObsDataPath;
   uint32_t m_numVars;
   uint32_t m_numObs;
+  uint32_t m_numThreads;
+  uint32_t m_cacheRows;
   char m_separator;
   bool m_parallelRead;
+  bool m_sharedData;
+  bool m_distributedData;
   bool m_colObs;
   bool m_varNames;
   bool m_obsIndices;
+  bool m_singlePrecision;
+  bool m_quantizeData;
   bool m_learnNetwork;
   bool m_directEdges;
   bool m_forceParallel;
@@ -0,0 +1,498 @@
+/**
+ * @file QuantizedData.hpp
+ * @brief Declaration of the functions used for querying data which is
+ *        stored as 16-bit fixed-point values.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef QUANTIZEDDATA_HPP_
+#define QUANTIZEDDATA_HPP_
+
+#include "utils/Logging.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Class that provides functionality for querying data which is
+ *        stored as 16-bit fixed-point values, in variable-major order.
+ *
+ * Every value x of a variable is stored as the code round((x - offset) / scale),
+ * where the offset is the minimum and the scale is the range of the values of
+ * the variable divided by the largest code. Missing values are stored using the
+ * largest possible code as a sentinel. Infinite values are not supported. The
+ * values are dequantized, in single precision, every time they are queried.
+ *
+ * @tparam Var Type of the variables (expected to be an integral type).
+ * @tparam Obs Type of the observations (expected to be an integral type).
+ */
+template <typename Var, typename Obs>
+class QuantizedData {
+public:
+  using Value = float;
+
+  /**
+   * @brief Class that provides access to the dequantized observations of a variable.
+   */
+  class Row {
+  public:
+    Value
+    operator[](const Obs j) const
+    {
+      if (m_codes[j] == m_missing) {
+        return std::numeric_limits<Value>::quiet_NaN();
+      }
+      return m_offset + m_scale * m_codes[j];
+    }
+
+  private:
+    Row(
+      const uint16_t* const codes,
+      const Value offset,
+      const Value scale
+    ) : m_codes(codes),
+        m_offset(offset),
+        m_scale(scale)
+    {
+    }
+
+  private:
+    const uint16_t* m_codes;
+    Value m_offset;
+    Value m_scale;
+
+    friend class QuantizedData;
+  };
+
+public:
+  template <typename DataType>
+  QuantizedData(const DataType* const, const std::vector<std::string>&, const Var, const Obs);
+
+  const std::string&
+  varName(const Var) const;
+
+  const std::vector<std::string>&
+  varNames() const;
+
+  template <typename Set = std::set<Var>>
+  std::vector<std::string>
+  varNames(const Set&) const;
+
+  Var
+  varIndex(const std::string&) const;
+
+  Var
+  numVars() const;
+
+  Obs
+  numObs() const;
+
+  Value
+  operator()(const Var, const Obs) const;
+
+  Row
+  row(const Var) const;
+
+  template <typename Func>
+  void
+  forEachStored(const Var, Func&&) const;
+
+  template <typename Set>
+  void
+  statistics(const Var, const Set&, std::tuple<double, double, uint32_t>&) const;
+
+  template <typename Set>
+  void
+  prefetch(const Set&) const;
+
+  std::pair<Var, double>
+  maxError() const;
+
+  void
+  writeErrors(const std::string&) const;
+
+  ~QuantizedData();
+
+private:
+  Value
+  dequantize(const Var, const uint16_t) const;
+
+private:
+  static constexpr uint16_t m_missing = std::numeric_limits<uint16_t>::max();
+  static constexpr uint16_t m_maxCode = m_missing - 1;
+
+private:
+  std::vector<uint16_t> m_codes;
+  std::vector<Value> m_offsets;
+  std::vector<Value> m_scales;
+  std::vector<double> m_maxErrors;
+  std::vector<double> m_rmsErrors;
+  const std::vector<std::string> m_varNames;
+  const Var m_nvars;
+  const Obs m_nobs;
+};
+
+template <typename Var, typename Obs>
+/**
+ * @brief Constructs the data provider object by quantizing the given
+ *        data set, and computes the quantization error of every variable.
+ *        Throws if the data set contains infinite values.
+ *
+ * @tparam DataType Type of the values in the given data set.
+ * @param raw A pointer to the raw data set, in variable-major order.
+ * @param varNames Names of the variables in the data set.
+ * @param n The number of variables in the data set.
+ * @param m The number of observations in the data set.
+ */
+template <typename DataType>
+QuantizedData<Var, Obs>::QuantizedData(
+  const DataType* const raw,
+  const std::vector<std::string>& varNames,
+  const Var n,
+  const Obs m
+) : m_codes(static_cast<size_t>(n) * m),
+    m_offsets(n),
+    m_scales(n),
+    m_maxErrors(n),
+    m_rmsErrors(n),
+    m_varNames(varNames),
+    m_nvars(n),
+    m_nobs(m)
+{
+  // An infinite value would be clamped to the smallest or the largest code
+  // of its variable, and its error would be infinite; therefore, reject it
+  auto rawEnd = raw + static_cast<size_t>(n) * m;
+  auto infinite = std::find_if(raw, rawEnd, [] (const DataType x) { return std::isinf(static_cast<double>(x)); });
+  if (infinite != rawEnd) {
+    auto x = static_cast<size_t>(std::distance(raw, infinite)) / m;
+    throw std::runtime_error("The variable " + varNames[x] + " contains infinite values, which can not be quantized.");
+  }
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < static_cast<size_t>(n); ++i) {
+    auto row = raw + i * m;
+    auto min = std::numeric_limits<double>::infinity();
+    auto max = -std::numeric_limits<double>::infinity();
+    for (Obs j = 0u; j < m; ++j) {
+      auto x = static_cast<double>(row[j]);
+      if (std::isfinite(x)) {
+        min = std::min(min, x);
+        max = std::max(max, x);
+      }
+    }
+    if (min > max) {
+      // There are no finite values; all the codes are either missing or zero
+      min = max = 0.0;
+    }
+    m_offsets[i] = static_cast<Value>(min);
+    m_scales[i] = static_cast<Value>((max - min) / m_maxCode);
+    auto codes = m_codes.begin() + i * m;
+    auto maxError = 0.0;
+    auto sumError2 = 0.0;
+    uint32_t count = 0u;
+    for (Obs j = 0u; j < m; ++j) {
+      auto x = static_cast<double>(row[j]);
+      if (std::isnan(x)) {
+        codes[j] = m_missing;
+        continue;
+      }
+      auto c = (m_scales[i] > 0) ? std::round((x - m_offsets[i]) / m_scales[i]) : 0.0;
+      codes[j] = static_cast<uint16_t>(std::min(std::max(c, 0.0), static_cast<double>(m_maxCode)));
+      auto error = std::abs(static_cast<double>(this->dequantize(static_cast<Var>(i), codes[j])) - x);
+      maxError = std::max(maxError, error);
+      sumError2 += error * error;
+      ++count;
+    }
+    m_maxErrors[i] = maxError;
+    m_rmsErrors[i] = (count > 0) ? std::sqrt(sumError2 / count) : 0.0;
+  }
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Default destructor.
+ */
+QuantizedData<Var, Obs>::~QuantizedData(
+)
+{
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the name of a variable.
+ *
+ * @param x The index of the query variable.
+ *
+ * @return The name of the query variable.
+ */
+const std::string&
+QuantizedData<Var, Obs>::varName(
+  const Var x
+) const
+{
+  LOG_MESSAGE_IF(x >= m_varNames.size(), error, "Variable index %d out of range.", static_cast<uint32_t>(x));
+  return m_varNames[x];
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the names of all the variables in the data set.
+ */
+const std::vector<std::string>&
+QuantizedData<Var, Obs>::varNames(
+) const
+{
+  return m_varNames;
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the names of all the variables in the given set.
+ *
+ * @tparam Set The type of container for the variable indices.
+ * @param vars The indices of all the query variable.
+ *
+ * @return The name of all the query variables.
+ */
+template <typename Set>
+std::vector<std::string>
+QuantizedData<Var, Obs>::varNames(
+  const Set& vars
+) const
+{
+  std::vector<std::string> names(vars.size());
+  auto i = 0u;
+  for (const auto var : vars) {
+    LOG_MESSAGE_IF(var >= m_varNames.size(), error, "Variable index %d out of range.", static_cast<uint32_t>(var));
+    names[i++] = m_varNames[var];
+  }
+  return names;
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the index of a variable.
+ *
+ * @param name The name of the query variable.
+ *
+ * @return The index of the query variable.
+ */
+Var
+QuantizedData<Var, Obs>::varIndex(
+  const std::string& name
+) const
+{
+  Var x = 0u;
+  for (const auto& var : m_varNames) {
+    if (var.compare(name) == 0) {
+      break;
+    }
+    ++x;
+  }
+  LOG_MESSAGE_IF(x == numVars(), error, "Variable with name %s not found.", name);
+  return x;
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the number of variables in the data set.
+ */
+Var
+QuantizedData<Var, Obs>::numVars(
+) const
+{
+  return m_nvars;
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the number of observations in the data set.
+ */
+Obs
+QuantizedData<Var, Obs>::numObs(
+) const
+{
+  return m_nobs;
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the value of a variable for the given code.
+ */
+typename QuantizedData<Var, Obs>::Value
+QuantizedData<Var, Obs>::dequantize(
+  const Var i,
+  const uint16_t code
+) const
+{
+  if (code == m_missing) {
+    return std::numeric_limits<Value>::quiet_NaN();
+  }
+  return m_offsets[i] + m_scales[i] * code;
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the data point at the given index.
+ *
+ * @param i The variable index.
+ * @param j The observation index.
+ */
+typename QuantizedData<Var, Obs>::Value
+QuantizedData<Var, Obs>::operator()(
+  const Var i,
+  const Obs j
+) const
+{
+  return this->dequantize(i, m_codes[static_cast<size_t>(i) * m_nobs + j]);
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the observations of a variable, which are
+ *        dequantized when they are accessed.
+ *
+ * @param x The index of the query variable.
+ */
+typename QuantizedData<Var, Obs>::Row
+QuantizedData<Var, Obs>::row(
+  const Var x
+) const
+{
+  return Row(&m_codes[static_cast<size_t>(x) * m_nobs], m_offsets[x], m_scales[x]);
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Calls the given function with the index and the value of every
+ *        observation of a variable, including the missing observations,
+ *        since all of them are stored.
+ *
+ * @tparam Func Type of the function.
+ * @param x The index of the query variable.
+ * @param func The function to be called.
+ */
+template <typename Func>
+void
+QuantizedData<Var, Obs>::forEachStored(
+  const Var x,
+  Func&& func
+) const
+{
+  auto values = this->row(x);
+  for (Obs j = 0u; j < m_nobs; ++j) {
+    func(j, values[j]);
+  }
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Adds the sum, the sum of squares, and the count of the non-missing
+ *        data points of a variable over the given observations to the given
+ *        statistics. The codes of the variable are dequantized as they are
+ *        read from its row.
+ *
+ * @tparam Set The type of container for the observation indices.
+ * @param x The index of the query variable.
+ * @param observations The indices of the observations.
+ * @param stats A tuple with the sum, the sum of squares, and the count.
+ */
+template <typename Set>
+void
+QuantizedData<Var, Obs>::statistics(
+  const Var x,
+  const Set& observations,
+  std::tuple<double, double, uint32_t>& stats
+) const
+{
+  auto& sum = std::get<0>(stats);
+  auto& sum2 = std::get<1>(stats);
+  auto& count = std::get<2>(stats);
+  auto row = m_codes.data() + static_cast<size_t>(x) * m_nobs;
+  const auto offset = m_offsets[x];
+  const auto scale = m_scales[x];
+  for (const auto o : observations) {
+    auto c = row[o];
+    if (c != m_missing) {
+      auto d = static_cast<double>(offset + scale * c);
+      sum += d;
+      sum2 += d * d;
+      ++count;
+    }
+  }
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Does nothing because all the data is stored on this processor.
+ */
+template <typename Set>
+void
+QuantizedData<Var, Obs>::prefetch(
+  const Set&
+) const
+{
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the variable with the largest maximum
+ *        quantization error, along with the error.
+ */
+std::pair<Var, double>
+QuantizedData<Var, Obs>::maxError(
+) const
+{
+  auto it = std::max_element(m_maxErrors.begin(), m_maxErrors.end());
+  if (it == m_maxErrors.end()) {
+    return std::make_pair(static_cast<Var>(0), 0.0);
+  }
+  return std::make_pair(static_cast<Var>(std::distance(m_maxErrors.begin(), it)), *it);
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Writes the quantization error of every variable to the given file.
+ *
+ * Every line contains the name of a variable, the scale of its codes,
+ * and the maximum and the root mean square of the absolute errors over
+ * the non-missing values of the variable.
+ *
+ * @param errorsFile Name of the file to which the errors are written.
+ */
+void
+QuantizedData<Var, Obs>::writeErrors(
+  const std::string& errorsFile
+) const
+{
+  LOG_MESSAGE(info, "Writing quantization errors to %s", errorsFile);
+  std::ofstream ef(errorsFile);
+  ef << "Variable\tScale\tMaxError\tRMSError" << std::endl;
+  for (size_t i = 0; i < m_varNames.size(); ++i) {
+    ef << m_varNames[i] << "\t" << m_scales[i] << "\t" << m_maxErrors[i] << "\t" << m_rmsErrors[i] << std::endl;
+  }
+}
+
+#endif // QUANTIZEDDATA_HPP_
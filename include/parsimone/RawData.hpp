@@ -22,24 +22,33 @@
 
 #include "utils/Logging.hpp"
 
+#include <cmath>
 #include <cstdint>
 #include <set>
 #include <string>
+#include <tuple>
 #include <vector>
 
 
 /**
  * @brief Class that provides functionality for querying raw data.
  *
- * @tparam DataType Type of the underlying raw data.
+ * @tparam DataType Type of the underlying raw data, which is also the
+ *                  precision in which the split scores are computed.
  * @tparam Var Type of the variables (expected to be an integral type).
+ * @tparam Obs Type of the observations (expected to be an integral type).
  */
-template <typename DataType, typename Var>
+template <typename DataType, typename Var, typename Obs>
 class RawData {
 public:
-  RawData(const std::vector<DataType>&, const std::vector<std::string>&, const Var, const Var);
+  using Value = DataType;
+  using Row = const DataType*;
 
-  const std::vector<DataType>&
+  RawData(const std::vector<DataType>&, const std::vector<std::string>&, const Var, const Obs);
+
+  RawData(const DataType* const, const std::vector<std::string>&, const Var, const Obs);
+
+  const DataType*
   raw() const;
 
   const std::string&
@@ -58,22 +67,37 @@ public:
   Var
   numVars() const;
 
-  Var
+  Obs
   numObs() const;
 
-  double
-  operator()(const Var, const Var) const;
+  DataType
+  operator()(const Var, const Obs) const;
+
+  Row
+  row(const Var) const;
+
+  template <typename Func>
+  void
+  forEachStored(const Var, Func&&) const;
+
+  template <typename Set>
+  void
+  statistics(const Var, const Set&, std::tuple<double, double, uint32_t>&) const;
+
+  template <typename Set>
+  void
+  prefetch(const Set&) const;
 
   ~RawData();
 
 private:
-  const std::vector<DataType>& m_raw;
+  const DataType* const m_raw;
   const std::vector<std::string> m_varNames;
   const Var m_nvars;
-  const Var m_nobs;
+  const Obs m_nobs;
 };
 
-template <typename DataType, typename Var>
+template <typename DataType, typename Var, typename Obs>
 /**
  * @brief Constructs the data provider object.
  *
@@ -82,11 +106,30 @@ template <typename DataType, typename Var>
  * @param n The number of variables in the data set.
  * @param m The number of observations in the data set.
  */
-RawData<DataType, Var>::RawData(
+RawData<DataType, Var, Obs>::RawData(
   const std::vector<DataType>& raw,
   const std::vector<std::string>& varNames,
   const Var n,
-  const Var m
+  const Obs m
+) : RawData(raw.data(), varNames, n, m)
+{
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Constructs the data provider object for the data set stored
+ *        in the given memory, which is not owned by the object.
+ *
+ * @param raw A pointer to the raw data set, in variable-major order.
+ * @param varNames Names of the variables in the data set.
+ * @param n The number of variables in the data set.
+ * @param m The number of observations in the data set.
+ */
+RawData<DataType, Var, Obs>::RawData(
+  const DataType* const raw,
+  const std::vector<std::string>& varNames,
+  const Var n,
+  const Obs m
 ) : m_raw(raw),
     m_varNames(varNames),
     m_nvars(n),
@@ -94,24 +137,27 @@ RawData<DataType, Var>::RawData(
 {
 }
 
-template <typename DataType, typename Var>
+template <typename DataType, typename Var, typename Obs>
 /**
  * @brief Default destructor.
  */
-RawData<DataType, Var>::~RawData(
+RawData<DataType, Var, Obs>::~RawData(
 )
 {
 }
 
-template <typename DataType, typename Var>
-const std::vector<DataType>&
-RawData<DataType, Var>::raw(
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns a pointer to the raw data set.
+ */
+const DataType*
+RawData<DataType, Var, Obs>::raw(
 ) const
 {
   return m_raw;
 }
 
-template <typename DataType, typename Var>
+template <typename DataType, typename Var, typename Obs>
 /**
  * @brief Returns the name of a variable.
  *
@@ -120,7 +166,7 @@ template <typename DataType, typename Var>
  * @return The name of the query variable.
  */
 const std::string&
-RawData<DataType, Var>::varName(
+RawData<DataType, Var, Obs>::varName(
   const Var x
 ) const
 {
@@ -128,18 +174,18 @@ RawData<DataType, Var>::varName(
   return m_varNames[x];
 }
 
-template <typename DataType, typename Var>
+template <typename DataType, typename Var, typename Obs>
 /**
  * @brief Returns the names of all the variables in the data set.
  */
 const std::vector<std::string>&
-RawData<DataType, Var>::varNames(
+RawData<DataType, Var, Obs>::varNames(
 ) const
 {
   return m_varNames;
 }
 
-template <typename Counter, typename Var>
+template <typename Counter, typename Var, typename Obs>
 /**
  * @brief Returns the names of all the variables in the given set.
  *
@@ -150,7 +196,7 @@ template <typename Counter, typename Var>
  */
 template <typename Set>
 std::vector<std::string>
-RawData<Counter, Var>::varNames(
+RawData<Counter, Var, Obs>::varNames(
   const Set& vars
 ) const
 {
@@ -163,7 +209,7 @@ RawData<Counter, Var>::varNames(
   return names;
 }
 
-template <typename Counter, typename Var>
+template <typename Counter, typename Var, typename Obs>
 /**
  * @brief Returns the index of a variable.
  *
@@ -172,7 +218,7 @@ template <typename Counter, typename Var>
  * @return The index of the query variable.
  */
 Var
-RawData<Counter, Var>::varIndex(
+RawData<Counter, Var, Obs>::varIndex(
   const std::string& name
 ) const
 {
@@ -187,42 +233,124 @@ RawData<Counter, Var>::varIndex(
   return x;
 }
 
-template <typename DataType, typename Var>
+template <typename DataType, typename Var, typename Obs>
 /**
  * @brief Returns the number of variables in the data set.
  */
 Var
-RawData<DataType, Var>::numVars(
+RawData<DataType, Var, Obs>::numVars(
 ) const
 {
   return m_nvars;
 }
 
-template <typename DataType, typename Var>
+template <typename DataType, typename Var, typename Obs>
 /**
  * @brief Returns the number of observations in the data set.
  */
-Var
-RawData<DataType, Var>::numObs(
+Obs
+RawData<DataType, Var, Obs>::numObs(
 ) const
 {
   return m_nobs;
 }
 
-template <typename DataType, typename Var>
+template <typename DataType, typename Var, typename Obs>
 /**
  * @brief Returns the data point at the given index.
  *
  * @param i The variable index.
  * @param j The observation index.
  */
-double
-RawData<DataType, Var>::operator()(
+DataType
+RawData<DataType, Var, Obs>::operator()(
   const Var i,
-  const Var j
+  const Obs j
+) const
+{
+  return m_raw[static_cast<size_t>(i) * m_nobs + j];
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the observations of a variable.
+ *
+ * @param x The index of the query variable.
+ */
+typename RawData<DataType, Var, Obs>::Row
+RawData<DataType, Var, Obs>::row(
+  const Var x
+) const
+{
+  return m_raw + static_cast<size_t>(x) * m_nobs;
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Calls the given function with the index and the value of every
+ *        observation of a variable, including the missing observations,
+ *        since all of them are stored.
+ *
+ * @tparam Func Type of the function.
+ * @param x The index of the query variable.
+ * @param func The function to be called.
+ */
+template <typename Func>
+void
+RawData<DataType, Var, Obs>::forEachStored(
+  const Var x,
+  Func&& func
+) const
+{
+  auto values = this->row(x);
+  for (Obs j = 0u; j < m_nobs; ++j) {
+    func(j, values[j]);
+  }
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Adds the sum, the sum of squares, and the count of the non-missing
+ *        data points of a variable over the given observations to the given
+ *        statistics.
+ *
+ * @tparam Set The type of container for the observation indices.
+ * @param x The index of the query variable.
+ * @param observations The indices of the observations.
+ * @param stats A tuple with the sum, the sum of squares, and the count.
+ */
+template <typename Set>
+void
+RawData<DataType, Var, Obs>::statistics(
+  const Var x,
+  const Set& observations,
+  std::tuple<double, double, uint32_t>& stats
+) const
+{
+  auto& sum = std::get<0>(stats);
+  auto& sum2 = std::get<1>(stats);
+  auto& count = std::get<2>(stats);
+  auto row = m_raw + static_cast<size_t>(x) * m_nobs;
+  for (const auto o : observations) {
+    auto d = static_cast<double>(row[o]);
+    if (!std::isnan(d)) {
+      sum += d;
+      sum2 += d * d;
+      ++count;
+    }
+  }
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Does nothing because all the data is stored on this processor.
+ */
+template <typename Set>
+void
+RawData<DataType, Var, Obs>::prefetch(
+  const Set&
 ) const
 {
-  return m_raw[i * m_nobs + j];
 }
 
 #endif // RAWDATA_HPP_
@@ -0,0 +1,187 @@
+/**
+ * @file SharedData.hpp
+ * @brief Declaration of the functions used for storing data in node-local shared memory.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SHAREDDATA_HPP_
+#define SHAREDDATA_HPP_
+
+#include "mxx/comm.hpp"
+
+#include <cstddef>
+
+
+/**
+ * @brief Class that provides an array which is stored only once on every node
+ *        and is shared by all the processors on the node, using MPI-3 shared
+ *        memory windows. The first processor on every node, i.e., the leader,
+ *        is expected to fill the array before it is read by the others.
+ *
+ * @tparam DataType Type of the elements of the array.
+ */
+template <typename DataType>
+class SharedData {
+public:
+  SharedData(const mxx::comm&, const size_t);
+
+  SharedData(const SharedData&) = delete;
+
+  SharedData&
+  operator=(const SharedData&) = delete;
+
+  const mxx::comm&
+  nodeComm() const;
+
+  DataType*
+  data();
+
+  const DataType*
+  data() const;
+
+  size_t
+  size() const;
+
+  void
+  sync() const;
+
+  ~SharedData();
+
+private:
+  static
+  mxx::comm
+  splitNodes(const mxx::comm&);
+
+private:
+  mxx::comm m_nodeComm;
+  MPI_Win m_window;
+  DataType* m_data;
+  size_t m_size;
+}; // class SharedData
+
+template <typename DataType>
+/**
+ * @brief Collectively allocates the array on every node.
+ *
+ * @param comm The communicator of all the processors.
+ * @param size The number of elements in the array.
+ */
+SharedData<DataType>::SharedData(
+  const mxx::comm& comm,
+  const size_t size
+) : m_nodeComm(splitNodes(comm)),
+    m_window(MPI_WIN_NULL),
+    m_data(nullptr),
+    m_size(size)
+{
+  // Only the leader contributes memory to the window
+  MPI_Aint bytes = m_nodeComm.is_first() ? static_cast<MPI_Aint>(size * sizeof(DataType)) : 0;
+  DataType* local = nullptr;
+  MPI_Win_allocate_shared(bytes, sizeof(DataType), MPI_INFO_NULL, m_nodeComm, &local, &m_window);
+  // Get the address of the leader's memory in the address space of this processor
+  int dispUnit = 0;
+  MPI_Win_shared_query(m_window, 0, &bytes, &dispUnit, &m_data);
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, m_window);
+}
+
+template <typename DataType>
+/**
+ * @brief Creates a communicator for the processors on the same node as
+ *        this processor, with the same relative order as the given one.
+ */
+mxx::comm
+SharedData<DataType>::splitNodes(
+  const mxx::comm& comm
+)
+{
+  MPI_Comm shared;
+  MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, comm.rank(), MPI_INFO_NULL, &shared);
+  // Use the rank of the leader of every node as the color for splitting
+  int leader = comm.rank();
+  MPI_Bcast(&leader, 1, MPI_INT, 0, shared);
+  MPI_Comm_free(&shared);
+  return comm.split(leader);
+}
+
+template <typename DataType>
+/**
+ * @brief Returns the communicator of the processors on this node.
+ */
+const mxx::comm&
+SharedData<DataType>::nodeComm(
+) const
+{
+  return m_nodeComm;
+}
+
+template <typename DataType>
+/**
+ * @brief Returns a pointer to the first element of the array.
+ */
+DataType*
+SharedData<DataType>::data(
+)
+{
+  return m_data;
+}
+
+template <typename DataType>
+/**
+ * @brief Returns a const pointer to the first element of the array.
+ */
+const DataType*
+SharedData<DataType>::data(
+) const
+{
+  return m_data;
+}
+
+template <typename DataType>
+/**
+ * @brief Returns the number of elements in the array.
+ */
+size_t
+SharedData<DataType>::size(
+) const
+{
+  return m_size;
+}
+
+template <typename DataType>
+/**
+ * @brief Collectively makes the writes to the array by any processor
+ *        visible to all the processors on the node.
+ */
+void
+SharedData<DataType>::sync(
+) const
+{
+  MPI_Win_sync(m_window);
+  m_nodeComm.barrier();
+  MPI_Win_sync(m_window);
+}
+
+template <typename DataType>
+/**
+ * @brief Collectively frees the array.
+ */
+SharedData<DataType>::~SharedData(
+)
+{
+  MPI_Win_unlock_all(m_window);
+  MPI_Win_free(&m_window);
+}
+
+#endif // SHAREDDATA_HPP_
@@ -0,0 +1,414 @@
+/**
+ * @file SparseData.hpp
+ * @brief Declaration of the functions used for querying sparse data.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SPARSEDATA_HPP_
+#define SPARSEDATA_HPP_
+
+#include "utils/Logging.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+/**
+ * @brief Class that provides functionality for querying raw data which is
+ *        stored in the compressed sparse row (CSR) format, with variables
+ *        as the rows. Only the values which are not zero, including the
+ *        missing values, are stored for every variable.
+ *
+ * @tparam DataType Type of the underlying raw data, which is also the
+ *                  precision in which the split scores are computed.
+ * @tparam Var Type of the variables (expected to be an integral type).
+ * @tparam Obs Type of the observations (expected to be an integral type).
+ */
+template <typename DataType, typename Var, typename Obs>
+class SparseData {
+public:
+  using Value = DataType;
+
+  /**
+   * @brief Class that provides access to the observations of a variable,
+   *        by searching for the observations in the stored values.
+   */
+  class Row {
+  public:
+    DataType
+    operator[](const Obs j) const
+    {
+      auto it = std::lower_bound(m_first, m_last, static_cast<uint32_t>(j));
+      return ((it != m_last) && (*it == j)) ? m_values[it - m_first] : static_cast<DataType>(0);
+    }
+
+  private:
+    Row(
+      const uint32_t* const first,
+      const uint32_t* const last,
+      const DataType* const values
+    ) : m_first(first),
+        m_last(last),
+        m_values(values)
+    {
+    }
+
+  private:
+    const uint32_t* m_first;
+    const uint32_t* m_last;
+    const DataType* m_values;
+
+    friend class SparseData;
+  };
+
+  SparseData(std::vector<DataType>&&, std::vector<uint32_t>&&, std::vector<uint64_t>&&,
+             const std::vector<std::string>&, const Var, const Obs);
+
+  const std::string&
+  varName(const Var) const;
+
+  const std::vector<std::string>&
+  varNames() const;
+
+  template <typename Set = std::set<Var>>
+  std::vector<std::string>
+  varNames(const Set&) const;
+
+  Var
+  varIndex(const std::string&) const;
+
+  Var
+  numVars() const;
+
+  Obs
+  numObs() const;
+
+  double
+  density() const;
+
+  DataType
+  operator()(const Var, const Obs) const;
+
+  Row
+  row(const Var) const;
+
+  template <typename Func>
+  void
+  forEachStored(const Var, Func&&) const;
+
+  template <typename Set>
+  void
+  statistics(const Var, const Set&, std::tuple<double, double, uint32_t>&) const;
+
+  template <typename Set>
+  void
+  prefetch(const Set&) const;
+
+  ~SparseData();
+
+private:
+  const std::vector<DataType> m_values;
+  const std::vector<uint32_t> m_indices;
+  const std::vector<uint64_t> m_offsets;
+  const std::vector<std::string> m_varNames;
+  const Var m_nvars;
+  const Obs m_nobs;
+};
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Constructs the data provider object.
+ *
+ * @param values The values which are not zero, ordered by the variables.
+ * @param indices The observation index of every value, in increasing
+ *                order for every variable.
+ * @param offsets The position of the first value of every variable,
+ *                followed by the total number of values.
+ * @param varNames Names of the variables in the data set.
+ * @param n The number of variables in the data set.
+ * @param m The number of observations in the data set.
+ */
+SparseData<DataType, Var, Obs>::SparseData(
+  std::vector<DataType>&& values,
+  std::vector<uint32_t>&& indices,
+  std::vector<uint64_t>&& offsets,
+  const std::vector<std::string>& varNames,
+  const Var n,
+  const Obs m
+) : m_values(std::move(values)),
+    m_indices(std::move(indices)),
+    m_offsets(std::move(offsets)),
+    m_varNames(varNames),
+    m_nvars(n),
+    m_nobs(m)
+{
+  if ((m_offsets.size() != static_cast<size_t>(n) + 1) || (m_offsets.back() != m_values.size()) ||
+      (m_indices.size() != m_values.size())) {
+    throw std::runtime_error("The sparse data set is not consistent with the given dimensions.");
+  }
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Default destructor.
+ */
+SparseData<DataType, Var, Obs>::~SparseData(
+)
+{
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the name of a variable.
+ *
+ * @param x The index of the query variable.
+ *
+ * @return The name of the query variable.
+ */
+const std::string&
+SparseData<DataType, Var, Obs>::varName(
+  const Var x
+) const
+{
+  LOG_MESSAGE_IF(x >= m_varNames.size(), error, "Variable index %d out of range.", static_cast<uint32_t>(x));
+  return m_varNames[x];
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the names of all the variables in the data set.
+ */
+const std::vector<std::string>&
+SparseData<DataType, Var, Obs>::varNames(
+) const
+{
+  return m_varNames;
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the names of all the variables in the given set.
+ *
+ * @tparam Set The type of container for the variable indices.
+ * @param vars The indices of all the query variable.
+ *
+ * @return The name of all the query variables.
+ */
+template <typename Set>
+std::vector<std::string>
+SparseData<DataType, Var, Obs>::varNames(
+  const Set& vars
+) const
+{
+  std::vector<std::string> names(vars.size());
+  auto i = 0u;
+  for (const auto var : vars) {
+    LOG_MESSAGE_IF(var >= m_varNames.size(), error, "Variable index %d out of range.", static_cast<uint32_t>(var));
+    names[i++] = m_varNames[var];
+  }
+  return names;
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the index of a variable.
+ *
+ * @param name The name of the query variable.
+ *
+ * @return The index of the query variable.
+ */
+Var
+SparseData<DataType, Var, Obs>::varIndex(
+  const std::string& name
+) const
+{
+  Var x = 0u;
+  for (const auto& var : m_varNames) {
+    if (var.compare(name) == 0) {
+      break;
+    }
+    ++x;
+  }
+  LOG_MESSAGE_IF(x == numVars(), error, "Variable with name %s not found.", name);
+  return x;
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the number of variables in the data set.
+ */
+Var
+SparseData<DataType, Var, Obs>::numVars(
+) const
+{
+  return m_nvars;
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the number of observations in the data set.
+ */
+Obs
+SparseData<DataType, Var, Obs>::numObs(
+) const
+{
+  return m_nobs;
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the fraction of the data points which are stored.
+ */
+double
+SparseData<DataType, Var, Obs>::density(
+) const
+{
+  return static_cast<double>(m_values.size()) / (static_cast<double>(m_nvars) * m_nobs);
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the data point at the given index.
+ *
+ * @param i The variable index.
+ * @param j The observation index.
+ */
+DataType
+SparseData<DataType, Var, Obs>::operator()(
+  const Var i,
+  const Obs j
+) const
+{
+  auto first = m_indices.begin() + m_offsets[i];
+  auto last = m_indices.begin() + m_offsets[i + 1];
+  auto it = std::lower_bound(first, last, static_cast<uint32_t>(j));
+  return ((it != last) && (*it == j)) ? m_values[std::distance(m_indices.begin(), it)] : static_cast<DataType>(0);
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Returns the observations of a variable.
+ *
+ * @param x The index of the query variable.
+ */
+typename SparseData<DataType, Var, Obs>::Row
+SparseData<DataType, Var, Obs>::row(
+  const Var x
+) const
+{
+  return Row(m_indices.data() + m_offsets[x], m_indices.data() + m_offsets[x + 1], m_values.data() + m_offsets[x]);
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Calls the given function with the index and the value of every
+ *        stored observation of a variable, in increasing order of the
+ *        observations. The observations which are not stored are zero.
+ *
+ * @tparam Func Type of the function.
+ * @param x The index of the query variable.
+ * @param func The function to be called.
+ */
+template <typename Func>
+void
+SparseData<DataType, Var, Obs>::forEachStored(
+  const Var x,
+  Func&& func
+) const
+{
+  for (auto k = m_offsets[x]; k < m_offsets[x + 1]; ++k) {
+    func(static_cast<Obs>(m_indices[k]), m_values[k]);
+  }
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Adds the sum, the sum of squares, and the count of the non-missing
+ *        data points of a variable over the given observations to the given
+ *        statistics. Since a zero only contributes to the count, only the
+ *        stored values of the variable are visited, unless there are fewer
+ *        observations than the stored values.
+ *
+ * @tparam Set The type of container for the observation indices.
+ * @param x The index of the query variable.
+ * @param observations The indices of the observations.
+ * @param stats A tuple with the sum, the sum of squares, and the count.
+ */
+template <typename Set>
+void
+SparseData<DataType, Var, Obs>::statistics(
+  const Var x,
+  const Set& observations,
+  std::tuple<double, double, uint32_t>& stats
+) const
+{
+  auto& sum = std::get<0>(stats);
+  auto& sum2 = std::get<1>(stats);
+  auto& count = std::get<2>(stats);
+  // Every observation is counted, and the stored missing values are then discounted
+  uint32_t numObs = observations.size();
+  count += numObs;
+  auto add = [this, &sum, &sum2, &count] (const size_t k) {
+               auto d = static_cast<double>(m_values[k]);
+               if (std::isnan(d)) {
+                 --count;
+               }
+               else {
+                 sum += d;
+                 sum2 += d * d;
+               }
+             };
+  auto first = m_indices.begin() + m_offsets[x];
+  auto last = m_indices.begin() + m_offsets[x + 1];
+  if (static_cast<uint64_t>(std::distance(first, last)) <= numObs) {
+    for (auto it = first; it != last; ++it) {
+      if (observations.contains(static_cast<Obs>(*it))) {
+        add(std::distance(m_indices.begin(), it));
+      }
+    }
+  }
+  else {
+    // Both the observations and the stored indices are sorted
+    for (const auto o : observations) {
+      first = std::lower_bound(first, last, static_cast<uint32_t>(o));
+      if (first == last) {
+        break;
+      }
+      if (*first == o) {
+        add(std::distance(m_indices.begin(), first));
+      }
+    }
+  }
+}
+
+template <typename DataType, typename Var, typename Obs>
+/**
+ * @brief Does nothing because all the data is stored on this processor.
+ */
+template <typename Set>
+void
+SparseData<DataType, Var, Obs>::prefetch(
+  const Set&
+) const
+{
+}
+
+#endif // SPARSEDATA_HPP_
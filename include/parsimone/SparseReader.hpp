@@ -0,0 +1,366 @@
+/**
+ * @file SparseReader.hpp
+ * @brief Declaration of the functions used for reading sparse data sets
+ *        from HDF5 files, e.g., the X matrix of h5ad files.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SPARSEREADER_HPP_
+#define SPARSEREADER_HPP_
+
+#include "HDF5Helpers.hpp"
+
+#include <hdf5.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Class that reads a sparse data set stored in the format used by
+ *        AnnData, i.e., a group with the datasets data, indices, and indptr,
+ *        in which the rows are the observations and the columns are the
+ *        variables. Both CSR and CSC matrices are supported, as specified
+ *        by the encoding-type (or h5sparse_format) attribute of the group.
+ *        The data set is converted to the CSR format with the variables
+ *        as the rows, as expected by SparseData.
+ *
+ * @tparam DataType Type of the values in the data set.
+ */
+template <typename DataType>
+class SparseReader {
+public:
+  static
+  bool
+  isSparse(const std::string&, const std::string&, const std::string&);
+
+  SparseReader(const std::string&, const uint32_t, const uint32_t,
+               const std::string&, const std::string&, const std::string&);
+
+  std::vector<DataType>&
+  values();
+
+  std::vector<uint32_t>&
+  indices();
+
+  std::vector<uint64_t>&
+  offsets();
+
+  const std::vector<std::string>&
+  varNames() const;
+
+private:
+  static
+  std::string
+  readFormat(const hid_t, const std::string&);
+
+  template <typename T>
+  static
+  std::vector<T>
+  readDataset(const hid_t, const std::string&, const hid_t);
+
+  void
+  transpose(const uint32_t, const uint32_t);
+
+private:
+  std::vector<DataType> m_values;
+  std::vector<uint32_t> m_indices;
+  std::vector<uint64_t> m_offsets;
+  std::vector<std::string> m_varNames;
+}; // class SparseReader
+
+template <typename DataType>
+/**
+ * @brief Checks if the given path in the given HDF5 file
+ *        is a group which contains a sparse matrix.
+ *
+ * @param fileName Name of the file.
+ * @param root The root path of all the data in the file.
+ * @param matrixPath Path of the matrix, relative to the root.
+ */
+bool
+SparseReader<DataType>::isSparse(
+  const std::string& fileName,
+  const std::string& root,
+  const std::string& matrixPath
+)
+{
+  // Suppress the error messages printed by HDF5 for the objects which do not exist
+  H5Eset_auto(H5E_DEFAULT, nullptr, nullptr);
+  auto file = H5Fopen(fileName.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (file < 0) {
+    return false;
+  }
+  auto matrix = hdf5JoinPath(root, matrixPath);
+  H5O_info_t info;
+  auto sparse = hdf5Exists(file, matrix) && (H5Oget_info_by_name(file, matrix.c_str(), &info, H5P_DEFAULT) >= 0) &&
+                (info.type == H5O_TYPE_GROUP) && hdf5Exists(file, matrix + "/data") &&
+                hdf5Exists(file, matrix + "/indices") && hdf5Exists(file, matrix + "/indptr");
+  H5Fclose(file);
+  return sparse;
+}
+
+template <typename DataType>
+/**
+ * @brief Reads the sparse data set from the given file.
+ *
+ * @param fileName Name of the file.
+ * @param n The number of variables in the data set.
+ * @param m The number of observations in the data set.
+ * @param root The root path of all the data in the file.
+ * @param matrixPath Path of the group which contains the sparse matrix.
+ * @param varPath Path of the dataset which contains the names of the variables.
+ *                The variables are named by their indices if it does not exist.
+ */
+SparseReader<DataType>::SparseReader(
+  const std::string& fileName,
+  const uint32_t n,
+  const uint32_t m,
+  const std::string& root,
+  const std::string& matrixPath,
+  const std::string& varPath
+) : m_values(),
+    m_indices(),
+    m_offsets(),
+    m_varNames()
+{
+  static_assert(std::is_same<DataType, float>::value || std::is_same<DataType, double>::value,
+                "Only float and double values are supported");
+  H5Eset_auto(H5E_DEFAULT, nullptr, nullptr);
+  auto file = H5Fopen(fileName.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (file < 0) {
+    throw std::runtime_error("Could not open the file " + fileName);
+  }
+  try {
+    auto matrix = hdf5JoinPath(root, matrixPath);
+    auto format = readFormat(file, matrix);
+    bool csr = (format == "csr_matrix") || (format == "csr");
+    if (!csr && (format != "csc_matrix") && (format != "csc")) {
+      throw std::runtime_error("The format of the sparse matrix " + matrix + " is not supported.");
+    }
+    auto valueType = std::is_same<DataType, float>::value ? H5T_NATIVE_FLOAT : H5T_NATIVE_DOUBLE;
+    m_values = readDataset<DataType>(file, matrix + "/data", valueType);
+    m_indices = readDataset<uint32_t>(file, matrix + "/indices", H5T_NATIVE_UINT32);
+    m_offsets = readDataset<uint64_t>(file, matrix + "/indptr", H5T_NATIVE_UINT64);
+    // The rows of the matrix are the observations and the columns are the variables
+    auto major = csr ? m : n;
+    auto minor = csr ? n : m;
+    if ((m_offsets.size() != static_cast<size_t>(major) + 1) || (m_offsets.back() != m_values.size()) ||
+        (m_indices.size() != m_values.size()) ||
+        std::any_of(m_indices.begin(), m_indices.end(), [minor] (const uint32_t i) { return i >= minor; })) {
+      throw std::runtime_error("The sparse matrix " + matrix + " does not match the given dimensions.");
+    }
+    if (csr) {
+      this->transpose(n, m);
+    }
+    else {
+      // The indices are not required to be sorted in every column
+      std::vector<std::pair<uint32_t, DataType>> column;
+      for (auto i = 0u; i < n; ++i) {
+        auto first = m_offsets[i];
+        auto last = m_offsets[i + 1];
+        if (!std::is_sorted(m_indices.begin() + first, m_indices.begin() + last)) {
+          column.clear();
+          for (auto k = first; k < last; ++k) {
+            column.emplace_back(m_indices[k], m_values[k]);
+          }
+          std::sort(column.begin(), column.end(),
+                    [] (const std::pair<uint32_t, DataType>& a, const std::pair<uint32_t, DataType>& b)
+                       { return a.first < b.first; });
+          for (auto k = first; k < last; ++k) {
+            std::tie(m_indices[k], m_values[k]) = column[k - first];
+          }
+        }
+      }
+    }
+    auto names = hdf5JoinPath(root, varPath);
+    if (hdf5Exists(file, names)) {
+      m_varNames = hdf5ReadStrings(file, names);
+      if (m_varNames.size() != n) {
+        throw std::runtime_error("The dataset " + names + " does not contain the names of all the variables.");
+      }
+    }
+    else {
+      for (auto i = 0u; i < n; ++i) {
+        m_varNames.push_back("V" + std::to_string(i));
+      }
+    }
+  }
+  catch (...) {
+    H5Fclose(file);
+    throw;
+  }
+  H5Fclose(file);
+}
+
+template <typename DataType>
+/**
+ * @brief Returns the values which are not zero, ordered by the variables.
+ */
+std::vector<DataType>&
+SparseReader<DataType>::values(
+)
+{
+  return m_values;
+}
+
+template <typename DataType>
+/**
+ * @brief Returns the observation index of every value.
+ */
+std::vector<uint32_t>&
+SparseReader<DataType>::indices(
+)
+{
+  return m_indices;
+}
+
+template <typename DataType>
+/**
+ * @brief Returns the position of the first value of every variable,
+ *        followed by the total number of values.
+ */
+std::vector<uint64_t>&
+SparseReader<DataType>::offsets(
+)
+{
+  return m_offsets;
+}
+
+template <typename DataType>
+/**
+ * @brief Returns the names of all the variables in the data set.
+ */
+const std::vector<std::string>&
+SparseReader<DataType>::varNames(
+) const
+{
+  return m_varNames;
+}
+
+template <typename DataType>
+/**
+ * @brief Reads the format of the sparse matrix in the given group,
+ *        which is stored as a string attribute of the group.
+ */
+std::string
+SparseReader<DataType>::readFormat(
+  const hid_t file,
+  const std::string& group
+)
+{
+  std::string name = "encoding-type";
+  if (H5Aexists_by_name(file, group.c_str(), name.c_str(), H5P_DEFAULT) <= 0) {
+    // Older versions of AnnData use a different attribute
+    name = "h5sparse_format";
+    if (H5Aexists_by_name(file, group.c_str(), name.c_str(), H5P_DEFAULT) <= 0) {
+      throw std::runtime_error("The format of the sparse matrix " + group + " is not specified.");
+    }
+  }
+  auto attr = H5Aopen_by_name(file, group.c_str(), name.c_str(), H5P_DEFAULT, H5P_DEFAULT);
+  auto type = H5Aget_type(attr);
+  std::string value;
+  if (H5Tis_variable_str(type) > 0) {
+    char* str = nullptr;
+    auto memType = H5Tcopy(H5T_C_S1);
+    H5Tset_size(memType, H5T_VARIABLE);
+    if (H5Aread(attr, memType, &str) >= 0) {
+      value = str;
+      H5free_memory(str);
+    }
+    H5Tclose(memType);
+  }
+  else {
+    std::vector<char> str(H5Tget_size(type) + 1, '\0');
+    H5Aread(attr, type, str.data());
+    value = str.data();
+  }
+  H5Tclose(type);
+  H5Aclose(attr);
+  return value;
+}
+
+template <typename DataType>
+/**
+ * @brief Reads the given one-dimensional dataset, converting
+ *        the values to the given type in memory.
+ */
+template <typename T>
+std::vector<T>
+SparseReader<DataType>::readDataset(
+  const hid_t file,
+  const std::string& path,
+  const hid_t memType
+)
+{
+  auto dataset = H5Dopen(file, path.c_str(), H5P_DEFAULT);
+  if (dataset < 0) {
+    throw std::runtime_error("Could not open the dataset " + path);
+  }
+  auto space = H5Dget_space(dataset);
+  auto size = static_cast<size_t>(H5Sget_simple_extent_npoints(space));
+  std::vector<T> values(size);
+  auto status = (size > 0) ? H5Dread(dataset, memType, H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data()) : 0;
+  H5Sclose(space);
+  H5Dclose(dataset);
+  if (status < 0) {
+    throw std::runtime_error("Could not read the dataset " + path);
+  }
+  return values;
+}
+
+template <typename DataType>
+/**
+ * @brief Converts the matrix from the CSR format with the observations as
+ *        the rows to the CSR format with the variables as the rows.
+ *
+ * @param n The number of variables in the data set.
+ * @param m The number of observations in the data set.
+ */
+void
+SparseReader<DataType>::transpose(
+  const uint32_t n,
+  const uint32_t m
+)
+{
+  std::vector<uint64_t> offsets(static_cast<size_t>(n) + 1, 0);
+  for (const auto i : m_indices) {
+    ++offsets[i + 1];
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  std::vector<DataType> values(m_values.size());
+  std::vector<uint32_t> indices(m_indices.size());
+  std::vector<uint64_t> next(offsets.begin(), offsets.end() - 1);
+  // Visiting the observations in order keeps the indices sorted for every variable
+  for (auto j = 0u; j < m; ++j) {
+    for (auto k = m_offsets[j]; k < m_offsets[j + 1]; ++k) {
+      auto pos = next[m_indices[k]]++;
+      values[pos] = m_values[k];
+      indices[pos] = j;
+    }
+  }
+  m_values = std::move(values);
+  m_indices = std::move(indices);
+  m_offsets = std::move(offsets);
+}
+
+#endif // SPARSEREADER_HPP_
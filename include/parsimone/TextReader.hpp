@@ -0,0 +1,645 @@
+/**
+ * @file TextReader.hpp
+ * @brief Declaration of the functions used for reading data sets from
+ *        delimited text files, e.g., CSV and TSV files.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TEXTREADER_HPP_
+#define TEXTREADER_HPP_
+
+#include "mxx/collective.hpp"
+#include "mxx/comm.hpp"
+#include "mxx/distribution.hpp"
+#include "mxx/reduction.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/**
+ * @brief Class that reads a data set from a delimited text file.
+ *
+ * The file is mapped to memory and is split into chunks of bytes, which
+ * are parsed by multiple threads. If the file is read in parallel, it is
+ * first split into contiguous ranges of bytes across the processors. Every
+ * line belongs to the chunk which contains its first byte. The lines are
+ * counted in the first pass over the chunks, so that every chunk can parse
+ * its lines directly into their final positions in the second pass. The
+ * values read in parallel are either gathered on all the processors or
+ * exchanged so that every processor gets only a block of the variables.
+ *
+ * The delimiters and the line breaks are found using memchr, which is
+ * vectorized by the C library, and the values are parsed using
+ * std::from_chars, or using strtod if the standard library does not
+ * support std::from_chars for floating point types, e.g., before GCC 11.
+ * Empty values and NA are read as NaN.
+ *
+ * @tparam DataType Type of the values in the data set.
+ */
+template <typename DataType>
+class TextReader {
+public:
+  TextReader(const mxx::comm&, const std::string&, const uint32_t, const uint32_t, const char,
+             const bool, const bool, const bool, const bool, const bool = false);
+
+  std::vector<DataType>&
+  data();
+
+  const std::vector<DataType>&
+  data() const;
+
+  const std::vector<std::string>&
+  varNames() const;
+
+private:
+  struct Chunk {
+    const char* begin;
+    const char* end;
+    uint64_t firstLine;
+    uint64_t numLines;
+  };
+
+private:
+  static
+  const char*
+  lineStart(const char*, const char*, const char*);
+
+  static
+  const char*
+  lineEnd(const char*, const char*);
+
+  static
+  bool
+  isEmpty(const char*, const char*);
+
+  static
+  bool
+  parseValue(const char*, const char*, DataType&);
+
+  std::vector<std::string>
+  splitFields(const char*, const char*) const;
+
+  std::string
+  parseLine(const char*, const char*, DataType*, std::string&) const;
+
+  std::vector<DataType>
+  distributeValues(const mxx::comm&, const uint32_t, const uint32_t, const uint64_t, const uint64_t,
+                   const std::vector<DataType>&) const;
+
+private:
+  std::vector<DataType> m_data;
+  std::vector<std::string> m_varNames;
+  const char m_sep;
+  const bool m_colObs;
+  const bool m_hasVarNames;
+  const bool m_hasObsIndices;
+  const uint32_t m_numFields;
+};
+
+template <typename DataType>
+/**
+ * @brief Reads the data set from the given file.
+ *
+ * @param comm The communicator of the processors reading the file, used
+ *             only if the file is read in parallel.
+ * @param fileName Name of the file.
+ * @param n The number of variables in the data set.
+ * @param m The number of observations in the data set.
+ * @param sep The delimiting character.
+ * @param colObs If the observations are in the columns, i.e., every line is a variable.
+ * @param varNames If the file contains the names of the variables.
+ * @param obsIndices If the file contains the indices of the observations.
+ * @param parallelRead If the file should be read in parallel by all the processors.
+ * @param distributeVars If every processor should only keep the observations of
+ *                       its block of the variables, as determined by mxx::blk_dist,
+ *                       instead of all the variables. Used only if the file is
+ *                       read in parallel.
+ */
+TextReader<DataType>::TextReader(
+  const mxx::comm& comm,
+  const std::string& fileName,
+  const uint32_t n,
+  const uint32_t m,
+  const char sep,
+  const bool colObs,
+  const bool varNames,
+  const bool obsIndices,
+  const bool parallelRead,
+  const bool distributeVars
+) : m_data(),
+    m_varNames(),
+    m_sep(sep),
+    m_colObs(colObs),
+    m_hasVarNames(varNames),
+    m_hasObsIndices(obsIndices),
+    m_numFields(colObs ? m : n)
+{
+#if TIMER
+  auto tStart = std::chrono::steady_clock::now();
+#endif
+  auto fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Could not open the file " + fileName);
+  }
+  struct stat st;
+  size_t size = (fstat(fd, &st) == 0) ? st.st_size : 0;
+  void* map = (size > 0) ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (map == MAP_FAILED) {
+    throw std::runtime_error("Could not map the file " + fileName);
+  }
+  madvise(map, size, MADV_SEQUENTIAL);
+  const char* file = static_cast<const char*>(map);
+  const char* fileEnd = file + size;
+
+  auto rank = parallelRead ? comm.rank() : 0;
+  auto numProcs = parallelRead ? comm.size() : 1;
+  const char* myBegin = lineStart(file, file + (size * rank) / numProcs, fileEnd);
+  const char* myEnd = lineStart(file, file + (size * (rank + 1)) / numProcs, fileEnd);
+  // Use chunks of at least 1 MB, and enough chunks for balancing the load across threads
+  constexpr size_t minChunkSize = 1 << 20;
+  constexpr size_t maxChunks = 256;
+  auto myBytes = static_cast<size_t>(myEnd - myBegin);
+  auto numChunks = std::max(static_cast<size_t>(1), std::min(maxChunks, myBytes / minChunkSize));
+  std::vector<Chunk> chunks(numChunks);
+  for (auto c = 0u; c < numChunks; ++c) {
+    chunks[c].begin = lineStart(file, myBegin + (myBytes * c) / numChunks, myEnd);
+    chunks[c].end = lineStart(file, myBegin + (myBytes * (c + 1)) / numChunks, myEnd);
+  }
+
+  // First, count the non-empty lines in every chunk
+  #pragma omp parallel for schedule(dynamic)
+  for (auto c = 0u; c < numChunks; ++c) {
+    auto count = 0u;
+    for (auto line = chunks[c].begin; line < chunks[c].end; ) {
+      auto end = lineEnd(line, chunks[c].end);
+      count += isEmpty(line, end) ? 0 : 1;
+      if (end == chunks[c].end) {
+        break;
+      }
+      line = end + 1;
+    }
+    chunks[c].numLines = count;
+  }
+  uint64_t myLines = 0;
+  for (auto& chunk : chunks) {
+    chunk.firstLine = myLines;
+    myLines += chunk.numLines;
+  }
+  uint64_t myFirstLine = parallelRead ? mxx::scan(myLines, comm) - myLines : 0;
+  uint64_t totalLines = parallelRead ? mxx::allreduce(myLines, comm) : myLines;
+
+  // The first line contains the names of the variables in the row format,
+  // and the indices of the observations in the column format
+  uint64_t headerLines = (colObs ? obsIndices : varNames) ? 1 : 0;
+  uint64_t numLines = colObs ? n : m;
+  if (totalLines != headerLines + numLines) {
+    munmap(map, size);
+    throw std::runtime_error("The file " + fileName + " contains " + std::to_string(totalLines) +
+                             " non-empty lines instead of the expected " +
+                             std::to_string(headerLines + numLines) + " lines.");
+  }
+  auto myDataFirst = std::max(myFirstLine, headerLines) - headerLines;
+  auto myDataLines = std::max(myFirstLine + myLines, headerLines) - headerLines - myDataFirst;
+
+  // Then, parse the lines of every chunk into their positions
+  std::vector<DataType> myValues(myDataLines * m_numFields);
+  std::vector<std::string> myNames((colObs && varNames) ? myDataLines : 0);
+  std::vector<std::string> header;
+  std::vector<std::string> errors(numChunks);
+  #pragma omp parallel for schedule(dynamic)
+  for (auto c = 0u; c < numChunks; ++c) {
+    auto lineIndex = myFirstLine + chunks[c].firstLine;
+    for (auto line = chunks[c].begin; (line < chunks[c].end) && errors[c].empty(); ) {
+      auto end = lineEnd(line, chunks[c].end);
+      if (!isEmpty(line, end)) {
+        if (lineIndex < headerLines) {
+          header = this->splitFields(line, end);
+        }
+        else {
+          auto d = lineIndex - headerLines - myDataFirst;
+          std::string name;
+          auto error = this->parseLine(line, end, &myValues[d * m_numFields], name);
+          if (!error.empty()) {
+            errors[c] = "Line " + std::to_string(lineIndex + 1) + ": " + error;
+          }
+          else if (!myNames.empty()) {
+            myNames[d] = std::move(name);
+          }
+        }
+        ++lineIndex;
+      }
+      if (end == chunks[c].end) {
+        break;
+      }
+      line = end + 1;
+    }
+  }
+  munmap(map, size);
+  auto error = std::find_if(errors.begin(), errors.end(), [] (const std::string& e) { return !e.empty(); });
+  auto hasError = (error != errors.end()) ? 1 : 0;
+  if (parallelRead) {
+    hasError = mxx::allreduce(hasError, mxx::max<int>(), comm);
+  }
+  if (hasError != 0) {
+    throw std::runtime_error("Error in parsing the file " + fileName + ". " +
+                             ((error != errors.end()) ? *error : "See the other processes for details."));
+  }
+
+  // Gather the values and the names from all the processors, if required
+  auto distributed = parallelRead && distributeVars;
+  if (distributed) {
+    myValues = this->distributeValues(comm, n, m, myDataFirst, myDataLines, myValues);
+  }
+  else if (parallelRead) {
+    myValues = mxx::allgatherv(myValues, comm);
+  }
+  if (parallelRead) {
+    if (colObs && varNames) {
+      std::string joined;
+      for (const auto& name : myNames) {
+        joined.append(name).push_back('\n');
+      }
+      auto allJoined = mxx::allgatherv(std::vector<char>(joined.begin(), joined.end()), comm);
+      myNames.clear();
+      for (auto first = allJoined.cbegin(); first != allJoined.cend(); ) {
+        auto last = std::find(first, allJoined.cend(), '\n');
+        myNames.emplace_back(first, last);
+        first = std::next(last);
+      }
+    }
+    if (!colObs && varNames) {
+      std::string joined;
+      for (const auto& name : header) {
+        joined.append(name).push_back('\n');
+      }
+      mxx::bcast(joined, 0, comm);
+      header.clear();
+      for (size_t first = 0; first < joined.size(); ) {
+        auto last = joined.find('\n', first);
+        header.emplace_back(joined.substr(first, last - first));
+        first = last + 1;
+      }
+    }
+  }
+  if (colObs) {
+    // Every line is a variable; therefore, the values are already in variable-major order
+    m_data = std::move(myValues);
+    m_varNames = std::move(myNames);
+  }
+  else {
+    if (distributed) {
+      // The values were transposed while they were being distributed
+      m_data = std::move(myValues);
+    }
+    else {
+      m_data.resize(static_cast<size_t>(n) * m);
+      #pragma omp parallel for
+      for (auto i = 0u; i < n; ++i) {
+        for (auto j = 0u; j < m; ++j) {
+          m_data[static_cast<size_t>(i) * m + j] = myValues[static_cast<size_t>(j) * n + i];
+        }
+      }
+    }
+    if (varNames) {
+      if (obsIndices && !header.empty()) {
+        header.erase(header.begin());
+      }
+      m_varNames = std::move(header);
+    }
+  }
+  if (!varNames) {
+    for (auto i = 0u; i < n; ++i) {
+      m_varNames.push_back("V" + std::to_string(i));
+    }
+  }
+  if (m_varNames.size() != n) {
+    throw std::runtime_error("The file " + fileName + " contains " + std::to_string(m_varNames.size()) +
+                             " variable names instead of the expected " + std::to_string(n) + " names.");
+  }
+#if TIMER
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - tStart;
+  if (!parallelRead || comm.is_first()) {
+    std::cout << "Throughput of parsing the file: " << (size / (1024.0 * 1024.0)) / elapsed.count() << " MB/s" << std::endl;
+  }
+#endif
+}
+
+template <typename DataType>
+/**
+ * @brief Returns the values of the data set, or of the block of the
+ *        variables on this processor, in variable-major order.
+ */
+std::vector<DataType>&
+TextReader<DataType>::data(
+)
+{
+  return m_data;
+}
+
+template <typename DataType>
+/**
+ * @brief Returns the values of the data set, or of the block of the
+ *        variables on this processor, in variable-major order.
+ */
+const std::vector<DataType>&
+TextReader<DataType>::data(
+) const
+{
+  return m_data;
+}
+
+template <typename DataType>
+/**
+ * @brief Returns the names of all the variables in the data set.
+ */
+const std::vector<std::string>&
+TextReader<DataType>::varNames(
+) const
+{
+  return m_varNames;
+}
+
+template <typename DataType>
+/**
+ * @brief Returns the start of the first line which starts at or after the
+ *        given position, or the given end if there is no such line.
+ */
+const char*
+TextReader<DataType>::lineStart(
+  const char* file,
+  const char* pos,
+  const char* end
+)
+{
+  if ((pos == file) || (pos >= end)) {
+    return std::min(pos, end);
+  }
+  auto newline = static_cast<const char*>(std::memchr(pos - 1, '\n', end - pos + 1));
+  return (newline != nullptr) ? newline + 1 : end;
+}
+
+template <typename DataType>
+/**
+ * @brief Returns the position of the line break which ends the given line,
+ *        or the given end if the line is not terminated.
+ */
+const char*
+TextReader<DataType>::lineEnd(
+  const char* line,
+  const char* end
+)
+{
+  auto newline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+  return (newline != nullptr) ? newline : end;
+}
+
+template <typename DataType>
+/**
+ * @brief Checks if the given line is empty, ignoring a trailing carriage return.
+ */
+bool
+TextReader<DataType>::isEmpty(
+  const char* line,
+  const char* end
+)
+{
+  return (line == end) || ((line + 1 == end) && (*line == '\r'));
+}
+
+template <typename DataType>
+/**
+ * @brief Parses the given value. Surrounding whitespace is ignored,
+ *        and empty values and NA are parsed as NaN.
+ *
+ * @return true if the value could be parsed, false otherwise.
+ */
+bool
+TextReader<DataType>::parseValue(
+  const char* first,
+  const char* last,
+  DataType& value
+)
+{
+  while ((first < last) && ((*first == ' ') || (*first == '\t'))) {
+    ++first;
+  }
+  while ((last > first) && ((*(last - 1) == ' ') || (*(last - 1) == '\t') || (*(last - 1) == '\r'))) {
+    --last;
+  }
+  if ((first == last) || ((last - first == 2) && (first[0] == 'N') && (first[1] == 'A'))) {
+    value = std::numeric_limits<DataType>::quiet_NaN();
+    return true;
+  }
+  // std::from_chars does not accept a plus sign; therefore, skip it,
+  // but only if it is followed by the value without another sign
+  if (*first == '+') {
+    ++first;
+    if ((first == last) || (*first == '+') || (*first == '-')) {
+      return false;
+    }
+  }
+#if defined(__cpp_lib_to_chars)
+  auto result = std::from_chars(first, last, value);
+  return (result.ec == std::errc()) && (result.ptr == last);
+#else
+  // strtod expects a null-terminated string; the copy is usually short
+  // enough to not require any allocation
+  std::string copy(first, last);
+  // Reject the forms which are accepted by strtod but not by std::from_chars
+  if (std::isspace(static_cast<unsigned char>(*first)) || (copy.find_first_of("xX") != std::string::npos)) {
+    return false;
+  }
+  char* end = nullptr;
+  errno = 0;
+  if (std::is_same<DataType, float>::value) {
+    value = std::strtof(copy.c_str(), &end);
+  }
+  else {
+    value = static_cast<DataType>(std::strtod(copy.c_str(), &end));
+  }
+  // strtod also reports the subnormal results as out of range, which are
+  // accepted by std::from_chars; only the values which overflow to infinity
+  // or underflow to zero are rejected by both
+  auto outOfRange = (errno == ERANGE) && ((value == 0) || std::isinf(value));
+  return !outOfRange && (end == copy.c_str() + copy.size());
+#endif
+}
+
+template <typename DataType>
+/**
+ * @brief Splits the given line into its fields.
+ */
+std::vector<std::string>
+TextReader<DataType>::splitFields(
+  const char* line,
+  const char* end
+) const
+{
+  if ((end > line) && (*(end - 1) == '\r')) {
+    --end;
+  }
+  std::vector<std::string> fields;
+  for (auto field = line; field <= end; ) {
+    auto sep = static_cast<const char*>(std::memchr(field, m_sep, end - field));
+    auto last = (sep != nullptr) ? sep : end;
+    fields.emplace_back(field, last);
+    field = last + 1;
+  }
+  return fields;
+}
+
+template <typename DataType>
+/**
+ * @brief Parses the values in the given line of data.
+ *
+ * @param line The start of the line.
+ * @param end The end of the line.
+ * @param values Pointer to the location for the values in the line.
+ * @param name The name of the variable, if the line is a variable with name.
+ *
+ * @return The description of the error if the line could not be parsed,
+ *         or an empty string otherwise.
+ */
+std::string
+TextReader<DataType>::parseLine(
+  const char* line,
+  const char* end,
+  DataType* values,
+  std::string& name
+) const
+{
+  auto field = line;
+  // The first field is either the name of the variable or the index of the observation
+  if (m_colObs ? m_hasVarNames : m_hasObsIndices) {
+    auto sep = static_cast<const char*>(std::memchr(field, m_sep, end - field));
+    auto last = (sep != nullptr) ? sep : end;
+    if (m_colObs) {
+      name.assign(field, last);
+    }
+    field = last + 1;
+  }
+  for (auto f = 0u; f < m_numFields; ++f) {
+    if (field > end) {
+      return "Expected " + std::to_string(m_numFields) + " values but found " + std::to_string(f) + " values.";
+    }
+    auto sep = static_cast<const char*>(std::memchr(field, m_sep, end - field));
+    auto last = (sep != nullptr) ? sep : end;
+    if (!parseValue(field, last, values[f])) {
+      return "Could not parse the value " + std::string(field, last) + ".";
+    }
+    field = last + 1;
+  }
+  // Allow a trailing delimiter, which results in an empty field at the end of the line
+  if ((field <= end) && !((field == end) || ((field + 1 == end) && (*field == '\r')))) {
+    return "Expected " + std::to_string(m_numFields) + " values but found more values.";
+  }
+  return "";
+}
+
+template <typename DataType>
+/**
+ * @brief Exchanges the values parsed by all the processors so that every
+ *        processor gets the observations of its block of the variables,
+ *        as determined by mxx::blk_dist, in variable-major order.
+ *
+ * @param comm The communicator of the processors reading the file.
+ * @param n The number of variables in the data set.
+ * @param m The number of observations in the data set.
+ * @param myFirst The index of the first line of values parsed by this processor.
+ * @param myLines The number of lines of values parsed by this processor.
+ * @param myValues The values parsed by this processor, in the order of the lines.
+ *
+ * @return The values of the variables in the block of this processor.
+ */
+std::vector<DataType>
+TextReader<DataType>::distributeValues(
+  const mxx::comm& comm,
+  const uint32_t n,
+  const uint32_t m,
+  const uint64_t myFirst,
+  const uint64_t myLines,
+  const std::vector<DataType>& myValues
+) const
+{
+  auto firsts = mxx::allgather(myFirst, comm);
+  auto lines = mxx::allgather(myLines, comm);
+  mxx::blk_dist block(n, comm.size(), comm.rank());
+  std::vector<size_t> sendSizes(comm.size()), sendDispls(comm.size());
+  std::vector<size_t> recvSizes(comm.size()), recvDispls(comm.size());
+  std::vector<DataType> local(block.local_size() * m);
+  if (m_colObs) {
+    // Every line is a variable; send the lines which overlap with the block of every processor
+    for (int r = 0; r < comm.size(); ++r) {
+      uint64_t blockFirst = block.eprefix_size(r);
+      uint64_t blockLast = blockFirst + block.local_size(r);
+      auto first = std::max(myFirst, blockFirst);
+      auto last = std::max(std::min(myFirst + myLines, blockLast), first);
+      sendSizes[r] = (last - first) * m;
+      sendDispls[r] = (first - myFirst) * m;
+      first = std::max(firsts[r], static_cast<uint64_t>(block.eprefix_size()));
+      last = std::max(std::min(firsts[r] + lines[r], static_cast<uint64_t>(block.iprefix_size())), first);
+      recvSizes[r] = (last - first) * m;
+      recvDispls[r] = (first - block.eprefix_size()) * m;
+    }
+    mxx::all2allv(myValues.data(), sendSizes, sendDispls, local.data(), recvSizes, recvDispls, comm);
+    return local;
+  }
+  // Every line is an observation; send the values of the variables
+  // in the block of every processor, in variable-major order
+  std::vector<DataType> sendValues(myValues.size());
+  size_t pos = 0;
+  for (int r = 0; r < comm.size(); ++r) {
+    sendDispls[r] = pos;
+    for (auto i = block.eprefix_size(r); i < block.eprefix_size(r) + block.local_size(r); ++i) {
+      for (uint64_t j = 0; j < myLines; ++j) {
+        sendValues[pos++] = myValues[j * n + i];
+      }
+    }
+    sendSizes[r] = pos - sendDispls[r];
+    recvSizes[r] = block.local_size() * lines[r];
+    recvDispls[r] = (r > 0) ? recvDispls[r - 1] + recvSizes[r - 1] : 0;
+  }
+  std::vector<DataType> received(local.size());
+  mxx::all2allv(sendValues.data(), sendSizes, sendDispls, received.data(), recvSizes, recvDispls, comm);
+  for (int r = 0; r < comm.size(); ++r) {
+    for (size_t i = 0; i < block.local_size(); ++i) {
+      std::copy_n(received.begin() + recvDispls[r] + i * lines[r], lines[r], local.begin() + i * m + firsts[r]);
+    }
+  }
+  return local;
+}
+
+#endif // TEXTREADER_HPP_
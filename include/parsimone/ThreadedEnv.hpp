@@ -0,0 +1,109 @@
+/**
+ * @file ThreadedEnv.hpp
+ * @brief Declaration of the class used for initializing MPI
+ *        with multi-threading support.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef THREADEDENV_HPP_
+#define THREADEDENV_HPP_
+
+#include <mpi.h>
+
+
+/**
+ * @brief Class that initializes MPI with the requested level of
+ *        thread support on construction and finalizes it on destruction.
+ *        Replaces mxx::env, which initializes MPI using MPI_Init.
+ */
+class ThreadedEnv {
+public:
+  ThreadedEnv(int&, char**&, const int);
+
+  ThreadedEnv(const ThreadedEnv&) = delete;
+
+  ThreadedEnv&
+  operator=(const ThreadedEnv&) = delete;
+
+  int
+  provided() const;
+
+  bool
+  supports(const int) const;
+
+  ~ThreadedEnv();
+
+private:
+  int m_provided;
+}; // class ThreadedEnv
+
+/**
+ * @brief Initializes MPI with the given level of thread support.
+ *
+ * @param argc Number of command line arguments.
+ * @param argv Command line arguments.
+ * @param required Level of thread support required by the caller;
+ *                 one of MPI_THREAD_SINGLE, MPI_THREAD_FUNNELED,
+ *                 MPI_THREAD_SERIALIZED, or MPI_THREAD_MULTIPLE.
+ */
+inline
+ThreadedEnv::ThreadedEnv(
+  int& argc,
+  char**& argv,
+  const int required
+) : m_provided(MPI_THREAD_SINGLE)
+{
+  MPI_Init_thread(&argc, &argv, required, &m_provided);
+}
+
+/**
+ * @brief Returns the level of thread support provided by the MPI library.
+ */
+inline
+int
+ThreadedEnv::provided(
+) const
+{
+  return m_provided;
+}
+
+/**
+ * @brief Checks if the provided level of thread support is at least the given level.
+ */
+inline
+bool
+ThreadedEnv::supports(
+  const int required
+) const
+{
+  // The levels are monotonic, i.e., SINGLE < FUNNELED < SERIALIZED < MULTIPLE
+  return m_provided >= required;
+}
+
+/**
+ * @brief Finalizes MPI, if it has not already been finalized.
+ */
+inline
+ThreadedEnv::~ThreadedEnv(
+)
+{
+  int finalized;
+  MPI_Finalized(&finalized);
+  if (!finalized) {
+    MPI_Finalize();
+  }
+}
+
+#endif // THREADEDENV_HPP_
@@ -20,46 +20,55 @@
 #ifndef DETAIL_ASSIGNMENTS_HPP_
 #define DETAIL_ASSIGNMENTS_HPP_
 
+#include "VectorMath.hpp"
 
-template <typename Data, typename Var, typename Set>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 class TreeNode;
 
-template <typename Data, typename Var, typename Set>
+template <typename DataType, typename Var, typename Obs>
+class SparseData;
+
+/**
+ * @brief Class that stores the values of a candidate parent in the two
+ *        children of a node, and computes the scores of its splits.
+ *
+ * The values are stored in the value type of the data provider; the
+ * vectorized kernels compute the terms in the same precision and sum
+ * them in double precision.
+ *
+ * @tparam Data Type of the object which is used for querying the data.
+ * @tparam Var Type of variable indices (expected to be an integer type).
+ * @tparam VarSet Type of set container for the variables.
+ * @tparam Obs Type of observation indices (expected to be an integer type).
+ * @tparam ObsSet Type of set container for the observations.
+ */
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 class Assignment {
 public:
+  using Value = typename Data::Value;
+
   Assignment(
     const Data& data,
     const Var v,
-    const TreeNode<Data, Var, Set>* const node
+    const TreeNode<Data, Var, VarSet, Obs, ObsSet>* const node,
+    const bool fastMath = false
   ) : m_data(),
       m_sum(std::make_pair(0.0, 0.0)),
       m_missing(std::make_pair(0, 0)),
-      m_varName(data.varName(v))
+      m_varName(data.varName(v)),
+      m_fastMath(fastMath)
   {
     const auto& firstObs = node->children().first->observations();
-    m_data.first = std::vector<double>(firstObs.size());
-    auto d = m_data.first.begin();
-    for (const auto o : firstObs) {
-      if (!std::isnan(data(v, o))) {
-        *d = data(v, o);
-        m_sum.first += *d;
-        ++d;
-      }
-    }
-    m_missing.first = std::distance(d, m_data.first.end());
-    m_data.first.resize(std::distance(m_data.first.begin(), d));
     const auto& secondObs = node->children().second->observations();
-    m_data.second = std::vector<double>(secondObs.size());
-    d = m_data.second.begin();
-    for (const auto o : secondObs) {
-      if (!std::isnan(data(v, o))) {
-        *d = data(v, o);
-        m_sum.second += *d;
-        ++d;
-      }
-    }
-    m_missing.second = std::distance(d, m_data.second.end());
-    m_data.second.resize(std::distance(m_data.second.begin(), d));
+    m_data.first.reserve(firstObs.size());
+    m_data.second.reserve(secondObs.size());
+    this->gather(data, v, firstObs, secondObs);
+    m_missing.first = firstObs.size() - m_data.first.size();
+    m_missing.second = secondObs.size() - m_data.second.size();
   }
 
   const std::string&
@@ -88,6 +97,9 @@ public:
     const double beta
   ) const
   {
+    if (m_fastMath) {
+      return logisticSum(m_data.second, sv, sign * beta) - logisticSum(m_data.first, sv, -1 * sign * beta);
+    }
     auto sumFirst = 0.0;
     for (const auto x : m_data.first) {
       sumFirst += (x - sv) / (1 + exp(-1 * sign * beta * (x - sv)));
@@ -99,6 +111,41 @@ public:
     return sumSecond - sumFirst;
   }
 
+  std::pair<double, double>
+  evaluateWithDerivative(
+    const double sv,
+    const int sign,
+    const double beta
+  ) const
+  {
+    double sumFirst, slopeFirst, sumSecond, slopeSecond;
+    if (m_fastMath) {
+      logisticSums(m_data.first, sv, -1 * sign * beta, sumFirst, slopeFirst);
+      logisticSums(m_data.second, sv, sign * beta, sumSecond, slopeSecond);
+    }
+    else {
+      sumFirst = 0.0;
+      slopeFirst = 0.0;
+      for (const auto x : m_data.first) {
+        const auto e = exp(-1 * sign * beta * (x - sv));
+        const auto r = 1 / (1 + e);
+        sumFirst += (x - sv) / (1 + e);
+        slopeFirst += (x - sv) * (x - sv) * r * (1 - r);
+      }
+      sumSecond = 0.0;
+      slopeSecond = 0.0;
+      for (const auto x : m_data.second) {
+        const auto e = exp(sign * beta * (x - sv));
+        const auto r = 1 / (1 + e);
+        sumSecond += (x - sv) / (1 + e);
+        slopeSecond += (x - sv) * (x - sv) * r * (1 - r);
+      }
+    }
+    // The derivative of (x - sv) / (1 + exp(c * beta * (x - sv))) w.r.t. beta is
+    // -c * (x - sv)^2 * r * (1 - r), where r = 1 / (1 + exp(c * beta * (x - sv)))
+    return std::make_pair(sumSecond - sumFirst, -1 * sign * (slopeFirst + slopeSecond));
+  }
+
   double
   score(
     const double sv,
@@ -106,6 +153,11 @@ public:
     const double beta
   ) const
   {
+    if (m_fastMath) {
+      auto sumFirst = -softplusSum(m_data.first, sv, sign * beta) - (m_missing.first * log(2));
+      auto sumSecond = -softplusSum(m_data.second, sv, -1 * sign * beta) - (m_missing.second * log(2));
+      return sumFirst + sumSecond;
+    }
     auto sumFirst = 0.0;
     for (const auto x : m_data.first) {
       sumFirst -= log(1 + exp(sign * beta * (x - sv)));
@@ -120,10 +172,398 @@ public:
   }
 
 private:
-  std::pair<std::vector<double>, std::vector<double>> m_data;
+  /**
+   * @brief Computes the sum of (x - sv) / (1 + exp(c * (x - sv)))
+   *        over the given data using vector instructions, if available.
+   */
+  static
+  double
+  logisticSum(
+    const std::vector<double>& data,
+    const double sv,
+    const double c
+  )
+  {
+    auto sum = 0.0;
+    size_t i = 0u;
+#if defined(HAVE_AVX512BW_INSTRUCTIONS) && defined(__AVX512F__)
+    auto vsum = _mm512_setzero_pd();
+    for ( ; i + 8 <= data.size(); i += 8) {
+      const auto d = _mm512_sub_pd(_mm512_loadu_pd(data.data() + i), _mm512_set1_pd(sv));
+      const auto e = exp_avx512(_mm512_mul_pd(_mm512_set1_pd(c), d));
+      vsum = _mm512_add_pd(vsum, _mm512_div_pd(d, _mm512_add_pd(_mm512_set1_pd(1.0), e)));
+    }
+    alignas(64) double partial[8];
+    _mm512_store_pd(partial, vsum);
+    for (auto k = 0u; k < 8u; ++k) {
+      sum += partial[k];
+    }
+#elif defined(HAVE_AVX2_INSTRUCTIONS) && defined(__AVX2__)
+    auto vsum = _mm256_setzero_pd();
+    for ( ; i + 4 <= data.size(); i += 4) {
+      const auto d = _mm256_sub_pd(_mm256_loadu_pd(data.data() + i), _mm256_set1_pd(sv));
+      const auto e = exp_avx2(_mm256_mul_pd(_mm256_set1_pd(c), d));
+      vsum = _mm256_add_pd(vsum, _mm256_div_pd(d, _mm256_add_pd(_mm256_set1_pd(1.0), e)));
+    }
+    const auto half = _mm_add_pd(_mm256_castpd256_pd128(vsum), _mm256_extractf128_pd(vsum, 1));
+    sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+#endif
+    for ( ; i < data.size(); ++i) {
+      sum += (data[i] - sv) / (1 + exp(c * (data[i] - sv)));
+    }
+    return sum;
+  }
+
+  /**
+   * @brief Computes the sum of (x - sv) / (1 + exp(c * (x - sv)))
+   *        over the given single precision data.
+   */
+  static
+  double
+  logisticSum(
+    const std::vector<float>& data,
+    const double sv,
+    const double c
+  )
+  {
+    auto sum = 0.0;
+    size_t i = 0u;
+    const auto fsv = static_cast<float>(sv);
+    const auto fc = static_cast<float>(c);
+#if defined(HAVE_AVX512BW_INSTRUCTIONS) && defined(__AVX512F__)
+    auto vsum = _mm512_setzero_pd();
+    for ( ; i + 16 <= data.size(); i += 16) {
+      const auto d = _mm512_sub_ps(_mm512_loadu_ps(data.data() + i), _mm512_set1_ps(fsv));
+      const auto e = exp_avx512(_mm512_mul_ps(_mm512_set1_ps(fc), d));
+      vsum = add_widen_avx512(vsum, _mm512_div_ps(d, _mm512_add_ps(_mm512_set1_ps(1.0f), e)));
+    }
+    alignas(64) double partial[8];
+    _mm512_store_pd(partial, vsum);
+    for (auto k = 0u; k < 8u; ++k) {
+      sum += partial[k];
+    }
+#elif defined(HAVE_AVX2_INSTRUCTIONS) && defined(__AVX2__)
+    auto vsum = _mm256_setzero_pd();
+    for ( ; i + 8 <= data.size(); i += 8) {
+      const auto d = _mm256_sub_ps(_mm256_loadu_ps(data.data() + i), _mm256_set1_ps(fsv));
+      const auto e = exp_avx2(_mm256_mul_ps(_mm256_set1_ps(fc), d));
+      vsum = add_widen_avx2(vsum, _mm256_div_ps(d, _mm256_add_ps(_mm256_set1_ps(1.0f), e)));
+    }
+    const auto half = _mm_add_pd(_mm256_castpd256_pd128(vsum), _mm256_extractf128_pd(vsum, 1));
+    sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+#endif
+    for ( ; i < data.size(); ++i) {
+      const auto d = data[i] - fsv;
+      sum += d / (1 + std::exp(fc * d));
+    }
+    return sum;
+  }
+
+  /**
+   * @brief Computes the sum of (x - sv) * r and the sum of (x - sv)^2 * r * (1 - r),
+   *        where r = 1 / (1 + exp(c * (x - sv))), over the given data
+   *        using vector instructions, if available.
+   */
+  static
+  void
+  logisticSums(
+    const std::vector<double>& data,
+    const double sv,
+    const double c,
+    double& sum,
+    double& slope
+  )
+  {
+    sum = 0.0;
+    slope = 0.0;
+    size_t i = 0u;
+#if defined(HAVE_AVX512BW_INSTRUCTIONS) && defined(__AVX512F__)
+    auto vsum = _mm512_setzero_pd();
+    auto vslope = _mm512_setzero_pd();
+    for ( ; i + 8 <= data.size(); i += 8) {
+      const auto d = _mm512_sub_pd(_mm512_loadu_pd(data.data() + i), _mm512_set1_pd(sv));
+      const auto e = exp_avx512(_mm512_mul_pd(_mm512_set1_pd(c), d));
+      const auto r = _mm512_div_pd(_mm512_set1_pd(1.0), _mm512_add_pd(_mm512_set1_pd(1.0), e));
+      const auto dr = _mm512_mul_pd(d, r);
+      vsum = _mm512_add_pd(vsum, dr);
+      vslope = _mm512_add_pd(vslope, _mm512_mul_pd(_mm512_mul_pd(d, dr), _mm512_sub_pd(_mm512_set1_pd(1.0), r)));
+    }
+    alignas(64) double partial[8];
+    _mm512_store_pd(partial, vsum);
+    for (auto k = 0u; k < 8u; ++k) {
+      sum += partial[k];
+    }
+    _mm512_store_pd(partial, vslope);
+    for (auto k = 0u; k < 8u; ++k) {
+      slope += partial[k];
+    }
+#elif defined(HAVE_AVX2_INSTRUCTIONS) && defined(__AVX2__)
+    auto vsum = _mm256_setzero_pd();
+    auto vslope = _mm256_setzero_pd();
+    for ( ; i + 4 <= data.size(); i += 4) {
+      const auto d = _mm256_sub_pd(_mm256_loadu_pd(data.data() + i), _mm256_set1_pd(sv));
+      const auto e = exp_avx2(_mm256_mul_pd(_mm256_set1_pd(c), d));
+      const auto r = _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_add_pd(_mm256_set1_pd(1.0), e));
+      const auto dr = _mm256_mul_pd(d, r);
+      vsum = _mm256_add_pd(vsum, dr);
+      vslope = _mm256_add_pd(vslope, _mm256_mul_pd(_mm256_mul_pd(d, dr), _mm256_sub_pd(_mm256_set1_pd(1.0), r)));
+    }
+    auto half = _mm_add_pd(_mm256_castpd256_pd128(vsum), _mm256_extractf128_pd(vsum, 1));
+    sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    half = _mm_add_pd(_mm256_castpd256_pd128(vslope), _mm256_extractf128_pd(vslope, 1));
+    slope = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+#endif
+    for ( ; i < data.size(); ++i) {
+      const auto d = data[i] - sv;
+      const auto r = 1 / (1 + exp(c * d));
+      sum += d * r;
+      slope += d * d * r * (1 - r);
+    }
+  }
+
+  /**
+   * @brief Computes the sum of (x - sv) * r and the sum of (x - sv)^2 * r * (1 - r),
+   *        where r = 1 / (1 + exp(c * (x - sv))), over the given single precision data.
+   */
+  static
+  void
+  logisticSums(
+    const std::vector<float>& data,
+    const double sv,
+    const double c,
+    double& sum,
+    double& slope
+  )
+  {
+    sum = 0.0;
+    slope = 0.0;
+    size_t i = 0u;
+    const auto fsv = static_cast<float>(sv);
+    const auto fc = static_cast<float>(c);
+#if defined(HAVE_AVX512BW_INSTRUCTIONS) && defined(__AVX512F__)
+    auto vsum = _mm512_setzero_pd();
+    auto vslope = _mm512_setzero_pd();
+    for ( ; i + 16 <= data.size(); i += 16) {
+      const auto d = _mm512_sub_ps(_mm512_loadu_ps(data.data() + i), _mm512_set1_ps(fsv));
+      const auto e = exp_avx512(_mm512_mul_ps(_mm512_set1_ps(fc), d));
+      const auto r = _mm512_div_ps(_mm512_set1_ps(1.0f), _mm512_add_ps(_mm512_set1_ps(1.0f), e));
+      const auto dr = _mm512_mul_ps(d, r);
+      vsum = add_widen_avx512(vsum, dr);
+      vslope = add_widen_avx512(vslope, _mm512_mul_ps(_mm512_mul_ps(d, dr), _mm512_sub_ps(_mm512_set1_ps(1.0f), r)));
+    }
+    alignas(64) double partial[8];
+    _mm512_store_pd(partial, vsum);
+    for (auto k = 0u; k < 8u; ++k) {
+      sum += partial[k];
+    }
+    _mm512_store_pd(partial, vslope);
+    for (auto k = 0u; k < 8u; ++k) {
+      slope += partial[k];
+    }
+#elif defined(HAVE_AVX2_INSTRUCTIONS) && defined(__AVX2__)
+    auto vsum = _mm256_setzero_pd();
+    auto vslope = _mm256_setzero_pd();
+    for ( ; i + 8 <= data.size(); i += 8) {
+      const auto d = _mm256_sub_ps(_mm256_loadu_ps(data.data() + i), _mm256_set1_ps(fsv));
+      const auto e = exp_avx2(_mm256_mul_ps(_mm256_set1_ps(fc), d));
+      const auto r = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_add_ps(_mm256_set1_ps(1.0f), e));
+      const auto dr = _mm256_mul_ps(d, r);
+      vsum = add_widen_avx2(vsum, dr);
+      vslope = add_widen_avx2(vslope, _mm256_mul_ps(_mm256_mul_ps(d, dr), _mm256_sub_ps(_mm256_set1_ps(1.0f), r)));
+    }
+    auto half = _mm_add_pd(_mm256_castpd256_pd128(vsum), _mm256_extractf128_pd(vsum, 1));
+    sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    half = _mm_add_pd(_mm256_castpd256_pd128(vslope), _mm256_extractf128_pd(vslope, 1));
+    slope = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+#endif
+    for ( ; i < data.size(); ++i) {
+      const auto d = data[i] - fsv;
+      const auto r = 1 / (1 + std::exp(fc * d));
+      sum += d * r;
+      slope += d * d * r * (1 - r);
+    }
+  }
+
+  /**
+   * @brief Computes the sum of log(1 + exp(c * (x - sv)))
+   *        over the given data using vector instructions, if available.
+   *        The terms are computed as max(t, 0) + log1p(exp(-|t|)),
+   *        which does not overflow for large values of t.
+   */
+  static
+  double
+  softplusSum(
+    const std::vector<double>& data,
+    const double sv,
+    const double c
+  )
+  {
+    auto sum = 0.0;
+    size_t i = 0u;
+#if defined(HAVE_AVX512BW_INSTRUCTIONS) && defined(__AVX512F__)
+    auto vsum = _mm512_setzero_pd();
+    for ( ; i + 8 <= data.size(); i += 8) {
+      const auto t = _mm512_mul_pd(_mm512_set1_pd(c), _mm512_sub_pd(_mm512_loadu_pd(data.data() + i), _mm512_set1_pd(sv)));
+      const auto negAbs = _mm512_min_pd(t, _mm512_sub_pd(_mm512_setzero_pd(), t));
+      const auto l = log1p_avx512(exp_avx512(negAbs));
+      vsum = _mm512_add_pd(vsum, _mm512_add_pd(_mm512_max_pd(t, _mm512_setzero_pd()), l));
+    }
+    alignas(64) double partial[8];
+    _mm512_store_pd(partial, vsum);
+    for (auto k = 0u; k < 8u; ++k) {
+      sum += partial[k];
+    }
+#elif defined(HAVE_AVX2_INSTRUCTIONS) && defined(__AVX2__)
+    auto vsum = _mm256_setzero_pd();
+    for ( ; i + 4 <= data.size(); i += 4) {
+      const auto t = _mm256_mul_pd(_mm256_set1_pd(c), _mm256_sub_pd(_mm256_loadu_pd(data.data() + i), _mm256_set1_pd(sv)));
+      const auto negAbs = _mm256_min_pd(t, _mm256_sub_pd(_mm256_setzero_pd(), t));
+      const auto l = log1p_avx2(exp_avx2(negAbs));
+      vsum = _mm256_add_pd(vsum, _mm256_add_pd(_mm256_max_pd(t, _mm256_setzero_pd()), l));
+    }
+    const auto half = _mm_add_pd(_mm256_castpd256_pd128(vsum), _mm256_extractf128_pd(vsum, 1));
+    sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+#endif
+    for ( ; i < data.size(); ++i) {
+      const auto t = c * (data[i] - sv);
+      sum += std::max(t, 0.0) + log1p(exp(-std::abs(t)));
+    }
+    return sum;
+  }
+
+  /**
+   * @brief Computes the sum of log(1 + exp(c * (x - sv)))
+   *        over the given single precision data.
+   */
+  static
+  double
+  softplusSum(
+    const std::vector<float>& data,
+    const double sv,
+    const double c
+  )
+  {
+    auto sum = 0.0;
+    size_t i = 0u;
+    const auto fsv = static_cast<float>(sv);
+    const auto fc = static_cast<float>(c);
+#if defined(HAVE_AVX512BW_INSTRUCTIONS) && defined(__AVX512F__)
+    auto vsum = _mm512_setzero_pd();
+    for ( ; i + 16 <= data.size(); i += 16) {
+      const auto t = _mm512_mul_ps(_mm512_set1_ps(fc), _mm512_sub_ps(_mm512_loadu_ps(data.data() + i), _mm512_set1_ps(fsv)));
+      const auto negAbs = _mm512_min_ps(t, _mm512_sub_ps(_mm512_setzero_ps(), t));
+      const auto l = log1p_avx512(exp_avx512(negAbs));
+      vsum = add_widen_avx512(vsum, _mm512_add_ps(_mm512_max_ps(t, _mm512_setzero_ps()), l));
+    }
+    alignas(64) double partial[8];
+    _mm512_store_pd(partial, vsum);
+    for (auto k = 0u; k < 8u; ++k) {
+      sum += partial[k];
+    }
+#elif defined(HAVE_AVX2_INSTRUCTIONS) && defined(__AVX2__)
+    auto vsum = _mm256_setzero_pd();
+    for ( ; i + 8 <= data.size(); i += 8) {
+      const auto t = _mm256_mul_ps(_mm256_set1_ps(fc), _mm256_sub_ps(_mm256_loadu_ps(data.data() + i), _mm256_set1_ps(fsv)));
+      const auto negAbs = _mm256_min_ps(t, _mm256_sub_ps(_mm256_setzero_ps(), t));
+      const auto l = log1p_avx2(exp_avx2(negAbs));
+      vsum = add_widen_avx2(vsum, _mm256_add_ps(_mm256_max_ps(t, _mm256_setzero_ps()), l));
+    }
+    const auto half = _mm_add_pd(_mm256_castpd256_pd128(vsum), _mm256_extractf128_pd(vsum, 1));
+    sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+#endif
+    for ( ; i < data.size(); ++i) {
+      const auto t = fc * (data[i] - fsv);
+      sum += std::max(t, 0.0f) + std::log1p(std::exp(-std::abs(t)));
+    }
+    return sum;
+  }
+
+private:
+  /**
+   * @brief Appends the given value to the values of a child, if it is not missing.
+   */
+  static
+  void
+  append(
+    const Value x,
+    std::vector<Value>& values,
+    double& sum
+  )
+  {
+    if (!std::isnan(x)) {
+      values.push_back(x);
+      sum += x;
+    }
+  }
+
+  /**
+   * @brief Gathers the values of the given variable for the observations
+   *        of both the children by looking up every observation in its row.
+   */
+  template <typename AnyData>
+  void
+  gather(
+    const AnyData& data,
+    const Var v,
+    const ObsSet& firstObs,
+    const ObsSet& secondObs
+  )
+  {
+    auto values = data.row(v);
+    for (const auto o : firstObs) {
+      append(values[o], m_data.first, m_sum.first);
+    }
+    for (const auto o : secondObs) {
+      append(values[o], m_data.second, m_sum.second);
+    }
+  }
+
+  /**
+   * @brief Gathers the values of the given variable for the observations
+   *        of both the children by merging its stored values with the
+   *        observations, which are both sorted, instead of searching for
+   *        every observation in the stored values. The observations which
+   *        are not stored are zeros.
+   */
+  template <typename DataType, typename DataVar, typename DataObs>
+  void
+  gather(
+    const SparseData<DataType, DataVar, DataObs>& data,
+    const Var v,
+    const ObsSet& firstObs,
+    const ObsSet& secondObs
+  )
+  {
+    auto firstIt = firstObs.begin();
+    auto secondIt = secondObs.begin();
+    auto merge = [] (auto& it, const auto& end, const Obs o, const Value x, std::vector<Value>& values, double& sum) {
+                   for ( ; (it != end) && (*it < o); ++it) {
+                     append(static_cast<Value>(0), values, sum);
+                   }
+                   if ((it != end) && (*it == o)) {
+                     append(x, values, sum);
+                     ++it;
+                   }
+                 };
+    data.forEachStored(v,
+                       [this, &firstIt, &secondIt, &firstObs, &secondObs, &merge] (const Obs o, const Value x) {
+                         merge(firstIt, firstObs.end(), o, x, m_data.first, m_sum.first);
+                         merge(secondIt, secondObs.end(), o, x, m_data.second, m_sum.second);
+                       });
+    for ( ; firstIt != firstObs.end(); ++firstIt) {
+      append(static_cast<Value>(0), m_data.first, m_sum.first);
+    }
+    for ( ; secondIt != secondObs.end(); ++secondIt) {
+      append(static_cast<Value>(0), m_data.second, m_sum.second);
+    }
+  }
+
+private:
+  std::pair<std::vector<Value>, std::vector<Value>> m_data;
   std::pair<double, double> m_sum;
   std::pair<uint32_t, uint32_t> m_missing;
   std::string m_varName;
-}; // class Assignment<Data, Var, Set>
+  const bool m_fastMath;
+}; // class Assignment<Data, Var, VarSet, Obs, ObsSet>
 
 #endif // DETAIL_ASSIGNMENT_HPP_
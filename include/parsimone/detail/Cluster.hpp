@@ -40,7 +40,8 @@ public:
     const Data& data,
     const Var max
   ) : m_elements(max),
-      m_data(data)
+      m_data(data),
+      m_version(0)
   {
   }
 
@@ -48,13 +49,15 @@ public:
     const Data& data,
     const Set& elements
   ) : m_elements(elements),
-      m_data(data)
+      m_data(data),
+      m_version(0)
   {
   }
 
   Cluster(const Cluster& other)
     : m_elements(other.m_elements),
-      m_data(other.m_data)
+      m_data(other.m_data),
+      m_version(other.m_version)
   {
   }
 
@@ -62,7 +65,8 @@ public:
     const Cluster& first,
     const Cluster& second
   ) : m_elements(set_union(first.m_elements, second.m_elements)),
-      m_data(first.m_data)
+      m_data(first.m_data),
+      m_version(0)
   {
   }
 
@@ -71,24 +75,28 @@ public:
   {
     // Merge the elements from the other cluster into this cluster
     m_elements = set_union(m_elements, other.m_elements);
+    ++m_version;
   }
 
   void
   insert(const Var e)
   {
     m_elements.insert(e);
+    ++m_version;
   }
 
   void
   erase(const Var e)
   {
     m_elements.erase(e);
+    ++m_version;
   }
 
   void
   clear()
   {
     m_elements.clear();
+    ++m_version;
   }
 
   bool
@@ -115,6 +123,12 @@ public:
     return m_elements;
   }
 
+  uint64_t
+  version() const
+  {
+    return m_version;
+  }
+
   ~Cluster()
   {
   }
@@ -128,6 +142,8 @@ public:
 protected:
   Set m_elements;
   const Data& m_data;
+  // Incremented every time the elements of this cluster are modified
+  uint64_t m_version;
 }; // class Cluster
 
 /**
@@ -0,0 +1,322 @@
+/**
+ * @file ClusterStatistics.hpp
+ * @brief Implementation of the structure-of-arrays storage
+ *        for the statistics of secondary clusters.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DETAIL_CLUSTERSTATISTICS_HPP_
+#define DETAIL_CLUSTERSTATISTICS_HPP_
+
+#include "LogLikelihood.hpp"
+
+#include <tuple>
+#include <vector>
+
+
+/**
+ * @brief Class that stores the statistics and the scores of a sequence of
+ *        clusters in separate contiguous arrays, indexed by the position
+ *        of the clusters, so that the scores for the candidate clusters
+ *        can be computed in tight loops.
+ */
+class ClusterStatistics {
+public:
+  ClusterStatistics();
+
+  ~ClusterStatistics();
+
+  void
+  clear();
+
+  void
+  push_back(const std::tuple<double, double, double, uint64_t>&);
+
+  void
+  erase(const size_t);
+
+  size_t
+  size() const;
+
+  double
+  score(const size_t) const;
+
+  std::tuple<double, double, double, uint64_t>
+  state(const size_t) const;
+
+  void
+  insert(const size_t, const double, const double, const uint32_t);
+
+  void
+  remove(const size_t, const double, const double, const uint32_t);
+
+  void
+  merge(const size_t, const size_t);
+
+  void
+  scoreInsertDiffs(const size_t, const size_t, const double, const double, const uint32_t, const double, double* const) const;
+
+  void
+  scoreMergeDiffs(const size_t, const size_t, const size_t, double* const) const;
+
+private:
+  std::vector<double> m_score;
+  std::vector<double> m_sum;
+  std::vector<double> m_sum2;
+  std::vector<uint32_t> m_count;
+}; // class ClusterStatistics
+
+/**
+ * @brief Constructs empty statistics.
+ */
+inline
+ClusterStatistics::ClusterStatistics(
+) : m_score(),
+    m_sum(),
+    m_sum2(),
+    m_count()
+{
+}
+
+/**
+ * @brief Default destructor.
+ */
+inline
+ClusterStatistics::~ClusterStatistics(
+)
+{
+}
+
+/**
+ * @brief Removes the statistics of all the clusters.
+ */
+inline
+void
+ClusterStatistics::clear(
+)
+{
+  m_score.clear();
+  m_sum.clear();
+  m_sum2.clear();
+  m_count.clear();
+}
+
+/**
+ * @brief Appends the statistics of a cluster.
+ *
+ * @param state A tuple with the score, the sum, the sum of squares,
+ *              and the count of the cluster.
+ */
+inline
+void
+ClusterStatistics::push_back(
+  const std::tuple<double, double, double, uint64_t>& state
+)
+{
+  m_score.push_back(std::get<0>(state));
+  m_sum.push_back(std::get<1>(state));
+  m_sum2.push_back(std::get<2>(state));
+  m_count.push_back(static_cast<uint32_t>(std::get<3>(state)));
+}
+
+/**
+ * @brief Erases the statistics of the cluster at the given position.
+ *
+ * @param pos The position of the cluster.
+ */
+inline
+void
+ClusterStatistics::erase(
+  const size_t pos
+)
+{
+  m_score.erase(m_score.begin() + pos);
+  m_sum.erase(m_sum.begin() + pos);
+  m_sum2.erase(m_sum2.begin() + pos);
+  m_count.erase(m_count.begin() + pos);
+}
+
+/**
+ * @brief Returns the number of clusters.
+ */
+inline
+size_t
+ClusterStatistics::size(
+) const
+{
+  return m_score.size();
+}
+
+/**
+ * @brief Returns the score of the cluster at the given position.
+ *
+ * @param pos The position of the cluster.
+ */
+inline
+double
+ClusterStatistics::score(
+  const size_t pos
+) const
+{
+  return m_score[pos];
+}
+
+/**
+ * @brief Returns the statistics of the cluster at the given position.
+ *
+ * @param pos The position of the cluster.
+ *
+ * @return A tuple with the score, the sum, the sum of squares,
+ *         and the count of the cluster.
+ */
+inline
+std::tuple<double, double, double, uint64_t>
+ClusterStatistics::state(
+  const size_t pos
+) const
+{
+  return std::make_tuple(m_score[pos], m_sum[pos], m_sum2[pos], static_cast<uint64_t>(m_count[pos]));
+}
+
+/**
+ * @brief Adds the given statistics to the cluster at the given position
+ *        and updates the score of the cluster.
+ *
+ * @param pos The position of the cluster.
+ * @param sum The sum to be added.
+ * @param sum2 The sum of squares to be added.
+ * @param count The count to be added.
+ */
+inline
+void
+ClusterStatistics::insert(
+  const size_t pos,
+  const double sum,
+  const double sum2,
+  const uint32_t count
+)
+{
+  m_score[pos] = computeLogLikelihood(m_count[pos] + count, m_sum[pos] + sum, m_sum2[pos] + sum2);
+  m_sum[pos] += sum;
+  m_sum2[pos] += sum2;
+  m_count[pos] += count;
+}
+
+/**
+ * @brief Subtracts the given statistics from the cluster at the given position
+ *        and updates the score of the cluster.
+ *
+ * @param pos The position of the cluster.
+ * @param sum The sum to be subtracted.
+ * @param sum2 The sum of squares to be subtracted.
+ * @param count The count to be subtracted.
+ */
+inline
+void
+ClusterStatistics::remove(
+  const size_t pos,
+  const double sum,
+  const double sum2,
+  const uint32_t count
+)
+{
+  m_score[pos] = computeLogLikelihood(m_count[pos] - count, m_sum[pos] - sum, m_sum2[pos] - sum2);
+  m_sum[pos] -= sum;
+  m_sum2[pos] -= sum2;
+  m_count[pos] -= count;
+}
+
+/**
+ * @brief Adds the statistics of another cluster to the cluster
+ *        at the given position and updates the score of the cluster.
+ *
+ * @param pos The position of the cluster.
+ * @param other The position of the cluster to be merged.
+ */
+inline
+void
+ClusterStatistics::merge(
+  const size_t pos,
+  const size_t other
+)
+{
+  this->insert(pos, m_sum[other], m_sum2[other], m_count[other]);
+}
+
+/**
+ * @brief Computes the change in the score of each cluster in the given range
+ *        when the given statistics are added to it, relative to the sum of
+ *        the current score of the cluster and the given base score.
+ *
+ * @param first The position of the first cluster in the range.
+ * @param last The position after the last cluster in the range.
+ * @param sum The sum to be added.
+ * @param sum2 The sum of squares to be added.
+ * @param count The count to be added.
+ * @param baseScore The score of the statistics to be added.
+ * @param out Pointer to the beginning of the output array.
+ */
+inline
+void
+ClusterStatistics::scoreInsertDiffs(
+  const size_t first,
+  const size_t last,
+  const double sum,
+  const double sum2,
+  const uint32_t count,
+  const double baseScore,
+  double* const out
+) const
+{
+  computeLogLikelihoods(last - first, m_count.data() + first, m_sum.data() + first, m_sum2.data() + first,
+                        out, count, sum, sum2);
+  for (auto pos = first; pos < last; ++pos) {
+    out[pos - first] -= (m_score[pos] + baseScore);
+  }
+}
+
+/**
+ * @brief Computes the change in the score of each cluster in the given range
+ *        when the given cluster is merged with it. The change is zero for
+ *        the given cluster itself.
+ *
+ * @param first The position of the first cluster in the range.
+ * @param last The position after the last cluster in the range.
+ * @param given The position of the cluster to be merged.
+ * @param out Pointer to the beginning of the output array.
+ */
+inline
+void
+ClusterStatistics::scoreMergeDiffs(
+  const size_t first,
+  const size_t last,
+  const size_t given,
+  double* const out
+) const
+{
+  computeLogLikelihoods(last - first, m_count.data() + first, m_sum.data() + first, m_sum2.data() + first,
+                        out, m_count[given], m_sum[given], m_sum2[given]);
+  const auto givenScore = m_score[given];
+  for (auto pos = first; pos < last; ++pos) {
+    if (pos != given) {
+      out[pos - first] -= (m_score[pos] + givenScore);
+    }
+    else {
+      out[pos - first] = 0.0;
+    }
+  }
+}
+
+#endif // DETAIL_CLUSTERSTATISTICS_HPP_
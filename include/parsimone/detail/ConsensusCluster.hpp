@@ -303,7 +303,11 @@ fillCoclusteringWeights(
     }
     varClusterMaps.push_back(thisMap);
   }
-  for (auto u = 0u; u < n; ++u) {
+  // The weights for different rows are computed in parallel threads,
+  // and then filled in the matrix, which is not thread-safe
+  std::vector<std::vector<std::pair<Var, double>>> rowWeights(n);
+  #pragma omp parallel for schedule(dynamic)
+  for (Var u = 0u; u < n; ++u) {
     for (auto v = u + 1; v < n; ++v) {
       auto cooccurrence = 0u;
       for (const auto& varCluster : varClusterMaps) {
@@ -313,11 +317,16 @@ fillCoclusteringWeights(
       }
       auto weight = static_cast<double>(cooccurrence) / sampledClusters.size();
       if (std::isgreater(weight, minWeight)) {
-        C(u, v) = weight;
-        C(v, u) = weight;
+        rowWeights[u].emplace_back(v, weight);
       }
     }
   }
+  for (Var u = 0u; u < n; ++u) {
+    for (const auto& vw : rowWeights[u]) {
+      C(u, vw.first) = vw.second;
+      C(vw.first, u) = vw.second;
+    }
+  }
 }
 
 template <typename Var, typename Set>
@@ -21,6 +21,10 @@
 #define DETAIL_GANESH_HPP_
 
 #include "PrimaryCluster.hpp"
+#include "RowStatisticsCache.hpp"
+#include "SlotVector.hpp"
+
+#include <memory>
 
 
 /**
@@ -29,12 +33,14 @@
  *
  * @tparam Data Type of the object which is used for querying the data.
  * @tparam Var Type of variable indices (expected to be an integer type).
- * @tparam Set Type of set container.
+ * @tparam VarSet Type of set container for the variables.
+ * @tparam Obs Type of observation indices (expected to be an integer type).
+ * @tparam ObsSet Type of set container for the observations.
  */
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 class Ganesh {
 public:
-  Ganesh(const Data&);
+  Ganesh(const Data&, const uint64_t = 0);
 
   ~Ganesh();
 
@@ -44,7 +50,7 @@ public:
 
   template <typename Generator>
   void
-  initializeGiven(Generator&, const std::list<Set>&);
+  initializeGiven(Generator&, const std::list<VarSet>&);
 
   template <typename Generator>
   void
@@ -54,17 +60,23 @@ public:
   void
   clusterSecondary(Generator&, const mxx::comm* const = nullptr, const uint32_t = 1);
 
-  const std::list<PrimaryCluster<Data, Var, Set>>&
+  const SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>&
   primaryClusters() const;
 
 private:
   template <typename Generator>
   void
-  initializeSecondaryRandom(Generator&, const Var);
+  initializeSecondaryRandom(Generator&, const Obs);
 
   void
   removeEmptyClusters();
 
+  template <typename WeightIt>
+  void
+  scoreInsertDiffs(const typename SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator&,
+                   const typename SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator&,
+                   const Var, const double, WeightIt);
+
   template <typename Generator>
   Var
   chooseReassignCluster(Generator&, const Var, const double);
@@ -79,50 +91,59 @@ private:
 
   template <typename Generator>
   Var
-  chooseMergeCluster(Generator&, const typename std::list<PrimaryCluster<Data, Var, Set>>::iterator&);
+  chooseMergeCluster(Generator&, const typename SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator&);
 
   template <typename Generator>
   Var
-  chooseMergeCluster(Generator&, const mxx::comm&, const typename std::list<PrimaryCluster<Data, Var, Set>>::iterator&);
+  chooseMergeCluster(Generator&, const mxx::comm&, const typename SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator&);
 
   template <typename Generator>
   bool
-  mergeCluster(Generator&, const mxx::comm&, typename std::list<PrimaryCluster<Data, Var, Set>>::iterator&);
+  mergeCluster(Generator&, const mxx::comm&, typename SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator&);
 
   template <typename Generator>
   void
   clusterPrimary(Generator&, const mxx::comm&);
 
 private:
-  std::list<PrimaryCluster<Data, Var, Set>> m_cluster;
-  std::vector<typename std::list<PrimaryCluster<Data, Var, Set>>::iterator> m_membership;
+  SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>> m_cluster;
+  std::vector<typename SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>::Id> m_membership;
+  std::unique_ptr<RowStatisticsCache<Var>> m_rowCache;
   const Data& m_data;
 }; // class Ganesh
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Constructs a Gibbs clustering object.
  *
  * @param data The data provider.
+ * @param rowCacheSize Maximum number of entries in the cache of the statistics
+ *                     of primary variables over secondary clusters; the cache
+ *                     is not used if this is zero.
  */
-Ganesh<Data, Var, Set>::Ganesh(
-  const Data& data
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::Ganesh(
+  const Data& data,
+  const uint64_t rowCacheSize
 ) : m_cluster(),
     m_membership(),
+    m_rowCache(),
     m_data(data)
 {
+  if (rowCacheSize > 0) {
+    m_rowCache.reset(new RowStatisticsCache<Var>(rowCacheSize));
+  }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Default destructor.
  */
-Ganesh<Data, Var, Set>::~Ganesh(
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::~Ganesh(
 )
 {
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Randomly initializes the secondary clusters
  *        for all the primary clusters.
@@ -132,9 +153,9 @@ template <typename Data, typename Var, typename Set>
  */
 template <typename Generator>
 void
-Ganesh<Data, Var, Set>::initializeSecondaryRandom(
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::initializeSecondaryRandom(
   Generator& generator,
-  const Var numSecondaryClusters
+  const Obs numSecondaryClusters
 )
 {
   for (auto& cluster : m_cluster) {
@@ -142,7 +163,7 @@ Ganesh<Data, Var, Set>::initializeSecondaryRandom(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Randomly initializes the primary clusters and
  *        the corresponding secondary clusters.
@@ -152,7 +173,7 @@ template <typename Data, typename Var, typename Set>
  */
 template <typename Generator>
 void
-Ganesh<Data, Var, Set>::initializeRandom(
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::initializeRandom(
   Generator& generator,
   const Var numPrimary
 )
@@ -160,36 +181,36 @@ Ganesh<Data, Var, Set>::initializeRandom(
   const auto n = m_data.numVars();
   const auto m = m_data.numObs();
   LOG_MESSAGE(info, "Randomly assigning primary variables to %u clusters", static_cast<uint32_t>(numPrimary));
-  std::vector<PrimaryCluster<Data, Var, Set>> cluster(numPrimary, PrimaryCluster<Data, Var, Set>(m_data, n, m));
+  std::vector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>> cluster(numPrimary, PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>(m_data, n, m));
   trng::uniform_int_dist clusterDistrib(0, numPrimary);
   for (Var e = 0; e < n; ++e) {
     // Pick a cluster uniformly at random
     auto c = clusterDistrib(generator);
     cluster[c].insert(e);
   }
-  m_cluster = std::list<PrimaryCluster<Data, Var, Set>>(cluster.begin(), cluster.end());
+  m_cluster = SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>(cluster.begin(), cluster.end());
   this->removeEmptyClusters();
-  m_membership.resize(n, m_cluster.end());
+  m_membership.resize(n, SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>::none);
   for (auto cIt = m_cluster.begin(); cIt != m_cluster.end(); ++cIt) {
     for (const auto e : cIt->elements()) {
-      m_membership[e] = cIt;
+      m_membership[e] = cIt.id();
     }
   }
   LOG_MESSAGE(info, "Assigned primary variables to %u clusters", m_cluster.size());
-  auto numSecondaryClusters = static_cast<Var>(sqrt(m));
+  auto numSecondaryClusters = static_cast<Obs>(sqrt(m));
   this->initializeSecondaryRandom(generator, numSecondaryClusters);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Initializes the primary clusters with the given clusters
  *        and randomly initializes the corresponding secondary clusters.
  */
 template <typename Generator>
 void
-Ganesh<Data, Var, Set>::initializeGiven(
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::initializeGiven(
   Generator& generator,
-  const std::list<Set>& givenClusters
+  const std::list<VarSet>& givenClusters
 )
 {
   const auto m = m_data.numObs();
@@ -198,27 +219,63 @@ Ganesh<Data, Var, Set>::initializeGiven(
   for (const auto& cluster : givenClusters) {
     m_cluster.emplace_back(m_data, cluster, m);
   }
-  auto numSecondaryClusters = static_cast<Var>(sqrt(m));
+  auto numSecondaryClusters = static_cast<Obs>(sqrt(m));
   this->initializeSecondaryRandom(generator, numSecondaryClusters);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Removes all the empty primary clusters.
  */
 void
-Ganesh<Data, Var, Set>::removeEmptyClusters(
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::removeEmptyClusters(
 )
 {
-  auto emptyCluster = [] (const PrimaryCluster<Data, Var, Set>& cluster)
+  auto emptyCluster = [] (const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& cluster)
                          { return cluster.empty(); };
   m_cluster.remove_if(emptyCluster);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+template <typename WeightIt>
+/**
+ * @brief Computes the change in the score of each primary cluster in the
+ *        given range when the given primary variable is inserted in it,
+ *        relative to the sum of the current score of the cluster and the
+ *        score of the variable in its separate cluster.
+ *
+ * The clusters are scored in parallel threads; every thread only updates
+ * the cached scores of the clusters that it scores.
+ *
+ * @tparam WeightIt Type of the random access output iterator for the diffs.
+ * @param first Iterator to the first cluster in the range.
+ * @param last Iterator past the last cluster in the range.
+ * @param given The index of the primary variable to be inserted.
+ * @param singleScore The score of the variable in its separate cluster.
+ * @param wIt Output iterator for the diffs.
+ */
+void
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::scoreInsertDiffs(
+  const typename SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator& first,
+  const typename SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator& last,
+  const Var given,
+  const double singleScore,
+  WeightIt wIt
+)
+{
+  const auto numClusters = last - first;
+  #pragma omp parallel for schedule(dynamic)
+  for (auto c = static_cast<decltype(numClusters)>(0); c < numClusters; ++c) {
+    auto& cluster = *(first + c);
+    wIt[c] = cluster.scoreInsertPrimary(given, false, m_rowCache.get()) -
+             (cluster.score() + singleScore);
+  }
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
 Var
-Ganesh<Data, Var, Set>::chooseReassignCluster(
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::chooseReassignCluster(
   Generator& generator,
   const Var given,
   const double singleScore
@@ -228,15 +285,9 @@ Ganesh<Data, Var, Set>::chooseReassignCluster(
   // as well as all the existing clusters
   std::vector<double> weight(m_cluster.size() + 1);
   weight[0] = 1.0;
-  auto maxDiff = weight[0];
-  auto wIt = weight.begin() + 1;
   // Only compute score diffs for existing clusters
-  for (auto cIt = m_cluster.begin(); cIt != m_cluster.end(); ++cIt, ++wIt) {
-    auto thisDiff = cIt->scoreInsertPrimary(given) -
-                    (cIt->score() + singleScore);
-    *wIt = thisDiff;
-    maxDiff = std::max(thisDiff, maxDiff);
-  }
+  this->scoreInsertDiffs(m_cluster.begin(), m_cluster.end(), given, singleScore, weight.begin() + 1);
+  auto maxDiff = *std::max_element(weight.cbegin(), weight.cend());
   for (auto& w : weight) {
     w = exp(w - maxDiff);
   }
@@ -245,10 +296,10 @@ Ganesh<Data, Var, Set>::chooseReassignCluster(
   return distrib(generator);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
 Var
-Ganesh<Data, Var, Set>::chooseReassignCluster(
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::chooseReassignCluster(
   Generator& generator,
   const mxx::comm& comm,
   const Var given,
@@ -267,16 +318,15 @@ Ganesh<Data, Var, Set>::chooseReassignCluster(
     ++wIt;
   }
   // Only compute score diffs for existing clusters
-  for (auto cIt = std::next(m_cluster.begin(), block.eprefix_size()); wIt != myWeights.end(); ++cIt, ++wIt) {
-    auto thisDiff = cIt->scoreInsertPrimary(given) -
-                    (cIt->score() + singleScore);
-    *wIt = thisDiff;
-    myMaxWeight = std::max(thisDiff, myMaxWeight);
+  auto cFirst = std::next(m_cluster.begin(), block.eprefix_size());
+  this->scoreInsertDiffs(cFirst, std::next(cFirst, block.local_size()), given, singleScore, wIt);
+  for ( ; wIt != myWeights.end(); ++wIt) {
+    myMaxWeight = std::max(*wIt, myMaxWeight);
   }
   return distributed_weighted_choose<Var>(generator, comm, std::move(block), std::move(myWeights), myMaxWeight, true);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Moves the given primary variable to a different
  *        primary cluster.
@@ -287,65 +337,63 @@ template <typename Data, typename Var, typename Set>
  */
 template <typename Generator>
 void
-Ganesh<Data, Var, Set>::reassignPrimary(
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::reassignPrimary(
   Generator& generator,
   const mxx::comm& comm,
   const Var given
 )
 {
   LOG_MESSAGE(debug, "Reassigning primary variable %u", static_cast<uint32_t>(given));
-  auto oldCluster = m_membership[given];
-  m_membership[given] = m_cluster.end();
-  // Create a copy of the old cluster to get the same
-  // clustering of the secondary elements
-  PrimaryCluster<Data, Var, Set> newCluster(*oldCluster);
-  // Remove all the primary elements from the copy
-  newCluster.scoreClear();
-  newCluster.clear();
-  // Insert this element as the only primary member of the copy
-  newCluster.insert(given);
-  if (oldCluster->size() > 1) {
+  auto oldId = m_membership[given];
+  m_membership[given] = SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>::none;
+  // Score the variable as the only primary member of a cluster with the
+  // same clustering of the secondary elements as the old cluster
+  // This must be done before the old cluster is modified or removed
+  auto singleScore = m_cluster[oldId].scoreSingle(given, m_rowCache.get());
+  if (m_cluster[oldId].size() > 1) {
     // Remove the element and update the score of the cluster
-    oldCluster->scoreErasePrimary(given, true);
-    oldCluster->erase(given);
+    m_cluster[oldId].scoreErasePrimary(given, true, m_rowCache.get());
+    m_cluster[oldId].erase(given);
   }
   else {
     // Remove the cluster if the var was its only element
     LOG_MESSAGE(debug, "Removing the old cluster of the variable");
-    m_cluster.erase(oldCluster);
+    m_cluster.erase(oldId);
   }
   auto c = m_cluster.size() + 1;
   if (comm.size() == 1) {
-    c = this->chooseReassignCluster(generator, given, newCluster.score());
+    c = this->chooseReassignCluster(generator, given, singleScore);
   }
   else {
-    c = this->chooseReassignCluster(generator, comm, given, newCluster.score());
+    c = this->chooseReassignCluster(generator, comm, given, singleScore);
   }
   if (c == 0) {
     // The variable will stay in its own cluster
+    // Only now create the new cluster for the variable
     LOG_MESSAGE(info, "Primary variable %u assigned to a newly created cluster", static_cast<uint32_t>(given));
-    newCluster.clearSecondary();
-    newCluster.randomSecondary(generator, static_cast<Var>(sqrt(m_data.numObs())));
-    m_cluster.push_back(std::move(newCluster));
-    m_membership[given] = std::prev(m_cluster.end());
+    m_cluster.emplace_back(m_data, m_data.numVars(), m_data.numObs());
+    auto newCluster = std::prev(m_cluster.end());
+    newCluster->insert(given);
+    newCluster->randomSecondary(generator, static_cast<Obs>(sqrt(m_data.numObs())));
+    m_membership[given] = newCluster.id();
   }
   else {
     // Add the variable to the chosen cluster
     LOG_MESSAGE(info, "Primary variable %u assigned to the existing cluster %u",
                       static_cast<uint32_t>(given), static_cast<uint32_t>(c - 1));
     auto chosen = std::next(m_cluster.begin(), c - 1);
-    chosen->scoreInsertPrimary(given, true);
+    chosen->scoreInsertPrimary(given, true, m_rowCache.get());
     chosen->insert(given);
-    m_membership[given] = chosen;
+    m_membership[given] = chosen.id();
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
 Var
-Ganesh<Data, Var, Set>::chooseMergeCluster(
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::chooseMergeCluster(
   Generator& generator,
-  const typename std::list<PrimaryCluster<Data, Var, Set>>::iterator& given
+  const typename SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator& given
 )
 {
   auto givenScore = given->score();
@@ -355,8 +403,8 @@ Ganesh<Data, Var, Set>::chooseMergeCluster(
   auto wIt = weight.begin();
   for (auto cIt = m_cluster.begin(); cIt != m_cluster.end(); ++cIt, ++wIt) {
     if (cIt != given) {
-      PrimaryCluster<Data, Var, Set> merged(*given, *cIt);
-      auto thisDiff = merged.score() - (cIt->score() + givenScore);
+      // Score the merged cluster without creating the merged cluster
+      auto thisDiff = given->scoreMergeSingle(*cIt) - (cIt->score() + givenScore);
       *wIt = exp(thisDiff);
     }
     else {
@@ -368,13 +416,13 @@ Ganesh<Data, Var, Set>::chooseMergeCluster(
   return distrib(generator);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
 Var
-Ganesh<Data, Var, Set>::chooseMergeCluster(
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::chooseMergeCluster(
   Generator& generator,
   const mxx::comm& comm,
-  const typename std::list<PrimaryCluster<Data, Var, Set>>::iterator& given
+  const typename SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator& given
 )
 {
   auto givenScore = given->score();
@@ -384,15 +432,15 @@ Ganesh<Data, Var, Set>::chooseMergeCluster(
   auto cIt = std::next(m_cluster.begin(), block.eprefix_size());
   for (auto c = block.eprefix_size(); c < block.iprefix_size(); ++c, ++cIt, ++wIt) {
     if (cIt != given) {
-      PrimaryCluster<Data, Var, Set> merged(*given, *cIt);
-      auto thisDiff = merged.score() - (cIt->score() + givenScore);
+      // Score the merged cluster without creating the merged cluster
+      auto thisDiff = given->scoreMergeSingle(*cIt) - (cIt->score() + givenScore);
       *wIt = thisDiff;
     }
   }
   return distributed_weighted_choose<Var>(generator, comm, std::move(block), std::move(myWeights));
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Merges the given primary cluster with another primary cluster.
  *
@@ -401,10 +449,10 @@ template <typename Data, typename Var, typename Set>
  */
 template <typename Generator>
 bool
-Ganesh<Data, Var, Set>::mergeCluster(
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::mergeCluster(
   Generator& generator,
   const mxx::comm& comm,
-  typename std::list<PrimaryCluster<Data, Var, Set>>::iterator& given
+  typename SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator& given
 )
 {
   auto c = m_cluster.size();
@@ -420,7 +468,7 @@ Ganesh<Data, Var, Set>::mergeCluster(
     // Merge this cluster with the chosen cluster
     // and update the membership of all the moved elements
     for (const auto e : given->elements()) {
-      m_membership[e] = chosen;
+      m_membership[e] = chosen.id();
     }
     chosen->scoreMerge(*given, true);
     chosen->merge(*given);
@@ -432,7 +480,7 @@ Ganesh<Data, Var, Set>::mergeCluster(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Performs a Gibbs clustering step for the primary variables.
  *
@@ -441,7 +489,7 @@ template <typename Data, typename Var, typename Set>
  */
 template <typename Generator>
 void
-Ganesh<Data, Var, Set>::clusterPrimary(
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::clusterPrimary(
   Generator& generator,
   const mxx::comm& comm
 )
@@ -454,7 +502,13 @@ Ganesh<Data, Var, Set>::clusterPrimary(
     auto v = static_cast<Var>(varDistrib(generator));
     this->reassignPrimary(generator, comm, v);
   }
+  // Compact the clusters once, so that they are accessed
+  // by position in constant time while merging them
+  m_cluster.compact();
   LOG_MESSAGE(info, "Done reassigning primary variables");
+  if (m_rowCache) {
+    LOG_MESSAGE(debug, "Row statistics cache size: %u", m_rowCache->size());
+  }
   // Try to merge clusters
   LOG_MESSAGE(info, "Merging primary clusters (number of clusters = %u)", m_cluster.size());
   for (auto cIt = m_cluster.begin(); (cIt != m_cluster.end()) && (m_cluster.size() > 1); ) {
@@ -465,10 +519,12 @@ Ganesh<Data, Var, Set>::clusterPrimary(
       ++cIt;
     }
   }
+  // The secondary clusters of the primary clusters are learned by position
+  m_cluster.compact();
   LOG_MESSAGE(info, "Done merging primary clusters (number of clusters = %u)", m_cluster.size());
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Performs a Gibbs clustering step for both primary as
  *        well as secondary variables.
@@ -478,7 +534,7 @@ template <typename Data, typename Var, typename Set>
  */
 template <typename Generator>
 void
-Ganesh<Data, Var, Set>::clusterTwoWay(
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::clusterTwoWay(
   Generator& generator,
   const mxx::comm& comm
 )
@@ -489,7 +545,7 @@ Ganesh<Data, Var, Set>::clusterTwoWay(
   this->clusterSecondary(generator, &comm, 50);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Performs a Gibbs clustering step for secondary variables.
  *
@@ -500,7 +556,7 @@ template <typename Data, typename Var, typename Set>
  */
 template <typename Generator>
 void
-Ganesh<Data, Var, Set>::clusterSecondary(
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::clusterSecondary(
   Generator& generator,
   const mxx::comm* const comm,
   const uint32_t numReps
@@ -520,6 +576,7 @@ Ganesh<Data, Var, Set>::clusterSecondary(
       auto cIt = std::next(m_cluster.begin(), myCluster);
       // First, learn secondary clusters for the local primary cluster
       // Each process will call clusterSecondary for just one cluster
+      m_data.prefetch(cIt->elements());
       cIt->clusterSecondary(generator, &clusterComm, numReps);
       // Then, synchronize secondary clusters for all the primary clusters
       cIt = m_cluster.begin();
@@ -540,6 +597,7 @@ Ganesh<Data, Var, Set>::clusterSecondary(
       // First, learn secondary clusters for all the local primary clusters
       auto cIt = std::next(m_cluster.begin(), clusterBlock.eprefix_size());
       for (auto c = clusterBlock.eprefix_size(); c < clusterBlock.iprefix_size(); ++c, ++cIt) {
+        m_data.prefetch(cIt->elements());
         cIt->clusterSecondary(generator, nullptr, numReps);
       }
       // Advance the generator state for next clusters
@@ -551,22 +609,40 @@ Ganesh<Data, Var, Set>::clusterSecondary(
       }
     }
   }
+  else if (((comm == nullptr) || (comm->size() == 1)) && (m_cluster.size() > 1)) {
+    // Learn the secondary clusters for different primary clusters in parallel
+    // threads, in the same way as for different processors; every cluster uses
+    // a copy of the generator advanced to the state for the cluster
+    auto perClusterGenerated = m_data.numObs() * numReps * 3;
+    const auto numClusters = m_cluster.size();
+    auto first = m_cluster.begin();
+    #pragma omp parallel for schedule(dynamic)
+    for (auto c = static_cast<decltype(numClusters)>(0); c < numClusters; ++c) {
+      auto clusterGenerator = generator;
+      ::advance(clusterGenerator, c * perClusterGenerated);
+      m_data.prefetch((first + c)->elements());
+      (first + c)->clusterSecondary(clusterGenerator, nullptr, numReps);
+    }
+    // Advance the generator state for all the clusters
+    ::advance(generator, numClusters * perClusterGenerated);
+  }
   else {
     // There is no way to learn different secondary clusters in parallel
     // We may compute the scores for reassignments and merges in parallel
     for (auto& cluster : m_cluster) {
+      m_data.prefetch(cluster.elements());
       cluster.clusterSecondary(generator, comm, numReps);
     }
   }
   LOG_MESSAGE(info, "Done clustering secondary variables");
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Returns the primary clusters.
  */
-const std::list<PrimaryCluster<Data, Var, Set>>&
-Ganesh<Data, Var, Set>::primaryClusters(
+const SlotVector<PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>>&
+Ganesh<Data, Var, VarSet, Obs, ObsSet>::primaryClusters(
 ) const
 {
   return m_cluster;
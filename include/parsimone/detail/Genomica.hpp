@@ -24,26 +24,26 @@
 #include "utils/Logging.hpp"
 
 
-template <typename Data, typename Var, typename Set>
-Genomica<Data, Var, Set>::Genomica(
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+Genomica<Data, Var, VarSet, Obs, ObsSet>::Genomica(
   const mxx::comm& comm,
   const Data& data
-) : ModuleNetworkLearning<Data, Var, Set>(comm, data)
+) : ModuleNetworkLearning<Data, Var, VarSet, Obs, ObsSet>(comm, data)
 {
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Default destructor.
  */
-Genomica<Data, Var, Set>::~Genomica(
+Genomica<Data, Var, VarSet, Obs, ObsSet>::~Genomica(
 )
 {
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-Genomica<Data, Var, Set>::learnNetwork_sequential(
+Genomica<Data, Var, VarSet, Obs, ObsSet>::learnNetwork_sequential(
   const pt::ptree&,
   const std::string&
 ) const
@@ -51,9 +51,9 @@ Genomica<Data, Var, Set>::learnNetwork_sequential(
   throw NotImplementedError("Genomica: Sequential algorithm is not implemented yet");
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-Genomica<Data, Var, Set>::learnNetwork_parallel(
+Genomica<Data, Var, VarSet, Obs, ObsSet>::learnNetwork_parallel(
   const pt::ptree&,
   const std::string&
 ) const
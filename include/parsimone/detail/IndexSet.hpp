@@ -0,0 +1,302 @@
+/**
+ * @file IndexSet.hpp
+ * @brief Implementation of a set of indices stored as a sorted vector,
+ *        which is used when the indices are too large for a bitset.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DETAIL_INDEXSET_HPP_
+#define DETAIL_INDEXSET_HPP_
+
+#include "mxx/collective.hpp"
+#include "mxx/comm.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+
+/**
+ * @brief Set of unsigned integers in the range [0, max), which provides
+ *        the same interface as UintSet.
+ *
+ * The elements are stored in a sorted vector, so the memory used by a set
+ * is proportional to its size instead of the maximum number of elements.
+ * Membership queries take logarithmic time, and inserting or erasing an
+ * element takes time linear in the size of the set; however, inserting
+ * the elements in increasing order is amortized constant.
+ *
+ * @tparam Element Type of the elements (expected to be an unsigned type).
+ */
+template <typename Element>
+class IndexSet {
+public:
+  static_assert(std::is_unsigned<Element>::value, "Elements of IndexSet must be unsigned");
+
+  using value_type = Element;
+  using size_type = typename std::vector<Element>::size_type;
+  using iterator = typename std::vector<Element>::const_iterator;
+  using const_iterator = iterator;
+
+  explicit
+  IndexSet(
+    const Element max = 0
+  ) : m_elements(),
+      m_max(max)
+  {
+  }
+
+  iterator
+  insert(const Element e)
+  {
+    if (m_elements.empty() || (m_elements.back() < e)) {
+      m_elements.push_back(e);
+      return std::prev(m_elements.cend());
+    }
+    auto it = std::lower_bound(m_elements.begin(), m_elements.end(), e);
+    if ((it == m_elements.end()) || (*it != e)) {
+      it = m_elements.insert(it, e);
+    }
+    return it;
+  }
+
+  iterator
+  insert(const_iterator, const Element e)
+  {
+    // The hint is not needed because appending is already the fast path
+    return insert(e);
+  }
+
+  void
+  erase(const Element e)
+  {
+    auto it = std::lower_bound(m_elements.begin(), m_elements.end(), e);
+    if ((it != m_elements.end()) && (*it == e)) {
+      m_elements.erase(it);
+    }
+  }
+
+  void
+  clear()
+  {
+    m_elements.clear();
+  }
+
+  bool
+  contains(const Element e) const
+  {
+    return std::binary_search(m_elements.begin(), m_elements.end(), e);
+  }
+
+  bool
+  empty() const
+  {
+    return m_elements.empty();
+  }
+
+  Element
+  size() const
+  {
+    return static_cast<Element>(m_elements.size());
+  }
+
+  Element
+  max() const
+  {
+    return m_max;
+  }
+
+  const_iterator
+  begin() const
+  {
+    return m_elements.cbegin();
+  }
+
+  const_iterator
+  end() const
+  {
+    return m_elements.cend();
+  }
+
+  bool
+  operator==(const IndexSet& other) const
+  {
+    return m_elements == other.m_elements;
+  }
+
+  bool
+  operator!=(const IndexSet& other) const
+  {
+    return !(*this == other);
+  }
+
+  ~IndexSet()
+  {
+  }
+
+public:
+  template <typename E>
+  friend
+  IndexSet<E>
+  set_init(IndexSet<E>&&, const E);
+
+  template <typename E>
+  friend
+  IndexSet<E>
+  set_union(const IndexSet<E>&, const IndexSet<E>&);
+
+  template <typename E>
+  friend
+  void
+  set_bcast(std::vector<std::reference_wrapper<IndexSet<E>>>&, const E, const int, const mxx::comm&);
+
+  template <typename E>
+  friend
+  void
+  set_bcast(IndexSet<E>&, const int, const mxx::comm&);
+
+private:
+  std::vector<Element> m_elements;
+  Element m_max;
+}; // class IndexSet
+
+/**
+ * @brief Initializes the given set for storing elements in the range [0, max).
+ */
+template <typename Element>
+IndexSet<Element>
+set_init(
+  IndexSet<Element>&& set,
+  const Element max
+)
+{
+  set.m_max = max;
+  return std::move(set);
+}
+
+/**
+ * @brief Returns the union of the given sets.
+ */
+template <typename Element>
+IndexSet<Element>
+set_union(
+  const IndexSet<Element>& first,
+  const IndexSet<Element>& second
+)
+{
+  IndexSet<Element> result(std::max(first.m_max, second.m_max));
+  result.m_elements.reserve(first.m_elements.size() + second.m_elements.size());
+  std::set_union(first.m_elements.begin(), first.m_elements.end(),
+                 second.m_elements.begin(), second.m_elements.end(),
+                 std::back_inserter(result.m_elements));
+  return result;
+}
+
+/**
+ * @brief Broadcasts the given sets from the source processor.
+ *
+ * The sizes of all the sets are broadcast first, followed by the
+ * elements of all the sets concatenated in one message.
+ *
+ * @param sets References to the sets, which must have the same length on all the processors.
+ * @param max The maximum number of elements in every set.
+ * @param source The rank of the source processor.
+ * @param comm The communicator.
+ */
+template <typename Element>
+void
+set_bcast(
+  std::vector<std::reference_wrapper<IndexSet<Element>>>& sets,
+  const Element max,
+  const int source,
+  const mxx::comm& comm
+)
+{
+  std::vector<uint64_t> sizes(sets.size());
+  if (comm.rank() == source) {
+    std::transform(sets.begin(), sets.end(), sizes.begin(),
+                   [] (const IndexSet<Element>& s) { return s.m_elements.size(); });
+  }
+  mxx::bcast(sizes.data(), sizes.size(), source, comm);
+  std::vector<Element> elements;
+  if (comm.rank() == source) {
+    for (const IndexSet<Element>& s : sets) {
+      elements.insert(elements.end(), s.m_elements.begin(), s.m_elements.end());
+    }
+  }
+  else {
+    elements.resize(std::accumulate(sizes.begin(), sizes.end(), static_cast<uint64_t>(0)));
+  }
+  mxx::bcast(elements.data(), elements.size(), source, comm);
+  if (comm.rank() != source) {
+    auto first = elements.begin();
+    auto sIt = sizes.begin();
+    for (IndexSet<Element>& s : sets) {
+      s.m_max = max;
+      s.m_elements.assign(first, first + *sIt);
+      first += *sIt;
+      ++sIt;
+    }
+  }
+}
+
+/**
+ * @brief Broadcasts the given set from the source processor.
+ *
+ * @param set The set, which is initialized with the same maximum on all the processors.
+ * @param source The rank of the source processor.
+ * @param comm The communicator.
+ */
+template <typename Element>
+void
+set_bcast(
+  IndexSet<Element>& set,
+  const int source,
+  const mxx::comm& comm
+)
+{
+  std::vector<std::reference_wrapper<IndexSet<Element>>> sets(1, std::ref(set));
+  set_bcast(sets, set.m_max, source, comm);
+}
+
+/**
+ * @brief Function for getting the output represention of a set.
+ */
+template <typename Element>
+std::ostream&
+operator<<(
+  std::ostream& stream,
+  const IndexSet<Element>& set
+)
+{
+  stream << "{";
+  auto first = true;
+  for (const auto e : set) {
+    if (!first) {
+      stream << ",";
+    }
+    stream << static_cast<uint64_t>(e);
+    first = false;
+  }
+  stream << "}";
+  return stream;
+}
+
+#endif // DETAIL_INDEXSET_HPP_
@@ -24,8 +24,11 @@
 #include "Ganesh.hpp"
 #include "Module.hpp"
 #include "ConsensusCluster.hpp"
+#include "SharedCounter.hpp"
 
 #include "mxx/distribution.hpp"
+#include "mxx/reduction.hpp"
+#include "mxx/shift.hpp"
 
 #include <boost/filesystem.hpp>
 #include <boost/iostreams/filtering_streambuf.hpp>
@@ -36,11 +39,11 @@
 // PRNG type to be used for generating random numbers
 using PRNG = trng::mrg3s;
 
-template <typename Data, typename Var, typename Set>
-LemonTree<Data, Var, Set>::LemonTree(
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::LemonTree(
   const mxx::comm& comm,
   const Data& data
-) : ModuleNetworkLearning<Data, Var, Set>(comm, data)
+) : ModuleNetworkLearning<Data, Var, VarSet, Obs, ObsSet>(comm, data)
 {
   TIMER_RESET(m_tWrite);
   TIMER_RESET(m_tGanesh);
@@ -49,11 +52,11 @@ LemonTree<Data, Var, Set>::LemonTree(
   TIMER_RESET(m_tSync);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Default destructor.
  */
-LemonTree<Data, Var, Set>::~LemonTree(
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::~LemonTree(
 )
 {
   if (this->m_comm.is_first()) {
@@ -65,10 +68,10 @@ LemonTree<Data, Var, Set>::~LemonTree(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
-std::list<Set>
-LemonTree<Data, Var, Set>::singleGaneshRun(
+std::list<VarSet>
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::singleGaneshRun(
   Generator& generator,
   const pt::ptree& ganeshConfigs,
   const mxx::comm& comm
@@ -79,7 +82,8 @@ LemonTree<Data, Var, Set>::singleGaneshRun(
   if ((initClusters == 0) || (initClusters > this->m_data.numVars())) {
     initClusters = this->m_data.numVars() / 2;
   }
-  Ganesh<Data, Var, Set> ganesh(this->m_data);
+  auto rowCacheSize = ganeshConfigs.get<uint64_t>("row_cache_size", 0);
+  Ganesh<Data, Var, VarSet, Obs, ObsSet> ganesh(this->m_data, rowCacheSize);
   ganesh.initializeRandom(generator, initClusters);
   for (auto s = 0u; s <= numSteps; ++s) {
     LOG_MESSAGE(info, "Step %u", s);
@@ -92,24 +96,24 @@ LemonTree<Data, Var, Set>::singleGaneshRun(
   // have any effect on the outcome
   LOG_MESSAGE(info, "Sampling");
   const auto& primaryClusters = ganesh.primaryClusters();
-  std::list<Set> varClusters;
+  std::list<VarSet> varClusters;
   for (const auto& cluster : primaryClusters) {
     varClusters.push_back(cluster.elements());
   }
   return varClusters;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
-std::list<std::list<Set>>
-LemonTree<Data, Var, Set>::clusterVarsGanesh(
+std::list<std::list<VarSet>>
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::clusterVarsGanesh(
   const pt::ptree& ganeshConfigs
 ) const
 {
   auto randomSeed = ganeshConfigs.get<uint64_t>("seed");
   auto numRuns = ganeshConfigs.get<uint32_t>("num_runs");
   Generator generator;
-  std::list<std::list<Set>> sampledClusters;
+  std::list<std::list<VarSet>> sampledClusters;
   if ((numRuns > 1) && (static_cast<uint32_t>(this->m_comm.size()) >= numRuns)) {
     // Split the communicator with one or more processes per run
     mxx::blk_dist commBlock(this->m_comm.size(), numRuns, 0);
@@ -125,9 +129,9 @@ LemonTree<Data, Var, Set>::clusterVarsGanesh(
       auto clusterSize = cluster.size();
       mxx::bcast(clusterSize, commBlock.eprefix_size(r), this->m_comm);
       cluster.resize(clusterSize);
-      std::vector<std::reference_wrapper<Set>> clusterRefs;
+      std::vector<std::reference_wrapper<VarSet>> clusterRefs;
       std::transform(cluster.begin(), cluster.end(), std::back_inserter(clusterRefs),
-                     [] (Set& c) { return std::ref(c); });
+                     [] (VarSet& c) { return std::ref(c); });
       set_bcast(clusterRefs, this->m_data.numVars(), commBlock.eprefix_size(r), this->m_comm);
       ++r;
     }
@@ -145,11 +149,11 @@ LemonTree<Data, Var, Set>::clusterVarsGanesh(
   return sampledClusters;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-LemonTree<Data, Var, Set>::writeVarClusters(
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::writeVarClusters(
   const std::string& clusterFile,
-  const std::list<std::list<Set>>& varClusters
+  const std::list<std::list<VarSet>>& varClusters
 ) const
 {
   LOG_MESSAGE(info, "Writing variable clusters to %s", clusterFile);
@@ -168,10 +172,10 @@ LemonTree<Data, Var, Set>::writeVarClusters(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 std::multimap<Var, Var>
-LemonTree<Data, Var, Set>::clusterConsensus(
-  const std::list<std::list<Set>>&& varClusters,
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::clusterConsensus(
+  const std::list<std::list<VarSet>>&& varClusters,
   const pt::ptree& consensusConfigs
 ) const
 {
@@ -185,9 +189,9 @@ LemonTree<Data, Var, Set>::clusterConsensus(
   return result;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-LemonTree<Data, Var, Set>::writeConsensusCluster(
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::writeConsensusCluster(
   const std::string& consensusFile,
   const std::multimap<Var, Var>& vertexClusters
 ) const
@@ -200,22 +204,24 @@ LemonTree<Data, Var, Set>::writeConsensusCluster(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
-std::list<std::list<Set>>
-LemonTree<Data, Var, Set>::clusterObsGanesh(
+std::list<std::list<ObsSet>>
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::clusterObsGanesh(
   const uint32_t numRuns,
   const uint32_t numSteps,
   const uint32_t burnSteps,
   const uint32_t sampleSteps,
   Generator& generator,
-  const Set& clusterVars
+  const VarSet& clusterVars
 ) const
 {
-  std::list<std::list<Set>> sampledClusters;
+  std::list<std::list<ObsSet>> sampledClusters;
+  // All the secondary clustering steps only query the variables in this cluster
+  this->m_data.prefetch(clusterVars);
   // Initialize Gibbs sampler algorithm for this cluster
-  Ganesh<Data, Var, Set> ganesh(this->m_data);
-  ganesh.initializeGiven(generator, std::list<Set>(1, clusterVars));
+  Ganesh<Data, Var, VarSet, Obs, ObsSet> ganesh(this->m_data);
+  ganesh.initializeGiven(generator, std::list<VarSet>(1, clusterVars));
   for (auto r = 0u; r < numRuns; ++r) {
     auto s = 0u;
     for ( ; s < burnSteps; ++s) {
@@ -230,7 +236,7 @@ LemonTree<Data, Var, Set>::clusterObsGanesh(
         // There should be only one primary cluster; get a reference to it
         const auto& primaryCluster = ganesh.primaryClusters().front();
         const auto& secondaryClusters = primaryCluster.secondaryClusters();
-        std::list<Set> obsClusters;
+        std::list<ObsSet> obsClusters;
         for (const auto& cluster : secondaryClusters) {
           obsClusters.push_back(cluster.elements());
         }
@@ -241,11 +247,11 @@ LemonTree<Data, Var, Set>::clusterObsGanesh(
   return sampledClusters;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-LemonTree<Data, Var, Set>::readCandidateParents(
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::readCandidateParents(
   const std::string& fileName,
-  Set& candidateParents
+  VarSet& candidateParents
 ) const
 {
   LOG_MESSAGE(info, "Reading candidate parents from %s", fileName);
@@ -260,10 +266,41 @@ LemonTree<Data, Var, Set>::readCandidateParents(
   LOG_MESSAGE(info, "Read %u candidate parents", candidateParents.size());
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+OptimalBeta
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::optimalBeta(
+  const pt::ptree& modulesConfigs
+) const
+{
+  auto betaMax = modulesConfigs.get<double>("beta_reg");
+  auto accuracy = modulesConfigs.get<std::string>("accuracy", "strict");
+  if ((accuracy != "strict") && (accuracy != "fast")) {
+    throw std::runtime_error("Unknown accuracy mode " + accuracy + ". Supported modes are: {strict, fast}");
+  }
+  auto solverName = modulesConfigs.get<std::string>("beta_solver", "bisection");
+  auto solver = OptimalBeta::Solver::Bisection;
+  if (solverName == "newton") {
+    solver = OptimalBeta::Solver::Newton;
+  }
+  else if (solverName != "bisection") {
+    throw std::runtime_error("Unknown beta solver " + solverName + ". Supported solvers are: {bisection, newton}");
+  }
+  auto evaluation = modulesConfigs.get<std::string>("split_evaluation", "independent");
+  if ((evaluation != "independent") && (evaluation != "sweep")) {
+    throw std::runtime_error("Unknown split evaluation " + evaluation + ". Supported evaluations are: {independent, sweep}");
+  }
+  LOG_MESSAGE(info, "Using %s accuracy mode, %s solver, and %s evaluation for parent splits",
+                    accuracy, solverName, evaluation);
+  // The original implementation compared the width of the bracket, truncated
+  // to an integer, with an accuracy of 1e-5; the same betas are found by
+  // comparing the width itself with an accuracy of one
+  return OptimalBeta(0.0, betaMax, 1.0, (accuracy == "fast"), solver, (evaluation == "sweep"));
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
-std::list<Module<Data, Var, Set>>
-LemonTree<Data, Var, Set>::constructModulesWithTrees(
+std::list<Module<Data, Var, VarSet, Obs, ObsSet>>
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::constructModulesWithTrees(
   const std::multimap<Var, Var>&& coClusters,
   Generator& generator,
   const pt::ptree& modulesConfigs
@@ -275,14 +312,14 @@ LemonTree<Data, Var, Set>::constructModulesWithTrees(
   auto sampleSteps = modulesConfigs.get<uint32_t>("sample_steps");
   auto scoreBHC = modulesConfigs.get<bool>("use_bayesian_score", true);
   auto scoreGain = modulesConfigs.get<double>("score_gain");
-  std::list<Module<Data, Var, Set>> modules;
+  std::list<Module<Data, Var, VarSet, Obs, ObsSet>> modules;
   auto m = 0u;
   for (auto cit = coClusters.begin(); cit != coClusters.end(); ++m) {
     LOG_MESSAGE(info, "Module %u: Learning tree structures", m);
     // Get the range of variables in this cluster
     auto clusterIts = coClusters.equal_range(cit->first);
     // Add all the variables in the cluster to a set
-    auto clusterVars = Set(this->m_data.numVars());
+    auto clusterVars = VarSet(this->m_data.numVars());
     for (auto vit = clusterIts.first; vit != clusterIts.second; ++vit) {
       clusterVars.insert(vit->second);
     }
@@ -299,19 +336,21 @@ LemonTree<Data, Var, Set>::constructModulesWithTrees(
   return modules;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
 void
-LemonTree<Data, Var, Set>::learnModulesParents(
-  std::list<Module<Data, Var, Set>>& modules,
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::learnModulesParents(
+  std::list<Module<Data, Var, VarSet, Obs, ObsSet>>& modules,
   Generator& generator,
   const pt::ptree& modulesConfigs
 ) const
 {
   auto regFile = modulesConfigs.get<std::string>("reg_file");
-  auto betaMax = modulesConfigs.get<double>("beta_reg");
   auto numSplits = modulesConfigs.get<uint32_t>("num_reg");
-  Set candidateParents(this->m_data.numVars());
+  if (numSplits == 0) {
+    throw std::runtime_error("The number of parent splits to be sampled must be positive");
+  }
+  VarSet candidateParents(this->m_data.numVars());
   if (!regFile.empty()) {
     // Read candidate parents from the given file
     this->readCandidateParents(regFile, candidateParents);
@@ -322,40 +361,44 @@ LemonTree<Data, Var, Set>::learnModulesParents(
       candidateParents.insert(v);
     }
   }
-  OptimalBeta ob(0.0, betaMax, 1e-5);
+  auto ob = this->optimalBeta(modulesConfigs);
+  auto streamSplits = modulesConfigs.get<bool>("stream_splits", false);
   auto m = 0u;
   for (auto moduleIt = modules.begin(); moduleIt != modules.end(); ++moduleIt, ++m) {
     LOG_MESSAGE(info, "Module %u: Learning parents", m);
-    moduleIt->learnParents(generator, candidateParents, ob, numSplits);
+    moduleIt->learnParents(generator, candidateParents, ob, numSplits, streamSplits);
   }
   LOG_MESSAGE(info, "Done learning module parents");
+#if defined(LOGGING) || TIMER
+  this->reportEvaluations(ob, false);
+#endif
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
 void
-LemonTree<Data, Var, Set>::learnModulesParents_nodes(
-  std::list<Module<Data, Var, Set>>& modules,
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::learnModulesParents_nodes(
+  std::list<Module<Data, Var, VarSet, Obs, ObsSet>>& modules,
   Generator& generator,
-  const Set&& candidateParents,
-  const double betaMax,
-  const uint32_t numSplits
+  const VarSet&& candidateParents,
+  const OptimalBeta& ob,
+  const uint32_t numSplits,
+  const bool streamSplits
 ) const
 {
-  OptimalBeta ob(0.0, betaMax, 1e-5);
   std::vector<uint32_t> moduleNodeCount(modules.size());
-  std::vector<uint32_t> moduleNodeWeights;
+  std::vector<uint64_t> moduleNodeWeights;
   auto totalNodes = 0u;
   auto moduleCit = modules.cbegin();
   for (auto m = 0u; m < modules.size(); ++m, ++moduleCit) {
     moduleNodeCount[m] = moduleCit->nodeCount();
-    auto nodeWeights = moduleCit->nodeWeights();
+    auto nodeWeights = moduleCit->nodeSplitWeights(candidateParents);
     moduleNodeWeights.insert(moduleNodeWeights.end(), nodeWeights.begin(), nodeWeights.end());
     totalNodes += moduleNodeCount[m];
   }
   std::vector<uint32_t> moduleNodeCountPrefix(moduleNodeCount.size());
   std::partial_sum(moduleNodeCount.cbegin(), moduleNodeCount.cend(), moduleNodeCountPrefix.begin());
-  std::vector<uint32_t> moduleNodeWeightsPrefix(moduleNodeWeights.size());
+  std::vector<uint64_t> moduleNodeWeightsPrefix(moduleNodeWeights.size());
   std::partial_sum(moduleNodeWeights.cbegin(), moduleNodeWeights.cend(), moduleNodeWeightsPrefix.begin());
   auto totalWeight = moduleNodeWeightsPrefix.back();
   mxx::blk_dist block(totalWeight, this->m_comm.size(), this->m_comm.rank());
@@ -377,7 +420,7 @@ LemonTree<Data, Var, Set>::learnModulesParents_nodes(
   // XXX: We need to track the validity of nodes because some nodes may not learn any splits
   //      and that information will be required for synchornization later
   std::vector<uint8_t> myValidNodes(myNodeCount, 0);
-  std::vector<std::tuple<Var, Var, double>> myNodeSplits(myNodeCount * 2 * numSplits);
+  std::vector<std::tuple<Var, Obs, double>> myNodeSplits(myNodeCount * 2 * numSplits);
   // Find the indices for the modules which contain the first and last node on this rank
   auto myFirstModule = std::distance(moduleNodeCountPrefix.cbegin(),
                                      std::lower_bound(moduleNodeCountPrefix.cbegin(),
@@ -396,7 +439,7 @@ LemonTree<Data, Var, Set>::learnModulesParents_nodes(
     auto numNodes = std::min(static_cast<uint32_t>(myLastNode), moduleNodeCountPrefix[m]) - prevNodeCount;
     if (numNodes > 0) {
       LOG_MESSAGE(info, "Module %u: Learning parents for %u nodes (starting node index = %u)", m, numNodes, firstNode);
-      moduleIt->learnParents(generator, candidateParents, ob, numSplits, firstNode, numNodes, validIt, splitIt);
+      moduleIt->learnParents(generator, candidateParents, ob, numSplits, streamSplits, firstNode, numNodes, validIt, splitIt);
       prevNodeCount += numNodes;
     }
   }
@@ -421,19 +464,19 @@ LemonTree<Data, Var, Set>::learnModulesParents_nodes(
   TIMER_PAUSE(m_tSync);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
 void
-LemonTree<Data, Var, Set>::learnModulesParents_splits(
-  std::list<Module<Data, Var, Set>>& modules,
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::learnModulesParents_splits(
+  std::list<Module<Data, Var, VarSet, Obs, ObsSet>>& modules,
   Generator& generator,
-  const Set&& candidateParents,
-  const double betaMax,
-  const uint32_t numSplits
+  const VarSet&& candidateParents,
+  const OptimalBeta& ob,
+  const uint32_t numSplits,
+  const bool streamSplits
 ) const
 {
   TIMER_DECLARE(tCandidates);
-  OptimalBeta ob(0.0, betaMax, 1e-5);
   std::vector<uint32_t> moduleNodeCount(modules.size());
   std::vector<uint64_t> moduleSplitWeight(modules.size());
   auto moduleCit = modules.cbegin();
@@ -455,7 +498,30 @@ LemonTree<Data, Var, Set>::learnModulesParents_splits(
                                     std::lower_bound(moduleSplitWeightPrefix.cbegin(),
                                                      moduleSplitWeightPrefix.cend(),
                                                      block.iprefix_size()));
-  std::vector<std::tuple<uint32_t, Var, Var, double>> mySplits;
+  std::vector<std::tuple<uint32_t, Var, Obs, double>> mySplits;
+  // Salts of the samplers for all the nodes, used only if the splits are streamed
+  std::vector<uint64_t> nodeSalts;
+  // Samplers for only the nodes which have any splits on this processor
+  std::map<uint32_t, SplitSampler<Var, Obs>> mySamplers;
+  if (streamSplits) {
+    // Salt the sampler for every node using the same random numbers
+    // that the node consumes in the sequential execution
+    nodeSalts.reserve(moduleNodeCountPrefix.back());
+    for (auto n = 0u; n < moduleNodeCountPrefix.back(); ++n) {
+      nodeSalts.push_back(generator());
+      ::advance(generator, 2 * numSplits - 1);
+    }
+  }
+  auto samplerIt = mySamplers.end();
+  auto sampleSplit = [&mySamplers, &samplerIt, &nodeSalts, &numSplits] (const std::tuple<uint32_t, Var, Obs, double>& split)
+                                   { auto n = std::get<0>(split);
+                                     // The splits of a node are streamed together, so look up the sampler only when the node changes
+                                     if ((samplerIt == mySamplers.end()) || (samplerIt->first != n)) {
+                                       samplerIt = mySamplers.try_emplace(n, numSplits, nodeSalts[n]).first;
+                                     }
+                                     samplerIt->second.insert(std::make_tuple(std::get<1>(split),
+                                                                              std::get<2>(split),
+                                                                              std::get<3>(split))); };
   auto moduleIt = std::next(modules.begin(), myFirstModule);
   auto prevWeight = block.eprefix_size();
   TIMER_DECLARE(tSplits);
@@ -464,195 +530,198 @@ LemonTree<Data, Var, Set>::learnModulesParents_splits(
     auto firstWeight = prevWeight - (moduleSplitWeightPrefix[m] - moduleSplitWeight[m]);
     auto maxWeight = std::min(block.iprefix_size(), moduleSplitWeightPrefix[m]) - prevWeight;
     if (maxWeight > 0) {
-      moduleIt->candidateParentsSplits(mySplits, candidateParents, ob, firstNode, firstWeight, maxWeight);
+      if (streamSplits) {
+        moduleIt->candidateParentsSplits(candidateParents, ob, firstNode, firstWeight, maxWeight,
+                                         boost::make_function_output_iterator(std::ref(sampleSplit)));
+      }
+      else {
+        moduleIt->candidateParentsSplits(candidateParents, ob, firstNode, firstWeight, maxWeight,
+                                         std::back_inserter(mySplits));
+      }
       prevWeight += maxWeight;
     }
   }
 #if TIMER
-  auto allSplitsTime = mxx::gather(static_cast<double>(tSplits.elapsed()), 0, this->m_comm);
-  this->m_comm.barrier();
-  if (this->m_comm.is_first()) {
-    TIMER_ELAPSED("Time taken in the split computations: ", tSplits);
-    auto totalTime = 0.0;
-    auto maxTime = 0.0;
-    for (const auto st : allSplitsTime) {
-      totalTime += st;
-      maxTime = std::max(maxTime, st);
+  this->timeSplits(tSplits);
+#endif
+  if (streamSplits) {
+    this->m_comm.barrier();
+    if (this->m_comm.is_first()) {
+      TIMER_ELAPSED("Time taken in learning candidate splits: ", tCandidates);
     }
-    auto avgTime = totalTime / allSplitsTime.size();
-    auto imbalance = (maxTime - avgTime) / avgTime;
-    std::cout << "Imbalance in the split computations: " << imbalance << std::endl;
+    this->syncSampledSplits(modules, mySamplers, moduleNodeCountPrefix.back(), numSplits);
+    return;
   }
-#endif
-  // Redistribute to get the same number of candidate splits on every processor
-  mxx::stable_distribute_inplace(mySplits, this->m_comm);
   this->m_comm.barrier();
   if (this->m_comm.is_first()) {
     TIMER_ELAPSED("Time taken in learning candidate splits: ", tCandidates);
   }
   TIMER_DECLARE(tChoose);
+  // The candidate splits are not redistributed; every processor chooses splits
+  // from the splits that it computed, which are contiguous in the global order
+  // of the splits, using only the per node totals of the weights
+  auto numNodes = moduleNodeCountPrefix.back();
   // Compute the max score for each node across all the processors
-  std::vector<double> mySplitsScoresMax(moduleNodeCountPrefix.back(), std::numeric_limits<double>::lowest());
+  std::vector<double> mySplitsScoresMax(numNodes, std::numeric_limits<double>::lowest());
   std::for_each(mySplits.cbegin(), mySplits.cend(),
-                [&mySplitsScoresMax] (const std::tuple<uint32_t, Var, Var, double>& split)
+                [&mySplitsScoresMax] (const std::tuple<uint32_t, Var, Obs, double>& split)
                                      { mySplitsScoresMax[std::get<0>(split)] = std::max(mySplitsScoresMax[std::get<0>(split)],
                                                                                         std::get<3>(split)); });
   auto allSplitsScoresMax = mxx::allreduce(mySplitsScoresMax, mxx::max<double>(), this->m_comm);
-  // Set of local node indices
-  // XXX: Using set instead of unordered_set because we want sorted indices
-  std::set<uint32_t> myNodeIdx;
-  // Count of node splits on this processor for all the nodes
-  std::vector<uint64_t> mySplitsCounts(moduleNodeCountPrefix.back(), 0);
-  // Vector of <node, weight> for each split, where weight = exp(score)
-  std::vector<std::pair<uint32_t, double>> mySplitsWeights(mySplits.size());
-  // Sum of weights of splits on this processor for all the nodes
-  std::vector<double> mySplitsWeightsSum(moduleNodeCountPrefix.back(), 0);
-  auto s = 0u;
-  auto splitFirst = mySplits.cbegin();
-  while (splitFirst != mySplits.cend()) {
-    auto n = std::get<0>(*splitFirst);
-    myNodeIdx.insert(n);
-    auto splitLast = std::find_if(splitFirst, mySplits.cend(),
-                                  [&n] (const std::tuple<uint32_t, Var, Var, double>& split)
-                                       { return std::get<0>(split) != n; });
-    mySplitsCounts[n] += std::distance(splitFirst, splitLast);
-    auto nodeMaxScore = allSplitsScoresMax[n];
-    for (auto it = splitFirst; it != splitLast; ++it, ++s) {
-      auto weight = exp(std::get<3>(*it) - nodeMaxScore);
-      mySplitsWeights[s] = std::make_pair(n, weight);
-      mySplitsWeightsSum[n] += weight;
-    }
-    splitFirst = splitLast;
+  // Weight of each split on this processor, where weight = exp(score - max score)
+  std::vector<double> mySplitsWeights(mySplits.size());
+  // Count and sum of weights of the splits on this processor for all the nodes
+  std::vector<std::pair<uint64_t, double>> mySplitsTotals(numNodes, std::make_pair(0u, 0.0));
+  for (auto s = 0u; s < mySplits.size(); ++s) {
+    auto n = std::get<0>(mySplits[s]);
+    mySplitsWeights[s] = relativeWeight(std::get<3>(mySplits[s]), allSplitsScoresMax[n]);
+    mySplitsTotals[n].first += 1;
+    mySplitsTotals[n].second += mySplitsWeights[s];
   }
-  // Get the count of splits of the first node on previous processor(s)
-  auto myLastNode = std::get<0>(mySplits.back());
-  auto lastSplitsCount = std::make_pair(myLastNode, mySplitsCounts[myLastNode]);
-  auto addSplitsCount = [] (const std::pair<uint32_t, uint64_t>& a,
-                            const std::pair<uint32_t, uint64_t>& b)
-                           { return (a.first == b.first) ?
-                                    std::make_pair(b.first, a.second + b.second) : b; };
-  auto firstCountsPrefix = mxx::exscan(lastSplitsCount, addSplitsCount, this->m_comm, false);
-  // Get the total count of splits for all the nodes
-  // Also get the sum of the weights of splits for each node on all the processors
-  // XXX: We really only need these for the nodes on this processor
-  //      Can we make it more efficient?
-  auto allSplitsCounts = mxx::allreduce(mySplitsCounts, this->m_comm);
-  auto allSplitsWeightsSum = mxx::allreduce(mySplitsWeightsSum, this->m_comm);
+  auto addSplitsTotals = [] (const std::pair<uint64_t, double>& a,
+                             const std::pair<uint64_t, double>& b)
+                            { return std::make_pair(a.first + b.first, a.second + b.second); };
+  auto allSplitsTotals = mxx::allreduce(mySplitsTotals, addSplitsTotals, this->m_comm);
   // First, handle any nodes with infinite weights
-  static auto findInf = [] (const double w) { return std::isinf(w); };
-  auto infWeightIt = std::find_if(allSplitsWeightsSum.begin(), allSplitsWeightsSum.end(), findInf);
-  while (infWeightIt != allSplitsWeightsSum.end()) {
-    // We have found that the total weight of all the splits for this node is infinite.
-    // Therefore, we want to modify the weights to replicate the following
-    // sequential behaviors of discrete_distribution_safe/std::discrete_distribution
-    // 1) If one or more of the split weights are infinite,
-    //    then always pick the first split with infinite weight
-    // 2) If none of the split weights are infinite,
-    //    then always pick the last split
-    auto n = std::distance(allSplitsWeightsSum.begin(), infWeightIt);
-    if (myNodeIdx.find(n) != myNodeIdx.end()) {
+  // If the total weight of all the splits for a node is infinite, we want to
+  // modify the weights to replicate the following sequential behaviors of
+  // discrete_distribution_safe/std::discrete_distribution
+  // 1) If one or more of the split weights are infinite,
+  //    then always pick the first split with infinite weight
+  // 2) If none of the split weights are infinite,
+  //    then always pick the last split
+  // Setting all infinite split weights to 1.0, the finite weights to 0.0,
+  // and the total weight for the node to 1.0 accomplishes both
+  for (auto s = 0u; s < mySplits.size(); ++s) {
+    if (std::isinf(allSplitsTotals[std::get<0>(mySplits[s])].second)) {
+      mySplitsWeights[s] = std::isinf(mySplitsWeights[s]) ? 1.0 : 0.0;
+    }
+  }
+  for (auto n = 0u; n < numNodes; ++n) {
+    if (std::isinf(allSplitsTotals[n].second)) {
       LOG_MESSAGE(debug, "Node %u: Handling infinite weights", n);
-      static auto nodeSplit = [&n] (const std::pair<uint32_t, double>& split)
-                                   { return split.first == n; };
-      auto splitIt = std::find_if(mySplitsWeights.begin(), mySplitsWeights.end(), nodeSplit);
-      while (splitIt->first == n) {
-        // Set all infinite split weights to 1.0 and the finite weights to 0.0
-        // This will accomplish the two requirements described above
-        splitIt->second = std::isinf(splitIt->second) ? 1.0 : 0.0;
-        ++splitIt;
-      }
+      allSplitsTotals[n].second = 1.0;
     }
-    // Set the total weight for this node to 1.0
-    *infWeightIt = 1.0;
-    infWeightIt = std::find_if(std::next(infWeightIt), allSplitsWeightsSum.end(), findInf);
-  }
-  // Then, normalize the weights for all the local splits
-  auto normalizeWeight = [&allSplitsWeightsSum] (std::pair<uint32_t, double>& split)
-                                                { split.second /= allSplitsWeightsSum[split.first]; };
-  std::for_each(mySplitsWeights.begin(), mySplitsWeights.end(), normalizeWeight);
-  // Perform a segmented parallel prefix on this vector of <node, normalized weight>
-  // with node defining the segment boundaries
-  // This will compute the prefix sum of the normalized split weights belonging to every node
-  std::vector<std::pair<uint32_t, double>> mySplitsWeightsPrefix(mySplitsWeights.size());
-  auto addSplitsWeights = [] (const std::pair<uint32_t, double>& a,
-                              const std::pair<uint32_t, double>& b)
-                             { return (a.first == b.first) ?
-                                      std::make_pair(b.first, a.second + b.second) : b; };
-  mxx::global_scan(mySplitsWeights.begin(), mySplitsWeights.end(),
-                   mySplitsWeightsPrefix.begin(), addSplitsWeights, false, this->m_comm);
+  }
+  // Then, normalize the weights for all the local splits and
+  // recompute the local sums of the weights from the normalized weights
+  for (auto n = 0u; n < numNodes; ++n) {
+    mySplitsTotals[n].second = 0.0;
+  }
+  for (auto s = 0u; s < mySplits.size(); ++s) {
+    auto n = std::get<0>(mySplits[s]);
+    mySplitsWeights[s] /= allSplitsTotals[n].second;
+    mySplitsTotals[n].second += mySplitsWeights[s];
+  }
+  // Only the first and the last node on this processor can have splits on other processors
+  // Perform a segmented scan on <node, count, sum of weights> for the last node on every
+  // processor, with node defining the segment boundaries and empty processors skipped
+  static constexpr auto noNode = std::numeric_limits<uint32_t>::max();
+  auto myLastTotals = std::make_tuple(noNode, static_cast<uint64_t>(0u), 0.0);
+  if (!mySplits.empty()) {
+    auto n = std::get<0>(mySplits.back());
+    myLastTotals = std::make_tuple(n, mySplitsTotals[n].first, mySplitsTotals[n].second);
+  }
+  auto addNodeTotals = [] (const std::tuple<uint32_t, uint64_t, double>& a,
+                           const std::tuple<uint32_t, uint64_t, double>& b)
+                          { if (std::get<0>(b) == noNode) {
+                              return a;
+                            }
+                            return (std::get<0>(a) == std::get<0>(b)) ?
+                                   std::make_tuple(std::get<0>(b), std::get<1>(a) + std::get<1>(b),
+                                                   std::get<2>(a) + std::get<2>(b)) : b; };
+  auto myLastPrefix = mxx::scan(myLastTotals, addNodeTotals, this->m_comm, false);
+  // Shift the inclusive prefixes instead of computing an exclusive scan, so that
+  // the upper bound of the weights of a node on one processor is bitwise identical
+  // to the lower bound of the weights of the same node on the next processor
+  auto prevLastPrefix = mxx::right_shift(myLastPrefix, this->m_comm);
+  if (this->m_comm.is_first()) {
+    prevLastPrefix = std::make_tuple(noNode, static_cast<uint64_t>(0u), 0.0);
+  }
   // Now, we can get the splits for the nodes on this processor
   trng::uniform01_dist<double> randDist;
-  auto first = 0u;
-  std::vector<std::tuple<uint32_t, Var, Var, double>> myChosenSplits(myNodeIdx.size() * 2 * numSplits);
-  auto chosenIt = myChosenSplits.begin();
+  std::vector<std::tuple<uint32_t, Var, Obs, double>> myChosenSplits;
   auto g = 0u;
-  for (const auto n : myNodeIdx) {
+  auto splitFirst = mySplits.cbegin();
+  while (splitFirst != mySplits.cend()) {
+    auto n = std::get<0>(*splitFirst);
+    auto splitLast = std::find_if(splitFirst, mySplits.cend(),
+                                  [&n] (const std::tuple<uint32_t, Var, Obs, double>& split)
+                                       { return std::get<0>(split) != n; });
     if (n > g) {
       // Advance the PRNG state to account for the previous nodes
       ::advance(generator, (n - g) * 2 * numSplits);
       g = n;
     }
     ++g;
-    auto nodeSplitsCount = mySplitsCounts[n];
-    auto nodeSplitsCountsPrefix = (firstCountsPrefix.first == n) ? firstCountsPrefix.second : 0u;
-    auto last = first + nodeSplitsCount - 1;
-    auto nodeWeightLower = mySplitsWeightsPrefix[first].second - mySplitsWeights[first].second;
-    // There may be some cases in which the last split for a node may
-    // not have a cumulative weight of 1.0, because of the following reasons:
-    // 1) If all the split weights were finite, but the sum of the weights was infinite
-    // 2) Due to eccentricities of floating point arithmetic
-    // In such cases, set it to 1.0
-    if ((nodeSplitsCountsPrefix + nodeSplitsCount == allSplitsCounts[n]) &&
-        std::isless(mySplitsWeightsPrefix[last].second, 1.0)) {
-      mySplitsWeightsPrefix[last].second = 1.0;
-    }
-    auto nodeWeightUpper = mySplitsWeightsPrefix[last].second;
-    trng::uniform_int_dist indexDist(0, allSplitsCounts[n]);
+    auto first = std::distance(mySplits.cbegin(), splitFirst);
+    auto nodeSplitsCount = mySplitsTotals[n].first;
+    // Count and normalized weight of the splits for this node on the previous processors
+    auto nodeSplitsCountsPrefix = static_cast<uint64_t>(0u);
+    auto nodeWeightLower = 0.0;
+    if (std::get<0>(prevLastPrefix) == n) {
+      nodeSplitsCountsPrefix = std::get<1>(prevLastPrefix);
+      nodeWeightLower = std::get<2>(prevLastPrefix);
+    }
+    // Cumulative normalized weights of the local splits of this node,
+    // offset by the weights of the splits on the previous processors
+    auto weightFirst = std::next(mySplitsWeights.begin(), first);
+    auto weightLast = std::next(weightFirst, nodeSplitsCount);
+    std::partial_sum(weightFirst, weightLast, weightFirst);
+    std::for_each(weightFirst, weightLast, [&nodeWeightLower] (double& w) { w += nodeWeightLower; });
+    auto nodeWeightUpper = (splitLast == mySplits.cend()) ? std::get<2>(myLastPrefix)
+                                                         : (nodeWeightLower + mySplitsTotals[n].second);
+    // The first and the last processor for a node also pick the weights outside
+    // their range, e.g., if the cumulative weight of the last split of the node
+    // is less than 1.0 because of the floating point arithmetic, then the last
+    // split is picked for any weight beyond it
+    if (nodeSplitsCountsPrefix == 0) {
+      nodeWeightLower = -std::numeric_limits<double>::infinity();
+    }
+    if (nodeSplitsCountsPrefix + nodeSplitsCount == allSplitsTotals[n].first) {
+      nodeWeightUpper = std::numeric_limits<double>::infinity();
+    }
+    trng::uniform_int_dist indexDist(0, allSplitsTotals[n].first);
     LOG_MESSAGE(debug, "Node %u: Choosing the splits", n);
     for (auto i = 0u; i < numSplits; ++i) {
       // Pick a split weighted by its score
       auto rand = randDist(generator);
       // Check if the split is local to this processor
-      if (std::isgreater(rand, nodeWeightLower) &&
-          std::islessequal(rand, nodeWeightUpper)) {
-        auto firstSplit = std::next(mySplitsWeightsPrefix.begin(), first);
-        auto lastSplit = std::next(firstSplit, nodeSplitsCount);
-        auto foundSplit = std::lower_bound(firstSplit, lastSplit, std::make_pair(n, rand));
-        auto foundIdx = std::distance(firstSplit, foundSplit);
-        auto weightSplit = mySplits[first + foundIdx];
+      if (std::isgreater(rand, nodeWeightLower) && std::islessequal(rand, nodeWeightUpper)) {
+        auto foundIdx = std::min(std::distance(weightFirst, std::lower_bound(weightFirst, weightLast, rand)),
+                                 static_cast<std::ptrdiff_t>(nodeSplitsCount - 1));
+        auto weightSplit = *std::next(splitFirst, foundIdx);
         LOG_MESSAGE(debug, "Chosen parent split using weights: (%s, %g)",
                            this->m_data.varName(std::get<1>(weightSplit)),
                            this->m_data(std::get<1>(weightSplit), std::get<2>(weightSplit)));
         // Index the split with the split index for sorting all the splits for this node later
-        *chosenIt = std::make_tuple(i, std::get<1>(weightSplit),
-                                    std::get<2>(weightSplit), std::get<3>(weightSplit));
-        ++chosenIt;
+        myChosenSplits.emplace_back(i, std::get<1>(weightSplit), std::get<2>(weightSplit), std::get<3>(weightSplit));
       }
       else {
-        LOG_MESSAGE(debug, "Split for weight %g not in the range [%g, %g)", rand, nodeWeightLower, nodeWeightUpper);
+        LOG_MESSAGE(debug, "Split for weight %g not in the range (%g, %g]", rand, nodeWeightLower, nodeWeightUpper);
       }
       // Pick a split uniformly at random
       auto randomIdx = static_cast<uint64_t>(indexDist(generator));
       // Check if the split index is local to this processor
       if ((randomIdx >= nodeSplitsCountsPrefix) &&
           (randomIdx < (nodeSplitsCountsPrefix + nodeSplitsCount))) {
-        auto randomSplit = mySplits[first + (randomIdx - nodeSplitsCountsPrefix)];
+        auto randomSplit = *std::next(splitFirst, randomIdx - nodeSplitsCountsPrefix);
         LOG_MESSAGE(debug, "Chosen parent split at random: (%s, %g)",
                            this->m_data.varName(std::get<1>(randomSplit)),
                            this->m_data(std::get<1>(randomSplit), std::get<2>(randomSplit)));
         // Index the split with the split index for sorting all the splits for this node later
         // Random splits are ordered after all the weight splits
-        *chosenIt = std::make_tuple(numSplits + i, std::get<1>(randomSplit),
-                                    std::get<2>(randomSplit), std::get<3>(randomSplit));
-        ++chosenIt;
+        myChosenSplits.emplace_back(numSplits + i, std::get<1>(randomSplit), std::get<2>(randomSplit), std::get<3>(randomSplit));
       }
       else {
         LOG_MESSAGE(debug, "Random split with index %u not on this processor", randomIdx);
       }
     }
-    first += nodeSplitsCount;
+    splitFirst = splitLast;
   }
-  myChosenSplits.resize(std::distance(myChosenSplits.begin(), chosenIt));
+  std::vector<uint64_t> allSplitsCounts(numNodes);
+  std::transform(allSplitsTotals.cbegin(), allSplitsTotals.cend(), allSplitsCounts.begin(),
+                 [] (const std::pair<uint64_t, double>& totals) { return totals.first; });
   this->m_comm.barrier();
   if (this->m_comm.is_first()) {
     TIMER_ELAPSED("Time taken in choosing splits: ", tChoose);
@@ -676,19 +745,587 @@ LemonTree<Data, Var, Set>::learnModulesParents_splits(
   TIMER_PAUSE(m_tSync);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+template <typename Generator>
+/**
+ * @brief Learns the parents of all the modules by dividing the candidate
+ *        splits of all the nodes into chunks of parents, which are handed
+ *        out to the processors dynamically through a shared counter.
+ *
+ * The chunks are handed out in decreasing order of their weights. The splits
+ * are chosen using per chunk summaries which are available on all the
+ * processors, so the chosen splits do not depend on which processor
+ * computed which chunk.
+ *
+ * @param modules The modules for which the parents are learned.
+ * @param generator Random number generator.
+ * @param candidateParents The candidate parents for the splits.
+ * @param ob Object used for finding the optimal beta for a split.
+ * @param numSplits Number of splits chosen using weights, and at random.
+ * @param streamSplits Whether the splits are sampled without storing them.
+ * @param chunksPerProcess Approximate number of chunks for every processor.
+ * @param progressParents Number of parents after which the first processor
+ *                        lets the shared counter make progress.
+ */
+void
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::learnModulesParents_dynamic(
+  std::list<Module<Data, Var, VarSet, Obs, ObsSet>>& modules,
+  Generator& generator,
+  const VarSet&& candidateParents,
+  const OptimalBeta& ob,
+  const uint32_t numSplits,
+  const bool streamSplits,
+  const uint32_t chunksPerProcess,
+  const uint64_t progressParents
+) const
+{
+  TIMER_DECLARE(tCandidates);
+  std::vector<const Module<Data, Var, VarSet, Obs, ObsSet>*> allModules;
+  std::vector<std::vector<uint64_t>> moduleNodeWeights;
+  uint64_t totalWeight = 0u;
+  for (const auto& module : modules) {
+    allModules.push_back(&module);
+    moduleNodeWeights.push_back(module.nodeSplitWeights(candidateParents));
+    totalWeight += std::accumulate(moduleNodeWeights.back().cbegin(), moduleNodeWeights.back().cend(),
+                                   static_cast<uint64_t>(0u));
+  }
+  // Divide the parents of every node into chunks of roughly the given weight
+  // Every chunk is a tuple of <module, first node of the module, node, first weight, weight>,
+  // with the weights relative to the first split of the module
+  uint64_t numParents = candidateParents.size();
+  auto chunkWeight = std::max(totalWeight / (static_cast<uint64_t>(chunksPerProcess) * this->m_comm.size()),
+                              static_cast<uint64_t>(1u));
+  std::vector<std::tuple<uint32_t, uint32_t, uint32_t, uint64_t, uint64_t>> chunks;
+  // Index of the first chunk for every node
+  std::vector<uint32_t> nodeFirstChunk;
+  auto node = 0u;
+  for (auto m = 0u; m < allModules.size(); ++m) {
+    auto firstNode = node;
+    uint64_t prevWeight = 0u;
+    for (const auto nodeWeight : moduleNodeWeights[m]) {
+      nodeFirstChunk.push_back(chunks.size());
+      if (nodeWeight > 0) {
+        auto parentWeight = nodeWeight / numParents;
+        auto numChunks = std::min((nodeWeight + chunkWeight - 1) / chunkWeight, numParents);
+        for (auto c = 0u; c < numChunks; ++c) {
+          auto firstParent = (c * numParents) / numChunks;
+          auto lastParent = ((c + 1) * numParents) / numChunks;
+          chunks.emplace_back(m, firstNode, node, prevWeight + firstParent * parentWeight,
+                              (lastParent - firstParent) * parentWeight);
+        }
+      }
+      prevWeight += nodeWeight;
+      ++node;
+    }
+  }
+  auto numNodes = node;
+  nodeFirstChunk.push_back(chunks.size());
+  // Hand out the heaviest chunks first
+  std::vector<uint32_t> schedule(chunks.size());
+  std::iota(schedule.begin(), schedule.end(), 0u);
+  std::stable_sort(schedule.begin(), schedule.end(),
+                   [&chunks] (const uint32_t a, const uint32_t b)
+                             { return std::get<4>(chunks[a]) > std::get<4>(chunks[b]); });
+  std::vector<std::tuple<uint32_t, Var, Obs, double>> mySplits;
+  // Pairs of <chunk, index of the first split of the chunk> for the chunks on this processor
+  std::vector<std::pair<uint32_t, uint64_t>> myChunks;
+  // Salts of the samplers for all the nodes, used only if the splits are streamed
+  std::vector<uint64_t> nodeSalts;
+  // Samplers for only the nodes which have any splits on this processor
+  std::map<uint32_t, SplitSampler<Var, Obs>> mySamplers;
+  if (streamSplits) {
+    // Salt the sampler for every node using the same random numbers
+    // that the node consumes in the sequential execution
+    nodeSalts.reserve(numNodes);
+    for (auto n = 0u; n < numNodes; ++n) {
+      nodeSalts.push_back(generator());
+      ::advance(generator, 2 * numSplits - 1);
+    }
+  }
+  auto samplerIt = mySamplers.end();
+  auto sampleSplit = [&mySamplers, &samplerIt, &nodeSalts, &numSplits] (const std::tuple<uint32_t, Var, Obs, double>& split)
+                                   { auto n = std::get<0>(split);
+                                     // The splits of a node are streamed together, so look up the sampler only when the node changes
+                                     if ((samplerIt == mySamplers.end()) || (samplerIt->first != n)) {
+                                       samplerIt = mySamplers.try_emplace(n, numSplits, nodeSalts[n]).first;
+                                     }
+                                     samplerIt->second.insert(std::make_tuple(std::get<1>(split),
+                                                                              std::get<2>(split),
+                                                                              std::get<3>(split))); };
+  TIMER_DECLARE(tSplits);
+  {
+    SharedCounter nextChunk(this->m_comm);
+    for (auto s = nextChunk.fetchAdd(); s < schedule.size(); s = nextChunk.fetchAdd()) {
+      auto c = schedule[s];
+      const auto& chunk = chunks[c];
+      const auto* module = allModules[std::get<0>(chunk)];
+      if (!streamSplits) {
+        myChunks.emplace_back(c, mySplits.size());
+      }
+      // The first processor stores the counter and may have to call into MPI for completing
+      // the fetches of the other processors; therefore, it computes the splits of a chunk in
+      // pieces of a few parents, which produce the same splits in the same order, and lets
+      // the counter make progress after every piece
+      auto chunkLast = std::get<3>(chunk) + std::get<4>(chunk);
+      auto pieceWeight = std::get<4>(chunk);
+      if (this->m_comm.is_first()) {
+        auto parentWeight = moduleNodeWeights[std::get<0>(chunk)][std::get<2>(chunk) - std::get<1>(chunk)] / numParents;
+        pieceWeight = std::max(progressParents * parentWeight, static_cast<uint64_t>(1u));
+      }
+      for (auto pieceFirst = std::get<3>(chunk); pieceFirst < chunkLast; pieceFirst += pieceWeight) {
+        auto weight = std::min(pieceWeight, chunkLast - pieceFirst);
+        if (streamSplits) {
+          module->candidateParentsSplits(candidateParents, ob, std::get<1>(chunk), pieceFirst, weight,
+                                         boost::make_function_output_iterator(std::ref(sampleSplit)));
+        }
+        else {
+          module->candidateParentsSplits(candidateParents, ob, std::get<1>(chunk), pieceFirst, weight,
+                                         std::back_inserter(mySplits));
+        }
+        nextChunk.progress();
+      }
+    }
+  }
+#if TIMER
+  this->timeSplits(tSplits);
+#endif
+  this->m_comm.barrier();
+  if (this->m_comm.is_first()) {
+    TIMER_ELAPSED("Time taken in learning candidate splits: ", tCandidates);
+  }
+  if (streamSplits) {
+    this->syncSampledSplits(modules, mySamplers, numNodes, numSplits);
+    return;
+  }
+  TIMER_DECLARE(tChoose);
+  // Compute the max score for each node across all the processors
+  std::vector<double> mySplitsScoresMax(numNodes, std::numeric_limits<double>::lowest());
+  std::for_each(mySplits.cbegin(), mySplits.cend(),
+                [&mySplitsScoresMax] (const std::tuple<uint32_t, Var, Obs, double>& split)
+                                     { mySplitsScoresMax[std::get<0>(split)] = std::max(mySplitsScoresMax[std::get<0>(split)],
+                                                                                        std::get<3>(split)); });
+  auto allSplitsScoresMax = mxx::allreduce(mySplitsScoresMax, mxx::max<double>(), this->m_comm);
+  // Compute the weights of the splits and the summary of every local chunk
+  // as <chunk, count, sum of weights, count of infinite weights>
+  std::vector<double> mySplitsWeights(mySplits.size());
+  std::vector<std::tuple<uint32_t, uint64_t, double, uint64_t>> myChunksTotals(myChunks.size());
+  // Index of the first local split of every chunk, if the chunk is on this processor
+  std::vector<uint64_t> chunkFirstSplit(chunks.size(), std::numeric_limits<uint64_t>::max());
+  for (auto i = 0u; i < myChunks.size(); ++i) {
+    auto first = myChunks[i].second;
+    auto last = (i + 1 < myChunks.size()) ? myChunks[i + 1].second : mySplits.size();
+    auto weightSum = 0.0;
+    auto infCount = static_cast<uint64_t>(0u);
+    for (auto s = first; s < last; ++s) {
+      mySplitsWeights[s] = relativeWeight(std::get<3>(mySplits[s]), allSplitsScoresMax[std::get<0>(mySplits[s])]);
+      weightSum += mySplitsWeights[s];
+      infCount += std::isinf(mySplitsWeights[s]) ? 1u : 0u;
+    }
+    myChunksTotals[i] = std::make_tuple(myChunks[i].first, last - first, weightSum, infCount);
+    chunkFirstSplit[myChunks[i].first] = first;
+  }
+  // Every processor computes the cumulative counts and weights of the chunks
+  // of every node in the order of the chunks, so that the results are identical
+  auto allChunksTotals = mxx::allgatherv(myChunksTotals, this->m_comm);
+  std::vector<uint64_t> chunkCounts(chunks.size(), 0u);
+  std::vector<double> chunkWeights(chunks.size(), 0.0);
+  std::vector<uint64_t> chunkInfCounts(chunks.size(), 0u);
+  for (const auto& totals : allChunksTotals) {
+    chunkCounts[std::get<0>(totals)] = std::get<1>(totals);
+    chunkWeights[std::get<0>(totals)] = std::get<2>(totals);
+    chunkInfCounts[std::get<0>(totals)] = std::get<3>(totals);
+  }
+  // Total weight of the splits of every node, used for normalizing the weights
+  std::vector<double> nodeWeightSums(numNodes, 0.0);
+  // Flags for the nodes with infinite total weights
+  std::vector<bool> nodeInfWeights(numNodes, false);
+  for (auto n = 0u; n < numNodes; ++n) {
+    auto first = nodeFirstChunk[n];
+    auto last = nodeFirstChunk[n + 1];
+    nodeWeightSums[n] = std::accumulate(std::next(chunkWeights.cbegin(), first),
+                                        std::next(chunkWeights.cbegin(), last), 0.0);
+    if (std::isinf(nodeWeightSums[n])) {
+      // If the total weight of all the splits for a node is infinite, we want to
+      // modify the weights to replicate the following sequential behaviors of
+      // discrete_distribution_safe/std::discrete_distribution
+      // 1) If one or more of the split weights are infinite,
+      //    then always pick the first split with infinite weight
+      // 2) If none of the split weights are infinite,
+      //    then always pick the last split
+      // Setting all infinite split weights to 1.0, the finite weights to 0.0,
+      // and the total weight for the node to 1.0 accomplishes both
+      LOG_MESSAGE(debug, "Node %u: Handling infinite weights", n);
+      for (auto c = first; c < last; ++c) {
+        chunkWeights[c] = static_cast<double>(chunkInfCounts[c]);
+      }
+      nodeWeightSums[n] = 1.0;
+      nodeInfWeights[n] = true;
+    }
+    for (auto c = first; c < last; ++c) {
+      chunkWeights[c] /= nodeWeightSums[n];
+    }
+  }
+  // Normalize the weights of the local splits and compute
+  // their cumulative weights within every local chunk
+  for (auto i = 0u; i < myChunks.size(); ++i) {
+    auto first = myChunks[i].second;
+    auto last = (i + 1 < myChunks.size()) ? myChunks[i + 1].second : mySplits.size();
+    auto n = std::get<2>(chunks[myChunks[i].first]);
+    auto weightSum = 0.0;
+    for (auto s = first; s < last; ++s) {
+      auto weight = nodeInfWeights[n] ? (std::isinf(mySplitsWeights[s]) ? 1.0 : 0.0) : mySplitsWeights[s];
+      weightSum += weight / nodeWeightSums[n];
+      mySplitsWeights[s] = weightSum;
+    }
+  }
+  std::vector<uint64_t> chunkCountsPrefix(chunks.size());
+  std::vector<double> chunkWeightsPrefix(chunks.size());
+  std::vector<uint64_t> allSplitsCounts(numNodes, 0u);
+  // Set of local node indices with any splits
+  // XXX: Using set instead of unordered_set because we want sorted indices
+  std::set<uint32_t> myNodeIdx;
+  for (auto n = 0u; n < numNodes; ++n) {
+    auto first = nodeFirstChunk[n];
+    auto last = nodeFirstChunk[n + 1];
+    std::partial_sum(std::next(chunkCounts.cbegin(), first), std::next(chunkCounts.cbegin(), last),
+                     std::next(chunkCountsPrefix.begin(), first));
+    std::partial_sum(std::next(chunkWeights.cbegin(), first), std::next(chunkWeights.cbegin(), last),
+                     std::next(chunkWeightsPrefix.begin(), first));
+    if (first < last) {
+      allSplitsCounts[n] = chunkCountsPrefix[last - 1];
+    }
+  }
+  for (const auto& chunk : myChunks) {
+    auto n = std::get<2>(chunks[chunk.first]);
+    if (allSplitsCounts[n] > 0) {
+      myNodeIdx.insert(n);
+    }
+  }
+  // Now, we can get the splits for the nodes on this processor
+  trng::uniform01_dist<double> randDist;
+  std::vector<std::tuple<uint32_t, uint32_t, Var, Obs, double>> myChosenSplits;
+  auto g = 0u;
+  for (const auto n : myNodeIdx) {
+    if (n > g) {
+      // Advance the PRNG state to account for the previous nodes
+      ::advance(generator, (n - g) * 2 * numSplits);
+      g = n;
+    }
+    ++g;
+    auto countFirst = std::next(chunkCountsPrefix.cbegin(), nodeFirstChunk[n]);
+    auto countLast = std::next(chunkCountsPrefix.cbegin(), nodeFirstChunk[n + 1]);
+    auto weightFirst = std::next(chunkWeightsPrefix.cbegin(), nodeFirstChunk[n]);
+    auto weightLast = std::next(chunkWeightsPrefix.cbegin(), nodeFirstChunk[n + 1]);
+    // Any weight beyond the sum of the weights picks the last split, same as the sequential
+    // execution; therefore, find the last chunk which contains any splits
+    auto lastChunk = std::distance(chunkCountsPrefix.cbegin(), std::lower_bound(countFirst, countLast, allSplitsCounts[n]));
+    trng::uniform_int_dist indexDist(0, allSplitsCounts[n]);
+    LOG_MESSAGE(debug, "Node %u: Choosing the splits", n);
+    for (auto i = 0u; i < numSplits; ++i) {
+      // Pick a split weighted by its score, i.e., the first split with
+      // the cumulative normalized weight not less than the random number
+      // Zero picks the first split with any weight, instead of an empty chunk
+      auto rand = std::max(randDist(generator), std::numeric_limits<double>::denorm_min());
+      auto c = std::min(std::distance(chunkWeightsPrefix.cbegin(), std::lower_bound(weightFirst, weightLast, rand)),
+                        lastChunk);
+      // Check if the chunk of the split is local to this processor
+      if (chunkFirstSplit[c] != std::numeric_limits<uint64_t>::max()) {
+        auto chunkWeightLower = (c > nodeFirstChunk[n]) ? chunkWeightsPrefix[c - 1] : 0.0;
+        auto splitFirst = std::next(mySplitsWeights.cbegin(), chunkFirstSplit[c]);
+        auto splitLast = std::next(splitFirst, chunkCounts[c]);
+        auto foundIdx = std::min(std::distance(splitFirst, std::lower_bound(splitFirst, splitLast, rand - chunkWeightLower)),
+                                 static_cast<std::ptrdiff_t>(chunkCounts[c] - 1));
+        auto weightSplit = mySplits[chunkFirstSplit[c] + foundIdx];
+        LOG_MESSAGE(debug, "Chosen parent split using weights: (%s, %g)",
+                           this->m_data.varName(std::get<1>(weightSplit)),
+                           this->m_data(std::get<1>(weightSplit), std::get<2>(weightSplit)));
+        // Index the split with the node and the split index for sorting all the splits later
+        myChosenSplits.emplace_back(n, i, std::get<1>(weightSplit), std::get<2>(weightSplit), std::get<3>(weightSplit));
+      }
+      // Pick a split uniformly at random
+      auto randomIdx = static_cast<uint64_t>(indexDist(generator));
+      c = std::distance(chunkCountsPrefix.cbegin(), std::upper_bound(countFirst, countLast, randomIdx));
+      // Check if the chunk of the split is local to this processor
+      if (chunkFirstSplit[c] != std::numeric_limits<uint64_t>::max()) {
+        auto randomSplit = mySplits[chunkFirstSplit[c] + (randomIdx - (chunkCountsPrefix[c] - chunkCounts[c]))];
+        LOG_MESSAGE(debug, "Chosen parent split at random: (%s, %g)",
+                           this->m_data.varName(std::get<1>(randomSplit)),
+                           this->m_data(std::get<1>(randomSplit), std::get<2>(randomSplit)));
+        // Index the split with the node and the split index for sorting all the splits later
+        // Random splits are ordered after all the weight splits
+        myChosenSplits.emplace_back(n, numSplits + i, std::get<1>(randomSplit), std::get<2>(randomSplit), std::get<3>(randomSplit));
+      }
+    }
+  }
+  this->m_comm.barrier();
+  if (this->m_comm.is_first()) {
+    TIMER_ELAPSED("Time taken in choosing splits: ", tChoose);
+  }
+  TIMER_START(m_tSync);
+  // Gather all the chosen splits on all the processors
+  // in order to assign them to the corresponding nodes
+  auto allNodesChosenSplits = mxx::allgatherv(myChosenSplits, this->m_comm);
+  // The nodes on a processor are not contiguous, therefore, sort the splits by the nodes
+  std::sort(allNodesChosenSplits.begin(), allNodesChosenSplits.end());
+  std::vector<std::tuple<uint32_t, Var, Obs, double>> allChosenSplits(allNodesChosenSplits.size());
+  std::transform(allNodesChosenSplits.cbegin(), allNodesChosenSplits.cend(), allChosenSplits.begin(),
+                 [] (const std::tuple<uint32_t, uint32_t, Var, Obs, double>& split)
+                    { return std::make_tuple(std::get<1>(split), std::get<2>(split),
+                                             std::get<3>(split), std::get<4>(split)); });
+  auto moduleIt = modules.begin();
+  auto countCit = allSplitsCounts.cbegin();
+  auto splitIt = allChosenSplits.begin();
+  for (auto m = 0u; m < modules.size(); ++m, ++moduleIt) {
+    // Synchronize the node parents for this module
+    LOG_MESSAGE(info, "Module %u: Synchronizing parents for all nodes", m);
+    moduleIt->syncParents(numSplits, countCit, splitIt);
+  }
+  LOG_MESSAGE(info, "Done synchronizing module parents");
+  this->m_comm.barrier();
+  TIMER_PAUSE(m_tSync);
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Merges the samplers of the splits for all the nodes across all
+ *        the processors and assigns the chosen splits to the nodes.
+ *
+ * Only the samplers of the nodes with any splits on a processor are gathered
+ * on all the processors, which then merge the samplers for every node.
+ *
+ * @param modules The modules to which the nodes belong.
+ * @param mySamplers The samplers for the nodes on this processor.
+ * @param numNodes Total number of the nodes in all the modules.
+ * @param numSplits Number of splits chosen using weights, and at random.
+ */
+void
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::syncSampledSplits(
+  std::list<Module<Data, Var, VarSet, Obs, ObsSet>>& modules,
+  const std::map<uint32_t, SplitSampler<Var, Obs>>& mySamplers,
+  const uint32_t numNodes,
+  const uint32_t numSplits
+) const
+{
+  using Entry = typename SplitSampler<Var, Obs>::Entry;
+  TIMER_START(m_tSync);
+  std::vector<uint32_t> myNodes;
+  std::vector<uint64_t> myCounts;
+  std::vector<Entry> myEntries;
+  myNodes.reserve(mySamplers.size());
+  myCounts.reserve(mySamplers.size());
+  myEntries.reserve(mySamplers.size() * 2 * numSplits);
+  for (const auto& sampler : mySamplers) {
+    myNodes.push_back(sampler.first);
+    myCounts.push_back(sampler.second.count());
+    const auto& entries = sampler.second.entries();
+    myEntries.insert(myEntries.end(), entries.begin(), entries.end());
+  }
+  auto allNodes = mxx::allgatherv(myNodes, this->m_comm);
+  auto allCounts = mxx::allgatherv(myCounts, this->m_comm);
+  auto allEntries = mxx::allgatherv(myEntries, this->m_comm);
+  // Keep the entry which wins every draw for every node across all the processors
+  std::vector<uint64_t> allSplitsCounts(numNodes, 0u);
+  std::vector<Entry> nodeEntries(static_cast<uint64_t>(numNodes) * 2 * numSplits, Entry(std::nan(""), 0, 0, 0.0));
+  for (auto s = 0u; s < allNodes.size(); ++s) {
+    auto n = allNodes[s];
+    allSplitsCounts[n] += allCounts[s];
+    auto entryIt = std::next(nodeEntries.begin(), static_cast<uint64_t>(n) * 2 * numSplits);
+    auto otherIt = std::next(allEntries.cbegin(), static_cast<uint64_t>(s) * 2 * numSplits);
+    for (auto i = 0u; i < 2 * numSplits; ++i, ++entryIt, ++otherIt) {
+      *entryIt = SplitSampler<Var, Obs>::better(*entryIt, *otherIt);
+    }
+  }
+  std::vector<std::tuple<uint32_t, Var, Obs, double>> allChosenSplits;
+  auto entryCit = nodeEntries.cbegin();
+  for (auto n = 0u; n < numNodes; ++n) {
+    if (allSplitsCounts[n] > 0) {
+      // Index the split with the draw index, same as the materialized splits
+      for (auto i = 0u; i < 2 * numSplits; ++i, ++entryCit) {
+        allChosenSplits.emplace_back(i, std::get<1>(*entryCit), std::get<2>(*entryCit), std::get<3>(*entryCit));
+      }
+    }
+    else {
+      std::advance(entryCit, 2 * numSplits);
+    }
+  }
+  auto moduleIt = modules.begin();
+  auto countCit = allSplitsCounts.cbegin();
+  auto splitIt = allChosenSplits.begin();
+  for (auto m = 0u; m < modules.size(); ++m, ++moduleIt) {
+    // Synchronize the node parents for this module
+    LOG_MESSAGE(info, "Module %u: Synchronizing parents for all nodes", m);
+    moduleIt->syncParents(numSplits, countCit, splitIt);
+  }
+  LOG_MESSAGE(info, "Done synchronizing module parents");
+  this->m_comm.barrier();
+  TIMER_PAUSE(m_tSync);
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+template <typename Timer>
+/**
+ * @brief Prints the time taken in the split computations and
+ *        the imbalance in the time across all the processors.
+ *
+ * @tparam Timer Type of the timer for the split computations.
+ * @param tSplits The timer for the split computations on this processor.
+ */
+void
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::timeSplits(
+  const Timer& tSplits
+) const
+{
+  auto allSplitsTime = mxx::gather(static_cast<double>(tSplits.elapsed()), 0, this->m_comm);
+  this->m_comm.barrier();
+  if (this->m_comm.is_first()) {
+    TIMER_ELAPSED("Time taken in the split computations: ", tSplits);
+    auto totalTime = 0.0;
+    auto maxTime = 0.0;
+    for (const auto st : allSplitsTime) {
+      totalTime += st;
+      maxTime = std::max(maxTime, st);
+    }
+    auto avgTime = totalTime / allSplitsTime.size();
+    auto imbalance = (maxTime - avgTime) / avgTime;
+    std::cout << "Imbalance in the split computations: " << imbalance << std::endl;
+  }
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Prints the average number of function evaluations
+ *        for finding beta for all the candidate splits.
+ *
+ * @param ob The object used for finding beta.
+ * @param isParallel If the splits were divided across all the processors.
+ */
+void
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::reportEvaluations(
+  const OptimalBeta& ob,
+  const bool isParallel
+) const
+{
+  auto numSolves = ob.numSolves();
+  auto numEvaluations = ob.numEvaluations();
+  if (isParallel) {
+    numSolves = mxx::allreduce(numSolves, this->m_comm);
+    numEvaluations = mxx::allreduce(numEvaluations, this->m_comm);
+  }
+  if (this->m_comm.is_first()) {
+    std::cout << "Average number of evaluations for finding beta: "
+              << static_cast<double>(numEvaluations) / std::max(numSolves, static_cast<uint64_t>(1))
+              << " (" << numSolves << " splits)" << std::endl;
+  }
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Estimates the cost per candidate split for all the nodes of the
+ *        given modules, which is then used for partitioning the splits.
+ *
+ * Every processor estimates the costs for a block of the nodes and the costs
+ * are gathered on all the processors. If calibration is requested, the
+ * average number of solver evaluations used by the cost model is measured by
+ * computing the splits for a sample of (node, parent) pairs across all the
+ * processors; otherwise, the typical number of evaluations of the configured
+ * solver is assumed.
+ *
+ * @param modules The modules with the nodes.
+ * @param candidateParents The candidate parents for the splits.
+ * @param modulesConfigs Configurations for learning the modules.
+ */
+void
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::estimateSplitCosts(
+  std::list<Module<Data, Var, VarSet, Obs, ObsSet>>& modules,
+  const VarSet& candidateParents,
+  const pt::ptree& modulesConfigs
+) const
+{
+  auto numSamples = modulesConfigs.get<uint32_t>("cost_samples", 0);
+  auto maxParents = modulesConfigs.get<uint32_t>("cost_parents", 64);
+  std::vector<uint32_t> moduleNodeCount;
+  for (const auto& module : modules) {
+    moduleNodeCount.push_back(module.nodeCount());
+  }
+  std::vector<uint32_t> moduleNodeCountPrefix(moduleNodeCount.size());
+  std::partial_sum(moduleNodeCount.cbegin(), moduleNodeCount.cend(), moduleNodeCountPrefix.begin());
+  auto numNodes = moduleNodeCountPrefix.empty() ? 0u : moduleNodeCountPrefix.back();
+  uint64_t numParents = candidateParents.size();
+  auto ob = this->optimalBeta(modulesConfigs);
+  auto numEvaluations = ob.typicalEvaluations();
+  if ((numSamples > 0) && (numNodes > 0) && (numParents > 0)) {
+    // Compute the splits of a sample of (node, parent) pairs, spread evenly
+    // over all the nodes, for measuring the number of solver evaluations
+    auto discardSplit = [] (const std::tuple<uint32_t, Var, Obs, double>&) { };
+    mxx::blk_dist block(numSamples, this->m_comm.size(), this->m_comm.rank());
+    auto moduleIt = modules.cbegin();
+    auto m = 0u;
+    std::vector<uint64_t> nodeWeightsPrefix;
+    for (auto s = block.eprefix_size(); s < block.iprefix_size(); ++s) {
+      auto node = static_cast<uint32_t>((s * numNodes) / numSamples);
+      auto p = (s * numParents) / numSamples;
+      if ((s == block.eprefix_size()) || (node >= moduleNodeCountPrefix[m])) {
+        while (node >= moduleNodeCountPrefix[m]) {
+          ++m;
+          ++moduleIt;
+        }
+        auto nodeWeights = moduleIt->nodeSplitWeights(candidateParents);
+        nodeWeightsPrefix.resize(nodeWeights.size() + 1);
+        nodeWeightsPrefix[0] = 0u;
+        std::partial_sum(nodeWeights.cbegin(), nodeWeights.cend(), nodeWeightsPrefix.begin() + 1);
+      }
+      auto firstNode = moduleNodeCountPrefix[m] - moduleNodeCount[m];
+      auto n = node - firstNode;
+      auto parentWeight = (nodeWeightsPrefix[n + 1] - nodeWeightsPrefix[n]) / numParents;
+      if (parentWeight > 0) {
+        moduleIt->candidateParentsSplits(candidateParents, ob, firstNode, nodeWeightsPrefix[n] + p * parentWeight,
+                                         parentWeight, boost::make_function_output_iterator(discardSplit));
+      }
+    }
+    auto numSolves = mxx::allreduce(ob.numSolves(), this->m_comm);
+    auto totalEvaluations = mxx::allreduce(ob.numEvaluations(), this->m_comm);
+    if (numSolves > 0) {
+      numEvaluations = static_cast<double>(totalEvaluations) / numSolves;
+    }
+    if (this->m_comm.is_first()) {
+      LOG_MESSAGE(info, "Calibrated the split cost model using %u samples (%g evaluations per split)",
+                        numSamples, numEvaluations);
+    }
+  }
+  mxx::blk_dist block(numNodes, this->m_comm.size(), this->m_comm.rank());
+  std::vector<uint64_t> myCosts;
+  auto moduleCit = modules.cbegin();
+  for (auto m = 0u; m < modules.size(); ++m, ++moduleCit) {
+    auto firstNode = std::max(static_cast<uint64_t>(moduleNodeCountPrefix[m] - moduleNodeCount[m]), block.eprefix_size());
+    auto lastNode = std::min(static_cast<uint64_t>(moduleNodeCountPrefix[m]), block.iprefix_size());
+    if (firstNode < lastNode) {
+      moduleCit->estimateSplitCosts(candidateParents, numEvaluations, maxParents,
+                                    firstNode - (moduleNodeCountPrefix[m] - moduleNodeCount[m]),
+                                    lastNode - firstNode, std::back_inserter(myCosts));
+    }
+  }
+  auto allCosts = mxx::allgatherv(myCosts, this->m_comm);
+  auto costIt = allCosts.cbegin();
+  for (auto& module : modules) {
+    module.setSplitCosts(costIt);
+  }
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
 void
-LemonTree<Data, Var, Set>::learnModulesParents_parallel(
-  std::list<Module<Data, Var, Set>>& modules,
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::learnModulesParents_parallel(
+  std::list<Module<Data, Var, VarSet, Obs, ObsSet>>& modules,
   Generator& generator,
   const pt::ptree& modulesConfigs
 ) const
 {
   auto regFile = modulesConfigs.get<std::string>("reg_file");
-  auto betaMax = modulesConfigs.get<double>("beta_reg");
   auto numSplits = modulesConfigs.get<uint32_t>("num_reg");
-  Set candidateParents(this->m_data.numVars());
+  if (numSplits == 0) {
+    throw std::runtime_error("The number of parent splits to be sampled must be positive");
+  }
+  VarSet candidateParents(this->m_data.numVars());
   if (!regFile.empty()) {
     if (this->m_comm.is_first()) {
       // Read candidate parents from the given file
@@ -702,13 +1339,77 @@ LemonTree<Data, Var, Set>::learnModulesParents_parallel(
       candidateParents.insert(v);
     }
   }
-  this->learnModulesParents_splits(modules, generator, std::move(candidateParents), betaMax, numSplits);
+  auto ob = this->optimalBeta(modulesConfigs);
+  auto streamSplits = modulesConfigs.get<bool>("stream_splits", false);
+  auto scheduling = modulesConfigs.get<std::string>("split_scheduling", "static");
+  if ((scheduling != "static") && (scheduling != "dynamic")) {
+    throw std::runtime_error("Unknown split scheduling " + scheduling + ". Supported schedulings are: {static, dynamic}");
+  }
+  auto partitioning = modulesConfigs.get<std::string>("split_partitioning", "splits");
+  if ((partitioning != "splits") && (partitioning != "nodes") && (partitioning != "auto")) {
+    throw std::runtime_error("Unknown split partitioning " + partitioning + ". Supported partitionings are: {splits, nodes, auto}");
+  }
+  auto costs = modulesConfigs.get<std::string>("split_costs", "observations");
+  if (costs == "estimated") {
+    this->m_comm.barrier();
+    TIMER_DECLARE(tCosts);
+    this->estimateSplitCosts(modules, candidateParents, modulesConfigs);
+    this->m_comm.barrier();
+    if (this->m_comm.is_first()) {
+      TIMER_ELAPSED("Time taken in estimating the split costs: ", tCosts);
+    }
+  }
+  else if (costs != "observations") {
+    throw std::runtime_error("Unknown split costs " + costs + ". Supported costs are: {estimated, observations}");
+  }
+  // The splits on every processor may use any of the candidate parents; therefore,
+  // fetch the data of the candidate parents which are not stored locally, up to the
+  // number of variables that the data provider caches (the data of the remaining
+  // parents is fetched when the splits are computed). The costs are estimated
+  // before this, using the data of at most cost_parents sampled parents, so that
+  // those parents do not evict the fetched data
+  this->m_data.prefetch(candidateParents);
+  if ((scheduling == "static") && (partitioning == "auto")) {
+    // Partitioning the nodes avoids splitting the work for a node across
+    // processors, but the imbalance can be as large as the heaviest node;
+    // therefore, partition the nodes only if it is a small fraction of the
+    // work for every processor
+    uint64_t totalWeight = 0u;
+    uint64_t maxWeight = 0u;
+    for (const auto& module : modules) {
+      for (const auto w : module.nodeSplitWeights(candidateParents)) {
+        totalWeight += w;
+        maxWeight = std::max(maxWeight, w);
+      }
+    }
+    partitioning = (10 * maxWeight * this->m_comm.size() <= totalWeight) ? "nodes" : "splits";
+    LOG_MESSAGE(info, "Using %s partitioning for the candidate splits", partitioning);
+  }
+  if (scheduling == "dynamic") {
+    auto chunksPerProcess = modulesConfigs.get<uint32_t>("chunks_per_process", 16);
+    auto progressParents = modulesConfigs.get<uint64_t>("progress_parents", 64);
+    if (progressParents == 0) {
+      throw std::runtime_error("The number of parents between the progress calls must be positive");
+    }
+    this->learnModulesParents_dynamic(modules, generator, std::move(candidateParents), ob, numSplits,
+                                      streamSplits, chunksPerProcess, progressParents);
+  }
+  else if (partitioning == "nodes") {
+    this->learnModulesParents_nodes(modules, generator, std::move(candidateParents), ob, numSplits, streamSplits);
+  }
+  else {
+    this->learnModulesParents_splits(modules, generator, std::move(candidateParents), ob, numSplits, streamSplits);
+  }
+#if defined(LOGGING) || TIMER
+  // Only reduce the statistics across the ranks if they are going to be reported
+  this->reportEvaluations(ob, true);
+#endif
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
-std::list<Module<Data, Var, Set>>
-LemonTree<Data, Var, Set>::learnModules(
+std::list<Module<Data, Var, VarSet, Obs, ObsSet>>
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::learnModules(
   const std::multimap<Var, Var>&& coClusters,
   const pt::ptree& modulesConfigs,
   const bool isParallel
@@ -736,9 +1437,9 @@ LemonTree<Data, Var, Set>::learnModules(
   return modules;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-LemonTree<Data, Var, Set>::writeParents(
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::writeParents(
   std::ofstream& stream,
   const std::unordered_map<Var, double>& splits,
   const uint32_t moduleIndex,
@@ -753,11 +1454,11 @@ LemonTree<Data, Var, Set>::writeParents(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-LemonTree<Data, Var, Set>::writeModules(
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::writeModules(
   const std::string& modulesFile,
-  const std::list<Module<Data, Var, Set>>& modules,
+  const std::list<Module<Data, Var, VarSet, Obs, ObsSet>>& modules,
   const double topParents
 ) const
 {
@@ -805,9 +1506,9 @@ LemonTree<Data, Var, Set>::writeModules(
   xmlf << "</ModuleNetwork>" << std::endl;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-LemonTree<Data, Var, Set>::learnNetwork_sequential(
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::learnNetwork_sequential(
   const pt::ptree& algoConfigs,
   const std::string& outputDir
 ) const
@@ -865,9 +1566,9 @@ LemonTree<Data, Var, Set>::learnNetwork_sequential(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-LemonTree<Data, Var, Set>::learnNetwork_parallel(
+LemonTree<Data, Var, VarSet, Obs, ObsSet>::learnNetwork_parallel(
   const pt::ptree& algoConfigs,
   const std::string& outputDir
 ) const
@@ -0,0 +1,317 @@
+/**
+ * @file LogLikelihood.hpp
+ * @brief Implementation of the log-likelihood computations for clusters.
+ * @author Ankit Srivastava <asrivast@gatech.edu>
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DETAIL_LOGLIKELIHOOD_HPP_
+#define DETAIL_LOGLIKELIHOOD_HPP_
+
+#include "VectorMath.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+/**
+ * @brief Fixed parameters of the normal-gamma prior.
+ */
+struct NormalGammaPrior {
+  static constexpr double lambda0 = 0.1;
+  static constexpr double alpha0 = 0.1;
+  static constexpr double beta0 = 0.1;
+  static constexpr double mu = 0.0;
+  static constexpr double log2pi = log(2 * acos(-1));
+}; // struct NormalGammaPrior
+
+/**
+ * @brief Computes the log-likelihood from the given statistics.
+ *
+ * @param count Number of data points.
+ * @param sum Sum of the data points.
+ * @param sum2 Sum of squares of the data points.
+ */
+inline
+double
+computeLogLikelihood(
+  const uint32_t count,
+  const double sum,
+  const double sum2
+)
+{
+  // Fixed parameters
+  static constexpr double lambda0 = NormalGammaPrior::lambda0;
+  static constexpr double alpha0 = NormalGammaPrior::alpha0;
+  static constexpr double beta0 = NormalGammaPrior::beta0;
+  static constexpr double mu = NormalGammaPrior::mu;
+  static constexpr double log2pi = NormalGammaPrior::log2pi;
+  // Function parameter independent computations
+  // lgamma is not a constexpr
+  static const auto fixed = 0.5 * log(lambda0) + alpha0 * log(beta0) - lgamma(alpha0);
+  // Dependent parameters
+  const auto lambda1 = lambda0 + count;
+  const auto alpha1 = alpha0 + 0.5 * count;
+  const auto beta1 = beta0 + 0.5 * (sum2 - pow(sum, 2) / count) +
+                     lambda0 * pow(sum - mu * count, 2) / (2 * lambda1 * count);
+  // Log-likelihood computation
+  auto logLikelihood = -0.5 * count * log2pi + fixed + lgamma(alpha1) -
+                       alpha1 * log(beta1) - 0.5 * log(lambda1);
+  return std::isnan(logLikelihood) ? 0.0 : logLikelihood;
+}
+
+#if defined(BATCHED_LOGLIKELIHOOD) && \
+    ((defined(HAVE_AVX512BW_INSTRUCTIONS) && defined(__AVX512F__)) || \
+     (defined(HAVE_AVX2_INSTRUCTIONS) && defined(__AVX2__)))
+/**
+ * @brief Class that provides tables of the terms of the log-likelihood
+ *        which depend only on the count. Since alpha1 = alpha0 + count / 2,
+ *        lgamma(alpha1) as well as log(lambda1) can be looked up by count.
+ */
+class LogLikelihoodTable {
+public:
+  static constexpr uint32_t size = 1u << 16;
+
+  static
+  const LogLikelihoodTable&
+  get()
+  {
+    static const LogLikelihoodTable table;
+    return table;
+  }
+
+  const double*
+  lgammaAlpha() const
+  {
+    return m_lgammaAlpha.data();
+  }
+
+  const double*
+  logLambda() const
+  {
+    return m_logLambda.data();
+  }
+
+  double
+  fixed() const
+  {
+    return m_fixed;
+  }
+
+private:
+  LogLikelihoodTable(
+  ) : m_lgammaAlpha(size),
+      m_logLambda(size),
+      m_fixed(0.5 * log(NormalGammaPrior::lambda0) + NormalGammaPrior::alpha0 * log(NormalGammaPrior::beta0) -
+              lgamma(NormalGammaPrior::alpha0))
+  {
+    // Use the same expressions as computeLogLikelihood
+    // so that the looked up terms are exactly the same
+    for (uint32_t count = 0u; count < size; ++count) {
+      m_lgammaAlpha[count] = lgamma(NormalGammaPrior::alpha0 + 0.5 * count);
+      m_logLambda[count] = log(NormalGammaPrior::lambda0 + count);
+    }
+  }
+
+private:
+  std::vector<double> m_lgammaAlpha;
+  std::vector<double> m_logLambda;
+  const double m_fixed;
+}; // class LogLikelihoodTable
+
+#endif
+
+#if defined(BATCHED_LOGLIKELIHOOD) && defined(HAVE_AVX512BW_INSTRUCTIONS) && defined(__AVX512F__)
+/**
+ * @brief Computes the log-likelihoods for eight consecutive statistics.
+ *
+ * @return Mask of the elements which could not be computed
+ *         and should be computed using the reference function.
+ */
+inline
+__mmask8
+computeLogLikelihoods_avx512(
+  const uint32_t* const count,
+  const double* const sum,
+  const double* const sum2,
+  double* const logLikelihood,
+  const uint32_t offsetCount,
+  const double offsetSum,
+  const double offsetSum2
+)
+{
+  const auto& table = LogLikelihoodTable::get();
+  const auto countIdx = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(count)),
+                                         _mm256_set1_epi32(static_cast<int>(offsetCount)));
+  const auto c = _mm512_cvtepu32_pd(countIdx);
+  const auto s = _mm512_add_pd(_mm512_loadu_pd(sum), _mm512_set1_pd(offsetSum));
+  const auto s2 = _mm512_add_pd(_mm512_loadu_pd(sum2), _mm512_set1_pd(offsetSum2));
+  // Dependent parameters
+  const auto lambda1 = _mm512_add_pd(_mm512_set1_pd(NormalGammaPrior::lambda0), c);
+  const auto alpha1 = _mm512_add_pd(_mm512_set1_pd(NormalGammaPrior::alpha0), _mm512_mul_pd(_mm512_set1_pd(0.5), c));
+  const auto d = _mm512_sub_pd(s, _mm512_mul_pd(_mm512_set1_pd(NormalGammaPrior::mu), c));
+  const auto beta1 = _mm512_add_pd(
+    _mm512_add_pd(_mm512_set1_pd(NormalGammaPrior::beta0),
+                  _mm512_mul_pd(_mm512_set1_pd(0.5), _mm512_sub_pd(s2, _mm512_div_pd(_mm512_mul_pd(s, s), c)))),
+    _mm512_div_pd(_mm512_mul_pd(_mm512_set1_pd(NormalGammaPrior::lambda0), _mm512_mul_pd(d, d)),
+                  _mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(2.0), lambda1), c)));
+  // Look up the terms that depend only on the count
+  const auto inTable = _mm512_cmp_pd_mask(c, _mm512_set1_pd(LogLikelihoodTable::size), _CMP_LT_OQ);
+  const auto idx = _mm256_min_epu32(countIdx, _mm256_set1_epi32(LogLikelihoodTable::size - 1));
+  // Masked gathers are used to avoid reading undefined source values
+  const auto lgammaAlpha = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, idx, table.lgammaAlpha(), 8);
+  const auto logLambda = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, idx, table.logLambda(), 8);
+  // The logarithm is computed only for positive normal numbers
+  const auto valid = inTable &
+                     _mm512_cmp_pd_mask(beta1, _mm512_set1_pd(std::numeric_limits<double>::min()), _CMP_GE_OQ) &
+                     _mm512_cmp_pd_mask(beta1, _mm512_set1_pd(std::numeric_limits<double>::max()), _CMP_LE_OQ);
+  const auto logBeta = log_avx512(_mm512_mask_blend_pd(valid, _mm512_set1_pd(1.0), beta1));
+  // Log-likelihood computation, in the same order as the reference function
+  auto ll = _mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(-0.5), c), _mm512_set1_pd(NormalGammaPrior::log2pi));
+  ll = _mm512_add_pd(ll, _mm512_set1_pd(table.fixed()));
+  ll = _mm512_add_pd(ll, lgammaAlpha);
+  ll = _mm512_sub_pd(ll, _mm512_mul_pd(alpha1, logBeta));
+  ll = _mm512_sub_pd(ll, _mm512_mul_pd(_mm512_set1_pd(0.5), logLambda));
+  _mm512_storeu_pd(logLikelihood, ll);
+  return static_cast<__mmask8>(~valid);
+}
+#elif defined(BATCHED_LOGLIKELIHOOD) && defined(HAVE_AVX2_INSTRUCTIONS) && defined(__AVX2__)
+/**
+ * @brief Computes the log-likelihoods for four consecutive statistics.
+ *
+ * @return Mask of the elements which could not be computed
+ *         and should be computed using the reference function.
+ */
+inline
+int
+computeLogLikelihoods_avx2(
+  const uint32_t* const count,
+  const double* const sum,
+  const double* const sum2,
+  double* const logLikelihood,
+  const uint32_t offsetCount,
+  const double offsetSum,
+  const double offsetSum2
+)
+{
+  const auto& table = LogLikelihoodTable::get();
+  const auto countIdx = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(count)),
+                                      _mm_set1_epi32(static_cast<int>(offsetCount)));
+  // Counts are converted as signed integers; larger counts are not looked up
+  const auto c = _mm256_cvtepi32_pd(countIdx);
+  const auto s = _mm256_add_pd(_mm256_loadu_pd(sum), _mm256_set1_pd(offsetSum));
+  const auto s2 = _mm256_add_pd(_mm256_loadu_pd(sum2), _mm256_set1_pd(offsetSum2));
+  // Dependent parameters
+  const auto lambda1 = _mm256_add_pd(_mm256_set1_pd(NormalGammaPrior::lambda0), c);
+  const auto alpha1 = _mm256_add_pd(_mm256_set1_pd(NormalGammaPrior::alpha0), _mm256_mul_pd(_mm256_set1_pd(0.5), c));
+  const auto d = _mm256_sub_pd(s, _mm256_mul_pd(_mm256_set1_pd(NormalGammaPrior::mu), c));
+  const auto beta1 = _mm256_add_pd(
+    _mm256_add_pd(_mm256_set1_pd(NormalGammaPrior::beta0),
+                  _mm256_mul_pd(_mm256_set1_pd(0.5), _mm256_sub_pd(s2, _mm256_div_pd(_mm256_mul_pd(s, s), c)))),
+    _mm256_div_pd(_mm256_mul_pd(_mm256_set1_pd(NormalGammaPrior::lambda0), _mm256_mul_pd(d, d)),
+                  _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(2.0), lambda1), c)));
+  // Look up the terms that depend only on the count
+  const auto inTable = _mm256_and_pd(_mm256_cmp_pd(c, _mm256_set1_pd(LogLikelihoodTable::size), _CMP_LT_OQ),
+                                     _mm256_cmp_pd(c, _mm256_setzero_pd(), _CMP_GE_OQ));
+  const auto idx = _mm_min_epu32(countIdx, _mm_set1_epi32(LogLikelihoodTable::size - 1));
+  // Masked gathers are used to avoid reading undefined source values
+  const auto all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+  const auto lgammaAlpha = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), table.lgammaAlpha(), idx, all, 8);
+  const auto logLambda = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), table.logLambda(), idx, all, 8);
+  // The logarithm is computed only for positive normal numbers
+  const auto valid = _mm256_and_pd(inTable,
+                                   _mm256_and_pd(_mm256_cmp_pd(beta1, _mm256_set1_pd(std::numeric_limits<double>::min()), _CMP_GE_OQ),
+                                                 _mm256_cmp_pd(beta1, _mm256_set1_pd(std::numeric_limits<double>::max()), _CMP_LE_OQ)));
+  const auto logBeta = log_avx2(_mm256_blendv_pd(_mm256_set1_pd(1.0), beta1, valid));
+  // Log-likelihood computation, in the same order as the reference function
+  auto ll = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(-0.5), c), _mm256_set1_pd(NormalGammaPrior::log2pi));
+  ll = _mm256_add_pd(ll, _mm256_set1_pd(table.fixed()));
+  ll = _mm256_add_pd(ll, lgammaAlpha);
+  ll = _mm256_sub_pd(ll, _mm256_mul_pd(alpha1, logBeta));
+  ll = _mm256_sub_pd(ll, _mm256_mul_pd(_mm256_set1_pd(0.5), logLambda));
+  _mm256_storeu_pd(logLikelihood, ll);
+  return ~_mm256_movemask_pd(valid) & 0xF;
+}
+#endif
+
+/**
+ * @brief Computes the log-likelihoods for arrays of statistics. The given
+ *        offsets are added to the statistics of all the elements.
+ *
+ * If BATCHED_LOGLIKELIHOOD is defined and AVX-512 or AVX2 instructions are
+ * available, the log-likelihoods are computed in batches using look up
+ * tables for the terms that depend only on the count and a vectorized
+ * logarithm. The results deviate from those of computeLogLikelihood, which
+ * is the reference, only because of the logarithm; the maximum relative
+ * deviation is checked by the accuracy test in test/LogLikelihood.hpp.
+ * Otherwise, the log-likelihoods are computed using the reference function
+ * and are exactly the same.
+ *
+ * @param n Number of elements in the arrays.
+ * @param count Array with the number of data points.
+ * @param sum Array with the sums of the data points.
+ * @param sum2 Array with the sums of squares of the data points.
+ * @param logLikelihood Array to be filled with the log-likelihoods.
+ * @param offsetCount Number of data points to be added to every element.
+ * @param offsetSum Sum of the data points to be added to every element.
+ * @param offsetSum2 Sum of squares of the data points to be added to every element.
+ */
+inline
+void
+computeLogLikelihoods(
+  const size_t n,
+  const uint32_t* const count,
+  const double* const sum,
+  const double* const sum2,
+  double* const logLikelihood,
+  const uint32_t offsetCount = 0u,
+  const double offsetSum = 0.0,
+  const double offsetSum2 = 0.0
+)
+{
+  size_t i = 0u;
+#if defined(BATCHED_LOGLIKELIHOOD) && defined(HAVE_AVX512BW_INSTRUCTIONS) && defined(__AVX512F__)
+  for ( ; i + 8 <= n; i += 8) {
+    auto fallback = computeLogLikelihoods_avx512(count + i, sum + i, sum2 + i, logLikelihood + i,
+                                                 offsetCount, offsetSum, offsetSum2);
+    for (auto k = 0u; fallback != 0; ++k, fallback >>= 1) {
+      if (fallback & 1) {
+        logLikelihood[i + k] = computeLogLikelihood(count[i + k] + offsetCount,
+                                                    sum[i + k] + offsetSum,
+                                                    sum2[i + k] + offsetSum2);
+      }
+    }
+  }
+#elif defined(BATCHED_LOGLIKELIHOOD) && defined(HAVE_AVX2_INSTRUCTIONS) && defined(__AVX2__)
+  for ( ; i + 4 <= n; i += 4) {
+    auto fallback = computeLogLikelihoods_avx2(count + i, sum + i, sum2 + i, logLikelihood + i,
+                                               offsetCount, offsetSum, offsetSum2);
+    for (auto k = 0u; fallback != 0; ++k, fallback >>= 1) {
+      if (fallback & 1) {
+        logLikelihood[i + k] = computeLogLikelihood(count[i + k] + offsetCount,
+                                                    sum[i + k] + offsetSum,
+                                                    sum2[i + k] + offsetSum2);
+      }
+    }
+  }
+#endif
+  for ( ; i < n; ++i) {
+    logLikelihood[i] = computeLogLikelihood(count[i] + offsetCount, sum[i] + offsetSum, sum2[i] + offsetSum2);
+  }
+}
+
+#endif // DETAIL_LOGLIKELIHOOD_HPP_
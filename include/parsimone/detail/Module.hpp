@@ -23,36 +23,45 @@
 #include "TreeNode.hpp"
 
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 class Module {
 public:
-  Module(const Set&&, const mxx::comm&, const Data&);
+  Module(const VarSet&&, const mxx::comm&, const Data&);
 
-  const Set&
+  const VarSet&
   variables() const;
 
   void
-  learnTreeStructures(const std::list<std::list<Set>>&&, const bool, const double);
+  learnTreeStructures(const std::list<std::list<ObsSet>>&&, const bool, const double);
 
   uint32_t
   nodeCount() const;
 
-  std::vector<uint32_t>
-  nodeWeights() const;
+  template <typename CostIt>
+  CostIt
+  estimateSplitCosts(const VarSet&, const double, const uint32_t, const uint32_t, const uint32_t, CostIt) const;
+
+  template <typename CostIt>
+  void
+  setSplitCosts(CostIt&);
 
   uint64_t
-  splitWeight(const Set&) const;
+  splitWeight(const VarSet&) const;
 
-  void
-  candidateParentsSplits(std::vector<std::tuple<uint32_t, Var, Var, double>>&, const Set&, const OptimalBeta&, const uint32_t, const uint64_t, const uint64_t) const;
+  std::vector<uint64_t>
+  nodeSplitWeights(const VarSet&) const;
+
+  template <typename SplitIt>
+  SplitIt
+  candidateParentsSplits(const VarSet&, const OptimalBeta&, const uint32_t, const uint64_t, const uint64_t, SplitIt) const;
 
   template <typename Generator>
   void
-  learnParents(Generator&, const Set&, const OptimalBeta&, const uint32_t);
+  learnParents(Generator&, const VarSet&, const OptimalBeta&, const uint32_t, const bool);
 
   template <typename Generator, typename ValidIt, typename SplitIt>
   void
-  learnParents(Generator&, const Set&, const OptimalBeta&, const uint32_t, uint32_t, uint32_t, ValidIt&, SplitIt&);
+  learnParents(Generator&, const VarSet&, const OptimalBeta&, const uint32_t, const bool, uint32_t, uint32_t, ValidIt&, SplitIt&);
 
   template <typename ValidIt, typename SplitIt>
   void
@@ -69,30 +78,30 @@ public:
   toXML(Stream&, const uint32_t) const;
 
 private:
-  std::shared_ptr<TreeNode<Data, Var, Set>>
-  bestOrderedMerge(const std::list<std::shared_ptr<TreeNode<Data, Var, Set>>>&, const bool) const;
+  std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>
+  bestOrderedMerge(const std::list<std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>>&, const bool) const;
 
   void
-  updateParentsWeights(const TreeNode<Data, Var, Set>* const);
+  updateParentsWeights(const TreeNode<Data, Var, VarSet, Obs, ObsSet>* const);
 
   void
-  setSplitsUpdateWeights(TreeNode<Data, Var, Set>* const, const uint32_t, const typename std::vector<std::tuple<Var, Var, double>>::const_iterator&);
+  setSplitsUpdateWeights(TreeNode<Data, Var, VarSet, Obs, ObsSet>* const, const uint32_t, const typename std::vector<std::tuple<Var, Obs, double>>::const_iterator&);
 
   void
-  setSplitsUpdateWeights(TreeNode<Data, Var, Set>* const, const uint32_t, const typename std::vector<std::tuple<uint32_t, Var, Var, double>>::iterator&);
+  setSplitsUpdateWeights(TreeNode<Data, Var, VarSet, Obs, ObsSet>* const, const uint32_t, const typename std::vector<std::tuple<uint32_t, Var, Obs, double>>::iterator&);
 
 private:
-  std::list<std::shared_ptr<TreeNode<Data, Var, Set>>> m_trees;
+  std::list<std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>> m_trees;
   std::unordered_map<Var, double> m_allParents;
   std::unordered_map<Var, double> m_randParents;
-  const Set m_variables;
+  const VarSet m_variables;
   const mxx::comm& m_comm;
   const Data& m_data;
 }; // class Module
 
-template <typename Data, typename Var, typename Set>
-Module<Data, Var, Set>::Module(
-  const Set&& variables,
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+Module<Data, Var, VarSet, Obs, ObsSet>::Module(
+  const VarSet&& variables,
   const mxx::comm& comm,
   const Data& data
 ) : m_trees(),
@@ -104,27 +113,27 @@ Module<Data, Var, Set>::Module(
 {
 }
 
-template <typename Data, typename Var, typename Set>
-const Set&
-Module<Data, Var, Set>::variables(
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+const VarSet&
+Module<Data, Var, VarSet, Obs, ObsSet>::variables(
 ) const
 {
   return m_variables;
 }
 
-template <typename Data, typename Var, typename Set>
-std::shared_ptr<TreeNode<Data, Var, Set>>
-Module<Data, Var, Set>::bestOrderedMerge(
-  const std::list<std::shared_ptr<TreeNode<Data, Var, Set>>>& treeList,
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>
+Module<Data, Var, VarSet, Obs, ObsSet>::bestOrderedMerge(
+  const std::list<std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>>& treeList,
   const bool scoreBHC
 ) const
 {
   LOG_MESSAGE_IF(treeList.empty(), error, "Empty tree list passed to ordered merge");
   if (treeList.size() > 1) {
-    std::shared_ptr<TreeNode<Data, Var, Set>> bestMerged;
+    std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>> bestMerged;
     double bestScore = std::numeric_limits<double>::lowest();
     for (auto fit = treeList.begin(), sit = std::next(fit); sit != treeList.end(); ++fit, ++sit) {
-      auto mergedTree = std::make_shared<TreeNode<Data, Var, Set>>(*fit, *sit);
+      auto mergedTree = std::make_shared<TreeNode<Data, Var, VarSet, Obs, ObsSet>>(*fit, *sit);
       auto mergeScore = mergedTree->mergeScore(scoreBHC);
       if ((bestScore == std::numeric_limits<double>::lowest()) ||
           std::isgreater(mergeScore, bestScore) ||
@@ -142,21 +151,21 @@ Module<Data, Var, Set>::bestOrderedMerge(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-Module<Data, Var, Set>::learnTreeStructures(
-  const std::list<std::list<Set>>&& sampledClusters,
+Module<Data, Var, VarSet, Obs, ObsSet>::learnTreeStructures(
+  const std::list<std::list<ObsSet>>&& sampledClusters,
   const bool scoreBHC,
   const double scoreGain
 )
 {
-  static auto treeCompare = [] (const std::shared_ptr<TreeNode<Data, Var, Set>>& a, const std::shared_ptr<TreeNode<Data, Var, Set>>& b)
+  static auto treeCompare = [] (const std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>& a, const std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>& b)
                                { return a->mean() < b->mean(); };
   // Learn hierarchical trees for all the sampled observation clusters
   for (const auto& obsClusters : sampledClusters) {
-    std::list<std::shared_ptr<TreeNode<Data, Var, Set>>> treeList;
+    std::list<std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>> treeList;
     for (const auto& cluster : obsClusters) {
-      auto newTree = std::make_shared<TreeNode<Data, Var, Set>>(this->m_data, m_variables, cluster);
+      auto newTree = std::make_shared<TreeNode<Data, Var, VarSet, Obs, ObsSet>>(this->m_data, m_variables, cluster);
       auto it = std::upper_bound(treeList.begin(), treeList.end(), newTree, treeCompare);
       treeList.insert(it, newTree);
     }
@@ -176,9 +185,9 @@ Module<Data, Var, Set>::learnTreeStructures(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 uint32_t
-Module<Data, Var, Set>::nodeCount(
+Module<Data, Var, VarSet, Obs, ObsSet>::nodeCount(
 ) const
 {
   uint32_t count = 0u;
@@ -188,26 +197,71 @@ Module<Data, Var, Set>::nodeCount(
   return count;
 }
 
-template <typename Data, typename Var, typename Set>
-std::vector<uint32_t>
-Module<Data, Var, Set>::nodeWeights(
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+template <typename CostIt>
+/**
+ * @brief Estimates the cost per candidate split for the given range of
+ *        the nodes of this module, and writes it to the output iterator.
+ *
+ * @tparam CostIt Type of the output iterator for the costs.
+ * @param candidateParents The candidate parents for the splits.
+ * @param numEvaluations Average number of evaluations for finding beta.
+ * @param maxParents Maximum number of candidate parents sampled for a node.
+ * @param firstNode The index of the first node in the range.
+ * @param numNodes The number of nodes in the range.
+ * @param costIt Output iterator for the costs.
+ *
+ * @return The output iterator after writing the costs.
+ */
+CostIt
+Module<Data, Var, VarSet, Obs, ObsSet>::estimateSplitCosts(
+  const VarSet& candidateParents,
+  const double numEvaluations,
+  const uint32_t maxParents,
+  const uint32_t firstNode,
+  const uint32_t numNodes,
+  CostIt costIt
 ) const
 {
-  std::vector<uint32_t> weights(this->nodeCount());
-  auto wIt = weights.begin();
+  auto n = 0u;
   for (auto& tree : m_trees) {
     for (auto* node : tree->nodes()) {
-      *wIt = node->observations().size();
-      ++wIt;
+      if ((n >= firstNode) && (n < firstNode + numNodes)) {
+        *costIt = node->estimateSplitCost(candidateParents, numEvaluations, maxParents);
+        ++costIt;
+      }
+      ++n;
     }
   }
-  return weights;
+  return costIt;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+template <typename CostIt>
+/**
+ * @brief Sets the cost per candidate split for all the nodes of this module.
+ *
+ * @tparam CostIt Type of the iterator over the costs.
+ * @param costIt Iterator to the cost for the first node of this module,
+ *               advanced past the cost for the last node.
+ */
+void
+Module<Data, Var, VarSet, Obs, ObsSet>::setSplitCosts(
+  CostIt& costIt
+)
+{
+  for (auto& tree : m_trees) {
+    for (auto* node : tree->nodes()) {
+      node->setSplitCost(*costIt);
+      ++costIt;
+    }
+  }
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 uint64_t
-Module<Data, Var, Set>::splitWeight(
-  const Set& candidateParents
+Module<Data, Var, VarSet, Obs, ObsSet>::splitWeight(
+  const VarSet& candidateParents
 ) const
 {
   uint64_t splitWeight = 0u;
@@ -219,19 +273,57 @@ Module<Data, Var, Set>::splitWeight(
   return splitWeight;
 }
 
-template <typename Data, typename Var, typename Set>
-void
-Module<Data, Var, Set>::candidateParentsSplits(
-  std::vector<std::tuple<uint32_t, Var, Var, double>>& candidateSplits,
-  const Set& candidateParents,
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Returns the weights of the candidate splits for every node of this
+ *        module, in the same order as the global node indices.
+ *
+ * @param candidateParents The candidate parents for the splits.
+ */
+std::vector<uint64_t>
+Module<Data, Var, VarSet, Obs, ObsSet>::nodeSplitWeights(
+  const VarSet& candidateParents
+) const
+{
+  std::vector<uint64_t> weights;
+  for (auto& tree : m_trees) {
+    for (auto* node : tree->nodes()) {
+      weights.push_back(node->splitWeight(candidateParents));
+    }
+  }
+  return weights;
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+template <typename SplitIt>
+/**
+ * @brief Computes the valid splits in the given range of the candidate
+ *        splits of the nodes of this module, and writes them, along with
+ *        the global index of the corresponding node, to the output iterator.
+ *
+ * @tparam SplitIt Type of the output iterator for the splits.
+ * @param candidateParents The candidate parents for the splits.
+ * @param ob Object used for finding the optimal beta for a split.
+ * @param firstNode The global index of the first node of this module.
+ * @param firstWeight The weight of the splits of this module preceding the range.
+ * @param maxWeight The weight of the splits in the range.
+ * @param splitIt Output iterator for the splits.
+ *
+ * @return The output iterator after writing the splits.
+ */
+SplitIt
+Module<Data, Var, VarSet, Obs, ObsSet>::candidateParentsSplits(
+  const VarSet& candidateParents,
   const OptimalBeta& ob,
   const uint32_t firstNode,
   const uint64_t firstWeight,
-  const uint64_t maxWeight
+  const uint64_t maxWeight,
+  SplitIt splitIt
 ) const
 {
-  std::list<std::tuple<uint32_t, Var, Var, double>> learnedSplits;
   auto nodeIndex = firstNode;
+  auto addNodeIndex = [&nodeIndex, &splitIt] (const std::tuple<Var, Obs, double>& split)
+                                             { *splitIt = std::tuple_cat(std::tie(nodeIndex), split); ++splitIt; };
   uint64_t prevWeight = 0u;
   for (auto& tree : m_trees) {
     for (auto* node : tree->nodes()) {
@@ -239,16 +331,11 @@ Module<Data, Var, Set>::candidateParentsSplits(
       if ((prevWeight + nodeWeight) >= firstWeight) {
         uint64_t nodeFirstWeight = (firstWeight >= prevWeight) ? (firstWeight - prevWeight) : 0u;
         uint64_t nodeMaxWeight = std::min(nodeWeight, firstWeight + maxWeight - prevWeight) - nodeFirstWeight;
-        auto nodeSplits = node->candidateParentsSplits(candidateParents, ob, nodeFirstWeight, nodeMaxWeight);
-        auto addNodeIndex = [&nodeIndex] (const std::tuple<Var, Var, double>& split)
-                                         { return std::tuple_cat(std::tie(nodeIndex), split); };
-        auto prevCandidatesSize = candidateSplits.size();
-        candidateSplits.resize(prevCandidatesSize + nodeSplits.size());
-        auto candidateIt = std::next(candidateSplits.begin(), prevCandidatesSize);
-        std::transform(nodeSplits.begin(), nodeSplits.end(), candidateIt, addNodeIndex);
+        node->candidateParentsSplits(candidateParents, ob, nodeFirstWeight, nodeMaxWeight,
+                                     boost::make_function_output_iterator(std::ref(addNodeIndex)));
         prevWeight += (nodeFirstWeight + nodeMaxWeight);
         if (prevWeight >= (firstWeight + maxWeight)) {
-          return;
+          return splitIt;
         }
       }
       else {
@@ -257,12 +344,13 @@ Module<Data, Var, Set>::candidateParentsSplits(
       ++nodeIndex;
     }
   }
+  return splitIt;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-Module<Data, Var, Set>::updateParentsWeights(
-  const TreeNode<Data, Var, Set>* const node
+Module<Data, Var, VarSet, Obs, ObsSet>::updateParentsWeights(
+  const TreeNode<Data, Var, VarSet, Obs, ObsSet>* const node
 )
 {
   auto nodeObs = node->observations().size();
@@ -285,19 +373,20 @@ Module<Data, Var, Set>::updateParentsWeights(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
 void
-Module<Data, Var, Set>::learnParents(
+Module<Data, Var, VarSet, Obs, ObsSet>::learnParents(
   Generator& generator,
-  const Set& candidateParents,
+  const VarSet& candidateParents,
   const OptimalBeta& ob,
-  const uint32_t numSplits
+  const uint32_t numSplits,
+  const bool streamSplits
 )
 {
   for (auto& tree : m_trees) {
     for (auto* node : tree->nodes()) {
-      if (node->learnParentsSplits(generator, candidateParents, ob, numSplits)) {
+      if (node->learnParentsSplits(generator, candidateParents, ob, numSplits, streamSplits)) {
         this->updateParentsWeights(node);
       }
       else {
@@ -307,14 +396,15 @@ Module<Data, Var, Set>::learnParents(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator, typename ValidIt, typename SplitIt>
 void
-Module<Data, Var, Set>::learnParents(
+Module<Data, Var, VarSet, Obs, ObsSet>::learnParents(
   Generator& generator,
-  const Set& candidateParents,
+  const VarSet& candidateParents,
   const OptimalBeta& ob,
   const uint32_t numSplits,
+  const bool streamSplits,
   uint32_t firstNode,
   uint32_t numNodes,
   ValidIt& validIt,
@@ -334,7 +424,7 @@ Module<Data, Var, Set>::learnParents(
       auto* node = *nodeIt;
       auto weightIt = splitIt;
       auto randomIt = std::next(splitIt, numSplits);
-      if (node->learnParentsSplits(generator, candidateParents, ob, numSplits, weightIt, randomIt)) {
+      if (node->learnParentsSplits(generator, candidateParents, ob, numSplits, streamSplits, weightIt, randomIt)) {
         *validIt = 1;
         std::advance(splitIt, 2 * numSplits);
       }
@@ -344,12 +434,12 @@ Module<Data, Var, Set>::learnParents(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-Module<Data, Var, Set>::setSplitsUpdateWeights(
-  TreeNode<Data, Var, Set>* const node,
+Module<Data, Var, VarSet, Obs, ObsSet>::setSplitsUpdateWeights(
+  TreeNode<Data, Var, VarSet, Obs, ObsSet>* const node,
   const uint32_t numSplits,
-  const typename std::vector<std::tuple<Var, Var, double>>::const_iterator& splitCit
+  const typename std::vector<std::tuple<Var, Obs, double>>::const_iterator& splitCit
 )
 {
   auto first = splitCit;
@@ -361,12 +451,12 @@ Module<Data, Var, Set>::setSplitsUpdateWeights(
   this->updateParentsWeights(node);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-Module<Data, Var, Set>::setSplitsUpdateWeights(
-  TreeNode<Data, Var, Set>* const node,
+Module<Data, Var, VarSet, Obs, ObsSet>::setSplitsUpdateWeights(
+  TreeNode<Data, Var, VarSet, Obs, ObsSet>* const node,
   const uint32_t numSplits,
-  const typename std::vector<std::tuple<uint32_t, Var, Var, double>>::iterator& splitIt
+  const typename std::vector<std::tuple<uint32_t, Var, Obs, double>>::iterator& splitIt
 )
 {
   auto first = splitIt;
@@ -375,19 +465,19 @@ Module<Data, Var, Set>::setSplitsUpdateWeights(
   // This will arrange the tuples in the order of their first element, i.e., the indices
   std::sort(splitIt, last);
   // Now, discard the index of the tuples
-  std::vector<std::tuple<Var, Var, double>> transformed(2 * numSplits);
+  std::vector<std::tuple<Var, Obs, double>> transformed(2 * numSplits);
   std::transform(first, last, transformed.begin(),
-                 [] (const std::tuple<uint32_t, Var, Var, double>& split)
+                 [] (const std::tuple<uint32_t, Var, Obs, double>& split)
                     { return std::make_tuple(std::get<1>(split),
                                              std::get<2>(split),
                                              std::get<3>(split)); });
   this->setSplitsUpdateWeights(node, numSplits, transformed.cbegin());
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename ValidIt, typename SplitIt>
 void
-Module<Data, Var, Set>::syncParents(
+Module<Data, Var, VarSet, Obs, ObsSet>::syncParents(
   const uint32_t numSplits,
   ValidIt& validIt,
   SplitIt& splitIt
@@ -407,26 +497,26 @@ Module<Data, Var, Set>::syncParents(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 const std::unordered_map<Var, double>&
-Module<Data, Var, Set>::allParents(
+Module<Data, Var, VarSet, Obs, ObsSet>::allParents(
 ) const
 {
   return m_allParents;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 const std::unordered_map<Var, double>&
-Module<Data, Var, Set>::randParents(
+Module<Data, Var, VarSet, Obs, ObsSet>::randParents(
 ) const
 {
   return m_randParents;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Stream>
 void
-Module<Data, Var, Set>::toXML(
+Module<Data, Var, VarSet, Obs, ObsSet>::toXML(
   Stream& stream,
   const uint32_t index
 ) const
@@ -29,32 +29,32 @@ NotImplementedError::NotImplementedError(
 {
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Constructs the object with the given data.
  *
  * @param data Reference to an object of the Data.
  */
-ModuleNetworkLearning<Data, Var, Set>::ModuleNetworkLearning(
+ModuleNetworkLearning<Data, Var, VarSet, Obs, ObsSet>::ModuleNetworkLearning(
   const mxx::comm& comm,
   const Data& data
 ) : m_comm(comm),
     m_data(data),
-    m_allVars(set_init(Set(), data.numVars()))
+    m_allVars(set_init(VarSet(), data.numVars()))
 {
   for (auto i = 0u; i < data.numVars(); ++i) {
     m_allVars.insert(m_allVars.end(), i);
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Top level function for getting the module network.
  *
  * @param isParallel Specifies if the network should be learned in parallel.
  */
 void
-ModuleNetworkLearning<Data, Var, Set>::learnNetwork(
+ModuleNetworkLearning<Data, Var, VarSet, Obs, ObsSet>::learnNetwork(
   const bool isParallel,
   const pt::ptree& algoConfigs,
   const std::string& outputDir
@@ -21,7 +21,9 @@
 #define DETAIL_PRIMARYCLUSTER_HPP_
 
 #include "Cluster.hpp"
+#include "ClusterStatistics.hpp"
 #include "SecondaryCluster.hpp"
+#include "SlotVector.hpp"
 #include "Random.hpp"
 
 #include "mxx/partition.hpp"
@@ -96,15 +98,17 @@ distributed_weighted_choose(
  *        primary clusters and computing their score.
  *
  * @tparam Data Type of the data provider.
- * @tparam Var Type of variables stored in the cluster.
- * @tparam Set Type of container used to store the clusters.
+ * @tparam Var Type of the primary variables stored in the cluster.
+ * @tparam VarSet Type of container used to store the primary clusters.
+ * @tparam Obs Type of the secondary variables.
+ * @tparam ObsSet Type of container used to store the secondary clusters.
  */
-template <typename Data, typename Var, typename Set>
-class PrimaryCluster : public Cluster<Data, Var, Set> {
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+class PrimaryCluster : public Cluster<Data, Var, VarSet> {
 public:
-  PrimaryCluster(const Data&, const Var, const Var);
+  PrimaryCluster(const Data&, const Var, const Obs);
 
-  PrimaryCluster(const Data&, const Set&, const Var);
+  PrimaryCluster(const Data&, const VarSet&, const Obs);
 
   PrimaryCluster(const PrimaryCluster&);
 
@@ -112,9 +116,36 @@ public:
 
   ~PrimaryCluster();
 
+  void
+  insert(const Var);
+
+  void
+  erase(const Var);
+
+  void
+  merge(const PrimaryCluster&);
+
+  void
+  clear();
+
   double
   score();
 
+  double
+  scoreMergeSingle(const PrimaryCluster&) const;
+
+  double
+  scoreSingle(const Var, RowStatisticsCache<Var>* const = nullptr) const;
+
+  std::tuple<double, double, uint32_t>
+  secondaryStatistics(const Obs) const;
+
+  std::tuple<double, double, uint32_t>
+  totalStatistics() const;
+
+  void
+  recomputeStatistics();
+
   void
   scoreClear();
 
@@ -122,10 +153,10 @@ public:
   scoreMerge(const PrimaryCluster&, const bool = false);
 
   double
-  scoreInsertPrimary(const Var, const bool = false);
+  scoreInsertPrimary(const Var, const bool = false, RowStatisticsCache<Var>* const = nullptr);
 
   double
-  scoreErasePrimary(const Var, const bool = false);
+  scoreErasePrimary(const Var, const bool = false, RowStatisticsCache<Var>* const = nullptr);
 
   void
   clearSecondary();
@@ -135,54 +166,79 @@ public:
 
   template <typename Generator>
   void
-  randomSecondary(Generator&, const Var);
+  randomSecondary(Generator&, const Obs);
 
   template <typename Generator>
   void
   clusterSecondary(Generator&, const mxx::comm* const, const uint32_t);
 
-  const std::list<SecondaryCluster<Data, Var, Set>>&
+  const SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>&
   secondaryClusters() const;
 
   void
   syncSecondary(const mxx::comm&, const int);
 
 private:
+#ifdef SECONDARY_SOA
+  void
+  gatherStatistics();
+
+  void
+  scatterStatistics();
+#endif
+
+  void
+  addStatistics(const Var);
+
+  void
+  removeStatistics(const Var);
+
   void
   removeEmptyClusters();
 
   template <typename Generator>
-  Var
-  chooseReassignCluster(Generator&, const Var, const double);
+  Obs
+  chooseReassignCluster(Generator&, const Obs, const double);
 
   template <typename Generator>
-  Var
-  chooseReassignCluster(Generator&, const mxx::comm&, const Var, const double);
+  Obs
+  chooseReassignCluster(Generator&, const mxx::comm&, const Obs, const double);
 
   template <typename Generator>
   void
-  reassignSecondary(Generator&, const mxx::comm* const, const Var);
+  reassignSecondary(Generator&, const mxx::comm* const, const Obs);
 
   template <typename Generator>
-  Var
-  chooseMergeCluster(Generator&, const typename std::list<SecondaryCluster<Data, Var, Set>>::iterator&);
+  Obs
+  chooseMergeCluster(Generator&, const typename SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator&);
 
   template <typename Generator>
-  Var
-  chooseMergeCluster(Generator&, const mxx::comm&, const typename std::list<SecondaryCluster<Data, Var, Set>>::iterator&);
+  Obs
+  chooseMergeCluster(Generator&, const mxx::comm&, const typename SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator&);
 
   template <typename Generator>
   bool
-  mergeCluster(Generator&, const mxx::comm* const, typename std::list<SecondaryCluster<Data, Var, Set>>::iterator&);
+  mergeCluster(Generator&, const mxx::comm* const, typename SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator&);
 
 private:
-  std::list<SecondaryCluster<Data, Var, Set>> m_cluster;
-  std::vector<typename std::list<SecondaryCluster<Data, Var, Set>>::iterator> m_membership;
+  SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>> m_cluster;
+  std::vector<typename SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>::Id> m_membership;
+  std::vector<double> m_secondarySum;
+  std::vector<double> m_secondarySum2;
+  std::vector<uint32_t> m_secondaryCount;
   double m_score;
-  const Var m_numSecondaryVars;
+  double m_sum;
+  double m_sum2;
+  uint32_t m_count;
+  const Obs m_numSecondaryVars;
+#ifdef SECONDARY_SOA
+  // Statistics of the secondary clusters, in the same order as the clusters,
+  // which are used only while clustering the secondary variables
+  ClusterStatistics m_clusterStats;
+#endif
 }; // class PrimaryCluster
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Constructs an empty primary cluster.
  *
@@ -190,19 +246,25 @@ template <typename Data, typename Var, typename Set>
  * @param numPrimary Number of primary variables.
  * @param numSecondaryVars Number of secondary variables.
  */
-PrimaryCluster<Data, Var, Set>::PrimaryCluster(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::PrimaryCluster(
   const Data& data,
   const Var numPrimary,
-  const Var numSecondaryVars
-) : Cluster<Data, Var, Set>(data, numPrimary),
+  const Obs numSecondaryVars
+) : Cluster<Data, Var, VarSet>(data, numPrimary),
     m_cluster(),
-    m_membership(numSecondaryVars, m_cluster.end()),
+    m_membership(numSecondaryVars, SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>::none),
+    m_secondarySum(numSecondaryVars, 0.0),
+    m_secondarySum2(numSecondaryVars, 0.0),
+    m_secondaryCount(numSecondaryVars, 0u),
     m_score(std::nan("")),
+    m_sum(),
+    m_sum2(),
+    m_count(),
     m_numSecondaryVars(numSecondaryVars)
 {
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Constructs a primary cluster from the given elements.
  *
@@ -210,42 +272,50 @@ template <typename Data, typename Var, typename Set>
  * @param primaryElements The primary variables in the cluster.
  * @param numSecondaryVars Number of secondary variables.
  */
-PrimaryCluster<Data, Var, Set>::PrimaryCluster(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::PrimaryCluster(
   const Data& data,
-  const Set& primaryElements,
-  const Var numSecondaryVars
-) : Cluster<Data, Var, Set>(data, primaryElements),
+  const VarSet& primaryElements,
+  const Obs numSecondaryVars
+) : Cluster<Data, Var, VarSet>(data, primaryElements),
     m_cluster(),
-    m_membership(numSecondaryVars, m_cluster.end()),
+    m_membership(numSecondaryVars, SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>::none),
+    m_secondarySum(numSecondaryVars, 0.0),
+    m_secondarySum2(numSecondaryVars, 0.0),
+    m_secondaryCount(numSecondaryVars, 0u),
     m_score(std::nan("")),
+    m_sum(),
+    m_sum2(),
+    m_count(),
     m_numSecondaryVars(numSecondaryVars)
 {
+  for (const auto p : this->m_elements) {
+    this->addStatistics(p);
+  }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Copy constructor.
  *
  * @param other The primary cluster to be copied.
  */
-PrimaryCluster<Data, Var, Set>::PrimaryCluster(
-  const PrimaryCluster<Data, Var, Set>& other
-) : Cluster<Data, Var, Set>(other),
-    m_cluster(),
-    m_membership(other.m_numSecondaryVars, m_cluster.end()),
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::PrimaryCluster(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& other
+) : Cluster<Data, Var, VarSet>(other),
+    m_cluster(other.m_cluster),
+    m_membership(other.m_membership),
+    m_secondarySum(other.m_secondarySum),
+    m_secondarySum2(other.m_secondarySum2),
+    m_secondaryCount(other.m_secondaryCount),
     m_score(other.m_score),
+    m_sum(other.m_sum),
+    m_sum2(other.m_sum2),
+    m_count(other.m_count),
     m_numSecondaryVars(other.m_numSecondaryVars)
 {
-  // Create a copy of the secondary clusters
-  for (auto cIt = other.m_cluster.begin(); cIt != other.m_cluster.end(); ++cIt) {
-    m_cluster.emplace_back(*cIt);
-    for (const auto e : cIt->elements()) {
-      m_membership[e] = std::prev(m_cluster.end());
-    }
-  }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Merge constructor creates a new primary cluster
  *        by merging the two given clusters.
@@ -253,35 +323,299 @@ template <typename Data, typename Var, typename Set>
  * @param first The first primary cluster to be merged.
  * @param second The second primary cluster to be merged.
  */
-PrimaryCluster<Data, Var, Set>::PrimaryCluster(
-  const PrimaryCluster<Data, Var, Set>& first,
-  const PrimaryCluster<Data, Var, Set>& second
-) : Cluster<Data, Var, Set>(first, second),
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::PrimaryCluster(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& first,
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& second
+) : Cluster<Data, Var, VarSet>(first, second),
     m_cluster(),
-    m_membership(first.m_numSecondaryVars, m_cluster.end()),
+    m_membership(first.m_numSecondaryVars, SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>::none),
+    m_secondarySum(first.m_secondarySum),
+    m_secondarySum2(first.m_secondarySum2),
+    m_secondaryCount(first.m_secondaryCount),
     m_score(std::nan("")),
+    m_sum(first.m_sum + second.m_sum),
+    m_sum2(first.m_sum2 + second.m_sum2),
+    m_count(first.m_count + second.m_count),
     m_numSecondaryVars(first.m_numSecondaryVars)
 {
+  for (Obs s = 0u; s < m_numSecondaryVars; ++s) {
+    m_secondarySum[s] += second.m_secondarySum[s];
+    m_secondarySum2[s] += second.m_secondarySum2[s];
+    m_secondaryCount[s] += second.m_secondaryCount[s];
+  }
   // Just one secondary cluster with all the elements is created
   this->singleSecondary();
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Default destructor.
  */
-PrimaryCluster<Data, Var, Set>::~PrimaryCluster(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::~PrimaryCluster(
+)
+{
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Adds all the non-missing data points of the given
+ *        primary variable to the statistics of this cluster.
+ *
+ * Every data point is counted first, and the missing data points are
+ * discounted while visiting the stored data points. Therefore, the data
+ * points which are not stored, i.e., the zeros in sparse data sets, are
+ * only counted, since they do not change the sums. The statistics of the
+ * variable are also added to the total statistics of this cluster.
+ *
+ * @param given The index of the primary variable.
+ */
+void
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::addStatistics(
+  const Var given
+)
+{
+  for (Obs s = 0u; s < m_numSecondaryVars; ++s) {
+    ++m_secondaryCount[s];
+  }
+  auto sum = 0.0;
+  auto sum2 = 0.0;
+  uint32_t count = m_numSecondaryVars;
+  this->m_data.forEachStored(given,
+                             [this, &sum, &sum2, &count] (const Obs s, const typename Data::Value value) {
+                               auto d = static_cast<double>(value);
+                               if (std::isnan(d)) {
+                                 --m_secondaryCount[s];
+                                 --count;
+                               }
+                               else {
+                                 m_secondarySum[s] += d;
+                                 m_secondarySum2[s] += d * d;
+                                 sum += d;
+                                 sum2 += d * d;
+                               }
+                             });
+  m_sum += sum;
+  m_sum2 += sum2;
+  m_count += count;
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Removes all the non-missing data points of the given
+ *        primary variable from the statistics of this cluster,
+ *        in the same way as they are added.
+ *
+ * @param given The index of the primary variable.
+ */
+void
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::removeStatistics(
+  const Var given
+)
+{
+  for (Obs s = 0u; s < m_numSecondaryVars; ++s) {
+    --m_secondaryCount[s];
+  }
+  auto sum = 0.0;
+  auto sum2 = 0.0;
+  uint32_t count = m_numSecondaryVars;
+  this->m_data.forEachStored(given,
+                             [this, &sum, &sum2, &count] (const Obs s, const typename Data::Value value) {
+                               auto d = static_cast<double>(value);
+                               if (std::isnan(d)) {
+                                 ++m_secondaryCount[s];
+                                 --count;
+                               }
+                               else {
+                                 m_secondarySum[s] -= d;
+                                 m_secondarySum2[s] -= d * d;
+                                 sum += d;
+                                 sum2 += d * d;
+                               }
+                             });
+  m_sum -= sum;
+  m_sum2 -= sum2;
+  m_count -= count;
+}
+
+#ifdef SECONDARY_SOA
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Copies the statistics of all the secondary clusters
+ *        to the arrays used while clustering the secondary variables.
+ */
+void
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::gatherStatistics(
+)
+{
+  m_clusterStats.clear();
+  for (auto& secondary : m_cluster) {
+    m_clusterStats.push_back(secondary.scoreState(*this));
+  }
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Copies the statistics from the arrays used while clustering
+ *        the secondary variables back to all the secondary clusters.
+ */
+void
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::scatterStatistics(
+)
+{
+  auto pos = 0u;
+  for (auto& secondary : m_cluster) {
+    secondary.scoreState(*this, m_clusterStats.state(pos++));
+  }
+  m_clusterStats.clear();
+}
+#endif
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Inserts a primary variable in this cluster
+ *        and updates the statistics of the cluster.
+ *
+ * @param given The index of the primary variable to be inserted.
+ */
+void
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::insert(
+  const Var given
+)
+{
+  Cluster<Data, Var, VarSet>::insert(given);
+  this->addStatistics(given);
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Erases a primary variable from this cluster
+ *        and updates the statistics of the cluster.
+ *
+ * @param given The index of the primary variable to be erased.
+ */
+void
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::erase(
+  const Var given
+)
+{
+  Cluster<Data, Var, VarSet>::erase(given);
+  if (this->empty()) {
+    // Discard the rounding errors accumulated in the statistics
+    this->clear();
+  }
+  else {
+    this->removeStatistics(given);
+  }
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Merges the primary variables from the other cluster
+ *        into this cluster and updates the statistics of the cluster.
+ *
+ * @param other The primary cluster to be merged.
+ */
+void
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::merge(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& other
+)
+{
+  Cluster<Data, Var, VarSet>::merge(other);
+  for (Obs s = 0u; s < m_numSecondaryVars; ++s) {
+    m_secondarySum[s] += other.m_secondarySum[s];
+    m_secondarySum2[s] += other.m_secondarySum2[s];
+    m_secondaryCount[s] += other.m_secondaryCount[s];
+  }
+  m_sum += other.m_sum;
+  m_sum2 += other.m_sum2;
+  m_count += other.m_count;
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Removes all the primary variables from this cluster
+ *        and resets the statistics of the cluster.
+ */
+void
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::clear(
 )
 {
+  Cluster<Data, Var, VarSet>::clear();
+  std::fill(m_secondarySum.begin(), m_secondarySum.end(), 0.0);
+  std::fill(m_secondarySum2.begin(), m_secondarySum2.end(), 0.0);
+  std::fill(m_secondaryCount.begin(), m_secondaryCount.end(), 0u);
+  m_sum = 0.0;
+  m_sum2 = 0.0;
+  m_count = 0u;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Returns the statistics of the non-missing data points of all
+ *        the primary variables in this cluster for a secondary variable.
+ *
+ * @param given The index of the secondary variable.
+ *
+ * @return A tuple with the sum, the sum of squares, and the count.
+ */
+std::tuple<double, double, uint32_t>
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::secondaryStatistics(
+  const Obs given
+) const
+{
+  return std::make_tuple(m_secondarySum[given], m_secondarySum2[given], m_secondaryCount[given]);
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Returns the statistics of the non-missing data points of all
+ *        the primary variables in this cluster for all the secondary
+ *        variables, which are accumulated variable by variable.
+ *
+ * @return A tuple with the sum, the sum of squares, and the count.
+ */
+std::tuple<double, double, uint32_t>
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::totalStatistics(
+) const
+{
+  return std::make_tuple(m_sum, m_sum2, m_count);
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Recomputes the statistics of this cluster from the data of all
+ *        its primary variables, and clears the cached scores.
+ *
+ * The statistics are updated incrementally whenever primary variables are
+ * inserted or erased, which accumulates rounding errors over the moves.
+ * Recomputing the statistics discards these errors, and the statistics are
+ * then identical to those of a cluster constructed from the same elements.
+ */
+void
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::recomputeStatistics(
+)
+{
+  std::fill(m_secondarySum.begin(), m_secondarySum.end(), 0.0);
+  std::fill(m_secondarySum2.begin(), m_secondarySum2.end(), 0.0);
+  std::fill(m_secondaryCount.begin(), m_secondaryCount.end(), 0u);
+  m_sum = 0.0;
+  m_sum2 = 0.0;
+  m_count = 0u;
+  for (const auto p : this->m_elements) {
+    this->addStatistics(p);
+  }
+  // The secondary clusters recompute their scores from the new statistics
+  ++this->m_version;
+  this->scoreClear();
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Computes the score of this cluster, if not cached,
  *        and returns it.
  */
 double
-PrimaryCluster<Data, Var, Set>::score(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::score(
 )
 {
   if (std::isnan(m_score)) {
@@ -295,36 +629,105 @@ PrimaryCluster<Data, Var, Set>::score(
   return m_score;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Computes the score of the cluster obtained by merging the other
+ *        primary cluster with this cluster and assigning all the secondary
+ *        variables to a single secondary cluster.
+ *
+ * The score is computed in constant time from the total statistics of the
+ * two clusters. A secondary cluster with all the secondary variables is
+ * scored from the total statistics of its primary cluster; therefore, the
+ * score is identical to the score of the merged cluster. If the statistics
+ * are rescanned from the data, both the scores are rescanned in linear time.
+ *
+ * @param other The primary cluster to be merged.
+ *
+ * @return The score of the merged cluster.
+ */
+double
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreMergeSingle(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& other
+) const
+{
+#ifdef RESCAN_STATISTICS
+  // Rescan the data of all the primary variables in the merged cluster,
+  // in the same order as the secondary cluster of the merged cluster
+  auto sum = 0.0;
+  auto sum2 = 0.0;
+  auto count = 0u;
+  for (const auto p : set_union(this->m_elements, other.m_elements)) {
+    for (Obs s = 0u; s < m_numSecondaryVars; ++s) {
+      auto d = this->m_data(p, s);
+      if (!std::isnan(d)) {
+        sum += d;
+        sum2 += d * d;
+        ++count;
+      }
+    }
+  }
+  return computeLogLikelihood(count, sum, sum2);
+#else
+  return computeLogLikelihood(m_count + other.m_count, m_sum + other.m_sum, m_sum2 + other.m_sum2);
+#endif
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Computes the score of a primary cluster with only the given primary
+ *        variable and the same secondary clusters as this cluster,
+ *        without creating such a cluster.
+ *
+ * @param given The index of the primary variable.
+ * @param rowCache Optional cache for the statistics of the variable.
+ *
+ * @return The score of the cluster with only the given variable.
+ */
+double
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreSingle(
+  const Var given,
+  RowStatisticsCache<Var>* const rowCache
+) const
+{
+  auto score = 0.0;
+  for (const auto& secondary : m_cluster) {
+    score += secondary.scoreSingle(given, rowCache);
+  }
+  return score;
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Clears the cached score for this cluster.
  */
 void
-PrimaryCluster<Data, Var, Set>::scoreClear(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreClear(
 )
 {
   m_score = std::nan("");
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Computes the score of this primary cluster when a primary variable
  *        is inserted, optionally updating the cached score.
  *
  * @param given The index of the primary variable to be inserted.
  * @param cache If the cached score should be updated.
+ * @param rowCache Optional cache for the statistics of the variable.
  *
  * @return The changed score of this cluster after inserting the variable.
  */
 double
-PrimaryCluster<Data, Var, Set>::scoreInsertPrimary(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreInsertPrimary(
   const Var given,
-  const bool cache
+  const bool cache,
+  RowStatisticsCache<Var>* const rowCache
 )
 {
   auto score = 0.0;
   for (auto& secondary : m_cluster) {
-    score += secondary.scoreInsertPrimary(*this, given, cache);
+    score += secondary.scoreInsertPrimary(*this, given, cache, rowCache);
   }
   if (cache) {
     m_score = score;
@@ -332,25 +735,27 @@ PrimaryCluster<Data, Var, Set>::scoreInsertPrimary(
   return score;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Computes the score of this cluster when a primary variable
  *        is erased, optionally updating the cached score.
  *
  * @param given The index of the primary variable to be erased.
  * @param cache If the cached score should be updated.
+ * @param rowCache Optional cache for the statistics of the variable.
  *
  * @return The changed score of this cluster after erasing the variable.
  */
 double
-PrimaryCluster<Data, Var, Set>::scoreErasePrimary(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreErasePrimary(
   const Var given,
-  const bool cache
+  const bool cache,
+  RowStatisticsCache<Var>* const rowCache
 )
 {
   auto score = 0.0;
   for (auto& secondary : m_cluster) {
-    score += secondary.scoreErasePrimary(*this, given, cache);
+    score += secondary.scoreErasePrimary(*this, given, cache, rowCache);
   }
   if (cache) {
     m_score = score;
@@ -358,7 +763,7 @@ PrimaryCluster<Data, Var, Set>::scoreErasePrimary(
   return score;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Computes the score of this cluster when another primary cluster
  *        is merged with it, optionally updating the cached score.
@@ -369,8 +774,8 @@ template <typename Data, typename Var, typename Set>
  * @return The changed score of this cluster after merging the clusters.
  */
 double
-PrimaryCluster<Data, Var, Set>::scoreMerge(
-  const PrimaryCluster<Data, Var, Set>& other,
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreMerge(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& other,
   const bool cache
 )
 {
@@ -378,7 +783,7 @@ PrimaryCluster<Data, Var, Set>::scoreMerge(
   // Iterate over all the secondary clusters and
   // compute the score for each one separately
   for (auto& secondary : m_cluster) {
-    score += secondary.scoreInsertPrimary(*this, other.elements(), cache);
+    score += secondary.scoreInsertPrimary(*this, other, cache);
   }
   if (cache) {
     m_score = score;
@@ -386,44 +791,44 @@ PrimaryCluster<Data, Var, Set>::scoreMerge(
   return score;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Clears all the secondary clusters for this primary cluster.
  *        Also clears the cached score for this cluster.
  */
 void
-PrimaryCluster<Data, Var, Set>::clearSecondary(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::clearSecondary(
 )
 {
   LOG_MESSAGE(info, "Clearing all secondary clusters");
   for (auto& m : m_membership) {
-    m = m_cluster.end();
+    m = SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>::none;
   }
   m_cluster.clear();
   this->scoreClear();
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Creates a single secondary cluster for this primary cluster.
  *        Also clears the cached score for this cluster.
  */
 void
-PrimaryCluster<Data, Var, Set>::singleSecondary(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::singleSecondary(
 )
 {
   LOG_MESSAGE(trace, "Assigning all secondary variables to the same cluster");
   m_cluster.clear();
   m_cluster.emplace_back(this->m_data, m_numSecondaryVars);
   auto single = m_cluster.begin();
-  for (Var e = 0u; e < m_numSecondaryVars; ++e) {
+  for (Obs e = 0u; e < m_numSecondaryVars; ++e) {
     single->insert(e);
-    m_membership[e] = single;
+    m_membership[e] = single.id();
   }
   this->scoreClear();
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Randomly initializes the secondary clusters for this primary cluster.
  *        Also clears the cached score for this cluster.
@@ -433,30 +838,30 @@ template <typename Data, typename Var, typename Set>
  */
 template <typename Generator>
 void
-PrimaryCluster<Data, Var, Set>::randomSecondary(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::randomSecondary(
   Generator& generator,
-  const Var numClusters
+  const Obs numClusters
 )
 {
   LOG_MESSAGE(info, "Randomly assigning secondary variables to %u clusters", static_cast<uint32_t>(numClusters));
-  std::vector<SecondaryCluster<Data, Var, Set>> cluster(numClusters, SecondaryCluster<Data, Var, Set>(this->m_data, m_numSecondaryVars));
+  std::vector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>> cluster(numClusters, SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>(this->m_data, m_numSecondaryVars));
   trng::uniform_int_dist clusterDistrib(0, numClusters);
-  for (Var e = 0u; e < m_numSecondaryVars; ++e) {
+  for (Obs e = 0u; e < m_numSecondaryVars; ++e) {
     auto c = clusterDistrib(generator);
     cluster[c].insert(e);
   }
-  m_cluster = std::list<SecondaryCluster<Data, Var, Set>>(cluster.begin(), cluster.end());
+  m_cluster = SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>(cluster.begin(), cluster.end());
   this->removeEmptyClusters();
   for (auto cIt = m_cluster.begin(); cIt != m_cluster.end(); ++cIt) {
     for (const auto e : cIt->elements()) {
-      m_membership[e] = cIt;
+      m_membership[e] = cIt.id();
     }
   }
   this->scoreClear();
   LOG_MESSAGE(info, "Assigned secondary variables to %u clusters", m_cluster.size());
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Performs a Gibbs clustering step for the secondary variables
  *        corresponding to this primary cluster.
@@ -468,31 +873,43 @@ template <typename Data, typename Var, typename Set>
  */
 template <typename Generator>
 void
-PrimaryCluster<Data, Var, Set>::clusterSecondary(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::clusterSecondary(
   Generator& generator,
   const mxx::comm* const comm,
   const uint32_t numReps
 )
 {
   trng::uniform_int_dist varDistrib(0, m_numSecondaryVars);
+  // Synchronize the statistics with the data once every step
+  this->recomputeStatistics();
+#ifdef SECONDARY_SOA
+  this->gatherStatistics();
+#endif
   for (auto r = 0u; r < numReps; ++r) {
     // Reassign a random secondary variable for n iterations
     LOG_MESSAGE(info, "Reassigning secondary variables");
     for (auto i = 0u; i < m_numSecondaryVars; ++i) {
-      auto v = static_cast<Var>(varDistrib(generator));
+      auto v = static_cast<Obs>(varDistrib(generator));
       this->reassignSecondary(generator, comm, v);
     }
+    // Compact the clusters once, so that they are accessed
+    // by position in constant time while merging them
+    m_cluster.compact();
     LOG_MESSAGE(info, "Done reassigning secondary variables");
     LOG_MESSAGE(info, "Merging secondary clusters (number of clusters = %u)", m_cluster.size());
     auto merges = 0u;
     for (auto cIt = m_cluster.begin(); (cIt != m_cluster.end()) && (m_cluster.size() > 1); ++merges) {
       if (this->mergeCluster(generator, comm, cIt)) {
+#ifdef SECONDARY_SOA
+        m_clusterStats.erase(cIt - m_cluster.begin());
+#endif
         cIt = m_cluster.erase(cIt);
       }
       else {
         ++cIt;
       }
     }
+    m_cluster.compact();
     LOG_MESSAGE_IF(merges > m_numSecondaryVars,
                    error, "More merges than secondary vars (%u > %u)", merges, m_numSecondaryVars);
     // Always advance generator state to maximum number of possible merges
@@ -500,39 +917,42 @@ PrimaryCluster<Data, Var, Set>::clusterSecondary(
     ::advance(generator, m_numSecondaryVars - merges);
     LOG_MESSAGE(info, "Done merging secondary clusters (number of clusters = %u)", m_cluster.size());
   }
+#ifdef SECONDARY_SOA
+  this->scatterStatistics();
+#endif
   this->scoreClear();
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Returns the secondary clusters corresponding to this primary cluster.
  */
-const std::list<SecondaryCluster<Data, Var, Set>>&
-PrimaryCluster<Data, Var, Set>::secondaryClusters(
+const SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>&
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::secondaryClusters(
 ) const
 {
   return m_cluster;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Removes all the empty secondary clusters from this primary cluster.
  */
 void
-PrimaryCluster<Data, Var, Set>::removeEmptyClusters(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::removeEmptyClusters(
 )
 {
-  auto emptyCluster = [] (const SecondaryCluster<Data, Var, Set>& cluster)
+  auto emptyCluster = [] (const SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>& cluster)
                          { return cluster.empty(); };
   m_cluster.remove_if(emptyCluster);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
-Var
-PrimaryCluster<Data, Var, Set>::chooseReassignCluster(
+Obs
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::chooseReassignCluster(
   Generator& generator,
-  const Var given,
+  const Obs given,
   const double singleScore
 )
 {
@@ -543,27 +963,37 @@ PrimaryCluster<Data, Var, Set>::chooseReassignCluster(
   auto maxDiff = weight[0];
   auto wIt = weight.begin() + 1;
   // Only compute score diffs for existing clusters
+#ifdef SECONDARY_SOA
+  double sum, sum2;
+  uint32_t count;
+  std::tie(sum, sum2, count) = this->secondaryStatistics(given);
+  m_clusterStats.scoreInsertDiffs(0, m_cluster.size(), sum, sum2, count, singleScore, weight.data() + 1);
+  for ( ; wIt != weight.end(); ++wIt) {
+    maxDiff = std::max(*wIt, maxDiff);
+  }
+#else
   for (auto cIt = m_cluster.begin(); cIt != m_cluster.end(); ++cIt, ++wIt) {
     auto thisDiff = cIt->scoreInsertSecondary(*this, given) -
                     (cIt->score(*this) + singleScore);
     *wIt = thisDiff;
     maxDiff = std::max(thisDiff, maxDiff);
   }
+#endif
   for (auto& w : weight) {
     w = exp(w - maxDiff);
   }
   // Pick a cluster using the computed weights
-  auto distrib = discrete_distribution_safe<Var>(weight.cbegin(), weight.cend());
+  auto distrib = discrete_distribution_safe<Obs>(weight.cbegin(), weight.cend());
   return distrib(generator);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
-Var
-PrimaryCluster<Data, Var, Set>::chooseReassignCluster(
+Obs
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::chooseReassignCluster(
   Generator& generator,
   const mxx::comm& comm,
-  const Var given,
+  const Obs given,
   const double singleScore
 )
 {
@@ -579,16 +1009,27 @@ PrimaryCluster<Data, Var, Set>::chooseReassignCluster(
     ++wIt;
   }
   // Only compute score diffs for existing clusters
+#ifdef SECONDARY_SOA
+  double sum, sum2;
+  uint32_t count;
+  std::tie(sum, sum2, count) = this->secondaryStatistics(given);
+  m_clusterStats.scoreInsertDiffs(block.eprefix_size(), block.iprefix_size(), sum, sum2, count, singleScore,
+                                  myWeights.data() + (wIt - myWeights.begin()));
+  for ( ; wIt != myWeights.end(); ++wIt) {
+    myMaxWeight = std::max(*wIt, myMaxWeight);
+  }
+#else
   for (auto cIt = std::next(m_cluster.begin(), block.eprefix_size()); wIt != myWeights.end(); ++cIt, ++wIt) {
     auto thisDiff = cIt->scoreInsertSecondary(*this, given) -
                     (cIt->score(*this) + singleScore);
     *wIt = thisDiff;
     myMaxWeight = std::max(thisDiff, myMaxWeight);
   }
-  return distributed_weighted_choose<Var>(generator, comm, std::move(block), std::move(myWeights), myMaxWeight, true);
+#endif
+  return distributed_weighted_choose<Obs>(generator, comm, std::move(block), std::move(myWeights), myMaxWeight, true);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Moves the given secondary variable to a different
  *        secondary cluster in this primary cluster.
@@ -599,65 +1040,96 @@ template <typename Data, typename Var, typename Set>
  */
 template <typename Generator>
 void
-PrimaryCluster<Data, Var, Set>::reassignSecondary(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::reassignSecondary(
   Generator& generator,
   const mxx::comm* const comm,
-  const Var given
+  const Obs given
 )
 {
   LOG_MESSAGE(debug, "Reassigning secondary variable %u", static_cast<uint32_t>(given));
   // Remove the given var from the old cluster
-  auto oldCluster = m_membership[given];
-  m_membership[given] = m_cluster.end();
+  auto oldId = m_membership[given];
+  m_membership[given] = SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>::none;
   // Create a new cluster with only the given var
-  SecondaryCluster<Data, Var, Set> newCluster(this->m_data, m_numSecondaryVars);
+  SecondaryCluster<Data, Var, VarSet, Obs, ObsSet> newCluster(this->m_data, m_numSecondaryVars);
   newCluster.insert(given);
-  if (oldCluster->size() > 1) {
+#ifdef SECONDARY_SOA
+  double sum, sum2;
+  uint32_t count;
+  std::tie(sum, sum2, count) = this->secondaryStatistics(given);
+  auto oldPos = static_cast<size_t>(m_cluster.find(oldId) - m_cluster.begin());
+#endif
+  if (m_cluster[oldId].size() > 1) {
     // Remove the element and update the score of the cluster
-    oldCluster->scoreEraseSecondary(*this, given, true);
-    oldCluster->erase(given);
+#ifdef SECONDARY_SOA
+    m_clusterStats.remove(oldPos, sum, sum2, count);
+#else
+    m_cluster[oldId].scoreEraseSecondary(*this, given, true);
+#endif
+    m_cluster[oldId].erase(given);
   }
   else {
     // Remove the cluster if this variable was its only element
     LOG_MESSAGE(debug, "Removing the old cluster of the variable");
-    m_cluster.erase(oldCluster);
+    m_cluster.erase(oldId);
+#ifdef SECONDARY_SOA
+    m_clusterStats.erase(oldPos);
+#endif
   }
+#ifdef SECONDARY_SOA
+  auto singleScore = computeLogLikelihood(count, sum, sum2);
+#else
+  auto singleScore = newCluster.score(*this);
+#endif
   auto c = m_cluster.size() + 1;
   if ((comm == nullptr) || (comm->size() == 1)) {
-    c = this->chooseReassignCluster(generator, given, newCluster.score(*this));
+    c = this->chooseReassignCluster(generator, given, singleScore);
   }
   else {
-    c = this->chooseReassignCluster(generator, *comm, given, newCluster.score(*this));
+    c = this->chooseReassignCluster(generator, *comm, given, singleScore);
   }
   if (c == 0) {
     // The variable will stay in its own cluster
     LOG_MESSAGE(info, "Secondary variable %u assigned to a newly created cluster", static_cast<uint32_t>(given));
     m_cluster.push_back(std::move(newCluster));
-    m_membership[given] = std::prev(m_cluster.end());
+    m_membership[given] = std::prev(m_cluster.end()).id();
+#ifdef SECONDARY_SOA
+    m_clusterStats.push_back(std::make_tuple(singleScore, sum, sum2, static_cast<uint64_t>(count)));
+#endif
   }
   else {
     // Add the variable to the chosen cluster
     LOG_MESSAGE(info, "Secondary variable %u assigned to the existing cluster %u",
                       static_cast<uint32_t>(given), static_cast<uint32_t>(c - 1));
     auto chosen = std::next(m_cluster.begin(), c - 1);
+#ifdef SECONDARY_SOA
+    m_clusterStats.insert(c - 1, sum, sum2, count);
+#else
     chosen->scoreInsertSecondary(*this, given, true);
+#endif
     chosen->insert(given);
-    m_membership[given] = chosen;
+    m_membership[given] = chosen.id();
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
-Var
-PrimaryCluster<Data, Var, Set>::chooseMergeCluster(
+Obs
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::chooseMergeCluster(
   Generator& generator,
-  const typename std::list<SecondaryCluster<Data, Var, Set>>::iterator& given
+  const typename SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator& given
 )
 {
   // Compute the weight of merging this cluster with
   // all the other clusters which are not empty
-  auto givenScore = given->score(*this);
   std::vector<double> weight(m_cluster.size(), 0.0);
+#ifdef SECONDARY_SOA
+  m_clusterStats.scoreMergeDiffs(0, m_cluster.size(), given - m_cluster.begin(), weight.data());
+  for (auto& w : weight) {
+    w = exp(w);
+  }
+#else
+  auto givenScore = given->score(*this);
   auto wIt = weight.begin();
   for (auto cIt = m_cluster.begin(); cIt != m_cluster.end(); ++cIt, ++wIt) {
     if (cIt != given) {
@@ -669,23 +1141,27 @@ PrimaryCluster<Data, Var, Set>::chooseMergeCluster(
       *wIt = 1.0;
     }
   }
+#endif
   // Choose a cluster using the computed weights
-  auto distrib = discrete_distribution_safe<Var>(weight.cbegin(), weight.cend());
+  auto distrib = discrete_distribution_safe<Obs>(weight.cbegin(), weight.cend());
   return distrib(generator);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
-Var
-PrimaryCluster<Data, Var, Set>::chooseMergeCluster(
+Obs
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::chooseMergeCluster(
   Generator& generator,
   const mxx::comm& comm,
-  const typename std::list<SecondaryCluster<Data, Var, Set>>::iterator& given
+  const typename SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator& given
 )
 {
-  auto givenScore = given->score(*this);
   mxx::blk_dist block(m_cluster.size(), comm.size(), comm.rank());
   std::vector<double> myWeights(block.local_size(), 0.0);
+#ifdef SECONDARY_SOA
+  m_clusterStats.scoreMergeDiffs(block.eprefix_size(), block.iprefix_size(), given - m_cluster.begin(), myWeights.data());
+#else
+  auto givenScore = given->score(*this);
   auto wIt = myWeights.begin();
   auto cIt = std::next(m_cluster.begin(), block.eprefix_size());
   for (auto c = block.eprefix_size(); c < block.iprefix_size(); ++c, ++cIt, ++wIt) {
@@ -695,10 +1171,11 @@ PrimaryCluster<Data, Var, Set>::chooseMergeCluster(
       *wIt = thisDiff;
     }
   }
-  return distributed_weighted_choose<Var>(generator, comm, std::move(block), std::move(myWeights));
+#endif
+  return distributed_weighted_choose<Obs>(generator, comm, std::move(block), std::move(myWeights));
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Merges the given secondary cluster with another secondary cluster
  *        in this primary cluster.
@@ -708,10 +1185,10 @@ template <typename Data, typename Var, typename Set>
  */
 template <typename Generator>
 bool
-PrimaryCluster<Data, Var, Set>::mergeCluster(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::mergeCluster(
   Generator& generator,
   const mxx::comm* const comm,
-  typename std::list<SecondaryCluster<Data, Var, Set>>::iterator& given
+  typename SlotVector<SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>>::iterator& given
 )
 {
   auto c = m_cluster.size();
@@ -727,9 +1204,13 @@ PrimaryCluster<Data, Var, Set>::mergeCluster(
     // Merge this cluster with the chosen cluster
     // and update the membership of all the moved elements
     for (const auto e : given->elements()) {
-      m_membership[e] = chosen;
+      m_membership[e] = chosen.id();
     }
+#ifdef SECONDARY_SOA
+    m_clusterStats.merge(c, given - m_cluster.begin());
+#else
     chosen->scoreMerge(*this, *given, true);
+#endif
     chosen->merge(*given);
     return true;
   }
@@ -739,18 +1220,18 @@ PrimaryCluster<Data, Var, Set>::mergeCluster(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-PrimaryCluster<Data, Var, Set>::syncSecondary(
+PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>::syncSecondary(
   const mxx::comm& comm,
   const int source
 )
 {
   auto numClusters = m_cluster.size();
   mxx::bcast(numClusters, source, comm);
-  m_cluster.resize(numClusters, SecondaryCluster<Data, Var, Set>(this->m_data, m_numSecondaryVars));
+  m_cluster.resize(numClusters, SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>(this->m_data, m_numSecondaryVars));
   LOG_MESSAGE(info, "Synchronizing secondary clusters from rank %d (number of clusters = %u)", source, m_cluster.size());
-  std::vector<std::reference_wrapper<Set>> allSecondary;
+  std::vector<std::reference_wrapper<ObsSet>> allSecondary;
   std::vector<std::tuple<double, double, double, uint64_t>> allScores(numClusters);
   auto cIt = m_cluster.begin();
   auto sIt = allScores.begin();
@@ -766,7 +1247,7 @@ PrimaryCluster<Data, Var, Set>::syncSecondary(
     for (auto c = 0u; c < numClusters; ++c, ++cIt, ++sIt) {
       cIt->scoreState(*this, *sIt);
       for (const auto e : cIt->elements()) {
-        m_membership[e] = cIt;
+        m_membership[e] = cIt.id();
       }
     }
     this->scoreClear();
@@ -23,6 +23,8 @@
 #include <trng/discrete_dist.hpp>
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
 
 /**
@@ -85,6 +87,28 @@ private:
 }; // class discrete_distribution_safe
 
 
+/**
+ * @brief Returns the weight of a score relative to the maximum score, i.e.,
+ *        exp(score - maxScore). Scores of +infinity get infinite weights
+ *        instead of NaN, so that they are handled as infinite weights.
+ *
+ * @param score The score for which the weight is computed.
+ * @param maxScore The maximum of all the scores.
+ */
+inline
+double
+relativeWeight(
+  const double score,
+  const double maxScore
+)
+{
+  if (std::isinf(maxScore) && std::isgreater(maxScore, 0.0) && (score == maxScore)) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return exp(score - maxScore);
+}
+
+
 template <typename Generator>
 class HasJump {
 private:
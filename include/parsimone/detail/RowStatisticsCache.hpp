@@ -0,0 +1,172 @@
+/**
+ * @file RowStatisticsCache.hpp
+ * @brief Implementation of a bounded cache of the statistics of
+ *        primary variables over secondary clusters.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DETAIL_ROWSTATISTICSCACHE_HPP_
+#define DETAIL_ROWSTATISTICSCACHE_HPP_
+
+#include "utils/Logging.hpp"
+
+#include <boost/functional/hash.hpp>
+
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
+#include <unordered_map>
+
+
+/**
+ * @brief Class that caches the statistics of the non-missing data points
+ *        of a primary variable over the elements of a secondary cluster.
+ *
+ * The entries are keyed by the identity of the secondary cluster, which
+ * changes whenever the elements of the cluster change. Therefore, entries
+ * for modified clusters are never looked up again and are discarded when
+ * the cache is flushed upon reaching its maximum size. The cache may be
+ * accessed concurrently from multiple threads.
+ *
+ * @tparam Var Type of variable indices (expected to be an integer type).
+ */
+template <typename Var>
+class RowStatisticsCache {
+public:
+  RowStatisticsCache(const uint64_t);
+
+  ~RowStatisticsCache();
+
+  bool
+  find(const uint64_t, const Var, std::tuple<double, double, uint32_t>&) const;
+
+  void
+  insert(const uint64_t, const Var, const std::tuple<double, double, uint32_t>&);
+
+  void
+  clear();
+
+  uint64_t
+  size() const;
+
+private:
+  std::unordered_map<std::pair<uint64_t, Var>,
+                     std::tuple<double, double, uint32_t>,
+                     boost::hash<std::pair<uint64_t, Var>>> m_stats;
+  mutable std::shared_mutex m_mutex;
+  const uint64_t m_maxSize;
+}; // class RowStatisticsCache
+
+template <typename Var>
+/**
+ * @brief Constructs an empty cache.
+ *
+ * @param maxSize Maximum number of entries stored in the cache.
+ */
+RowStatisticsCache<Var>::RowStatisticsCache(
+  const uint64_t maxSize
+) : m_stats(),
+    m_mutex(),
+    m_maxSize(maxSize)
+{
+}
+
+template <typename Var>
+/**
+ * @brief Default destructor.
+ */
+RowStatisticsCache<Var>::~RowStatisticsCache(
+)
+{
+}
+
+template <typename Var>
+/**
+ * @brief Looks up the statistics of a primary variable over a secondary cluster.
+ *
+ * @param identity The identity of the secondary cluster.
+ * @param given The index of the primary variable.
+ * @param stats Tuple to be filled with the sum, the sum of squares, and the count.
+ *
+ * @return true if the statistics were found in the cache.
+ */
+bool
+RowStatisticsCache<Var>::find(
+  const uint64_t identity,
+  const Var given,
+  std::tuple<double, double, uint32_t>& stats
+) const
+{
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+  auto found = m_stats.find(std::make_pair(identity, given));
+  if (found == m_stats.end()) {
+    return false;
+  }
+  stats = found->second;
+  return true;
+}
+
+template <typename Var>
+/**
+ * @brief Stores the statistics of a primary variable over a secondary cluster.
+ *        All the existing entries are discarded if the cache is full.
+ *
+ * @param identity The identity of the secondary cluster.
+ * @param given The index of the primary variable.
+ * @param stats Tuple with the sum, the sum of squares, and the count.
+ */
+void
+RowStatisticsCache<Var>::insert(
+  const uint64_t identity,
+  const Var given,
+  const std::tuple<double, double, uint32_t>& stats
+)
+{
+  if (m_maxSize == 0) {
+    return;
+  }
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+  if (m_stats.size() >= m_maxSize) {
+    LOG_MESSAGE(debug, "Flushing the row statistics cache (size = %u)", m_stats.size());
+    m_stats.clear();
+  }
+  m_stats.emplace(std::make_pair(identity, given), stats);
+}
+
+template <typename Var>
+/**
+ * @brief Discards all the entries in the cache.
+ */
+void
+RowStatisticsCache<Var>::clear(
+)
+{
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+  m_stats.clear();
+}
+
+template <typename Var>
+/**
+ * @brief Returns the number of entries in the cache.
+ */
+uint64_t
+RowStatisticsCache<Var>::size(
+) const
+{
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+  return m_stats.size();
+}
+
+#endif // DETAIL_ROWSTATISTICSCACHE_HPP_
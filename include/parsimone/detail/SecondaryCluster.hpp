@@ -21,54 +21,29 @@
 #define DETAIL_SECONDARYCLUSTER_HPP_
 
 #include "Cluster.hpp"
+#include "LogLikelihood.hpp"
+#include "RowStatisticsCache.hpp"
 
+#include <atomic>
 
-/**
- * @brief Computes the log-likelihood from the given statistics.
- *
- * @param count Number of data points.
- * @param sum Sum of the data points.
- * @param sum2 Sum of squares of the data points.
- */
-double
-computeLogLikelihood(
-  const uint32_t count,
-  const double sum,
-  const double sum2
-)
-{
-  // Fixed parameters
-  static constexpr double lambda0 = 0.1;
-  static constexpr double alpha0 = 0.1;
-  static constexpr double beta0 = 0.1;
-  static constexpr double mu = 0.0;
-  static constexpr double log2pi = log(2 * acos(-1));
-  // Function parameter independent computations
-  // lgamma is not a constexpr
-  static const auto fixed = 0.5 * log(lambda0) + alpha0 * log(beta0) - lgamma(alpha0);
-  // Dependent parameters
-  const auto lambda1 = lambda0 + count;
-  const auto alpha1 = alpha0 + 0.5 * count;
-  const auto beta1 = beta0 + 0.5 * (sum2 - pow(sum, 2) / count) +
-                     lambda0 * pow(sum - mu * count, 2) / (2 * lambda1 * count);
-  // Log-likelihood computation
-  auto logLikelihood = -0.5 * count * log2pi + fixed + lgamma(alpha1) -
-                       alpha1 * log(beta1) - 0.5 * log(lambda1);
-  return std::isnan(logLikelihood) ? 0.0 : logLikelihood;
-}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+class PrimaryCluster;
 
 /**
  * @brief Class that provides functionality for storing
  *        primary clusters and computing their score.
  *
  * @tparam Data Type of the data provider.
- * @tparam Var Type of variables stored in the cluster.
- * @tparam Set Type of container used to store the clusters.
+ * @tparam Var Type of the primary variables.
+ * @tparam VarSet Type of container used to store the primary clusters.
+ * @tparam Obs Type of the secondary variables stored in the cluster.
+ * @tparam ObsSet Type of container used to store the secondary clusters.
  */
-template <typename Data, typename Var, typename Set>
-class SecondaryCluster : public Cluster<Data, Var, Set> {
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+class SecondaryCluster : public Cluster<Data, Obs, ObsSet> {
 public:
-  SecondaryCluster(const Data&, const Var);
+  SecondaryCluster(const Data&, const Obs);
 
   SecondaryCluster(const SecondaryCluster&);
 
@@ -76,60 +51,87 @@ public:
 
   ~SecondaryCluster();
 
+  void
+  insert(const Obs);
+
+  void
+  erase(const Obs);
+
+  void
+  merge(const SecondaryCluster&);
+
+  void
+  clear();
+
+  uint64_t
+  identity() const;
+
   double
-  score(const Cluster<Data, Var, Set>&);
+  score(const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>&);
 
   double
-  scoreMerge(const Cluster<Data, Var, Set>&, const SecondaryCluster&, const bool = false);
+  scoreSingle(const Var, RowStatisticsCache<Var>* const = nullptr) const;
 
   double
-  scoreInsertPrimary(const Cluster<Data, Var, Set>&, const Var, const bool = false);
+  scoreMerge(const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>&, const SecondaryCluster&, const bool = false);
 
   double
-  scoreInsertPrimary(const Cluster<Data, Var, Set>&, const Set&, const bool = false);
+  scoreInsertPrimary(const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>&, const Var, const bool = false, RowStatisticsCache<Var>* const = nullptr);
 
   double
-  scoreInsertSecondary(const Cluster<Data, Var, Set>&, const Var, const bool = false);
+  scoreInsertPrimary(const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>&, const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>&, const bool = false);
 
   double
-  scoreErasePrimary(const Cluster<Data, Var, Set>&, const Var, const bool = false);
+  scoreInsertSecondary(const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>&, const Obs, const bool = false);
 
   double
-  scoreEraseSecondary(const Cluster<Data, Var, Set>&, const Var, const bool = false);
+  scoreErasePrimary(const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>&, const Var, const bool = false, RowStatisticsCache<Var>* const = nullptr);
 
-  std::reference_wrapper<Set>
+  double
+  scoreEraseSecondary(const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>&, const Obs, const bool = false);
+
+  std::reference_wrapper<ObsSet>
   elementsRef();
 
   std::tuple<double, double, double, uint64_t>
-  scoreState(const Cluster<Data, Var, Set>&);
+  scoreState(const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>&);
 
   void
-  scoreState(const Cluster<Data, Var, Set>&, const std::tuple<double, double, double, uint64_t>&);
+  scoreState(const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>&, const std::tuple<double, double, double, uint64_t>&);
 
 private:
+  static
+  uint64_t
+  nextIdentity();
+
+  std::tuple<double, double, uint32_t>
+  primaryStatistics(const Var, RowStatisticsCache<Var>* const) const;
+
   void
-  scoreCache(const Cluster<Data, Var, Set>&);
+  scoreCache(const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>&);
 
 private:
-  Set m_primary;
+  uint64_t m_primaryVersion;
+  uint64_t m_identity;
   double m_score;
   double m_sum;
   double m_sum2;
   uint32_t m_count;
 };
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Constructs an empty secondary cluster.
  *
  * @param data The data provider.
  * @param numSecondary Number of secondary variables.
  */
-SecondaryCluster<Data, Var, Set>::SecondaryCluster(
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::SecondaryCluster(
   const Data& data,
-  const Var numSecondary
-) : Cluster<Data, Var, Set>(data, numSecondary),
-    m_primary(),
+  const Obs numSecondary
+) : Cluster<Data, Obs, ObsSet>(data, numSecondary),
+    m_primaryVersion(0),
+    m_identity(nextIdentity()),
     m_score(std::nan("")),
     m_sum(),
     m_sum2(),
@@ -137,16 +139,17 @@ SecondaryCluster<Data, Var, Set>::SecondaryCluster(
 {
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Copy constructor.
  *
  * @param other The secondary cluster to be copied.
  */
-SecondaryCluster<Data, Var, Set>::SecondaryCluster(
-  const SecondaryCluster<Data, Var, Set>& other
-) : Cluster<Data, Var, Set>(other),
-    m_primary(other.m_primary),
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::SecondaryCluster(
+  const SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>& other
+) : Cluster<Data, Obs, ObsSet>(other),
+    m_primaryVersion(other.m_primaryVersion),
+    m_identity(other.m_identity),
     m_score(other.m_score),
     m_sum(other.m_sum),
     m_sum2(other.m_sum2),
@@ -154,7 +157,7 @@ SecondaryCluster<Data, Var, Set>::SecondaryCluster(
 {
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Merge constructor creates a new secondary cluster
  *        by merging the two given clusters.
@@ -162,31 +165,145 @@ template <typename Data, typename Var, typename Set>
  * @param first The first secondary cluster to be merged.
  * @param second The second secondary cluster to be merged.
  */
-SecondaryCluster<Data, Var, Set>::SecondaryCluster(
-  const SecondaryCluster<Data, Var, Set>& first,
-  const SecondaryCluster<Data, Var, Set>& second
-) : Cluster<Data, Var, Set>(first, second),
-    m_primary(first.m_primary),
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::SecondaryCluster(
+  const SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>& first,
+  const SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>& second
+) : Cluster<Data, Obs, ObsSet>(first, second),
+    m_primaryVersion(first.m_primaryVersion),
+    m_identity(nextIdentity()),
     m_score(std::nan("")),
     m_sum(first.m_sum + second.m_sum),
     m_sum2(first.m_sum2 + second.m_sum2),
     m_count(first.m_count + second.m_count)
 {
-  LOG_MESSAGE_IF(first.m_primary != second.m_primary, error,
+  LOG_MESSAGE_IF(first.m_primaryVersion != second.m_primaryVersion, error,
                  "Merging secondary clusters with different primary clusters");
   m_score = computeLogLikelihood(m_count, m_sum, m_sum2);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Default destructor.
  */
-SecondaryCluster<Data, Var, Set>::~SecondaryCluster(
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::~SecondaryCluster(
+)
+{
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Returns a new identity, different from all the previous ones.
+ */
+uint64_t
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::nextIdentity(
+)
+{
+  // Clusters may be modified in parallel threads
+  static std::atomic<uint64_t> identity(0);
+  return ++identity;
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Inserts a secondary variable in this cluster
+ *        and renews the identity of the cluster.
+ *
+ * @param given The index of the secondary variable to be inserted.
+ */
+void
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::insert(
+  const Obs given
 )
 {
+  Cluster<Data, Obs, ObsSet>::insert(given);
+  m_identity = nextIdentity();
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Erases a secondary variable from this cluster
+ *        and renews the identity of the cluster.
+ *
+ * @param given The index of the secondary variable to be erased.
+ */
+void
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::erase(
+  const Obs given
+)
+{
+  Cluster<Data, Obs, ObsSet>::erase(given);
+  m_identity = nextIdentity();
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Merges the secondary variables from the other cluster
+ *        into this cluster and renews the identity of the cluster.
+ *
+ * @param other The secondary cluster to be merged.
+ */
+void
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::merge(
+  const SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>& other
+)
+{
+  Cluster<Data, Obs, ObsSet>::merge(other);
+  m_identity = nextIdentity();
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Removes all the secondary variables from this cluster
+ *        and renews the identity of the cluster.
+ */
+void
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::clear(
+)
+{
+  Cluster<Data, Obs, ObsSet>::clear();
+  m_identity = nextIdentity();
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Returns the identity of this cluster. Two clusters with
+ *        the same identity are guaranteed to have the same elements.
+ */
+uint64_t
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::identity(
+) const
+{
+  return m_identity;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Computes the statistics of the non-missing data points of
+ *        a primary variable over all the secondary variables in this cluster.
+ *
+ * @param given The index of the primary variable.
+ * @param rowCache Optional cache for storing the statistics.
+ *
+ * @return A tuple with the sum, the sum of squares, and the count.
+ */
+std::tuple<double, double, uint32_t>
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::primaryStatistics(
+  const Var given,
+  RowStatisticsCache<Var>* const rowCache
+) const
+{
+  std::tuple<double, double, uint32_t> stats(0.0, 0.0, 0u);
+  if ((rowCache != nullptr) && rowCache->find(m_identity, given, stats)) {
+    return stats;
+  }
+  this->m_data.statistics(given, this->m_elements, stats);
+  if (rowCache != nullptr) {
+    rowCache->insert(m_identity, given, stats);
+  }
+  return stats;
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Caches the score of this cluster corresponding
  *        to the given elements in the primary cluster.
@@ -194,22 +311,23 @@ template <typename Data, typename Var, typename Set>
  * @param primary The primary cluster to be used for score computations.
  */
 void
-SecondaryCluster<Data, Var, Set>::scoreCache(
-  const Cluster<Data, Var, Set>& primary
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreCache(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& primary
 )
 {
   // We need to compute the score if it has never been computed
   // before or if the elements in the primary cluster have changed
-  if (std::isnan(m_score) || (m_primary != primary.elements())) {
-    if (!m_primary.empty()) {
-      // Reset counts for previous data
-      m_sum = 0.0;
-      m_sum2 = 0.0;
-      m_count = 0u;
-    }
-    // Store a snapshot of the elements in the primary cluster
-    m_primary = primary.elements();
-    for (const auto p : m_primary) {
+  if (std::isnan(m_score) || (m_primaryVersion != primary.version())) {
+    // Reset counts for previous data
+    m_sum = 0.0;
+    m_sum2 = 0.0;
+    m_count = 0u;
+    // Store the version of the primary cluster used for the statistics
+    m_primaryVersion = primary.version();
+#ifdef RESCAN_STATISTICS
+    // Rescan the data of all the primary variables in the primary cluster
+    // for all the secondary variables in this cluster, in that order
+    for (const auto p : primary.elements()) {
       for (const auto s : this->m_elements) {
         auto d = this->m_data(p, s);
         if (!std::isnan(d)) {
@@ -219,11 +337,29 @@ SecondaryCluster<Data, Var, Set>::scoreCache(
         }
       }
     }
+#else
+    if (!this->empty() && (this->size() == this->max())) {
+      // The statistics for all the secondary variables are the total
+      // statistics of the primary cluster, which also score the proposals
+      // for merging primary clusters in PrimaryCluster::scoreMergeSingle
+      std::tie(m_sum, m_sum2, m_count) = primary.totalStatistics();
+    }
+    else {
+      // Accumulate the statistics of the primary cluster
+      // for all the secondary variables in this cluster
+      for (const auto s : this->m_elements) {
+        auto stats = primary.secondaryStatistics(s);
+        m_sum += std::get<0>(stats);
+        m_sum2 += std::get<1>(stats);
+        m_count += std::get<2>(stats);
+      }
+    }
+#endif
     m_score = computeLogLikelihood(m_count, m_sum, m_sum2);
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Returns the score of this secondary cluster corresponding
  *        to the given primary cluster elements.
@@ -231,15 +367,37 @@ template <typename Data, typename Var, typename Set>
  * @param primary The primary cluster to be used for score computations.
  */
 double
-SecondaryCluster<Data, Var, Set>::score(
-  const Cluster<Data, Var, Set>& primary
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::score(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& primary
 )
 {
   this->scoreCache(primary);
   return m_score;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Computes the score of this secondary cluster corresponding to
+ *        a primary cluster with only the given primary variable.
+ *
+ * @param given The index of the only primary variable.
+ * @param rowCache Optional cache for the statistics of the variable.
+ *
+ * @return The score of this cluster for the given variable.
+ */
+double
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreSingle(
+  const Var given,
+  RowStatisticsCache<Var>* const rowCache
+) const
+{
+  double sum, sum2;
+  uint32_t count;
+  std::tie(sum, sum2, count) = this->primaryStatistics(given, rowCache);
+  return computeLogLikelihood(count, sum, sum2);
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Computes the score of this cluster when another secondary cluster
  *        is merged with it, optionally updating the cached score.
@@ -251,14 +409,14 @@ template <typename Data, typename Var, typename Set>
  * @return The changed score of this cluster after merging the clusters.
  */
 double
-SecondaryCluster<Data, Var, Set>::scoreMerge(
-  const Cluster<Data, Var, Set>& primary,
-  const SecondaryCluster<Data, Var, Set>& other,
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreMerge(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& primary,
+  const SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>& other,
   const bool cache
 )
 {
   this->scoreCache(primary);
-  LOG_MESSAGE_IF(m_primary != other.m_primary, error,
+  LOG_MESSAGE_IF(m_primaryVersion != other.m_primaryVersion, error,
                  "Merging secondary clusters with different primary clusters");
   auto score = computeLogLikelihood(m_count + other.m_count,
                                     m_sum + other.m_sum,
@@ -272,92 +430,78 @@ SecondaryCluster<Data, Var, Set>::scoreMerge(
   return score;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Computes the score of this secondary cluster when a primary variable
- *        is inserted, optionally updating the cached score.
+ *        is inserted, optionally invalidating the cached score.
  *
  * @param primary The primary cluster to be used for score computations.
  * @param given The index of the primary variable to be inserted.
- * @param cache If the cached score should be updated.
+ * @param cache If the cached score should be invalidated.
+ * @param rowCache Optional cache for the statistics of the variable.
  *
  * @return The changed score of this cluster after inserting the variable.
  */
 double
-SecondaryCluster<Data, Var, Set>::scoreInsertPrimary(
-  const Cluster<Data, Var, Set>& primary,
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreInsertPrimary(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& primary,
   const Var given,
-  const bool cache
+  const bool cache,
+  RowStatisticsCache<Var>* const rowCache
 )
 {
   this->scoreCache(primary);
-  auto sum = 0.0;
-  auto sum2 = 0.0;
-  auto count = 0;
-  for (const auto s : this->m_elements) {
-    auto d = this->m_data(given, s);
-    if (!std::isnan(d)) {
-      sum += d;
-      sum2 += d * d;
-      ++count;
-    }
-  }
+  double sum, sum2;
+  uint32_t count;
+  std::tie(sum, sum2, count) = this->primaryStatistics(given, rowCache);
   auto score = computeLogLikelihood(m_count + count, m_sum + sum, m_sum2 + sum2);
   if (cache) {
-    m_primary.insert(given);
-    m_sum += sum;
-    m_sum2 += sum2;
-    m_count += count;
-    m_score = score;
+    // The primary cluster is expected to be modified right after this,
+    // and the statistics are recomputed from it when they are next used
+    m_score = std::nan("");
   }
   return score;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
- * @brief Computes the score of this secondary cluster when multiple primary variables
- *        are inserted, optionally updating the cached score.
+ * @brief Computes the score of this secondary cluster when all the primary variables
+ *        from another primary cluster are inserted, optionally invalidating the cached score.
  *
  * @param primary The primary cluster to be used for score computations.
- * @param newElements A container with the elements to be inserted in the primary cluster.
- * @param cache If the cached score should be updated.
+ * @param other The primary cluster with the elements to be inserted in the primary cluster.
+ * @param cache If the cached score should be invalidated.
  *
  * @return The changed score of this cluster after inserting the variables.
  */
 double
-SecondaryCluster<Data, Var, Set>::scoreInsertPrimary(
-  const Cluster<Data, Var, Set>& primary,
-  const Set& newElements,
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreInsertPrimary(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& primary,
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& other,
   const bool cache
 )
 {
   this->scoreCache(primary);
   auto sum = 0.0;
   auto sum2 = 0.0;
-  auto count = 0;
+  auto count = 0u;
   // We assume that the sets are mutually exclusive
-  for (const auto p : newElements) {
-    for (const auto s : this->m_elements) {
-      auto d = this->m_data(p, s);
-      if (!std::isnan(d)) {
-        sum += d;
-        sum2 += d * d;
-        ++count;
-      }
-    }
+  for (const auto s : this->m_elements) {
+    auto stats = other.secondaryStatistics(s);
+    sum += std::get<0>(stats);
+    sum2 += std::get<1>(stats);
+    count += std::get<2>(stats);
   }
   auto score = computeLogLikelihood(m_count + count, m_sum + sum, m_sum2 + sum2);
   if (cache) {
-    m_primary = set_union(primary.elements(), newElements);
-    m_sum += sum;
-    m_sum2 += sum2;
-    m_count += count;
-    m_score = score;
+    // The primary cluster is expected to be modified right after this,
+    // and the statistics are recomputed from it when they are next used
+    m_score = std::nan("");
   }
   return score;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Computes the score of this primary cluster when a secondary variable
  *        is inserted, optionally updating the cached score.
@@ -369,24 +513,16 @@ template <typename Data, typename Var, typename Set>
  * @return The changed score of this cluster after inserting the variable.
  */
 double
-SecondaryCluster<Data, Var, Set>::scoreInsertSecondary(
-  const Cluster<Data, Var, Set>& primary,
-  const Var given,
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreInsertSecondary(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& primary,
+  const Obs given,
   const bool cache
 )
 {
   this->scoreCache(primary);
-  auto sum = 0.0;
-  auto sum2 = 0.0;
-  auto count = 0;
-  for (const auto p : m_primary) {
-    auto d = this->m_data(p, given);
-    if (!std::isnan(d)) {
-      sum += d;
-      sum2 += d * d;
-      ++count;
-    }
-  }
+  double sum, sum2;
+  uint32_t count;
+  std::tie(sum, sum2, count) = primary.secondaryStatistics(given);
   auto score = computeLogLikelihood(m_count + count, m_sum + sum, m_sum2 + sum2);
   if (cache) {
     m_sum += sum;
@@ -397,48 +533,40 @@ SecondaryCluster<Data, Var, Set>::scoreInsertSecondary(
   return score;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Computes the score of this cluster when a primary variable
- *        is erased, optionally updating the cached score.
+ *        is erased, optionally invalidating the cached score.
  *
  * @param primary The primary cluster to be used for score computations.
  * @param given The index of the primary variable to be erased.
- * @param cache If the cached score should be updated.
+ * @param cache If the cached score should be invalidated.
+ * @param rowCache Optional cache for the statistics of the variable.
  *
  * @return The changed score of this cluster after erasing the variable.
  */
 double
-SecondaryCluster<Data, Var, Set>::scoreErasePrimary(
-  const Cluster<Data, Var, Set>& primary,
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreErasePrimary(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& primary,
   const Var given,
-  const bool cache
+  const bool cache,
+  RowStatisticsCache<Var>* const rowCache
 )
 {
   this->scoreCache(primary);
-  auto sum = 0.0;
-  auto sum2 = 0.0;
-  auto count = 0;
-  for (const auto s : this->m_elements) {
-    auto d = this->m_data(given, s);
-    if (!std::isnan(d)) {
-      sum += d;
-      sum2 += d * d;
-      ++count;
-    }
-  }
+  double sum, sum2;
+  uint32_t count;
+  std::tie(sum, sum2, count) = this->primaryStatistics(given, rowCache);
   auto score = computeLogLikelihood(m_count - count, m_sum - sum, m_sum2 - sum2);
   if (cache) {
-    m_primary.erase(given);
-    m_sum -= sum;
-    m_sum2 -= sum2;
-    m_count -= count;
-    m_score = score;
+    // The primary cluster is expected to be modified right after this,
+    // and the statistics are recomputed from it when they are next used
+    m_score = std::nan("");
   }
   return score;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 /**
  * @brief Computes the score of this cluster when a secondary variable
  *        is erased, optionally updating the cached score.
@@ -450,24 +578,16 @@ template <typename Data, typename Var, typename Set>
  * @return The changed score of this cluster after erasing the variable.
  */
 double
-SecondaryCluster<Data, Var, Set>::scoreEraseSecondary(
-  const Cluster<Data, Var, Set>& primary,
-  const Var given,
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreEraseSecondary(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& primary,
+  const Obs given,
   const bool cache
 )
 {
   this->scoreCache(primary);
-  auto sum = 0.0;
-  auto sum2 = 0.0;
-  auto count = 0;
-  for (const auto p : m_primary) {
-    auto d = this->m_data(p, given);
-    if (!std::isnan(d)) {
-      sum += d;
-      sum2 += d * d;
-      ++count;
-    }
-  }
+  double sum, sum2;
+  uint32_t count;
+  std::tie(sum, sum2, count) = primary.secondaryStatistics(given);
   auto score = computeLogLikelihood(m_count - count, m_sum - sum, m_sum2 - sum2);
   if (cache) {
     m_sum -= sum;
@@ -478,32 +598,34 @@ SecondaryCluster<Data, Var, Set>::scoreEraseSecondary(
   return score;
 }
 
-template <typename Data, typename Var, typename Set>
-std::reference_wrapper<Set>
-SecondaryCluster<Data, Var, Set>::elementsRef(
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+std::reference_wrapper<ObsSet>
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::elementsRef(
 )
 {
+  // The elements may be modified through the reference
+  m_identity = nextIdentity();
   return std::ref(this->m_elements);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 std::tuple<double, double, double, uint64_t>
-SecondaryCluster<Data, Var, Set>::scoreState(
-  const Cluster<Data, Var, Set>& primary
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreState(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& primary
 )
 {
   this->scoreCache(primary);
   return std::make_tuple(m_score, m_sum, m_sum2, static_cast<uint64_t>(m_count));
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-SecondaryCluster<Data, Var, Set>::scoreState(
-  const Cluster<Data, Var, Set>& primary,
+SecondaryCluster<Data, Var, VarSet, Obs, ObsSet>::scoreState(
+  const PrimaryCluster<Data, Var, VarSet, Obs, ObsSet>& primary,
   const std::tuple<double, double, double, uint64_t>& state
 )
 {
-  m_primary = primary.elements();
+  m_primaryVersion = primary.version();
   std::tie(m_score, m_sum, m_sum2, m_count) = state;
 }
 
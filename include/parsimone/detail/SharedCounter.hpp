@@ -0,0 +1,134 @@
+/**
+ * @file SharedCounter.hpp
+ * @brief Implementation of a counter shared by all the processors.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DETAIL_SHAREDCOUNTER_HPP_
+#define DETAIL_SHAREDCOUNTER_HPP_
+
+#include "mxx/comm.hpp"
+
+#include <cstdint>
+
+
+/**
+ * @brief Class that implements a counter which is stored on the first
+ *        processor and is atomically incremented by any processor, using
+ *        MPI-3 one-sided communication. It is used as a work queue, in
+ *        which every processor takes the next unit of work by incrementing
+ *        the counter, without involving any other processor.
+ *
+ * Unless the MPI library makes progress asynchronously, e.g., with
+ * MPICH_ASYNC_PROGRESS=1 for MPICH, or the network supports the atomic
+ * operations in hardware, the increments by the other processors may only
+ * complete when the first processor calls into the MPI library. Therefore,
+ * the first processor should call progress() regularly while it is busy.
+ */
+class SharedCounter {
+public:
+  SharedCounter(const mxx::comm&);
+
+  SharedCounter(const SharedCounter&) = delete;
+
+  SharedCounter&
+  operator=(const SharedCounter&) = delete;
+
+  ~SharedCounter();
+
+  uint64_t
+  fetchAdd(const uint64_t = 1);
+
+  void
+  progress() const;
+
+private:
+  MPI_Comm m_comm;
+  MPI_Win m_window;
+  uint64_t* m_value;
+  bool m_owner;
+}; // class SharedCounter
+
+/**
+ * @brief Collectively constructs a counter with the value zero.
+ *
+ * @param comm The communicator of the processors sharing the counter.
+ */
+inline
+SharedCounter::SharedCounter(
+  const mxx::comm& comm
+) : m_comm(comm),
+    m_window(MPI_WIN_NULL),
+    m_value(nullptr),
+    m_owner(comm.is_first())
+{
+  auto size = comm.is_first() ? sizeof(uint64_t) : 0;
+  MPI_Win_allocate(size, sizeof(uint64_t), MPI_INFO_NULL, comm, &m_value, &m_window);
+  if (comm.is_first()) {
+    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, m_window);
+    *m_value = 0;
+    MPI_Win_unlock(0, m_window);
+  }
+  comm.barrier();
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, m_window);
+}
+
+/**
+ * @brief Collectively frees the counter.
+ */
+inline
+SharedCounter::~SharedCounter(
+)
+{
+  MPI_Win_unlock_all(m_window);
+  MPI_Win_free(&m_window);
+}
+
+/**
+ * @brief Atomically adds to the counter.
+ *
+ * @param increment The value to be added.
+ *
+ * @return The value of the counter before the addition.
+ */
+inline
+uint64_t
+SharedCounter::fetchAdd(
+  const uint64_t increment
+)
+{
+  uint64_t previous = 0;
+  MPI_Fetch_and_op(&increment, &previous, MPI_UINT64_T, 0, 0, MPI_SUM, m_window);
+  MPI_Win_flush(0, m_window);
+  return previous;
+}
+
+/**
+ * @brief Lets the MPI library make progress on the pending increments
+ *        by the other processors. Only does anything on the first
+ *        processor, which stores the counter.
+ */
+inline
+void
+SharedCounter::progress(
+) const
+{
+  if (m_owner) {
+    int flag = 0;
+    MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, m_comm, &flag, MPI_STATUS_IGNORE);
+  }
+}
+
+#endif // DETAIL_SHAREDCOUNTER_HPP_
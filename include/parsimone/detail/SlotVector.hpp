@@ -0,0 +1,434 @@
+/**
+ * @file SlotVector.hpp
+ * @brief Implementation of a container with stable indices
+ *        and contiguous storage for clusters.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DETAIL_SLOTVECTOR_HPP_
+#define DETAIL_SLOTVECTOR_HPP_
+
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+
+/**
+ * @brief Container which stores its elements in contiguous slots.
+ *
+ * Every element is identified by the index of its slot, which does not
+ * change until the element is erased. Slots of erased elements are kept in
+ * a free list and are reused for new elements. The elements are iterated
+ * in the order of insertion, same as a std::list, using random access
+ * iterators.
+ *
+ * Erasing an element takes constant time; the slot of the element is
+ * released and the element is only marked as erased in the order of
+ * iteration, which the iterators skip. The marks are removed in a single
+ * pass when compact is called, or when they make up half of the order.
+ * Moving an iterator by more than one position, or computing the distance
+ * between two iterators, takes constant time when there are no marks, and
+ * time proportional to the distance otherwise; therefore, the owners should
+ * compact the container before such accesses. Erasing an element, or
+ * compacting the container, invalidates all the iterators except the one
+ * returned by erase. The const accessors do not modify the container, so
+ * that they can be used from multiple threads.
+ *
+ * @tparam T Type of the elements; it is not required to be assignable.
+ */
+template <typename T>
+class SlotVector {
+public:
+  using Id = uint32_t;
+
+  static constexpr Id none = std::numeric_limits<Id>::max();
+
+  template <typename Value>
+  class Iterator : public boost::iterator_facade<Iterator<Value>,
+                                                 Value,
+                                                 boost::random_access_traversal_tag> {
+  public:
+    using Container = std::conditional_t<std::is_const<Value>::value,
+                                         const SlotVector,
+                                         SlotVector>;
+
+    Iterator(
+    ) : m_container(nullptr),
+        m_pos(0)
+    {
+    }
+
+    Iterator(
+      Container* const container,
+      const size_t pos
+    ) : m_container(container),
+        m_pos(pos)
+    {
+    }
+
+    template <typename Other, typename = std::enable_if_t<std::is_convertible<Other*, Value*>::value>>
+    Iterator(
+      const Iterator<Other>& other
+    ) : m_container(other.container()),
+        m_pos(other.pos())
+    {
+    }
+
+    Id
+    id() const
+    {
+      return m_container->m_order[m_pos];
+    }
+
+    Container*
+    container() const
+    {
+      return m_container;
+    }
+
+    size_t
+    pos() const
+    {
+      return m_pos;
+    }
+
+  private:
+    friend class boost::iterator_core_access;
+
+    Value&
+    dereference() const
+    {
+      return *m_container->m_slots[m_container->m_order[m_pos]];
+    }
+
+    template <typename Other>
+    bool
+    equal(const Iterator<Other>& other) const
+    {
+      return m_pos == other.pos();
+    }
+
+    void
+    increment()
+    {
+      m_pos = m_container->nextLive(m_pos + 1);
+    }
+
+    void
+    decrement()
+    {
+      m_pos = m_container->prevLive(m_pos - 1);
+    }
+
+    void
+    advance(const std::ptrdiff_t n)
+    {
+      if (m_container->m_erased == 0) {
+        m_pos += n;
+      }
+      else {
+        for (auto i = n; i > 0; --i) {
+          this->increment();
+        }
+        for (auto i = n; i < 0; ++i) {
+          this->decrement();
+        }
+      }
+    }
+
+    template <typename Other>
+    std::ptrdiff_t
+    distance_to(const Iterator<Other>& other) const
+    {
+      auto first = std::min(m_pos, other.pos());
+      auto last = std::max(m_pos, other.pos());
+      auto distance = static_cast<std::ptrdiff_t>(last - first);
+      if (m_container->m_erased != 0) {
+        distance -= std::count(m_container->m_order.cbegin() + first, m_container->m_order.cbegin() + last, none);
+      }
+      return (m_pos <= other.pos()) ? distance : -distance;
+    }
+
+  private:
+    Container* m_container;
+    size_t m_pos;
+  }; // class Iterator
+
+  using iterator = Iterator<T>;
+  using const_iterator = Iterator<const T>;
+
+public:
+  SlotVector(
+  ) : m_slots(),
+      m_order(),
+      m_position(),
+      m_free(),
+      m_erased(0)
+  {
+  }
+
+  template <typename InputIt>
+  SlotVector(
+    InputIt first,
+    const InputIt last
+  ) : SlotVector()
+  {
+    for (; first != last; ++first) {
+      this->emplace_back(*first);
+    }
+  }
+
+  template <typename... Args>
+  T&
+  emplace_back(Args&&... args)
+  {
+    Id id = static_cast<Id>(m_slots.size());
+    if (m_free.empty()) {
+      m_slots.emplace_back(std::in_place, std::forward<Args>(args)...);
+      m_position.push_back(m_order.size());
+    }
+    else {
+      id = m_free.back();
+      m_free.pop_back();
+      m_slots[id].emplace(std::forward<Args>(args)...);
+      m_position[id] = m_order.size();
+    }
+    m_order.push_back(id);
+    return *m_slots[id];
+  }
+
+  void
+  push_back(const T& value)
+  {
+    this->emplace_back(value);
+  }
+
+  void
+  push_back(T&& value)
+  {
+    this->emplace_back(std::move(value));
+  }
+
+  iterator
+  erase(const const_iterator& it)
+  {
+    auto next = this->nextLive(it.pos() + 1);
+    auto nextId = (next < m_order.size()) ? m_order[next] : none;
+    if (this->mark(it.id())) {
+      next = (nextId != none) ? m_position[nextId] : m_order.size();
+    }
+    return iterator(this, next);
+  }
+
+  void
+  erase(const Id id)
+  {
+    this->mark(id);
+  }
+
+  template <typename Predicate>
+  void
+  remove_if(Predicate pred)
+  {
+    for (auto pos = this->nextLive(0); pos < m_order.size(); pos = this->nextLive(pos + 1)) {
+      auto id = m_order[pos];
+      if (pred(*m_slots[id])) {
+        m_order[pos] = none;
+        ++m_erased;
+        m_slots[id].reset();
+        m_free.push_back(id);
+      }
+    }
+    this->compact();
+  }
+
+  void
+  resize(const size_t count, const T& value)
+  {
+    this->compact();
+    while (m_order.size() > count) {
+      m_slots[m_order.back()].reset();
+      m_free.push_back(m_order.back());
+      m_order.pop_back();
+    }
+    while (m_order.size() < count) {
+      this->emplace_back(value);
+    }
+  }
+
+  void
+  clear()
+  {
+    m_slots.clear();
+    m_order.clear();
+    m_position.clear();
+    m_free.clear();
+    m_erased = 0;
+  }
+
+  T&
+  operator[](const Id id)
+  {
+    return *m_slots[id];
+  }
+
+  const T&
+  operator[](const Id id) const
+  {
+    return *m_slots[id];
+  }
+
+  Id
+  id(const size_t pos) const
+  {
+    return std::next(this->begin(), pos).id();
+  }
+
+  iterator
+  find(const Id id)
+  {
+    if ((id >= m_slots.size()) || !m_slots[id]) {
+      return this->end();
+    }
+    return iterator(this, m_position[id]);
+  }
+
+  const_iterator
+  find(const Id id) const
+  {
+    if ((id >= m_slots.size()) || !m_slots[id]) {
+      return this->end();
+    }
+    return const_iterator(this, m_position[id]);
+  }
+
+  T&
+  front()
+  {
+    return *this->begin();
+  }
+
+  const T&
+  front() const
+  {
+    return *this->begin();
+  }
+
+  size_t
+  size() const
+  {
+    return m_order.size() - m_erased;
+  }
+
+  bool
+  empty() const
+  {
+    return (this->size() == 0);
+  }
+
+  iterator
+  begin()
+  {
+    return iterator(this, this->nextLive(0));
+  }
+
+  iterator
+  end()
+  {
+    return iterator(this, m_order.size());
+  }
+
+  const_iterator
+  begin() const
+  {
+    return const_iterator(this, this->nextLive(0));
+  }
+
+  const_iterator
+  end() const
+  {
+    return const_iterator(this, m_order.size());
+  }
+
+  void
+  compact()
+  {
+    if (m_erased > 0) {
+      auto first = static_cast<size_t>(std::find(m_order.cbegin(), m_order.cend(), none) - m_order.cbegin());
+      m_order.erase(std::remove(m_order.begin() + first, m_order.end(), none), m_order.end());
+      for (auto pos = first; pos < m_order.size(); ++pos) {
+        m_position[m_order[pos]] = pos;
+      }
+      m_erased = 0;
+    }
+  }
+
+private:
+  bool
+  mark(const Id id)
+  {
+    m_order[m_position[id]] = none;
+    ++m_erased;
+    m_slots[id].reset();
+    m_free.push_back(id);
+    // Compact the order once the marks make up half of it, so that the
+    // cost of compacting is amortized over the erased elements
+    if (2 * m_erased >= m_order.size()) {
+      this->compact();
+      return true;
+    }
+    return false;
+  }
+
+  size_t
+  nextLive(size_t pos) const
+  {
+    while ((pos < m_order.size()) && (m_order[pos] == none)) {
+      ++pos;
+    }
+    return pos;
+  }
+
+  size_t
+  prevLive(size_t pos) const
+  {
+    while (m_order[pos] == none) {
+      --pos;
+    }
+    return pos;
+  }
+
+private:
+  // Storage for all the elements, including the erased ones
+  std::vector<std::optional<T>> m_slots;
+  // Slots of the elements in the order of iteration; the slots of the
+  // erased elements are marked until the order is compacted
+  std::vector<Id> m_order;
+  // Position of every slot in the order of iteration
+  std::vector<size_t> m_position;
+  // Slots of the erased elements, which can be reused
+  std::vector<Id> m_free;
+  // Number of the marked slots in the order of iteration
+  size_t m_erased;
+}; // class SlotVector
+
+#endif // DETAIL_SLOTVECTOR_HPP_
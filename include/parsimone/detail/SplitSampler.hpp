@@ -0,0 +1,329 @@
+/**
+ * @file SplitSampler.hpp
+ * @brief Implementation of streaming sampling of parent splits.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DETAIL_SPLITSAMPLER_HPP_
+#define DETAIL_SPLITSAMPLER_HPP_
+
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+
+/**
+ * @brief Class that samples the parent splits of a node, with replacement,
+ *        from a stream of candidate splits without storing the candidates.
+ *
+ * Every draw is an independent race between the candidates, in which every
+ * candidate gets a key and the draw picks the candidate with the largest key.
+ * For the draws weighted by the split scores, the key is score + g, where g
+ * is Gumbel noise, which picks a candidate with probability proportional to
+ * exp(score). For the uniform draws, the key is the Gumbel noise itself.
+ *
+ * Instead of generating the noise of a candidate for every draw, a single
+ * uniform random number per candidate and per kind of draw is used for
+ * generating the largest noise across all the draws; for k draws, this is
+ * a Gumbel variable shifted by log(k). The candidate is skipped if its
+ * largest key can not beat the smallest key among the current winners of the
+ * draws, which is the case for most of the candidates once the draws have
+ * seen a few of them. Otherwise, the noise for all the draws is generated
+ * conditioned on the largest noise, which yields the same distribution as
+ * generating the noise for every draw independently.
+ *
+ * The random numbers are derived by hashing the split with a salt for the
+ * node. Therefore, the sampled splits do not depend on the order in which the
+ * candidates are inserted, and the entries of the samplers for the same node
+ * on different processors can be merged by keeping the better entry for every
+ * draw.
+ *
+ * @tparam Var Type of variable indices (expected to be an integer type).
+ * @tparam Obs Type of observation indices (expected to be an integer type).
+ */
+template <typename Var, typename Obs>
+class SplitSampler {
+public:
+  // Tuple of the key, the parent, the observation, and the score of a split
+  using Entry = std::tuple<double, Var, Obs, double>;
+
+public:
+  SplitSampler(const uint32_t, const uint64_t);
+
+  void
+  insert(const std::tuple<Var, Obs, double>&);
+
+  void
+  merge(const SplitSampler<Var, Obs>&);
+
+  uint64_t
+  count() const;
+
+  const std::vector<Entry>&
+  entries() const;
+
+  template <typename SplitIt>
+  void
+  chosen(SplitIt, SplitIt) const;
+
+  static
+  Entry
+  better(const Entry&, const Entry&);
+
+private:
+  static
+  uint64_t
+  mix(uint64_t);
+
+  static
+  double
+  uniform(const uint64_t);
+
+  void
+  race(const uint32_t, const double, const uint64_t, const Var, const Obs, const double);
+
+  double
+  minKey(const uint32_t) const;
+
+private:
+  std::vector<Entry> m_entries;
+  // Smallest key among the winners of the weighted and the uniform draws
+  double m_minKeys[2];
+  uint64_t m_salt;
+  uint64_t m_count;
+  uint32_t m_numSplits;
+}; // class SplitSampler
+
+template <typename Var, typename Obs>
+/**
+ * @brief Constructs a sampler without any candidates.
+ *
+ * @param numSplits Number of splits drawn with weights, and also uniformly,
+ *                  which must be positive.
+ * @param salt Salt for the random numbers of this node.
+ */
+SplitSampler<Var, Obs>::SplitSampler(
+  const uint32_t numSplits,
+  const uint64_t salt
+) : m_entries(2 * numSplits, Entry(std::nan(""), 0, 0, 0.0)),
+    m_minKeys{-std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()},
+    m_salt(salt),
+    m_count(0),
+    m_numSplits(numSplits)
+{
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Enters the given candidate split in all the draws.
+ *
+ * @param split Tuple of the parent, the observation, and the score of the split.
+ */
+void
+SplitSampler<Var, Obs>::insert(
+  const std::tuple<Var, Obs, double>& split
+)
+{
+  auto parent = std::get<0>(split);
+  auto obs = std::get<1>(split);
+  auto score = std::get<2>(split);
+  auto h = mix(mix(static_cast<uint64_t>(parent)) ^ static_cast<uint64_t>(obs));
+  this->race(0, score, mix(m_salt ^ h), parent, obs, score);
+  this->race(1, 0.0, mix(m_salt ^ (h + 1)), parent, obs, score);
+  ++m_count;
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Merges the candidates entered in another sampler for the same node,
+ *        i.e., with the same salt, into this sampler.
+ *
+ * @param other The sampler to be merged.
+ */
+void
+SplitSampler<Var, Obs>::merge(
+  const SplitSampler<Var, Obs>& other
+)
+{
+  for (auto i = 0u; i < 2 * m_numSplits; ++i) {
+    m_entries[i] = better(m_entries[i], other.m_entries[i]);
+  }
+  m_minKeys[0] = this->minKey(0);
+  m_minKeys[1] = this->minKey(1);
+  m_count += other.m_count;
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the number of candidate splits entered in the draws.
+ */
+uint64_t
+SplitSampler<Var, Obs>::count(
+) const
+{
+  return m_count;
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the currently chosen entries for all the draws.
+ */
+const std::vector<typename SplitSampler<Var, Obs>::Entry>&
+SplitSampler<Var, Obs>::entries(
+) const
+{
+  return m_entries;
+}
+
+template <typename Var, typename Obs>
+template <typename SplitIt>
+/**
+ * @brief Writes the splits chosen by the weighted and the uniform draws.
+ *
+ * @tparam SplitIt Type of the output iterators for the splits.
+ * @param weightIt Output iterator for the splits drawn with weights.
+ * @param randomIt Output iterator for the splits drawn uniformly.
+ */
+void
+SplitSampler<Var, Obs>::chosen(
+  SplitIt weightIt,
+  SplitIt randomIt
+) const
+{
+  for (auto i = 0u; i < m_numSplits; ++i, ++weightIt, ++randomIt) {
+    const auto& w = m_entries[i];
+    *weightIt = std::make_tuple(std::get<1>(w), std::get<2>(w), std::get<3>(w));
+    const auto& r = m_entries[m_numSplits + i];
+    *randomIt = std::make_tuple(std::get<1>(r), std::get<2>(r), std::get<3>(r));
+  }
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the entry which wins the race among the given entries.
+ *        Entries with NaN keys are empty and lose against any other entry.
+ *        Ties are broken in favor of the smaller split, so that the result
+ *        does not depend on the order of the arguments.
+ */
+typename SplitSampler<Var, Obs>::Entry
+SplitSampler<Var, Obs>::better(
+  const Entry& a,
+  const Entry& b
+)
+{
+  if (std::isnan(std::get<0>(b))) {
+    return a;
+  }
+  if (std::isnan(std::get<0>(a))) {
+    return b;
+  }
+  if (std::get<0>(a) != std::get<0>(b)) {
+    return std::isgreater(std::get<0>(a), std::get<0>(b)) ? a : b;
+  }
+  return (std::make_pair(std::get<1>(a), std::get<2>(a)) <= std::make_pair(std::get<1>(b), std::get<2>(b))) ? a : b;
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Finalizer of the SplitMix64 generator, used for hashing.
+ */
+uint64_t
+SplitSampler<Var, Obs>::mix(
+  uint64_t z
+)
+{
+  z += 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the uniform random number in (0, 1) for the given hash.
+ */
+double
+SplitSampler<Var, Obs>::uniform(
+  const uint64_t h
+)
+{
+  return (static_cast<double>(h >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Enters the given candidate split in one kind of the draws.
+ *
+ * @param race Index of the kind of the draws; 0 for weighted, 1 for uniform.
+ * @param offset The offset added to the noise for computing the keys.
+ * @param h Hash of the split for this kind of the draws.
+ * @param parent The parent of the split.
+ * @param obs The observation of the split.
+ * @param score The score of the split.
+ */
+void
+SplitSampler<Var, Obs>::race(
+  const uint32_t race,
+  const double offset,
+  const uint64_t h,
+  const Var parent,
+  const Obs obs,
+  const double score
+)
+{
+  // Logarithm of the largest of the uniform random numbers for all the draws,
+  // which is distributed as u^(1/k) for k draws
+  auto logMax = log(uniform(h)) / m_numSplits;
+  if (std::isless(offset - log(-logMax), m_minKeys[race])) {
+    return;
+  }
+  // The draw which gets the largest random number is picked uniformly, and the
+  // random numbers for the other draws are uniform in (0, largest random number)
+  auto first = race * m_numSplits;
+  auto maxDraw = mix(h) % m_numSplits;
+  for (auto i = 0u; i < m_numSplits; ++i) {
+    auto logU = (i == maxDraw) ? logMax : (logMax + log(uniform(mix(h + i + 1))));
+    m_entries[first + i] = better(m_entries[first + i], Entry(offset - log(-logU), parent, obs, score));
+  }
+  m_minKeys[race] = this->minKey(race);
+}
+
+template <typename Var, typename Obs>
+/**
+ * @brief Returns the smallest key among the winners of one kind of the draws,
+ *        which is -infinity if any of the draws does not have a winner yet.
+ *
+ * @param race Index of the kind of the draws; 0 for weighted, 1 for uniform.
+ */
+double
+SplitSampler<Var, Obs>::minKey(
+  const uint32_t race
+) const
+{
+  auto first = race * m_numSplits;
+  auto key = std::numeric_limits<double>::infinity();
+  for (auto i = first; i < first + m_numSplits; ++i) {
+    if (std::isnan(std::get<0>(m_entries[i]))) {
+      return -std::numeric_limits<double>::infinity();
+    }
+    key = std::min(key, std::get<0>(m_entries[i]));
+  }
+  return key;
+}
+
+#endif // DETAIL_SPLITSAMPLER_HPP_
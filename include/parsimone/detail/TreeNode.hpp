@@ -22,53 +22,137 @@
 
 #include "Assignment.hpp"
 #include "Random.hpp"
+#include "SplitSampler.hpp"
 
+#include <boost/iterator/function_output_iterator.hpp>
 #include <trng/uniform_int_dist.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
 
 class OptimalBeta {
+public:
+  enum class Solver {
+    Bisection,
+    Newton
+  };
+
 public:
   OptimalBeta(
     const double min,
     const double max,
-    const double acc
+    const double acc,
+    const bool fastMath = false,
+    const Solver solver = Solver::Bisection,
+    const bool warmStart = false
   ) : m_min(min),
       m_max(max),
-      m_acc(acc)
+      m_acc(acc),
+      m_fastMath(fastMath),
+      m_solver(solver),
+      m_warmStart(warmStart),
+      m_numSolves(0),
+      m_numEvaluations(0)
+  {
+  }
+
+  bool
+  fastMath() const
+  {
+    return m_fastMath;
+  }
+
+  bool
+  warmStart() const
+  {
+    return m_warmStart;
+  }
+
+  uint64_t
+  numSolves() const
+  {
+    return m_numSolves.load();
+  }
+
+  uint64_t
+  numEvaluations() const
+  {
+    return m_numEvaluations.load();
+  }
+
+  /**
+   * @brief Returns the typical number of evaluations for finding beta,
+   *        if the root is in the initial bracket.
+   *
+   * Both the ends of the bracket are evaluated, and the bracket is then
+   * halved until it is narrower than the accuracy. Bisection evaluates
+   * the lower end once more before halving, while Newton's method
+   * usually saves one of the halvings.
+   */
+  double
+  typicalEvaluations() const
   {
+    auto halvings = std::max(std::ceil(std::log2((m_max - m_min) / m_acc)), 0.0);
+    return ((m_solver == Solver::Newton) ? 2.0 : 3.0) + halvings;
   }
 
-  template <typename Data, typename Var, typename Set>
+  template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
   double
   find(
-    const Assignment<Data, Var, Set>& assmt,
+    const Assignment<Data, Var, VarSet, Obs, ObsSet>& assmt,
     const double sv,
-    const int sign
+    const int sign,
+    const double hint = std::nan("")
   ) const
   {
     auto min = m_min;
     auto max = m_max;
+    auto fMin = 0.0;
     auto optimal = 0.0;
-    auto found = this->init(assmt, sv, sign, min, max);
+    auto evaluations = 0u;
+    auto found = false;
+    if (std::isgreater(hint, m_min)) {
+      // Try a narrow bracket around the given hint first
+      found = this->init(assmt, sv, sign, hint, min, max, fMin, evaluations);
+    }
+    if (!found) {
+      min = m_min;
+      max = m_max;
+      found = this->init(assmt, sv, sign, min, max, fMin, evaluations);
+    }
     if (found) {
-      found = this->bisect(assmt, sv, sign, min, max, optimal);
+      if (m_solver == Solver::Newton) {
+        found = this->newton(assmt, sv, sign, min, max, fMin, hint, optimal, evaluations);
+      }
+      else {
+        found = this->bisect(assmt, sv, sign, min, max, optimal, evaluations);
+      }
     }
+    m_numSolves.fetch_add(1, std::memory_order_relaxed);
+    m_numEvaluations.fetch_add(evaluations, std::memory_order_relaxed);
     return found ? optimal : std::nan("");
   }
 
 private:
-  template <typename Data, typename Var, typename Set>
+  template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
   bool
   init(
-    const Assignment<Data, Var, Set>& assmt,
+    const Assignment<Data, Var, VarSet, Obs, ObsSet>& assmt,
     const double sv,
     const int sign,
     double& min,
-    double& max
+    double& max,
+    double& fMin,
+    uint32_t& evaluations
   ) const
   {
     auto f1 = assmt.evaluate(sv, sign, min);
     auto f2 = assmt.evaluate(sv, sign, max);
+    evaluations += 2;
     auto found = false;
     for (auto i = 0u; i < m_initTries; ++i) {
       if (std::isless(f1 * f2, 0)) {
@@ -78,24 +162,65 @@ private:
       min = max;
       max = m_factor * max;
       f2 = assmt.evaluate(sv, sign, max);
+      ++evaluations;
     }
+    // The function has the same sign at the moved min as at the initial min
+    fMin = f1;
     LOG_MESSAGE_IF(!found, trace, "Unable to initialize beta for split (%s, %g)",
                                   assmt.varName(), sv);
     return found;
   }
 
-  template <typename Data, typename Var, typename Set>
+  template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+  bool
+  init(
+    const Assignment<Data, Var, VarSet, Obs, ObsSet>& assmt,
+    const double sv,
+    const int sign,
+    const double hint,
+    double& min,
+    double& max,
+    double& fMin,
+    uint32_t& evaluations
+  ) const
+  {
+    min = std::max(m_min, hint / m_factor);
+    max = hint * m_factor;
+    fMin = assmt.evaluate(sv, sign, min);
+    auto fMax = assmt.evaluate(sv, sign, max);
+    evaluations += 2;
+    return std::isless(fMin * fMax, 0);
+  }
+
+  /**
+   * @brief Checks if the bracket of the root is narrow enough to stop.
+   *
+   * Both the solvers stop once the width of the bracket of the root falls
+   * below the accuracy; therefore, Newton's method does not change the
+   * accuracy of beta, only the number of evaluations for reaching it.
+   */
+  bool
+  converged(
+    const double width
+  ) const
+  {
+    return std::isless(std::abs(width), m_acc);
+  }
+
+  template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
   bool
   bisect(
-    const Assignment<Data, Var, Set>& assmt,
+    const Assignment<Data, Var, VarSet, Obs, ObsSet>& assmt,
     const double sv,
     const int sign,
     const double min,
     const double max,
-    double& optimal
+    double& optimal,
+    uint32_t& evaluations
   ) const
   {
     auto fMin = assmt.evaluate(sv, sign, min);
+    ++evaluations;
     auto diff = 0.0;
     if (std::isless(fMin, 0)) {
       optimal = min;
@@ -110,13 +235,98 @@ private:
       diff *= 0.5;
       auto mid = optimal + diff;
       auto fMid = assmt.evaluate(sv, sign, mid);
+      ++evaluations;
       if (std::islessequal(fMid, 0)) {
         optimal = mid;
       }
-      if (std::isless(abs(diff), m_acc) || (fMid == 0)) {
+      if (this->converged(diff) || (fMid == 0)) {
+        found = true;
+        break;
+      }
+    }
+    LOG_MESSAGE_IF(!found, warning, "Unable to find beta for split (%s, %g)",
+                                    assmt.varName(), sv);
+    return found;
+  }
+
+  /**
+   * @brief Finds the root in the given bracket using Newton's method,
+   *        with the derivative computed in the same pass as the function.
+   *        Falls back to bisection whenever a Newton step would leave the
+   *        bracket or would not reduce the bracket fast enough. Stops
+   *        when the bracket is narrow enough, same as bisection.
+   */
+  template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+  bool
+  newton(
+    const Assignment<Data, Var, VarSet, Obs, ObsSet>& assmt,
+    const double sv,
+    const int sign,
+    const double min,
+    const double max,
+    const double fMin,
+    const double start,
+    double& optimal,
+    uint32_t& evaluations
+  ) const
+  {
+    // Orient the bracket so that the function is negative at low
+    auto low = min;
+    auto high = max;
+    if (!std::isless(fMin, 0)) {
+      std::swap(low, high);
+    }
+    // Start from the given point if it is in the bracket, otherwise from the middle
+    optimal = (std::isgreater(start, min) && std::isless(start, max)) ? start : 0.5 * (min + max);
+    auto estimate = optimal;
+    auto dxOld = std::abs(max - min);
+    auto dx = dxOld;
+    auto fd = assmt.evaluateWithDerivative(sv, sign, optimal);
+    ++evaluations;
+    auto found = false;
+    for (auto i = 0u; i < m_bisectTries; ++i) {
+      const auto f = fd.first;
+      const auto df = fd.second;
+      if (f == 0) {
+        found = true;
+        break;
+      }
+      if (std::isless(f, 0)) {
+        low = optimal;
+      }
+      else {
+        high = optimal;
+      }
+      // Stop once the bracket is as narrow as for the bisection solver,
+      // and return the last Newton estimate if it is in the bracket
+      if (this->converged(high - low)) {
+        if (std::islessequal((estimate - low) * (estimate - high), 0)) {
+          optimal = estimate;
+        }
         found = true;
         break;
       }
+      dxOld = dx;
+      if (std::isnan(df) ||
+          std::isgreater(((optimal - high) * df - f) * ((optimal - low) * df - f), 0) ||
+          std::isgreater(std::abs(2.0 * f), std::abs(dxOld * df))) {
+        dx = 0.5 * (high - low);
+        optimal = low + dx;
+        estimate = optimal;
+      }
+      else {
+        dx = f / df;
+        estimate = optimal - dx;
+        // A small step does not bracket the root by itself, because the
+        // iterates may approach the root from one side; therefore, the
+        // function is evaluated past the estimate, at twice the step,
+        // which narrows the bracket enough if the estimate is accurate.
+        // The point is in the bracket, since otherwise the bracket
+        // would already be narrower than twice the step
+        optimal = this->converged(2.0 * dx) ? optimal - 2.0 * dx : estimate;
+      }
+      fd = assmt.evaluateWithDerivative(sv, sign, optimal);
+      ++evaluations;
     }
     LOG_MESSAGE_IF(!found, warning, "Unable to find beta for split (%s, %g)",
                                     assmt.varName(), sv);
@@ -132,17 +342,27 @@ private:
   const double m_min;
   const double m_max;
   const double m_acc;
+  // Use vectorized approximations of exp and log,
+  // instead of the standard library functions
+  const bool m_fastMath;
+  const Solver m_solver;
+  // Start the search for every split value from the optimum
+  // for the preceding split value, in sorted order
+  const bool m_warmStart;
+  // Statistics of the number of function evaluations
+  mutable std::atomic<uint64_t> m_numSolves;
+  mutable std::atomic<uint64_t> m_numEvaluations;
 }; // class OptimalBeta
 
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 class TreeNode {
 public:
-  TreeNode(const Data&, const Set&, const Set&);
+  TreeNode(const Data&, const VarSet&, const ObsSet&);
 
-  TreeNode(const std::shared_ptr<TreeNode<Data, Var, Set>>&, const std::shared_ptr<TreeNode<Data, Var, Set>>&);
+  TreeNode(const std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>&, const std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>&);
 
-  const std::pair<std::shared_ptr<TreeNode<Data, Var, Set>>, std::shared_ptr<TreeNode<Data, Var, Set>>>&
+  const std::pair<std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>, std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>>&
   children() const;
 
   void
@@ -151,10 +371,10 @@ public:
   uint32_t
   nodeCount(const bool = false) const;
 
-  std::list<TreeNode<Data, Var, Set>*>
+  std::list<TreeNode<Data, Var, VarSet, Obs, ObsSet>*>
   nodes(const bool = false);
 
-  const Set&
+  const ObsSet&
   observations() const;
 
   double
@@ -170,18 +390,25 @@ public:
   prune(const double);
 
   uint64_t
-  splitWeight(const Set&) const;
+  estimateSplitCost(const VarSet&, const double, const uint32_t) const;
 
-  std::list<std::tuple<Var, Var, double>>
-  candidateParentsSplits(const Set&, const OptimalBeta&, const uint64_t, const uint64_t) const;
+  void
+  setSplitCost(const uint64_t);
+
+  uint64_t
+  splitWeight(const VarSet&) const;
+
+  template <typename SplitIt>
+  SplitIt
+  candidateParentsSplits(const VarSet&, const OptimalBeta&, const uint64_t, const uint64_t, SplitIt) const;
 
   template <typename Generator>
   bool
-  learnParentsSplits(Generator&, const Set&, const OptimalBeta&, const uint32_t);
+  learnParentsSplits(Generator&, const VarSet&, const OptimalBeta&, const uint32_t, const bool);
 
   template <typename Generator, typename SplitIt>
   bool
-  learnParentsSplits(Generator&, const Set&, const OptimalBeta&, const uint32_t, SplitIt, SplitIt) const;
+  learnParentsSplits(Generator&, const VarSet&, const OptimalBeta&, const uint32_t, const bool, SplitIt, SplitIt) const;
 
   template <typename SplitIt>
   void
@@ -191,10 +418,10 @@ public:
   void
   setRandomSplits(const SplitIt&, const SplitIt&);
 
-  const std::list<std::tuple<Var, Var, double>>&
+  const std::list<std::tuple<Var, Obs, double>>&
   weightSplits() const;
 
-  const std::list<std::tuple<Var, Var, double>>&
+  const std::list<std::tuple<Var, Obs, double>>&
   randomSplits() const;
 
   template <typename Stream>
@@ -205,31 +432,40 @@ private:
   double
   logPartSum() const;
 
-  std::vector<std::tuple<Var, Var, double>>
-  candidateParentsSplits(const Set&, const OptimalBeta&) const;
+  std::vector<std::tuple<Var, Obs, double>>
+  candidateParentsSplits(const VarSet&, const OptimalBeta&) const;
+
+  template <typename ObsIt, typename SplitIt>
+  SplitIt
+  parentSplits(const Var, ObsIt, const ObsIt, const OptimalBeta&, SplitIt) const;
+
+  template <typename Generator, typename SplitIt>
+  bool
+  chooseSplits(Generator&, const std::vector<std::tuple<Var, Obs, double>>&&, const uint32_t, SplitIt, SplitIt) const;
 
   template <typename Generator, typename SplitIt>
   bool
-  chooseSplits(Generator&, const std::vector<std::tuple<Var, Var, double>>&&, const uint32_t, SplitIt, SplitIt) const;
+  sampleSplits(Generator&, const VarSet&, const OptimalBeta&, const uint32_t, SplitIt, SplitIt) const;
 
 private:
-  std::list<std::tuple<Var, Var, double>> m_weightSplits;
-  std::list<std::tuple<Var, Var, double>> m_randomSplits;
-  std::pair<std::shared_ptr<TreeNode<Data, Var, Set>>, std::shared_ptr<TreeNode<Data, Var, Set>>> m_children;
+  std::list<std::tuple<Var, Obs, double>> m_weightSplits;
+  std::list<std::tuple<Var, Obs, double>> m_randomSplits;
+  std::pair<std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>, std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>> m_children;
   const Data& m_data;
-  const Set m_observations;
+  const ObsSet m_observations;
   double m_score;
   double m_sum;
   double m_sum2;
   uint32_t m_count;
+  uint64_t m_splitCost;
   bool m_leaf;
 }; // class TreeNode
 
-template <typename Data, typename Var, typename Set>
-TreeNode<Data, Var, Set>::TreeNode(
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::TreeNode(
   const Data& data,
-  const Set& variables,
-  const Set& observations
+  const VarSet& variables,
+  const ObsSet& observations
 ) : m_weightSplits(),
     m_randomSplits(),
     m_children(),
@@ -239,25 +475,21 @@ TreeNode<Data, Var, Set>::TreeNode(
     m_sum(0.0),
     m_sum2(0.0),
     m_count(0),
+    m_splitCost(observations.size()),
     m_leaf(true)
 {
+  std::tuple<double, double, uint32_t> stats(0.0, 0.0, 0u);
   for (const auto v : variables) {
-    for (const auto o : observations) {
-      auto d = data(v, o);
-      if (!std::isnan(d)) {
-        m_sum += d;
-        m_sum2 += d * d;
-        ++m_count;
-      }
-    }
+    data.statistics(v, observations, stats);
   }
+  std::tie(m_sum, m_sum2, m_count) = stats;
   m_score = computeLogLikelihood(m_count, m_sum, m_sum2);
 }
 
-template <typename Data, typename Var, typename Set>
-TreeNode<Data, Var, Set>::TreeNode(
-  const std::shared_ptr<TreeNode<Data, Var, Set>>& leftChild,
-  const std::shared_ptr<TreeNode<Data, Var, Set>>& rightChild
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::TreeNode(
+  const std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>& leftChild,
+  const std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>& rightChild
 ) : m_weightSplits(),
     m_randomSplits(),
     m_children(std::make_pair(leftChild, rightChild)),
@@ -267,22 +499,23 @@ TreeNode<Data, Var, Set>::TreeNode(
     m_sum(leftChild->m_sum + rightChild->m_sum),
     m_sum2(leftChild->m_sum2 + rightChild->m_sum2),
     m_count(leftChild->m_count + rightChild->m_count),
+    m_splitCost(m_observations.size()),
     m_leaf(false)
 {
   m_score = computeLogLikelihood(m_count, m_sum, m_sum2);
 }
 
-template <typename Data, typename Var, typename Set>
-const std::pair<std::shared_ptr<TreeNode<Data, Var, Set>>, std::shared_ptr<TreeNode<Data, Var, Set>>>&
-TreeNode<Data, Var, Set>::children(
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+const std::pair<std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>, std::shared_ptr<TreeNode<Data, Var, VarSet, Obs, ObsSet>>>&
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::children(
 ) const
 {
   return m_children;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-TreeNode<Data, Var, Set>::makeLeaf(
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::makeLeaf(
 )
 {
   m_leaf = true;
@@ -290,9 +523,9 @@ TreeNode<Data, Var, Set>::makeLeaf(
   m_children.second.reset();
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 uint32_t
-TreeNode<Data, Var, Set>::nodeCount(
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::nodeCount(
   const bool includeLeaves
 ) const
 {
@@ -307,13 +540,13 @@ TreeNode<Data, Var, Set>::nodeCount(
   return count;
 }
 
-template <typename Data, typename Var, typename Set>
-std::list<TreeNode<Data, Var, Set>*>
-TreeNode<Data, Var, Set>::nodes(
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+std::list<TreeNode<Data, Var, VarSet, Obs, ObsSet>*>
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::nodes(
   const bool includeLeaves
 )
 {
-  std::list<TreeNode<Data, Var, Set>*> nodes;
+  std::list<TreeNode<Data, Var, VarSet, Obs, ObsSet>*> nodes;
   if (!m_leaf || includeLeaves) {
     nodes.push_back(this);
   }
@@ -326,25 +559,25 @@ TreeNode<Data, Var, Set>::nodes(
   return nodes;
 }
 
-template <typename Data, typename Var, typename Set>
-const Set&
-TreeNode<Data, Var, Set>::observations(
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+const ObsSet&
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::observations(
 ) const
 {
   return m_observations;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 double
-TreeNode<Data, Var, Set>::score(
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::score(
 ) const
 {
   return m_score;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 double
-TreeNode<Data, Var, Set>::mergeScore(
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::mergeScore(
   const bool scoreBHC
 ) const
 {
@@ -361,17 +594,17 @@ TreeNode<Data, Var, Set>::mergeScore(
   return mergeScore;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 double
-TreeNode<Data, Var, Set>::mean(
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::mean(
 ) const
 {
   return m_sum / m_count;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 void
-TreeNode<Data, Var, Set>::prune(
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::prune(
   const double scoreGain
 )
 {
@@ -391,9 +624,9 @@ TreeNode<Data, Var, Set>::prune(
   }
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 double
-TreeNode<Data, Var, Set>::logPartSum(
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::logPartSum(
 ) const
 {
   auto lps = m_score;
@@ -404,101 +637,259 @@ TreeNode<Data, Var, Set>::logPartSum(
   return lps;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Estimates the average cost of computing a candidate split of this node.
+ *
+ * For every candidate parent, the splits are computed by sorting the n non-NaN
+ * values of the parent for the observations of this node, and then solving for
+ * the optimal beta once for each of the d distinct values, where every solver
+ * evaluation, as well as the final score, takes time proportional to n.
+ * Therefore, the cost for the parent is modeled as n log(n) + d (k + 1) n,
+ * where k is the average number of solver evaluations. The cost is estimated
+ * from an evenly spaced sample of the candidate parents, which is the same for
+ * all the nodes; therefore, estimating the costs of all the nodes only uses the
+ * data of at most maxParents parents.
+ *
+ * @param candidateParents The candidate parents for the splits.
+ * @param numEvaluations Average number of evaluations for finding beta.
+ * @param maxParents Maximum number of candidate parents sampled.
+ *
+ * @return The estimated cost per candidate split, which is at least one.
+ */
 uint64_t
-TreeNode<Data, Var, Set>::splitWeight(
-  const Set& candidateParents
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::estimateSplitCost(
+  const VarSet& candidateParents,
+  const double numEvaluations,
+  const uint32_t maxParents
+) const
+{
+  uint64_t numParents = candidateParents.size();
+  uint64_t numSampled = std::min(numParents, static_cast<uint64_t>(maxParents));
+  if ((numSampled == 0) || (m_observations.size() == 0)) {
+    return 1;
+  }
+  std::vector<double> values;
+  values.reserve(m_observations.size());
+  auto cost = 0.0;
+  auto pIt = candidateParents.begin();
+  uint64_t prevParent = 0u;
+  for (auto i = 0u; i < numSampled; ++i) {
+    auto p = (i * numParents) / numSampled;
+    std::advance(pIt, p - prevParent);
+    prevParent = p;
+    values.clear();
+    auto parentValues = m_data.row(*pIt);
+    for (const auto o : m_observations) {
+      auto d = parentValues[o];
+      if (!std::isnan(d)) {
+        values.push_back(d);
+      }
+    }
+    std::sort(values.begin(), values.end());
+    auto numValues = static_cast<double>(values.size());
+    auto numDistinct = static_cast<double>(std::distance(values.begin(), std::unique(values.begin(), values.end())));
+    cost += numValues * std::log2(numValues + 1.0) + numDistinct * (numEvaluations + 1.0) * numValues;
+  }
+  auto splitCost = cost / static_cast<double>(numSampled * m_observations.size());
+  return std::max(static_cast<uint64_t>(std::llround(splitCost)), static_cast<uint64_t>(1u));
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+/**
+ * @brief Sets the cost of computing a candidate split of this node, which is
+ *        used as the weight of every candidate split for partitioning the work.
+ *
+ * @param splitCost The cost per candidate split; must be positive.
+ */
+void
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::setSplitCost(
+  const uint64_t splitCost
+)
+{
+  m_splitCost = splitCost;
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+uint64_t
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::splitWeight(
+  const VarSet& candidateParents
 ) const
 {
   uint64_t splitCount = candidateParents.size() * m_observations.size();
-  uint64_t splitWeight = splitCount * m_observations.size();
+  uint64_t splitWeight = splitCount * m_splitCost;
   return splitWeight;
 }
 
-template <typename Data, typename Var, typename Set>
-std::vector<std::tuple<Var, Var, double>>
-TreeNode<Data, Var, Set>::candidateParentsSplits(
-  const Set& candidateParents,
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+std::vector<std::tuple<Var, Obs, double>>
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::candidateParentsSplits(
+  const VarSet& candidateParents,
   const OptimalBeta& ob
 ) const
 {
-  std::list<std::tuple<Var, Var, double>> splits;
-  for (const auto v : candidateParents) {
-    Assignment<Data, Var, Set> assmt(m_data, v, this);
-    for (const auto o : m_observations) {
-      auto sv = m_data(v, o);
-      if (!std::isnan(sv)) {
-        LOG_MESSAGE(trace, "Considering split (%s, %g)", m_data.varName(v), sv);
-        auto sign = assmt.sign(sv);
-        if (sign == 0) {
-          LOG_MESSAGE(trace, "Split sign is zero. Skipping");
-          continue;
-        }
-        auto beta = ob.find(assmt, sv, sign);
-        if (std::isnan(beta)) {
-          continue;
-        }
-        auto score = assmt.score(sv, sign, beta);
-        LOG_MESSAGE(trace, "Parent split details for (%s, %g) : beta=%g, score=%g", m_data.varName(v), sv, beta, score);
-        splits.push_back(std::make_tuple(v, o, score));
-      }
-    }
+  // The splits of different parents are computed in parallel threads
+  // and then concatenated in the order of the parents
+  std::vector<Var> parents(candidateParents.begin(), candidateParents.end());
+  std::vector<std::vector<std::tuple<Var, Obs, double>>> parentsSplits(parents.size());
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t p = 0; p < parents.size(); ++p) {
+    this->parentSplits(parents[p], m_observations.begin(), m_observations.end(), ob,
+                       std::back_inserter(parentsSplits[p]));
+  }
+  std::vector<std::tuple<Var, Obs, double>> splits;
+  for (const auto& ps : parentsSplits) {
+    splits.insert(splits.end(), ps.begin(), ps.end());
   }
-  return std::vector<std::tuple<Var, Var, double>>(splits.begin(), splits.end());
+  return splits;
 }
 
-template <typename Data, typename Var, typename Set>
-std::list<std::tuple<Var, Var, double>>
-TreeNode<Data, Var, Set>::candidateParentsSplits(
-  const Set& candidateParents,
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+template <typename SplitIt>
+/**
+ * @brief Computes the valid splits in the given range of the candidate
+ *        splits of this node, and writes them to the given output iterator.
+ *
+ * @tparam SplitIt Type of the output iterator for the splits.
+ * @param candidateParents The candidate parents for the splits.
+ * @param ob Object used for finding the optimal beta for a split.
+ * @param firstWeight The weight of the splits preceding the range.
+ * @param maxWeight The weight of the splits in the range.
+ * @param splitIt Output iterator for the splits.
+ *
+ * @return The output iterator after writing the splits.
+ */
+SplitIt
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::candidateParentsSplits(
+  const VarSet& candidateParents,
   const OptimalBeta& ob,
   const uint64_t firstWeight,
-  const uint64_t maxWeight
+  const uint64_t maxWeight,
+  SplitIt splitIt
 ) const
 {
-  std::list<std::tuple<Var, Var, double>> splits;
-  auto unitWeight = m_observations.size();
+  auto unitWeight = m_splitCost;
   uint64_t firstSplit = (firstWeight / unitWeight) + ((firstWeight % unitWeight) ? 1 : 0);
   auto lastWeight = firstWeight + maxWeight;
   uint64_t lastSplit = (lastWeight / unitWeight) + ((lastWeight % unitWeight) ? 1 : 0) - 1;
   auto firstParent = firstSplit / m_observations.size();
   auto lastParent = lastSplit / m_observations.size();
+  if (firstParent > lastParent) {
+    return splitIt;
+  }
+  // Tuples of <parent, first observation, number of observations>
+  // for the splits of every parent in the range
+  std::vector<std::tuple<Var, uint64_t, uint64_t>> ranges;
   auto pIt = std::next(candidateParents.begin(), firstParent);
   auto prevSplits = firstSplit;
   for (auto p = firstParent; p <= lastParent; ++p, ++pIt) {
-    Assignment<Data, Var, Set> assmt(m_data, *pIt, this);
-    auto firstObservation = prevSplits % m_observations.size();
-    auto numObservations = std::min(m_observations.size() - firstObservation, lastSplit + 1 - prevSplits);
-    auto oIt = std::next(m_observations.begin(), firstObservation);
-    for (auto o = firstObservation; o < firstObservation + numObservations; ++o, ++oIt) {
-      auto sv = m_data(*pIt, *oIt);
-      if (!std::isnan(sv)) {
-        LOG_MESSAGE(trace, "Considering split (%s, %g)", m_data.varName(*pIt), sv);
-        auto sign = assmt.sign(sv);
-        if (sign == 0) {
-          LOG_MESSAGE(trace, "Split sign is zero. Skipping");
-          continue;
-        }
-        auto beta = ob.find(assmt, sv, sign);
-        if (std::isnan(beta)) {
-          continue;
-        }
-        auto score = assmt.score(sv, sign, beta);
-        LOG_MESSAGE(trace, "Parent split details for (%s, %g) : beta=%g, score=%g", m_data.varName(*pIt), sv, beta, score);
-        splits.push_back(std::make_tuple(*pIt, *oIt, score));
+    uint64_t firstObservation = prevSplits % m_observations.size();
+    uint64_t numObservations = std::min(m_observations.size() - firstObservation, lastSplit + 1 - prevSplits);
+    ranges.emplace_back(*pIt, firstObservation, numObservations);
+    prevSplits += numObservations;
+  }
+  // The splits of different parents are computed in parallel threads
+  // and then written in the order of the parents
+  std::vector<std::vector<std::tuple<Var, Obs, double>>> parentsSplits(ranges.size());
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t r = 0; r < ranges.size(); ++r) {
+    auto oFirst = std::next(m_observations.begin(), std::get<1>(ranges[r]));
+    auto oLast = std::next(oFirst, std::get<2>(ranges[r]));
+    this->parentSplits(std::get<0>(ranges[r]), oFirst, oLast, ob, std::back_inserter(parentsSplits[r]));
+  }
+  for (const auto& ps : parentsSplits) {
+    splitIt = std::copy(ps.begin(), ps.end(), splitIt);
+  }
+  return splitIt;
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+template <typename ObsIt, typename SplitIt>
+/**
+ * @brief Computes the scores of the splits of the given parent at its
+ *        values for the given observations, and writes the valid splits.
+ *
+ * The split values are processed in sorted order so that the score is
+ * computed only once for every distinct value. If warm start is enabled,
+ * the search for the optimal beta at every value starts from the optimum
+ * for the preceding value. The splits are appended in the order of the
+ * observations, independent of the order of processing.
+ *
+ * @tparam ObsIt Type of the iterator over the observations.
+ * @tparam SplitIt Type of the output iterator for the splits.
+ * @param v The index of the candidate parent.
+ * @param first Iterator to the first observation.
+ * @param last Iterator past the last observation.
+ * @param ob Object used for finding the optimal beta for a split.
+ * @param splitIt Output iterator for the splits.
+ *
+ * @return The output iterator after writing the splits.
+ */
+SplitIt
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::parentSplits(
+  const Var v,
+  ObsIt first,
+  const ObsIt last,
+  const OptimalBeta& ob,
+  SplitIt splitIt
+) const
+{
+  Assignment<Data, Var, VarSet, Obs, ObsSet> assmt(m_data, v, this, ob.fastMath());
+  std::vector<std::pair<typename Data::Value, Obs>> values;
+  auto splitValues = m_data.row(v);
+  for (; first != last; ++first) {
+    auto sv = splitValues[*first];
+    if (!std::isnan(sv)) {
+      values.push_back(std::make_pair(sv, *first));
+    }
+  }
+  std::vector<uint32_t> sorted(values.size());
+  std::iota(sorted.begin(), sorted.end(), 0u);
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [&values] (const uint32_t a, const uint32_t b)
+                             { return values[a].first < values[b].first; });
+  std::vector<double> scores(values.size(), 0.0);
+  std::vector<uint8_t> valid(values.size(), 0);
+  auto prevBeta = std::nan("");
+  for (auto i = 0u; i < sorted.size(); ) {
+    auto sv = values[sorted[i]].first;
+    auto score = 0.0;
+    auto isValid = false;
+    LOG_MESSAGE(trace, "Considering split (%s, %g)", m_data.varName(v), sv);
+    auto sign = assmt.sign(sv);
+    if (sign != 0) {
+      auto beta = ob.find(assmt, sv, sign, ob.warmStart() ? prevBeta : std::nan(""));
+      if (!std::isnan(beta)) {
+        score = assmt.score(sv, sign, beta);
+        isValid = true;
+        prevBeta = beta;
+        LOG_MESSAGE(trace, "Parent split details for (%s, %g) : beta=%g, score=%g", m_data.varName(v), sv, beta, score);
       }
     }
-    prevSplits += numObservations;
+    else {
+      LOG_MESSAGE(trace, "Split sign is zero. Skipping");
+    }
+    // Reuse the result for all the observations with the same value
+    for (; (i < sorted.size()) && (values[sorted[i]].first == sv); ++i) {
+      scores[sorted[i]] = score;
+      valid[sorted[i]] = isValid;
+    }
   }
-  return splits;
+  for (auto i = 0u; i < values.size(); ++i) {
+    if (valid[i]) {
+      *splitIt = std::make_tuple(v, values[i].second, scores[i]);
+      ++splitIt;
+    }
+  }
+  return splitIt;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator, typename SplitIt>
 bool
-TreeNode<Data, Var, Set>::chooseSplits(
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::chooseSplits(
   Generator& generator,
-  const std::vector<std::tuple<Var, Var, double>>&& candidateSplits,
+  const std::vector<std::tuple<Var, Obs, double>>&& candidateSplits,
   const uint32_t numSplits,
   SplitIt weightIt,
   SplitIt randomIt
@@ -513,14 +904,14 @@ TreeNode<Data, Var, Set>::chooseSplits(
   }
   LOG_MESSAGE(debug, "Number of candidate splits found: %u", candidateSplits.size());
   auto maxScoreSplit = std::max_element(candidateSplits.cbegin(), candidateSplits.cend(),
-                                        [] (const std::tuple<Var, Var, double>& a,
-                                            const std::tuple<Var, Var, double>& b)
+                                        [] (const std::tuple<Var, Obs, double>& a,
+                                            const std::tuple<Var, Obs, double>& b)
                                            { return std::isless(std::get<2>(a), std::get<2>(b)); });
   auto maxScore = std::get<2>(*maxScoreSplit);
   std::vector<double> weights(candidateSplits.size());
   std::transform(candidateSplits.cbegin(), candidateSplits.cend(), weights.begin(),
-                 [&maxScore] (const std::tuple<Var, Var, double>& s)
-                             { return exp(std::get<2>(s) - maxScore); });
+                 [&maxScore] (const std::tuple<Var, Obs, double>& s)
+                             { return relativeWeight(std::get<2>(s), maxScore); });
   discrete_distribution_safe<uint64_t> splitWeight(weights.cbegin(), weights.cend());
   trng::uniform_int_dist splitRand(0, candidateSplits.size());
   for (auto i = 0u; i < numSplits; ++i, ++weightIt, ++randomIt) {
@@ -538,16 +929,85 @@ TreeNode<Data, Var, Set>::chooseSplits(
   return true;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+template <typename Generator, typename SplitIt>
+/**
+ * @brief Chooses the splits of this node by streaming the candidate splits
+ *        through a sampler, without storing all the candidate splits.
+ *
+ * Same as chooseSplits, 2 * numSplits random numbers are consumed from the
+ * generator; the first one is used as the salt for the sampler.
+ *
+ * @tparam Generator Type of the random number generator.
+ * @tparam SplitIt Type of the output iterators for the splits.
+ * @param generator Random number generator.
+ * @param candidateParents The candidate parents for the splits.
+ * @param ob Object used for finding the optimal beta for a split.
+ * @param numSplits Number of splits to be chosen, using weights and at random.
+ * @param weightIt Output iterator for the splits chosen using weights.
+ * @param randomIt Output iterator for the splits chosen at random.
+ *
+ * @return true if any candidate split was found, false otherwise.
+ */
+bool
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::sampleSplits(
+  Generator& generator,
+  const VarSet& candidateParents,
+  const OptimalBeta& ob,
+  const uint32_t numSplits,
+  SplitIt weightIt,
+  SplitIt randomIt
+) const
+{
+  auto salt = generator();
+  ::advance(generator, 2 * numSplits - 1);
+  SplitSampler<Var, Obs> sampler(numSplits, salt);
+  // Every thread streams the splits of its parents through its own sampler;
+  // the samplers are merged afterwards, independent of the order of merging
+  std::vector<Var> parents(candidateParents.begin(), candidateParents.end());
+  #pragma omp parallel
+  {
+    SplitSampler<Var, Obs> threadSampler(numSplits, salt);
+    auto insertSplit = [&threadSampler] (const std::tuple<Var, Obs, double>& split)
+                                        { threadSampler.insert(split); };
+    #pragma omp for schedule(dynamic)
+    for (size_t p = 0; p < parents.size(); ++p) {
+      this->parentSplits(parents[p], m_observations.begin(), m_observations.end(), ob,
+                         boost::make_function_output_iterator(std::ref(insertSplit)));
+    }
+    #pragma omp critical
+    sampler.merge(threadSampler);
+  }
+  if (sampler.count() == 0) {
+    LOG_MESSAGE(debug, "No candidate splits found");
+    return false;
+  }
+  LOG_MESSAGE(debug, "Number of candidate splits found: %u", sampler.count());
+  sampler.chosen(weightIt, randomIt);
+  return true;
+}
+
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator>
 bool
-TreeNode<Data, Var, Set>::learnParentsSplits(
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::learnParentsSplits(
   Generator& generator,
-  const Set& candidateParents,
+  const VarSet& candidateParents,
   const OptimalBeta& ob,
-  const uint32_t numSplits
+  const uint32_t numSplits,
+  const bool streamSplits
 )
 {
+  if (streamSplits) {
+    m_weightSplits.resize(numSplits);
+    m_randomSplits.resize(numSplits);
+    if (!this->sampleSplits(generator, candidateParents, ob, numSplits, m_weightSplits.begin(), m_randomSplits.begin())) {
+      m_weightSplits.clear();
+      m_randomSplits.clear();
+      return false;
+    }
+    return true;
+  }
   auto splits = this->candidateParentsSplits(candidateParents, ob);
   if (!splits.empty()) {
     m_weightSplits.resize(numSplits);
@@ -556,26 +1016,30 @@ TreeNode<Data, Var, Set>::learnParentsSplits(
   return this->chooseSplits(generator, std::move(splits), numSplits, m_weightSplits.begin(), m_randomSplits.begin());
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Generator, typename SplitIt>
 bool
-TreeNode<Data, Var, Set>::learnParentsSplits(
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::learnParentsSplits(
   Generator& generator,
-  const Set& candidateParents,
+  const VarSet& candidateParents,
   const OptimalBeta& ob,
   const uint32_t numSplits,
+  const bool streamSplits,
   SplitIt weightIt,
   SplitIt randomIt
 ) const
 {
+  if (streamSplits) {
+    return this->sampleSplits(generator, candidateParents, ob, numSplits, weightIt, randomIt);
+  }
   auto splits = this->candidateParentsSplits(candidateParents, ob);
   return this->chooseSplits(generator, std::move(splits), numSplits, weightIt, randomIt);
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename SplitIt>
 void
-TreeNode<Data, Var, Set>::setWeightSplits(
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::setWeightSplits(
   const SplitIt& first,
   const SplitIt& last
 )
@@ -584,10 +1048,10 @@ TreeNode<Data, Var, Set>::setWeightSplits(
   std::copy(first, last, std::back_inserter(m_weightSplits));
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename SplitIt>
 void
-TreeNode<Data, Var, Set>::setRandomSplits(
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::setRandomSplits(
   const SplitIt& first,
   const SplitIt& last
 )
@@ -596,26 +1060,26 @@ TreeNode<Data, Var, Set>::setRandomSplits(
   std::copy(first, last, std::back_inserter(m_randomSplits));
 }
 
-template <typename Data, typename Var, typename Set>
-const std::list<std::tuple<Var, Var, double>>&
-TreeNode<Data, Var, Set>::weightSplits(
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+const std::list<std::tuple<Var, Obs, double>>&
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::weightSplits(
 ) const
 {
   return m_weightSplits;
 }
 
-template <typename Data, typename Var, typename Set>
-const std::list<std::tuple<Var, Var, double>>&
-TreeNode<Data, Var, Set>::randomSplits(
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
+const std::list<std::tuple<Var, Obs, double>>&
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::randomSplits(
 ) const
 {
   return m_randomSplits;
 }
 
-template <typename Data, typename Var, typename Set>
+template <typename Data, typename Var, typename VarSet, typename Obs, typename ObsSet>
 template <typename Stream>
 void
-TreeNode<Data, Var, Set>::toXML(
+TreeNode<Data, Var, VarSet, Obs, ObsSet>::toXML(
   Stream& stream
 ) const
 {
@@ -0,0 +1,547 @@
+/**
+ * @file VectorMath.hpp
+ * @brief Implementation of vectorized elementary functions.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DETAIL_VECTORMATH_HPP_
+#define DETAIL_VECTORMATH_HPP_
+
+#if (defined(HAVE_AVX512BW_INSTRUCTIONS) && defined(__AVX512F__)) || \
+    (defined(HAVE_AVX2_INSTRUCTIONS) && defined(__AVX2__))
+#include <immintrin.h>
+
+#include <limits>
+
+
+/**
+ * @brief Coefficients of the rational approximation of log(1 + x)
+ *        for x in [sqrt(0.5) - 1, sqrt(2) - 1], from the Cephes library.
+ */
+struct LogCoefficients {
+  static constexpr double P[6] = {1.01875663804580931796E-4, 4.97494994976747001425E-1,
+                                  4.70579119878881725854E0, 1.44989225341610930846E1,
+                                  1.79368678507819816313E1, 7.70838733755885391666E0};
+  static constexpr double Q[5] = {1.12873587189167450590E1, 4.52279145837532221105E1,
+                                  8.29875266912776603211E1, 7.11544750618563894466E1,
+                                  2.31251620126765340583E1};
+  static constexpr double sqrtHalf = 0.70710678118654752440;
+  // log(2) split into two parts for extra precision
+  static constexpr double ln2Hi = 0.693359375;
+  static constexpr double ln2Lo = -2.121944400546905827679E-4;
+}; // struct LogCoefficients
+/**
+ * @brief Coefficients of the rational approximation of exp(x)
+ *        for x in [-log(2) / 2, log(2) / 2], from the Cephes library.
+ */
+struct ExpCoefficients {
+  static constexpr double P[3] = {1.26177193074810590878E-4, 3.02994407707441961300E-2,
+                                  9.99999999999999999910E-1};
+  static constexpr double Q[4] = {3.00198505138664455042E-6, 2.52448340349684104192E-3,
+                                  2.27265548208155028766E-1, 2.00000000000000000009E0};
+  static constexpr double log2e = 1.4426950408889634073599;
+  // log(2) split into two parts for extra precision
+  static constexpr double ln2Hi = 6.93145751953125E-1;
+  static constexpr double ln2Lo = 1.42860682030941723212E-6;
+  // The arguments are clamped to this range; the results
+  // underflow to zero and overflow to infinity beyond it
+  static constexpr double minArg = -746.0;
+  static constexpr double maxArg = 710.0;
+}; // struct ExpCoefficients
+
+/**
+ * @brief Coefficients of the polynomial approximation of log(1 + x)
+ *        in single precision, from the Cephes library.
+ */
+struct LogfCoefficients {
+  static constexpr float P[9] = {7.0376836292E-2f, -1.1514610310E-1f, 1.1676998740E-1f,
+                                 -1.2420140846E-1f, 1.4249322787E-1f, -1.6668057665E-1f,
+                                 2.0000714765E-1f, -2.4999993993E-1f, 3.3333331174E-1f};
+  static constexpr float sqrtHalf = 0.707106781186547524f;
+  // log(2) split into two parts for extra precision
+  static constexpr float ln2Hi = 0.693359375f;
+  static constexpr float ln2Lo = -2.12194440E-4f;
+}; // struct LogfCoefficients
+
+/**
+ * @brief Coefficients of the polynomial approximation of exp(x)
+ *        in single precision, from the Cephes library.
+ */
+struct ExpfCoefficients {
+  static constexpr float P[6] = {1.9875691500E-4f, 1.3981999507E-3f, 8.3334519073E-3f,
+                                 4.1665795894E-2f, 1.6666665459E-1f, 5.0000001201E-1f};
+  static constexpr float log2e = 1.44269504088896341f;
+  // log(2) split into two parts for extra precision
+  static constexpr float ln2Hi = 0.693359375f;
+  static constexpr float ln2Lo = -2.12194440E-4f;
+  // The arguments are clamped to this range; the results
+  // underflow to zero and overflow to infinity beyond it
+  static constexpr float minArg = -104.0f;
+  static constexpr float maxArg = 89.0f;
+}; // struct ExpfCoefficients
+#endif
+
+#if defined(HAVE_AVX512BW_INSTRUCTIONS) && defined(__AVX512F__)
+/**
+ * @brief Computes the natural logarithm of eight numbers.
+ */
+inline
+__m512d
+log_avx512(
+  const __m512d x
+)
+{
+  const auto one = _mm512_set1_pd(1.0);
+  // Scale the subnormal numbers by 2^54 so that they are normal
+  const auto tiny = _mm512_cmp_pd_mask(x, _mm512_set1_pd(std::numeric_limits<double>::min()), _CMP_LT_OQ);
+  const auto bits = _mm512_castpd_si512(_mm512_mask_mul_pd(x, tiny, x, _mm512_set1_pd(18014398509481984.0)));
+  // Decompose x = m * 2^e, with m in [0.5, 1)
+  auto m = _mm512_castsi512_pd(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi64(0x800FFFFFFFFFFFFFLL)),
+                                               _mm512_set1_epi64(0x3FE0000000000000LL)));
+  // Convert the biased exponent to double by adding it to the mantissa of 2^52
+  const auto magic = _mm512_set1_pd(4503599627370496.0);
+  auto e = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(bits, 52), _mm512_castpd_si512(magic))),
+                         magic);
+  e = _mm512_mask_sub_pd(_mm512_sub_pd(e, _mm512_set1_pd(1022.0)), tiny, e, _mm512_set1_pd(1022.0 + 54.0));
+  // Shift the range of m to [sqrt(0.5), sqrt(2)) and compute x = m - 1
+  const auto small = _mm512_cmp_pd_mask(m, _mm512_set1_pd(LogCoefficients::sqrtHalf), _CMP_LT_OQ);
+  e = _mm512_mask_sub_pd(e, small, e, one);
+  const auto y = _mm512_sub_pd(_mm512_mask_add_pd(m, small, m, m), one);
+  const auto z = _mm512_mul_pd(y, y);
+  auto p = _mm512_set1_pd(LogCoefficients::P[0]);
+  for (auto i = 1u; i < 6u; ++i) {
+    p = _mm512_add_pd(_mm512_mul_pd(p, y), _mm512_set1_pd(LogCoefficients::P[i]));
+  }
+  auto q = _mm512_add_pd(y, _mm512_set1_pd(LogCoefficients::Q[0]));
+  for (auto i = 1u; i < 5u; ++i) {
+    q = _mm512_add_pd(_mm512_mul_pd(q, y), _mm512_set1_pd(LogCoefficients::Q[i]));
+  }
+  auto r = _mm512_mul_pd(y, _mm512_div_pd(_mm512_mul_pd(z, p), q));
+  r = _mm512_add_pd(r, _mm512_mul_pd(e, _mm512_set1_pd(LogCoefficients::ln2Lo)));
+  r = _mm512_sub_pd(r, _mm512_mul_pd(_mm512_set1_pd(0.5), z));
+  r = _mm512_add_pd(_mm512_add_pd(y, r), _mm512_mul_pd(e, _mm512_set1_pd(LogCoefficients::ln2Hi)));
+  // log(inf) = inf, log(0) = -inf, and the logarithms of negative numbers are NaN
+  const auto zero = _mm512_setzero_pd();
+  r = _mm512_mask_mov_pd(r, _mm512_cmp_pd_mask(x, _mm512_set1_pd(std::numeric_limits<double>::infinity()), _CMP_EQ_OQ), x);
+  r = _mm512_mask_mov_pd(r, _mm512_cmp_pd_mask(x, zero, _CMP_EQ_OQ), _mm512_set1_pd(-std::numeric_limits<double>::infinity()));
+  return _mm512_mask_mov_pd(r, _mm512_cmp_pd_mask(x, zero, _CMP_NGE_UQ), _mm512_set1_pd(std::numeric_limits<double>::quiet_NaN()));
+}
+
+/**
+ * @brief Computes 2^n for eight integral values of n in [-1022, 1023].
+ */
+inline
+__m512d
+pow2_avx512(
+  const __m512d n
+)
+{
+  // The biased exponent is in the lower bits of the mantissa of 2^52 + n + 1023
+  const auto biased = _mm512_add_pd(n, _mm512_set1_pd(4503599627370496.0 + 1023.0));
+  return _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_castpd_si512(biased), 52));
+}
+
+/**
+ * @brief Computes the exponential of eight numbers.
+ */
+inline
+__m512d
+exp_avx512(
+  const __m512d x
+)
+{
+  // The second operands of min and max are returned if either is NaN
+  auto y = _mm512_min_pd(_mm512_set1_pd(ExpCoefficients::maxArg),
+                         _mm512_max_pd(_mm512_set1_pd(ExpCoefficients::minArg), x));
+  // Express exp(x) = 2^n * exp(y), with |y| <= log(2) / 2
+  const auto n = _mm512_roundscale_pd(_mm512_mul_pd(y, _mm512_set1_pd(ExpCoefficients::log2e)),
+                                      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  y = _mm512_sub_pd(y, _mm512_mul_pd(n, _mm512_set1_pd(ExpCoefficients::ln2Hi)));
+  y = _mm512_sub_pd(y, _mm512_mul_pd(n, _mm512_set1_pd(ExpCoefficients::ln2Lo)));
+  const auto z = _mm512_mul_pd(y, y);
+  auto p = _mm512_set1_pd(ExpCoefficients::P[0]);
+  for (auto i = 1u; i < 3u; ++i) {
+    p = _mm512_add_pd(_mm512_mul_pd(p, z), _mm512_set1_pd(ExpCoefficients::P[i]));
+  }
+  p = _mm512_mul_pd(p, y);
+  auto q = _mm512_set1_pd(ExpCoefficients::Q[0]);
+  for (auto i = 1u; i < 4u; ++i) {
+    q = _mm512_add_pd(_mm512_mul_pd(q, z), _mm512_set1_pd(ExpCoefficients::Q[i]));
+  }
+  auto e = _mm512_add_pd(_mm512_set1_pd(1.0), _mm512_mul_pd(_mm512_set1_pd(2.0), _mm512_div_pd(p, _mm512_sub_pd(q, p))));
+  // Scale in two steps so that n is always in the range of normal exponents
+  const auto n1 = _mm512_roundscale_pd(_mm512_mul_pd(n, _mm512_set1_pd(0.5)), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  e = _mm512_mul_pd(e, pow2_avx512(n1));
+  return _mm512_mul_pd(e, pow2_avx512(_mm512_sub_pd(n, n1)));
+}
+
+/**
+ * @brief Computes log(1 + x) for eight numbers.
+ */
+inline
+__m512d
+log1p_avx512(
+  const __m512d x
+)
+{
+  const auto u = _mm512_add_pd(_mm512_set1_pd(1.0), x);
+  // Correct for the rounding error in computing 1 + x
+  auto c = _mm512_div_pd(_mm512_sub_pd(_mm512_sub_pd(u, _mm512_set1_pd(1.0)), x), u);
+  // The correction is zero, instead of NaN, if 1 + x is infinite or zero
+  c = _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(c, c, _CMP_ORD_Q), c);
+  return _mm512_sub_pd(log_avx512(u), c);
+}
+
+/**
+ * @brief Computes the natural logarithm of sixteen numbers.
+ */
+inline
+__m512
+log_avx512(
+  const __m512 x
+)
+{
+  const auto one = _mm512_set1_ps(1.0f);
+  // Scale the subnormal numbers by 2^25 so that they are normal
+  const auto tiny = _mm512_cmp_ps_mask(x, _mm512_set1_ps(std::numeric_limits<float>::min()), _CMP_LT_OQ);
+  const auto bits = _mm512_castps_si512(_mm512_mask_mul_ps(x, tiny, x, _mm512_set1_ps(33554432.0f)));
+  // Decompose x = m * 2^e, with m in [0.5, 1)
+  auto m = _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x807FFFFF)),
+                                               _mm512_set1_epi32(0x3F000000)));
+  auto e = _mm512_cvtepi32_ps(_mm512_srli_epi32(bits, 23));
+  e = _mm512_mask_sub_ps(_mm512_sub_ps(e, _mm512_set1_ps(126.0f)), tiny, e, _mm512_set1_ps(126.0f + 25.0f));
+  // Shift the range of m to [sqrt(0.5), sqrt(2)) and compute x = m - 1
+  const auto small = _mm512_cmp_ps_mask(m, _mm512_set1_ps(LogfCoefficients::sqrtHalf), _CMP_LT_OQ);
+  e = _mm512_mask_sub_ps(e, small, e, one);
+  const auto y = _mm512_sub_ps(_mm512_mask_add_ps(m, small, m, m), one);
+  const auto z = _mm512_mul_ps(y, y);
+  auto p = _mm512_set1_ps(LogfCoefficients::P[0]);
+  for (auto i = 1u; i < 9u; ++i) {
+    p = _mm512_add_ps(_mm512_mul_ps(p, y), _mm512_set1_ps(LogfCoefficients::P[i]));
+  }
+  auto r = _mm512_mul_ps(_mm512_mul_ps(p, y), z);
+  r = _mm512_add_ps(r, _mm512_mul_ps(e, _mm512_set1_ps(LogfCoefficients::ln2Lo)));
+  r = _mm512_sub_ps(r, _mm512_mul_ps(_mm512_set1_ps(0.5f), z));
+  r = _mm512_add_ps(_mm512_add_ps(y, r), _mm512_mul_ps(e, _mm512_set1_ps(LogfCoefficients::ln2Hi)));
+  // log(inf) = inf, log(0) = -inf, and the logarithms of negative numbers are NaN
+  const auto zero = _mm512_setzero_ps();
+  r = _mm512_mask_mov_ps(r, _mm512_cmp_ps_mask(x, _mm512_set1_ps(std::numeric_limits<float>::infinity()), _CMP_EQ_OQ), x);
+  r = _mm512_mask_mov_ps(r, _mm512_cmp_ps_mask(x, zero, _CMP_EQ_OQ), _mm512_set1_ps(-std::numeric_limits<float>::infinity()));
+  return _mm512_mask_mov_ps(r, _mm512_cmp_ps_mask(x, zero, _CMP_NGE_UQ), _mm512_set1_ps(std::numeric_limits<float>::quiet_NaN()));
+}
+
+/**
+ * @brief Computes 2^n for sixteen integral values of n in [-126, 127].
+ */
+inline
+__m512
+pow2_avx512(
+  const __m512 n
+)
+{
+  const auto biased = _mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127));
+  return _mm512_castsi512_ps(_mm512_slli_epi32(biased, 23));
+}
+
+/**
+ * @brief Computes the exponential of sixteen numbers.
+ */
+inline
+__m512
+exp_avx512(
+  const __m512 x
+)
+{
+  // The second operands of min and max are returned if either is NaN
+  auto y = _mm512_min_ps(_mm512_set1_ps(ExpfCoefficients::maxArg),
+                         _mm512_max_ps(_mm512_set1_ps(ExpfCoefficients::minArg), x));
+  // Express exp(x) = 2^n * exp(y), with |y| <= log(2) / 2
+  const auto n = _mm512_roundscale_ps(_mm512_mul_ps(y, _mm512_set1_ps(ExpfCoefficients::log2e)),
+                                      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  y = _mm512_sub_ps(y, _mm512_mul_ps(n, _mm512_set1_ps(ExpfCoefficients::ln2Hi)));
+  y = _mm512_sub_ps(y, _mm512_mul_ps(n, _mm512_set1_ps(ExpfCoefficients::ln2Lo)));
+  const auto z = _mm512_mul_ps(y, y);
+  auto p = _mm512_set1_ps(ExpfCoefficients::P[0]);
+  for (auto i = 1u; i < 6u; ++i) {
+    p = _mm512_add_ps(_mm512_mul_ps(p, y), _mm512_set1_ps(ExpfCoefficients::P[i]));
+  }
+  auto e = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(p, z), y), _mm512_set1_ps(1.0f));
+  // Scale in two steps so that n is always in the range of normal exponents
+  const auto n1 = _mm512_roundscale_ps(_mm512_mul_ps(n, _mm512_set1_ps(0.5f)), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  e = _mm512_mul_ps(e, pow2_avx512(n1));
+  return _mm512_mul_ps(e, pow2_avx512(_mm512_sub_ps(n, n1)));
+}
+
+/**
+ * @brief Computes log(1 + x) for sixteen numbers.
+ */
+inline
+__m512
+log1p_avx512(
+  const __m512 x
+)
+{
+  const auto u = _mm512_add_ps(_mm512_set1_ps(1.0f), x);
+  // Correct for the rounding error in computing 1 + x
+  auto c = _mm512_div_ps(_mm512_sub_ps(_mm512_sub_ps(u, _mm512_set1_ps(1.0f)), x), u);
+  // The correction is zero, instead of NaN, if 1 + x is infinite or zero
+  c = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(c, c, _CMP_ORD_Q), c);
+  return _mm512_sub_ps(log_avx512(u), c);
+}
+
+/**
+ * @brief Adds sixteen single precision numbers, pairwise
+ *        in double precision, to eight double precision sums.
+ */
+inline
+__m512d
+add_widen_avx512(
+  const __m512d sum,
+  const __m512 x
+)
+{
+  const auto lo = _mm512_cvtps_pd(_mm512_castps512_ps256(x));
+  const auto hi = _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(x), 1)));
+  return _mm512_add_pd(sum, _mm512_add_pd(lo, hi));
+}
+#endif
+
+// The AVX2 functions are also available with AVX-512, so that both can be tested
+#if defined(HAVE_AVX2_INSTRUCTIONS) && defined(__AVX2__)
+/**
+ * @brief Computes the natural logarithm of four numbers.
+ */
+inline
+__m256d
+log_avx2(
+  const __m256d x
+)
+{
+  const auto one = _mm256_set1_pd(1.0);
+  // Scale the subnormal numbers by 2^54 so that they are normal
+  const auto tiny = _mm256_cmp_pd(x, _mm256_set1_pd(std::numeric_limits<double>::min()), _CMP_LT_OQ);
+  const auto bits = _mm256_castpd_si256(_mm256_blendv_pd(x, _mm256_mul_pd(x, _mm256_set1_pd(18014398509481984.0)), tiny));
+  // Decompose x = m * 2^e, with m in [0.5, 1)
+  auto m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x800FFFFFFFFFFFFFLL)),
+                                               _mm256_set1_epi64x(0x3FE0000000000000LL)));
+  // Convert the biased exponent to double by adding it to the mantissa of 2^52
+  const auto magic = _mm256_set1_pd(4503599627370496.0);
+  auto e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_castpd_si256(magic))),
+                         magic);
+  e = _mm256_sub_pd(e, _mm256_add_pd(_mm256_set1_pd(1022.0), _mm256_and_pd(tiny, _mm256_set1_pd(54.0))));
+  // Shift the range of m to [sqrt(0.5), sqrt(2)) and compute x = m - 1
+  const auto small = _mm256_cmp_pd(m, _mm256_set1_pd(LogCoefficients::sqrtHalf), _CMP_LT_OQ);
+  e = _mm256_sub_pd(e, _mm256_and_pd(small, one));
+  const auto y = _mm256_sub_pd(_mm256_add_pd(m, _mm256_and_pd(small, m)), one);
+  const auto z = _mm256_mul_pd(y, y);
+  auto p = _mm256_set1_pd(LogCoefficients::P[0]);
+  for (auto i = 1u; i < 6u; ++i) {
+    p = _mm256_add_pd(_mm256_mul_pd(p, y), _mm256_set1_pd(LogCoefficients::P[i]));
+  }
+  auto q = _mm256_add_pd(y, _mm256_set1_pd(LogCoefficients::Q[0]));
+  for (auto i = 1u; i < 5u; ++i) {
+    q = _mm256_add_pd(_mm256_mul_pd(q, y), _mm256_set1_pd(LogCoefficients::Q[i]));
+  }
+  auto r = _mm256_mul_pd(y, _mm256_div_pd(_mm256_mul_pd(z, p), q));
+  r = _mm256_add_pd(r, _mm256_mul_pd(e, _mm256_set1_pd(LogCoefficients::ln2Lo)));
+  r = _mm256_sub_pd(r, _mm256_mul_pd(_mm256_set1_pd(0.5), z));
+  r = _mm256_add_pd(_mm256_add_pd(y, r), _mm256_mul_pd(e, _mm256_set1_pd(LogCoefficients::ln2Hi)));
+  // log(inf) = inf, log(0) = -inf, and the logarithms of negative numbers are NaN
+  const auto zero = _mm256_setzero_pd();
+  r = _mm256_blendv_pd(r, x, _mm256_cmp_pd(x, _mm256_set1_pd(std::numeric_limits<double>::infinity()), _CMP_EQ_OQ));
+  r = _mm256_blendv_pd(r, _mm256_set1_pd(-std::numeric_limits<double>::infinity()), _mm256_cmp_pd(x, zero, _CMP_EQ_OQ));
+  return _mm256_blendv_pd(r, _mm256_set1_pd(std::numeric_limits<double>::quiet_NaN()), _mm256_cmp_pd(x, zero, _CMP_NGE_UQ));
+}
+
+/**
+ * @brief Computes 2^n for four integral values of n in [-1022, 1023].
+ */
+inline
+__m256d
+pow2_avx2(
+  const __m256d n
+)
+{
+  // The biased exponent is in the lower bits of the mantissa of 2^52 + n + 1023
+  const auto biased = _mm256_add_pd(n, _mm256_set1_pd(4503599627370496.0 + 1023.0));
+  return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(biased), 52));
+}
+
+/**
+ * @brief Computes the exponential of four numbers.
+ */
+inline
+__m256d
+exp_avx2(
+  const __m256d x
+)
+{
+  // The second operands of min and max are returned if either is NaN
+  auto y = _mm256_min_pd(_mm256_set1_pd(ExpCoefficients::maxArg),
+                         _mm256_max_pd(_mm256_set1_pd(ExpCoefficients::minArg), x));
+  // Express exp(x) = 2^n * exp(y), with |y| <= log(2) / 2
+  const auto n = _mm256_round_pd(_mm256_mul_pd(y, _mm256_set1_pd(ExpCoefficients::log2e)),
+                                 _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  y = _mm256_sub_pd(y, _mm256_mul_pd(n, _mm256_set1_pd(ExpCoefficients::ln2Hi)));
+  y = _mm256_sub_pd(y, _mm256_mul_pd(n, _mm256_set1_pd(ExpCoefficients::ln2Lo)));
+  const auto z = _mm256_mul_pd(y, y);
+  auto p = _mm256_set1_pd(ExpCoefficients::P[0]);
+  for (auto i = 1u; i < 3u; ++i) {
+    p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(ExpCoefficients::P[i]));
+  }
+  p = _mm256_mul_pd(p, y);
+  auto q = _mm256_set1_pd(ExpCoefficients::Q[0]);
+  for (auto i = 1u; i < 4u; ++i) {
+    q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(ExpCoefficients::Q[i]));
+  }
+  auto e = _mm256_add_pd(_mm256_set1_pd(1.0), _mm256_mul_pd(_mm256_set1_pd(2.0), _mm256_div_pd(p, _mm256_sub_pd(q, p))));
+  // Scale in two steps so that n is always in the range of normal exponents
+  const auto n1 = _mm256_floor_pd(_mm256_mul_pd(n, _mm256_set1_pd(0.5)));
+  e = _mm256_mul_pd(e, pow2_avx2(n1));
+  return _mm256_mul_pd(e, pow2_avx2(_mm256_sub_pd(n, n1)));
+}
+
+/**
+ * @brief Computes log(1 + x) for four numbers.
+ */
+inline
+__m256d
+log1p_avx2(
+  const __m256d x
+)
+{
+  const auto u = _mm256_add_pd(_mm256_set1_pd(1.0), x);
+  // Correct for the rounding error in computing 1 + x
+  auto c = _mm256_div_pd(_mm256_sub_pd(_mm256_sub_pd(u, _mm256_set1_pd(1.0)), x), u);
+  // The correction is zero, instead of NaN, if 1 + x is infinite or zero
+  c = _mm256_and_pd(c, _mm256_cmp_pd(c, c, _CMP_ORD_Q));
+  return _mm256_sub_pd(log_avx2(u), c);
+}
+
+/**
+ * @brief Computes the natural logarithm of eight numbers.
+ */
+inline
+__m256
+log_avx2(
+  const __m256 x
+)
+{
+  const auto one = _mm256_set1_ps(1.0f);
+  // Scale the subnormal numbers by 2^25 so that they are normal
+  const auto tiny = _mm256_cmp_ps(x, _mm256_set1_ps(std::numeric_limits<float>::min()), _CMP_LT_OQ);
+  const auto bits = _mm256_castps_si256(_mm256_blendv_ps(x, _mm256_mul_ps(x, _mm256_set1_ps(33554432.0f)), tiny));
+  // Decompose x = m * 2^e, with m in [0.5, 1)
+  auto m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x807FFFFF)),
+                                               _mm256_set1_epi32(0x3F000000)));
+  auto e = _mm256_cvtepi32_ps(_mm256_srli_epi32(bits, 23));
+  e = _mm256_sub_ps(e, _mm256_add_ps(_mm256_set1_ps(126.0f), _mm256_and_ps(tiny, _mm256_set1_ps(25.0f))));
+  // Shift the range of m to [sqrt(0.5), sqrt(2)) and compute x = m - 1
+  const auto small = _mm256_cmp_ps(m, _mm256_set1_ps(LogfCoefficients::sqrtHalf), _CMP_LT_OQ);
+  e = _mm256_sub_ps(e, _mm256_and_ps(small, one));
+  const auto y = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(small, m)), one);
+  const auto z = _mm256_mul_ps(y, y);
+  auto p = _mm256_set1_ps(LogfCoefficients::P[0]);
+  for (auto i = 1u; i < 9u; ++i) {
+    p = _mm256_add_ps(_mm256_mul_ps(p, y), _mm256_set1_ps(LogfCoefficients::P[i]));
+  }
+  auto r = _mm256_mul_ps(_mm256_mul_ps(p, y), z);
+  r = _mm256_add_ps(r, _mm256_mul_ps(e, _mm256_set1_ps(LogfCoefficients::ln2Lo)));
+  r = _mm256_sub_ps(r, _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+  r = _mm256_add_ps(_mm256_add_ps(y, r), _mm256_mul_ps(e, _mm256_set1_ps(LogfCoefficients::ln2Hi)));
+  // log(inf) = inf, log(0) = -inf, and the logarithms of negative numbers are NaN
+  const auto zero = _mm256_setzero_ps();
+  r = _mm256_blendv_ps(r, x, _mm256_cmp_ps(x, _mm256_set1_ps(std::numeric_limits<float>::infinity()), _CMP_EQ_OQ));
+  r = _mm256_blendv_ps(r, _mm256_set1_ps(-std::numeric_limits<float>::infinity()), _mm256_cmp_ps(x, zero, _CMP_EQ_OQ));
+  return _mm256_blendv_ps(r, _mm256_set1_ps(std::numeric_limits<float>::quiet_NaN()), _mm256_cmp_ps(x, zero, _CMP_NGE_UQ));
+}
+
+/**
+ * @brief Computes 2^n for eight integral values of n in [-126, 127].
+ */
+inline
+__m256
+pow2_avx2(
+  const __m256 n
+)
+{
+  const auto biased = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+  return _mm256_castsi256_ps(_mm256_slli_epi32(biased, 23));
+}
+
+/**
+ * @brief Computes the exponential of eight numbers.
+ */
+inline
+__m256
+exp_avx2(
+  const __m256 x
+)
+{
+  // The second operands of min and max are returned if either is NaN
+  auto y = _mm256_min_ps(_mm256_set1_ps(ExpfCoefficients::maxArg),
+                         _mm256_max_ps(_mm256_set1_ps(ExpfCoefficients::minArg), x));
+  // Express exp(x) = 2^n * exp(y), with |y| <= log(2) / 2
+  const auto n = _mm256_round_ps(_mm256_mul_ps(y, _mm256_set1_ps(ExpfCoefficients::log2e)),
+                                 _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  y = _mm256_sub_ps(y, _mm256_mul_ps(n, _mm256_set1_ps(ExpfCoefficients::ln2Hi)));
+  y = _mm256_sub_ps(y, _mm256_mul_ps(n, _mm256_set1_ps(ExpfCoefficients::ln2Lo)));
+  const auto z = _mm256_mul_ps(y, y);
+  auto p = _mm256_set1_ps(ExpfCoefficients::P[0]);
+  for (auto i = 1u; i < 6u; ++i) {
+    p = _mm256_add_ps(_mm256_mul_ps(p, y), _mm256_set1_ps(ExpfCoefficients::P[i]));
+  }
+  auto e = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p, z), y), _mm256_set1_ps(1.0f));
+  // Scale in two steps so that n is always in the range of normal exponents
+  const auto n1 = _mm256_floor_ps(_mm256_mul_ps(n, _mm256_set1_ps(0.5f)));
+  e = _mm256_mul_ps(e, pow2_avx2(n1));
+  return _mm256_mul_ps(e, pow2_avx2(_mm256_sub_ps(n, n1)));
+}
+
+/**
+ * @brief Computes log(1 + x) for eight numbers.
+ */
+inline
+__m256
+log1p_avx2(
+  const __m256 x
+)
+{
+  const auto u = _mm256_add_ps(_mm256_set1_ps(1.0f), x);
+  // Correct for the rounding error in computing 1 + x
+  auto c = _mm256_div_ps(_mm256_sub_ps(_mm256_sub_ps(u, _mm256_set1_ps(1.0f)), x), u);
+  // The correction is zero, instead of NaN, if 1 + x is infinite or zero
+  c = _mm256_and_ps(c, _mm256_cmp_ps(c, c, _CMP_ORD_Q));
+  return _mm256_sub_ps(log_avx2(u), c);
+}
+
+/**
+ * @brief Adds eight single precision numbers, pairwise
+ *        in double precision, to four double precision sums.
+ */
+inline
+__m256d
+add_widen_avx2(
+  const __m256d sum,
+  const __m256 x
+)
+{
+  const auto lo = _mm256_cvtps_pd(_mm256_castps256_ps128(x));
+  const auto hi = _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1));
+  return _mm256_add_pd(sum, _mm256_add_pd(lo, hi));
+}
+#endif
+
+#endif // DETAIL_VECTORMATH_HPP_
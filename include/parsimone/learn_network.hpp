@@ -1,7 +1,10 @@
 #ifndef LEARN_NETWORK_HPP
 #define LEARN_NETWORK_HPP
 
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 #include <mxx/comm.hpp>
 
 #include "parsimone/ProgramOptions.hpp"
@@ -27,4 +30,57 @@ void learn_network(
   std::unique_ptr<DataReader<float>>&& reader
 );
 
+void learn_network(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  const double* const raw,
+  const std::vector<std::string>& varNames
+);
+
+void learn_network(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  const float* const raw,
+  const std::vector<std::string>& varNames
+);
+
+void learn_network(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  const double* const raw,
+  const std::vector<std::string>& varNames,
+  const std::function<void()>& release
+);
+
+void learn_network(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  const float* const raw,
+  const std::vector<std::string>& varNames,
+  const std::function<void()>& release
+);
+
+void learn_network(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  std::vector<double>&& local,
+  const std::vector<std::string>& varNames
+);
+
+void learn_network(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  std::vector<float>&& local,
+  const std::vector<std::string>& varNames
+);
+
+void learn_network(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  std::vector<float>&& values,
+  std::vector<uint32_t>&& indices,
+  std::vector<uint64_t>&& offsets,
+  const std::vector<std::string>& varNames
+);
+
 #endif // LEARN_NETWORK_HPP
@@ -40,11 +40,17 @@ ProgramOptions::ProgramOptions(
     m_h5ObsDataPath(),
     m_numVars(),
     m_numObs(),
+    m_numThreads(),
+    m_cacheRows(),
     m_separator(),
     m_parallelRead(),
+    m_sharedData(),
+    m_distributedData(),
     m_colObs(),
     m_varNames(),
     m_obsIndices(),
+    m_singlePrecision(),
+    m_quantizeData(),
     m_learnNetwork(),
     m_forceParallel(),
     m_hostNames(),
@@ -73,6 +79,12 @@ ProgramOptions::ProgramOptions(
   advanced.add_options()
     ("config,g", po::value<std::string>(&m_configFile)->default_value(""), "JSON file with algorithm specific configurations")
     ("warmup,w", po::bool_switch(&m_warmupMPI)->default_value(false), "Warmup the MPI_Alltoall(v) functions before starting execution")
+    ("threads,t", po::value<uint32_t>(&m_numThreads)->default_value(1), "Number of threads used by every process")
+    ("shared", po::bool_switch(&m_sharedData)->default_value(false), "Store the dataset once per node in shared memory")
+    ("distribute", po::bool_switch(&m_distributedData)->default_value(false), "Distribute the variables in the dataset across the processes")
+    ("cacherows", po::value<uint32_t>(&m_cacheRows)->default_value(1024), "Number of remote variables cached by every process with distributed dataset")
+    ("single", po::bool_switch(&m_singlePrecision)->default_value(false), "Read the dataset from a text file, and learn the network, in single precision")
+    ("quantize", po::bool_switch(&m_quantizeData)->default_value(false), "Store the dataset as 16-bit fixed-point values with a scale and an offset for every variable")
     ;
 
   po::options_description developer("Developer options");
@@ -109,6 +121,15 @@ ProgramOptions::parse(
   if ((vm.count("nvars") == 0) || (vm.count("nobs") == 0)) {
     throw po::error("Dimensions of the data file should be provided using -n and -m");
   }
+  if (m_numThreads == 0) {
+    throw po::error("Number of threads should be positive");
+  }
+  if (m_sharedData && m_distributedData) {
+    throw po::error("The dataset can not be both shared and distributed");
+  }
+  if (m_quantizeData && (m_sharedData || m_distributedData)) {
+    throw po::error("The dataset can not be quantized when it is shared or distributed");
+  }
   if (m_configFile.empty()) {
     m_configFile = m_algoName + "_configs.json";
     std::cerr << "Using the default configuration file for the algorithm: " << m_configFile << std::endl;
@@ -146,6 +167,27 @@ ProgramOptions::parallelRead(
   return m_parallelRead;
 }
 
+bool
+ProgramOptions::sharedData(
+) const
+{
+  return m_sharedData;
+}
+
+bool
+ProgramOptions::distributedData(
+) const
+{
+  return m_distributedData;
+}
+
+uint32_t
+ProgramOptions::cacheRows(
+) const
+{
+  return m_cacheRows;
+}
+
 bool
 ProgramOptions::colObs(
 ) const
@@ -167,6 +209,20 @@ ProgramOptions::obsIndices(
   return m_obsIndices;
 }
 
+bool
+ProgramOptions::singlePrecision(
+) const
+{
+  return m_singlePrecision;
+}
+
+bool
+ProgramOptions::quantizeData(
+) const
+{
+  return m_quantizeData;
+}
+
 char
 ProgramOptions::separator(
 ) const
@@ -223,6 +279,13 @@ ProgramOptions::warmupMPI(
   return m_warmupMPI;
 }
 
+uint32_t
+ProgramOptions::numThreads(
+) const
+{
+  return m_numThreads;
+}
+
 const std::string&
 ProgramOptions::logLevel(
 ) const
@@ -0,0 +1,119 @@
+/**
+ * @file convert.cpp
+ * @brief The implementation of the main function for converting
+ *        data sets to the native binary format of ParsiMoNe.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mxx/comm.hpp"
+
+#include "common/DataReader.hpp"
+#include "common/HDF5DataReader.hpp"
+#include "utils/Timer.hpp"
+
+#include "parsimone/MappedData.hpp"
+#include "parsimone/TextReader.hpp"
+#include "parsimone/ThreadedEnv.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/program_options.hpp>
+
+#include <iostream>
+#include <sstream>
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+
+namespace po = boost::program_options;
+
+int
+main(
+  int argc,
+  char** argv
+)
+{
+  ThreadedEnv e(argc, argv, MPI_THREAD_SERIALIZED);
+#ifdef USE_OPENMP
+  if (!e.supports(MPI_THREAD_SERIALIZED)) {
+    // Do not read the file using multiple threads if the MPI library is not thread-safe
+    omp_set_num_threads(1);
+  }
+#endif
+
+  uint32_t n, m;
+  std::string dataFile, outputFile;
+  std::string h5Path, h5MatrixDataPath, h5ObsDataPath, h5VarsDataPath;
+  char separator;
+  bool colObs, varNames, obsIndices;
+  po::options_description desc("Conversion of data sets to the native binary format of ParsiMoNe");
+  desc.add_options()
+    ("help,h", "Print this message")
+    ("nvars,n", po::value<uint32_t>(&n), "Number of variables in the dataset")
+    ("nobs,m", po::value<uint32_t>(&m), "Number of observations in the dataset")
+    ("file,f", po::value<std::string>(&dataFile), "Name of the file from which dataset is to be read")
+    ("output,o", po::value<std::string>(&outputFile), "Name of the file to which the converted dataset should be written")
+    ("colobs,c", po::bool_switch(&colObs)->default_value(false), "The file contains observations in columns")
+    ("separator,s", po::value<char>(&separator)->default_value(','), "Delimiting character in the file")
+    ("varnames,v", po::bool_switch(&varNames)->default_value(false), "The file contains variable names")
+    ("indices,i", po::bool_switch(&obsIndices)->default_value(false), "The file contains observation indices")
+    ("h5root", po::value<std::string>(&h5Path)->default_value("/"), "HDF5 Root Path for all data")
+    ("h5matrix", po::value<std::string>(&h5MatrixDataPath)->default_value("matrix"), "HDF5 path to matrix data")
+    ("h5obs", po::value<std::string>(&h5ObsDataPath)->default_value("col_attrs/CellID"), "HDF5 path to observations names")
+    ("h5var", po::value<std::string>(&h5VarsDataPath)->default_value("row_attrs/Gene"), "HDF5 path to variable names")
+    ;
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+    if ((argc == 1) || (vm.count("help") > 0)) {
+      std::stringstream ss;
+      ss << desc;
+      throw po::error(ss.str());
+    }
+    if ((vm.count("file") == 0) || (vm.count("output") == 0)) {
+      throw po::error("Names of the input and the output files should be provided using -f and -o");
+    }
+    if ((vm.count("nvars") == 0) || (vm.count("nobs") == 0)) {
+      throw po::error("Dimensions of the data file should be provided using -n and -m");
+    }
+  }
+  catch (const po::error& pe) {
+    std::cerr << pe.what() << std::endl;
+    return 1;
+  }
+
+  try {
+    TIMER_DECLARE(tConvert);
+    if (boost::algorithm::ends_with(dataFile, "hdf5") || boost::algorithm::ends_with(dataFile, ".h5") ||
+        boost::algorithm::ends_with(dataFile, ".loom") || boost::algorithm::ends_with(dataFile, ".h5ad")) {
+      HDF5ObservationReader<float> reader(dataFile, n, m, h5Path, h5MatrixDataPath, h5ObsDataPath, h5VarsDataPath, false);
+      MappedData::write(outputFile, reader.data().data(), n, m, reader.varNames());
+    }
+    else {
+      TextReader<double> reader(mxx::comm(), dataFile, n, m, separator, colObs, varNames, obsIndices, false);
+      MappedData::write(outputFile, reader.data().data(), n, m, reader.varNames());
+    }
+    TIMER_ELAPSED("Time taken in converting the file: ", tConvert);
+  }
+  catch (const std::runtime_error& e) {
+    std::cerr << "Encountered runtime error during execution:" << std::endl;
+    std::cerr << e.what() << std::endl;
+    std::cerr << "Aborting." << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -19,10 +19,15 @@
  * limitations under the License.
  */
 #include "parsimone/RawData.hpp"
+#include "parsimone/QuantizedData.hpp"
+#include "parsimone/DistributedData.hpp"
+#include "parsimone/SparseData.hpp"
 #include "parsimone/Genomica.hpp"
 #include "parsimone/LemonTree.hpp"
 #include "parsimone/ProgramOptions.hpp"
+#include "parsimone/detail/IndexSet.hpp"
 
+#include "common/DataReader.hpp"
 #include "common/UintSet.hpp"
 #include "utils/Timer.hpp"
 
@@ -31,6 +36,7 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <functional>
 #include <iostream>
 #include <memory>
 
@@ -58,7 +64,9 @@ bool endsWith(const std::string& str, const char* suffix)
  * @brief Gets a pointer to the object of the required module network learning algorithm.
  *
  * @tparam Var Type of the variables (expected to be an integral type).
- * @tparam Set Type of set container.
+ * @tparam VarSet Type of set container for the variables.
+ * @tparam Obs Type of the observations (expected to be an integral type).
+ * @tparam ObsSet Type of set container for the observations.
  * @tparam Data Type of the object which is used for querying data.
  * @param algoName The name of the algorithm.
  * @param data The object which is used for querying data.
@@ -66,8 +74,8 @@ bool endsWith(const std::string& str, const char* suffix)
  * @return unique_ptr to the object of the given algorithm.
  *         The unique_ptr points to a nullptr if the algorithm is not found.
  */
-template <typename Var, typename Set, typename Data>
-std::unique_ptr<ModuleNetworkLearning<Data, Var, Set>>
+template <typename Var, typename VarSet, typename Obs, typename ObsSet, typename Data>
+std::unique_ptr<ModuleNetworkLearning<Data, Var, VarSet, Obs, ObsSet>>
 getAlgorithm(
   const std::string& algoName,
   const mxx::comm& comm,
@@ -76,15 +84,15 @@ getAlgorithm(
 {
   std::stringstream ss;
   if (algoName.compare("lemontree") == 0) {
-    return std::make_unique<LemonTree<Data, Var, Set>>(comm, data);
+    return std::make_unique<LemonTree<Data, Var, VarSet, Obs, ObsSet>>(comm, data);
   }
   ss << "lemontree";
   if (algoName.compare("genomica") == 0) {
-    return std::make_unique<Genomica<Data, Var, Set>>(comm, data);
+    return std::make_unique<Genomica<Data, Var, VarSet, Obs, ObsSet>>(comm, data);
   }
   ss << ",genomica";
   throw std::runtime_error("Requested algorithm not found. Supported algorithms are: {" + ss.str() + "}");
-  return std::unique_ptr<ModuleNetworkLearning<Data, Var, Set>>();
+  return std::unique_ptr<ModuleNetworkLearning<Data, Var, VarSet, Obs, ObsSet>>();
 }
 
 pt::ptree
@@ -114,14 +122,33 @@ readConfigs(
   return configs;
 }
 
+/**
+ * @brief Creates the output directory, if it does not exist.
+ */
+void
+createOutputDir(
+  const std::string& outputDir
+)
+{
+  namespace fs = boost::filesystem;
+  if (!fs::is_directory(outputDir)) {
+    if (!fs::create_directories(outputDir)) {
+      throw po::error("Output directory doesn't exist and could not be created");
+    }
+  }
+}
+
 /**
  * @brief Learns the module network with the given parameters
  *        and writes it to the given file.
  *
  * @tparam Var Type of the variables (expected to be an integral type).
+ * @tparam VarSet Type of set container for the variables.
+ * @tparam Obs Type of the observations (expected to be an integral type).
+ * @tparam ObsSet Type of set container for the observations.
  * @param options Program options provider.
  */
-template <typename Var, typename Size, typename Data>
+template <typename Var, typename VarSet, typename Obs, typename ObsSet, typename Data>
 void
 learnNetwork(
   const ProgramOptions& options,
@@ -129,15 +156,11 @@ learnNetwork(
   const Data& data
 )
 {
-  auto algo = getAlgorithm<Var, UintSet<Var, Size>>(options.algoName(), comm, data);
+  auto algo = getAlgorithm<Var, VarSet, Obs, ObsSet>(options.algoName(), comm, data);
   auto configs = readConfigs(options.configFile(), comm);
   if (comm.is_first()) {
     namespace fs = boost::filesystem;
-    if (!fs::is_directory(options.outputDir())) {
-      if (!fs::create_directories(options.outputDir())) {
-        throw po::error("Output directory doesn't exist and could not be created");
-      }
-    }
+    createOutputDir(options.outputDir());
     fs::copy_file(fs::path(options.configFile()), options.outputDir() + "/configs.json", fs::copy_options::overwrite_existing);
   }
   comm.barrier();
@@ -149,82 +172,217 @@ learnNetwork(
   }
 }
 
+/**
+ * @brief Tag type which carries a type of indices and
+ *        the corresponding type of set container.
+ */
+template <typename IndexType, typename SetType>
+struct IndexTypes {
+  using Index = IndexType;
+  using Set = SetType;
+};
+
+/**
+ * @brief Calls the given function with the tag of the type of indices,
+ *        and of set container, which can store the given number of
+ *        variables or observations.
+ *
+ * Only four capacity classes, which differ by a factor of sixteen, are used
+ * for either dimension, since every one of them is compiled in combination
+ * with every capacity class of the other dimension for every type of data.
+ * Bitsets are used for up to 65535 elements, because the updates of the
+ * sets with single elements are much slower with sets of indices.
+ *
+ * @tparam Func Type of the function to be called.
+ * @param size The number of elements to be stored.
+ * @param func The function to be called with the tag.
+ */
+template <typename Func>
+void
+withIndexTypes(
+  const uint32_t size,
+  Func&& func
+)
+{
+  if ((size - 1) <= UintSet<uint8_t>::capacity()) {
+    func(IndexTypes<uint8_t, UintSet<uint8_t, std::integral_constant<int, maxSize<uint8_t>()>>>());
+  }
+  else if ((size - 1) <= UintSet<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 4)>>::capacity()) {
+    func(IndexTypes<uint16_t, UintSet<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 4)>>>());
+  }
+  else if ((size - 1) <= UintSet<uint16_t, std::integral_constant<int, maxSize<uint16_t>()>>::capacity()) {
+    func(IndexTypes<uint16_t, UintSet<uint16_t, std::integral_constant<int, maxSize<uint16_t>()>>>());
+  }
+  else {
+    // Bitsets of this capacity would use too much memory for every set;
+    // therefore, use sets which store only the indices of their elements
+    func(IndexTypes<uint32_t, IndexSet<uint32_t>>());
+  }
+}
+
+/**
+ * @brief Learns the module network with the given parameters, using the
+ *        smallest types of the variables and of the observations that can
+ *        index the respective dimensions of the data set.
+ *
+ * @tparam DataFactory Type of the function that constructs the data provider.
+ * @param options Program options provider.
+ * @param makeData Function that constructs the data provider object, given
+ *                 values of the types of the variables and the observations.
+ *                 It is called exactly once, and may therefore move the data
+ *                 set that it owns into the data provider object.
+ */
+template <typename DataFactory>
+void
+learnNetwork(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  DataFactory makeData
+)
+{
+  auto n = options.numVars();
+  auto m = options.numObs();
+  withIndexTypes(n, [&] (auto varTypes) {
+    using Var = typename decltype(varTypes)::Index;
+    using VarSet = typename decltype(varTypes)::Set;
+    withIndexTypes(m, [&] (auto obsTypes) {
+      using Obs = typename decltype(obsTypes)::Index;
+      using ObsSet = typename decltype(obsTypes)::Set;
+      auto data = makeData(Var(), Obs());
+      learnNetwork<Var, VarSet, Obs, ObsSet>(options, comm, data);
+    });
+  });
+}
+
 /**
  * @brief Learns the module network with the given parameters
- *        and writes it to the given file.
+ *        and writes it to the given file. If requested, the data set
+ *        is quantized first and the quantization errors are written
+ *        to the output directory.
  *
- * @tparam FileType Type of the file to be read.
+ * @tparam DataType Type of the data set.
+ * @tparam ReleaseFunc Type of the function that releases the data set.
  * @param options Program options provider.
- * @param reader File data reader.
+ * @param raw Pointer to the data set, in variable-major order.
+ * @param varNames Names of the variables in the data set.
+ * @param release Function that is called once the data set has been
+ *                quantized, after which neither the data set nor the
+ *                names are accessed. It is not called otherwise.
  */
-template <template <typename> class Reader, typename DataType>
+template <typename DataType, typename ReleaseFunc>
 void
 learnNetwork(
   const ProgramOptions& options,
   const mxx::comm& comm,
-  std::unique_ptr<Reader<DataType>>&& reader
+  const DataType* const raw,
+  const std::vector<std::string>& varNames,
+  ReleaseFunc&& release
 )
 {
   auto n = options.numVars();
   auto m = options.numObs();
-  auto s = std::max(n, m);
-  if ((s - 1) <= UintSet<uint8_t, std::integral_constant<int, (maxSize<uint8_t>() >> 2)>>::capacity()) {
-    RawData<DataType, uint8_t> data(reader->data(), reader->varNames(), static_cast<uint8_t>(n), static_cast<uint8_t>(m));
-    learnNetwork<uint8_t, std::integral_constant<int, (maxSize<uint8_t>() >> 2)>>(options, comm, data);
-  }
-  else if ((s - 1) <= UintSet<uint8_t, std::integral_constant<int, (maxSize<uint8_t>() >> 1)>>::capacity()) {
-    RawData<DataType, uint8_t> data(reader->data(), reader->varNames(), static_cast<uint8_t>(n), static_cast<uint8_t>(m));
-    learnNetwork<uint8_t, std::integral_constant<int, (maxSize<uint8_t>() >> 1)>>(options, comm, data);
-  }
-  else if ((s - 1) <= UintSet<uint8_t>::capacity()) {
-    RawData<DataType, uint8_t> data(reader->data(), reader->varNames(), static_cast<uint8_t>(n), static_cast<uint8_t>(m));
-    learnNetwork<uint8_t, std::integral_constant<int, maxSize<uint8_t>()>>(options, comm, data);
-  }
-  else if ((s - 1) <= UintSet<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 7)>>::capacity()) {
-    RawData<DataType, uint16_t> data(reader->data(), reader->varNames(), static_cast<uint16_t>(n), static_cast<uint16_t>(m));
-    learnNetwork<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 7)>>(options, comm, data);
-  }
-  else if ((s - 1) <= UintSet<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 6)>>::capacity()) {
-    RawData<DataType, uint16_t> data(reader->data(), reader->varNames(), static_cast<uint16_t>(n), static_cast<uint16_t>(m));
-    learnNetwork<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 6)>>(options, comm, data);
-  }
-  else if ((s - 1) <= UintSet<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 5)>>::capacity()) {
-    RawData<DataType, uint16_t> data(reader->data(), reader->varNames(), static_cast<uint16_t>(n), static_cast<uint16_t>(m));
-    learnNetwork<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 5)>>(options, comm, data);
-  }
-  else if ((s - 1) <= UintSet<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 4)>>::capacity()) {
-    RawData<DataType, uint16_t> data(reader->data(), reader->varNames(), static_cast<uint16_t>(n), static_cast<uint16_t>(m));
-    learnNetwork<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 4)>>(options, comm, data);
-  }
-  else if ((s - 1) <= UintSet<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 3)>>::capacity()) {
-    RawData<DataType, uint16_t> data(reader->data(), reader->varNames(), static_cast<uint16_t>(n), static_cast<uint16_t>(m));
-    learnNetwork<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 3)>>(options, comm, data);
-  }
-  else if ((s - 1) <= UintSet<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 2)>>::capacity()) {
-    RawData<DataType, uint16_t> data(reader->data(), reader->varNames(), static_cast<uint16_t>(n), static_cast<uint16_t>(m));
-    learnNetwork<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 2)>>(options, comm, data);
-  }
-  else if ((s - 1) <= UintSet<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 1)>>::capacity()) {
-    RawData<DataType, uint16_t> data(reader->data(), reader->varNames(), static_cast<uint16_t>(n), static_cast<uint16_t>(m));
-    learnNetwork<uint16_t, std::integral_constant<int, (maxSize<uint16_t>() >> 1)>>(options, comm, data);
-  }
-  else if ((s - 1) <= UintSet<uint16_t, std::integral_constant<int, maxSize<uint16_t>()>>::capacity()) {
-    RawData<DataType, uint16_t> data(reader->data(), reader->varNames(), static_cast<uint16_t>(n), static_cast<uint16_t>(m));
-    learnNetwork<uint16_t, std::integral_constant<int, maxSize<uint16_t>()>>(options, comm, data);
-  }
-  else {
-    throw std::runtime_error("The given number of variables and observations is not supported.");
+  if (options.quantizeData()) {
+    auto makeData = [&] (auto var, auto obs) {
+                      using Var = decltype(var);
+                      using Obs = decltype(obs);
+                      TIMER_DECLARE(tQuantize);
+                      QuantizedData<Var, Obs> data(raw, varNames, static_cast<Var>(n), static_cast<Obs>(m));
+                      release();
+                      if (comm.is_first()) {
+                        TIMER_ELAPSED("Time taken in quantizing the data set: ", tQuantize);
+                        auto maxError = data.maxError();
+                        std::cout << "Largest quantization error: " << maxError.second
+                                  << " (" << data.varName(maxError.first) << ")" << std::endl;
+                        createOutputDir(options.outputDir());
+                        data.writeErrors(options.outputDir() + "/quantization_errors.txt");
+                      }
+                      return data;
+                    };
+    learnNetwork(options, comm, makeData);
+    return;
   }
+  auto makeData = [&] (auto var, auto obs) {
+                    using Var = decltype(var);
+                    using Obs = decltype(obs);
+                    return RawData<DataType, Var, Obs>(raw, varNames, static_cast<Var>(n), static_cast<Obs>(m));
+                  };
+  learnNetwork(options, comm, makeData);
 }
 
-#include "common/DataReader.hpp"
+/**
+ * @brief Learns the module network with the given parameters
+ *        and writes it to the given file, from the data set
+ *        distributed across the processors by variables.
+ *
+ * @tparam DataType Type of the data set.
+ * @param options Program options provider.
+ * @param local Observations of the block of variables on this processor.
+ * @param varNames Names of all the variables in the data set.
+ */
+template <typename DataType>
+void
+learnNetwork(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  std::vector<DataType>&& local,
+  const std::vector<std::string>& varNames
+)
+{
+  auto n = options.numVars();
+  auto m = options.numObs();
+  auto makeData = [&options, &comm, &varNames, n, m, local = std::move(local)] (auto var, auto obs) mutable {
+                    using Var = decltype(var);
+                    using Obs = decltype(obs);
+                    return DistributedData<DataType, Var, Obs>(comm, std::move(local), varNames, static_cast<Var>(n),
+                                                               static_cast<Obs>(m), options.cacheRows());
+                  };
+  learnNetwork(options, comm, std::move(makeData));
+}
+
+/**
+ * @brief Learns the module network with the given parameters
+ *        and writes it to the given file, from the sparse data set.
+ *
+ * @tparam DataType Type of the data set.
+ * @param options Program options provider.
+ * @param values The values which are not zero, ordered by the variables.
+ * @param indices The observation index of every value.
+ * @param offsets The position of the first value of every variable.
+ * @param varNames Names of all the variables in the data set.
+ */
+template <typename DataType>
+void
+learnNetwork(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  std::vector<DataType>&& values,
+  std::vector<uint32_t>&& indices,
+  std::vector<uint64_t>&& offsets,
+  const std::vector<std::string>& varNames
+)
+{
+  auto n = options.numVars();
+  auto m = options.numObs();
+  if (comm.is_first()) {
+    std::cout << "Density of the sparse data set: " << static_cast<double>(values.size()) / (static_cast<double>(n) * m) << std::endl;
+  }
+  auto makeData = [&varNames, n, m, values = std::move(values), indices = std::move(indices),
+                   offsets = std::move(offsets)] (auto var, auto obs) mutable {
+                    using Var = decltype(var);
+                    using Obs = decltype(obs);
+                    return SparseData<DataType, Var, Obs>(std::move(values), std::move(indices), std::move(offsets),
+                                                          varNames, static_cast<Var>(n), static_cast<Obs>(m));
+                  };
+  learnNetwork(options, comm, std::move(makeData));
+}
 
 void learn_network(
   const ProgramOptions& options,
   const mxx::comm& comm,
   std::unique_ptr<DataReader<double>>&& reader
 ){
-    learnNetwork(options, comm, std::move(reader));
+    // The reader is destroyed once the data set has been quantized
+    learnNetwork(options, comm, reader->data().data(), reader->varNames(), [&reader] { reader.reset(); });
 }
 
 void learn_network(
@@ -232,5 +390,73 @@ void learn_network(
   const mxx::comm& comm,
   std::unique_ptr<DataReader<float>>&& reader
 ){
-    learnNetwork(options, comm, std::move(reader));
+    // The reader is destroyed once the data set has been quantized
+    learnNetwork(options, comm, reader->data().data(), reader->varNames(), [&reader] { reader.reset(); });
+}
+
+void learn_network(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  const double* const raw,
+  const std::vector<std::string>& varNames
+){
+    learnNetwork(options, comm, raw, varNames, [] { });
+}
+
+void learn_network(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  const double* const raw,
+  const std::vector<std::string>& varNames,
+  const std::function<void()>& release
+){
+    learnNetwork(options, comm, raw, varNames, release);
+}
+
+void learn_network(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  const float* const raw,
+  const std::vector<std::string>& varNames
+){
+    learnNetwork(options, comm, raw, varNames, [] { });
+}
+
+void learn_network(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  const float* const raw,
+  const std::vector<std::string>& varNames,
+  const std::function<void()>& release
+){
+    learnNetwork(options, comm, raw, varNames, release);
+}
+
+void learn_network(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  std::vector<double>&& local,
+  const std::vector<std::string>& varNames
+){
+    learnNetwork(options, comm, std::move(local), varNames);
+}
+
+void learn_network(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  std::vector<float>&& local,
+  const std::vector<std::string>& varNames
+){
+    learnNetwork(options, comm, std::move(local), varNames);
+}
+
+void learn_network(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  std::vector<float>&& values,
+  std::vector<uint32_t>&& indices,
+  std::vector<uint64_t>&& offsets,
+  const std::vector<std::string>& varNames
+){
+    learnNetwork(options, comm, std::move(values), std::move(indices), std::move(offsets), varNames);
 }
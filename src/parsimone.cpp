@@ -1,17 +1,30 @@
 
 #include "mxx/env.hpp"
+#include "mxx/collective.hpp"
+#include "mxx/distribution.hpp"
 
 #include "common/DataReader.hpp"
 #include "common/HDF5DataReader.hpp"
 #include "utils/Timer.hpp"
 #include "utils/Logging.hpp"
 
+#include "parsimone/HDF5BlockReader.hpp"
+#include "parsimone/MappedData.hpp"
 #include "parsimone/ProgramOptions.hpp"
+#include "parsimone/SharedData.hpp"
+#include "parsimone/SparseReader.hpp"
+#include "parsimone/TextReader.hpp"
+#include "parsimone/ThreadedEnv.hpp"
 #include "parsimone/learn_network.hpp"
 
 #include <boost/asio/ip/host_name.hpp>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <vector>
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
 
 
 
@@ -33,16 +46,193 @@ warmupMPI(
   mxx::all2allv(&send[0], sendSizes, sendDispls, &recv[0], recvSizes, recvDispls, comm);
 }
 
+/**
+ * @brief Broadcasts the names of the variables from the first processor.
+ *
+ * @param varNames Names of the variables, only used on the first processor.
+ * @param comm The communicator for the broadcast.
+ *
+ * @return Names of the variables on all the processors.
+ */
+std::vector<std::string>
+bcastVarNames(
+  const std::vector<std::string>& varNames,
+  const mxx::comm& comm
+)
+{
+  std::string names;
+  if (comm.is_first()) {
+    for (const auto& name : varNames) {
+      names += name + '\n';
+    }
+  }
+  mxx::bcast(names, 0, comm);
+  std::vector<std::string> allNames;
+  std::istringstream ss(names);
+  for (std::string name; std::getline(ss, name); ) {
+    allNames.push_back(name);
+  }
+  return allNames;
+}
+
+/**
+ * @brief Reads the data set and learns the module network from it.
+ *        If requested, the data set is either read by only one process
+ *        on every node and stored once per node in memory shared by all
+ *        the processes on the node, or distributed across the processes
+ *        by variables, in which case every process only reads its block.
+ *
+ * @tparam DataType Type of the data set.
+ * @tparam ReadFunc Type of the function that reads the data set.
+ * @tparam ReadBlockFunc Type of the function that reads a block of the data set.
+ * @param options Program options provider.
+ * @param readFile Function that returns a reader for the data set, given
+ *                 whether the file should be read in parallel.
+ * @param readBlock Function that returns a reader for the observations of
+ *                  the given block of the variables, and the names of all
+ *                  the variables.
+ */
+template <typename DataType, typename ReadFunc, typename ReadBlockFunc>
+void
+readAndLearn(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  ReadFunc&& readFile,
+  ReadBlockFunc&& readBlock
+)
+{
+  TIMER_DECLARE(tRead);
+  if (!options.sharedData() && !options.distributedData()) {
+    auto reader = readFile(options.parallelRead());
+    comm.barrier();
+    if (comm.is_first()) {
+      TIMER_ELAPSED("Time taken in reading the file: ", tRead);
+    }
+    // The reader, and with it the original values, is destroyed
+    // as soon as the data set has been quantized, if requested
+    auto varNames = reader->varNames();
+    learn_network(options, comm, static_cast<const DataType*>(reader->data().data()), varNames,
+                  [&reader] { reader.reset(); });
+    return;
+  }
+  auto n = options.numVars();
+  auto m = options.numObs();
+  if (options.distributedData()) {
+    mxx::blk_dist block(n, comm.size(), comm.rank());
+    auto reader = readBlock(block);
+    std::vector<DataType> local(std::move(reader->data()));
+    auto varNames = reader->varNames();
+    reader.reset();
+    comm.barrier();
+    if (comm.is_first()) {
+      TIMER_ELAPSED("Time taken in reading the file: ", tRead);
+    }
+    learn_network(options, comm, std::move(local), varNames);
+    return;
+  }
+  if (comm.is_first() && options.parallelRead()) {
+    std::cerr << "WARNING: The file is not read in parallel when the data set is shared" << std::endl;
+  }
+  SharedData<DataType> shared(comm, static_cast<size_t>(n) * m);
+  std::vector<std::string> names;
+  if (shared.nodeComm().is_first()) {
+    auto reader = readFile(false);
+    std::copy(reader->data().begin(), reader->data().end(), shared.data());
+    names = reader->varNames();
+  }
+  shared.sync();
+  auto varNames = bcastVarNames(names, shared.nodeComm());
+  comm.barrier();
+  if (comm.is_first()) {
+    TIMER_ELAPSED("Time taken in reading the file: ", tRead);
+  }
+  learn_network(options, comm, static_cast<const DataType*>(shared.data()), varNames);
+}
+
+/**
+ * @brief Learns the module network from the data set in a file in the
+ *        native binary format, which is mapped to memory. Since the
+ *        mapped pages are shared by all the processes on a node, the
+ *        data set is never copied unless it is distributed.
+ *
+ * @tparam DataType Type of the values in the file.
+ * @param options Program options provider.
+ * @param mapped The mapped file.
+ */
+template <typename DataType>
+void
+learnMapped(
+  const ProgramOptions& options,
+  const mxx::comm& comm,
+  const MappedData& mapped
+)
+{
+  auto data = mapped.data<DataType>();
+  if (options.distributedData()) {
+    auto m = mapped.numObs();
+    mxx::blk_dist block(mapped.numVars(), comm.size(), comm.rank());
+    std::vector<DataType> local(data + block.eprefix_size() * m, data + block.iprefix_size() * m);
+    learn_network(options, comm, std::move(local), mapped.varNames());
+  }
+  else {
+    learn_network(options, comm, data, mapped.varNames());
+  }
+}
+
+/**
+ * @brief Learns the module network from the sparse data set in an HDF5
+ *        file, which is read by every process and is kept in the sparse
+ *        format throughout the learning.
+ *
+ * @param options Program options provider.
+ */
+void
+learnSparse(
+  const ProgramOptions& options,
+  const mxx::comm& comm
+)
+{
+  if (comm.is_first() && (options.sharedData() || options.distributedData() || options.parallelRead())) {
+    std::cerr << "WARNING: The sparse data set is read by every process and is not shared or distributed" << std::endl;
+  }
+  if (comm.is_first() && options.quantizeData()) {
+    std::cerr << "WARNING: The sparse data set is not quantized" << std::endl;
+  }
+  TIMER_DECLARE(tRead);
+  SparseReader<float> reader(options.dataFile(), options.numVars(), options.numObs(), options.h5root(),
+                             options.h5matrixPath(), options.h5varPath());
+  comm.barrier();
+  if (comm.is_first()) {
+    TIMER_ELAPSED("Time taken in reading the file: ", tRead);
+  }
+  learn_network(options, comm, std::move(reader.values()), std::move(reader.indices()),
+                std::move(reader.offsets()), reader.varNames());
+}
+
 int
 main(
   int argc,
   char** argv
 )
 {
+  // Parse the options before setting up MPI because
+  // the required level of thread support depends on them
+  ProgramOptions options;
+  std::string parseError;
+  try {
+    options.parse(argc, argv);
+  }
+  catch (const po::error& pe) {
+    parseError = pe.what();
+  }
+  // Threads only make MPI calls one at a time, except when the data set is
+  // distributed and the rows are fetched from inside OpenMP parallel regions
+  int required = (parseError.empty() && options.distributedData()) ? MPI_THREAD_MULTIPLE : MPI_THREAD_SERIALIZED;
+
   // Set up MPI
   TIMER_DECLARE(tInit);
 
-  mxx::env e(argc, argv);
+  ThreadedEnv e(argc, argv, required);
   mxx::env::set_exception_on_error();
   mxx::comm comm;
   comm.barrier();
@@ -50,18 +240,29 @@ main(
     TIMER_ELAPSED("Time taken in initializing MPI: ", tInit);
   }
 
-
-  ProgramOptions options;
-  try {
-    options.parse(argc, argv);
-  }
-  catch (const po::error& pe) {
+  if (!parseError.empty()) {
     if (comm.is_first()) {
-      std::cerr << pe.what() << std::endl;
+      std::cerr << parseError << std::endl;
     }
     return 1;
   }
 
+  auto numThreads = options.numThreads();
+  if ((numThreads > 1) && !e.supports(required)) {
+    if (comm.is_first()) {
+      std::cerr << "WARNING: The MPI library does not provide the required level of thread support; "
+                << "using one thread per process" << std::endl;
+    }
+    numThreads = 1;
+  }
+#ifdef USE_OPENMP
+  omp_set_num_threads(numThreads);
+#else
+  if (comm.is_first() && (numThreads > 1)) {
+    std::cerr << "Built without OpenMP support; using one thread per process" << std::endl;
+  }
+#endif
+
   if (options.hostNames()) {
     auto name = boost::asio::ip::host_name();
     if (comm.is_first()) {
@@ -106,40 +307,68 @@ main(
       std::cerr << "WARNING: The given number of observations is possibly too big to be handled by 32-bit unsigned integer" << std::endl;
       std::cerr << "         This may result in silent errors because of overflow" << std::endl;
     }
-    TIMER_DECLARE(tRead);
-    constexpr auto varMajor = true;
     const std::string& filename = options.dataFile();
-    if ((endsWith(filename, "hdf5")) || (endsWith(filename, ".h5")) || 
-        (endsWith(filename, ".loom")) || (endsWith(filename, ".h5ad"))){
-        std::unique_ptr<DataReader<float>> reader;
-        reader.reset(new HDF5ObservationReader<float>(options.dataFile(), n, m, 
-                                                      options.h5root(),
-                                                      options.h5matrixPath(),
-                                                      options.h5obsPath(),
-                                                      options.h5varPath(),
-                                                      options.parallelRead()));
-
+    if (MappedData::isMapped(filename)) {
+        TIMER_DECLARE(tMap);
+        MappedData mapped(filename);
+        if ((mapped.numVars() != n) || (mapped.numObs() != m)) {
+          throw std::runtime_error("The dimensions of the data set in the file do not match the given dimensions.");
+        }
         comm.barrier();
         if (comm.is_first()) {
-          TIMER_ELAPSED("Time taken in reading the file: ", tRead);
+          TIMER_ELAPSED("Time taken in mapping the file: ", tMap);
         }
-        learn_network(options, comm, std::move(reader));
-    } else {
-        std::unique_ptr<DataReader<double>> reader;
-
-        if (options.colObs()) {
-          reader.reset(new ColumnObservationReader<double>(options.dataFile(), n, m, options.separator(),
-                                                           options.varNames(), options.obsIndices(), varMajor, options.parallelRead()));
+        if (mapped.valueType() == MappedData::ValueType::Float32) {
+          learnMapped<float>(options, comm, mapped);
         }
         else {
-          reader.reset(new RowObservationReader<double>(options.dataFile(), n, m, options.separator(),
-                                                        options.varNames(), options.obsIndices(), varMajor, options.parallelRead()));
+          learnMapped<double>(options, comm, mapped);
         }
-        comm.barrier();
-        if (comm.is_first()) {
-          TIMER_ELAPSED("Time taken in reading the file: ", tRead);
-        }
-        learn_network(options, comm, std::move(reader));
+    } else if (((endsWith(filename, "hdf5")) || (endsWith(filename, ".h5")) || (endsWith(filename, ".h5ad"))) &&
+               SparseReader<float>::isSparse(filename, options.h5root(), options.h5matrixPath())) {
+        learnSparse(options, comm);
+    } else if ((endsWith(filename, "hdf5")) || (endsWith(filename, ".h5")) || 
+        (endsWith(filename, ".loom")) || (endsWith(filename, ".h5ad"))){
+        auto readFile = [&options, n, m] (const bool parallelRead) {
+          std::unique_ptr<DataReader<float>> reader;
+          reader.reset(new HDF5ObservationReader<float>(options.dataFile(), n, m, 
+                                                        options.h5root(),
+                                                        options.h5matrixPath(),
+                                                        options.h5obsPath(),
+                                                        options.h5varPath(),
+                                                        parallelRead));
+          return reader;
+        };
+        auto readBlock = [&options, n, m] (const mxx::blk_dist& block) {
+          return std::make_unique<HDF5BlockReader<float>>(options.dataFile(), n, m, block.eprefix_size(),
+                                                          block.local_size(), options.h5root(),
+                                                          options.h5matrixPath(), options.h5varPath());
+        };
+        readAndLearn<float>(options, comm, readFile, readBlock);
+    } else if (options.singlePrecision()) {
+        auto readFile = [&options, &comm, n, m] (const bool parallelRead) {
+          return std::make_unique<TextReader<float>>(comm, options.dataFile(), n, m, options.separator(),
+                                                     options.colObs(), options.varNames(), options.obsIndices(),
+                                                     parallelRead);
+        };
+        auto readBlock = [&options, &comm, n, m] (const mxx::blk_dist&) {
+          return std::make_unique<TextReader<float>>(comm, options.dataFile(), n, m, options.separator(),
+                                                     options.colObs(), options.varNames(), options.obsIndices(),
+                                                     true, true);
+        };
+        readAndLearn<float>(options, comm, readFile, readBlock);
+    } else {
+        auto readFile = [&options, &comm, n, m] (const bool parallelRead) {
+          return std::make_unique<TextReader<double>>(comm, options.dataFile(), n, m, options.separator(),
+                                                      options.colObs(), options.varNames(), options.obsIndices(),
+                                                      parallelRead);
+        };
+        auto readBlock = [&options, &comm, n, m] (const mxx::blk_dist&) {
+          return std::make_unique<TextReader<double>>(comm, options.dataFile(), n, m, options.separator(),
+                                                      options.colObs(), options.varNames(), options.obsIndices(),
+                                                      true, true);
+        };
+        readAndLearn<double>(options, comm, readFile, readBlock);
     }
   }
   catch (const std::runtime_error& e) {
@@ -0,0 +1,120 @@
+/**
+ * @file DistributedData.hpp
+ * @brief Tests for the data which is distributed across the processors.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TEST_DISTRIBUTEDDATA_HPP_
+#define TEST_DISTRIBUTEDDATA_HPP_
+
+#include "parsimone/DistributedData.hpp"
+
+#include <gtest/gtest.h>
+#include <mpi.h>
+#include <mxx/comm.hpp>
+#include <mxx/distribution.hpp>
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+class DistributedDataTest : public testing::Test {
+protected:
+  using Data = DistributedData<double, uint16_t, uint32_t>;
+
+  static constexpr uint16_t n = 50u;
+  static constexpr uint32_t m = 700u;
+  // Much smaller than the number of remote variables and
+  // the number of threads, so that the rows are evicted
+  // while they are being read by the other threads
+  static constexpr uint32_t cacheRows = 2u;
+  static constexpr int numThreads = 6;
+  static constexpr int numQueries = 20000;
+
+  DistributedDataTest(
+  ) : m_comm(),
+      m_varNames(n)
+  {
+    for (auto i = 0u; i < n; ++i) {
+      m_varNames[i] = "V" + std::to_string(i);
+    }
+  }
+
+  // Value of the given variable for the given observation
+  static
+  double
+  value(
+    const uint16_t x,
+    const uint32_t j
+  )
+  {
+    return 1000.0 * x + j;
+  }
+
+  // Observations of the block of the variables on this processor
+  std::vector<double>
+  local(
+  ) const
+  {
+    mxx::blk_dist block(n, m_comm.size(), m_comm.rank());
+    std::vector<double> values;
+    for (auto x = block.eprefix_size(); x < block.iprefix_size(); ++x) {
+      for (auto j = 0u; j < m; ++j) {
+        values.push_back(value(static_cast<uint16_t>(x), j));
+      }
+    }
+    return values;
+  }
+
+  const mxx::comm m_comm;
+  std::vector<std::string> m_varNames;
+};
+
+TEST_F(DistributedDataTest, ConcurrentRows) {
+  int provided;
+  MPI_Query_thread(&provided);
+  if (provided < MPI_THREAD_MULTIPLE) {
+    GTEST_SKIP() << "The MPI library does not support MPI_THREAD_MULTIPLE.";
+  }
+  Data data(m_comm, this->local(), m_varNames, n, m, cacheRows);
+  const std::set<uint16_t> prefetched{0u, 1u, n / 2, n - 1};
+  uint64_t mismatches = 0u;
+  // Every thread queries a different sequence of the variables, and checks
+  // all the observations of every row while the other threads evict it
+  #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 16) reduction(+:mismatches)
+  for (int q = 0; q < numQueries; ++q) {
+    auto x = static_cast<uint16_t>((static_cast<uint32_t>(q) * 7919u + m_comm.rank() * 13u) % n);
+    if (q % 997 == 0) {
+      data.prefetch(prefetched);
+    }
+    auto row = data.row(x);
+    for (auto j = 0u; j < m; ++j) {
+      mismatches += (row[j] != value(x, j)) ? 1u : 0u;
+    }
+    auto j = (static_cast<uint32_t>(q) * 31u) % m;
+    mismatches += (data(x, j) != value(x, j)) ? 1u : 0u;
+    std::tuple<double, double, uint32_t> stats(0.0, 0.0, 0u);
+    data.statistics(x, std::set<uint32_t>{0u, j}, stats);
+    mismatches += (std::get<0>(stats) != value(x, 0u) + ((j > 0u) ? value(x, j) : 0.0)) ? 1u : 0u;
+  }
+  EXPECT_EQ(mismatches, 0u);
+  // Only destroy the data after all the processors are done with querying
+  m_comm.barrier();
+}
+
+#endif // TEST_DISTRIBUTEDDATA_HPP_
@@ -0,0 +1,253 @@
+/**
+ * @file PrimaryCluster.hpp
+ * @brief Tests for the statistics of the primary clusters.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TEST_PRIMARYCLUSTER_HPP_
+#define TEST_PRIMARYCLUSTER_HPP_
+
+#include "parsimone/RawData.hpp"
+#include "parsimone/detail/IndexSet.hpp"
+#include "parsimone/detail/PrimaryCluster.hpp"
+
+#include <gtest/gtest.h>
+#include <trng/mrg3s.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+class PrimaryClusterTest : public testing::Test {
+protected:
+  using Data = RawData<double, uint16_t, uint16_t>;
+  using Set = IndexSet<uint16_t>;
+  using Primary = PrimaryCluster<Data, uint16_t, Set, uint16_t, Set>;
+
+  static constexpr uint16_t n = 64u;
+  static constexpr uint16_t m = 100u;
+  // Number of primary variables inserted in or erased from the cluster
+  static constexpr uint32_t numMoves = 1u << 16;
+
+  PrimaryClusterTest(
+  ) : m_raw(n * m),
+      m_data()
+  {
+    // Data points with a large mean, so that the rounding errors
+    // of the incremental updates are larger than the last bits,
+    // and about one in twenty data points missing
+    std::mt19937_64 generator(0);
+    std::normal_distribution<double> normalDist(1E3, 1E2);
+    std::bernoulli_distribution missingDist(0.05);
+    for (auto& d : m_raw) {
+      d = missingDist(generator) ? std::nan("") : normalDist(generator);
+    }
+    std::vector<std::string> varNames(n);
+    for (auto i = 0u; i < n; ++i) {
+      varNames[i] = "V" + std::to_string(i);
+    }
+    m_data.reset(new Data(m_raw, varNames, n, m));
+  }
+
+  std::vector<double> m_raw;
+  std::unique_ptr<Data> m_data;
+};
+
+TEST_F(PrimaryClusterTest, RecomputeStatistics) {
+  Primary cluster(*m_data, n, m);
+  std::mt19937_64 generator(1);
+  std::uniform_int_distribution<uint16_t> varDist(0, n - 1);
+  for (auto i = 0u; i < numMoves; ++i) {
+    auto v = varDist(generator);
+    if (!cluster.elements().contains(v)) {
+      cluster.insert(v);
+    }
+    else if (cluster.size() > 1) {
+      cluster.erase(v);
+    }
+  }
+  Primary expected(*m_data, cluster.elements(), m);
+  // The incremental statistics only differ because of rounding
+  auto maxDeviation = 0.0;
+  for (uint16_t s = 0u; s < m; ++s) {
+    auto observed = cluster.secondaryStatistics(s);
+    auto reference = expected.secondaryStatistics(s);
+    EXPECT_EQ(std::get<2>(observed), std::get<2>(reference));
+    EXPECT_NEAR(std::get<0>(observed), std::get<0>(reference), 1E-9 * std::abs(std::get<0>(reference)));
+    EXPECT_NEAR(std::get<1>(observed), std::get<1>(reference), 1E-9 * std::abs(std::get<1>(reference)));
+    maxDeviation = std::max(maxDeviation, std::abs(std::get<1>(observed) - std::get<1>(reference)));
+  }
+  RecordProperty("MaxDeviation", testing::PrintToString(maxDeviation));
+  // The recomputed statistics are identical to the statistics from scratch
+  cluster.recomputeStatistics();
+  for (uint16_t s = 0u; s < m; ++s) {
+    EXPECT_EQ(cluster.secondaryStatistics(s), expected.secondaryStatistics(s));
+  }
+  EXPECT_EQ(cluster.scoreMergeSingle(cluster), expected.scoreMergeSingle(expected));
+}
+
+TEST_F(PrimaryClusterTest, EraseAll) {
+  Primary cluster(*m_data, n, m);
+  for (uint16_t v = 0u; v < n; ++v) {
+    cluster.insert(v);
+  }
+  for (uint16_t v = 0u; v < n; ++v) {
+    cluster.erase(v);
+  }
+  // The statistics of an emptied cluster are exactly zero
+  for (uint16_t s = 0u; s < m; ++s) {
+    EXPECT_EQ(cluster.secondaryStatistics(s), std::make_tuple(0.0, 0.0, 0u));
+  }
+}
+
+TEST_F(PrimaryClusterTest, MergeSingle) {
+  // Clusters with statistics updated by random moves
+  std::vector<Primary> clusters(4, Primary(*m_data, n, m));
+  std::mt19937_64 generator(2);
+  std::uniform_int_distribution<uint16_t> varDist(0, n - 1);
+  std::uniform_int_distribution<uint32_t> clusterDist(0, clusters.size() - 1);
+  std::vector<uint32_t> membership(n, clusters.size());
+  for (auto i = 0u; i < numMoves; ++i) {
+    auto v = varDist(generator);
+    auto c = clusterDist(generator);
+    if (membership[v] == clusters.size()) {
+      clusters[c].insert(v);
+      membership[v] = c;
+    }
+    else if (clusters[membership[v]].size() > 1) {
+      clusters[membership[v]].erase(v);
+      membership[v] = clusters.size();
+    }
+  }
+  // Score of the merged cluster from the data, in the order of the
+  // primary variables and then of the secondary variables
+  auto fromData = [this] (const Primary& first, const Primary& second) {
+                    auto sum = 0.0;
+                    auto sum2 = 0.0;
+                    auto count = 0u;
+                    for (uint16_t v = 0u; v < n; ++v) {
+                      if (first.elements().contains(v) || second.elements().contains(v)) {
+                        for (uint16_t s = 0u; s < m; ++s) {
+                          auto d = m_raw[v * m + s];
+                          if (!std::isnan(d)) {
+                            sum += d;
+                            sum2 += d * d;
+                            ++count;
+                          }
+                        }
+                      }
+                    }
+                    return computeLogLikelihood(count, sum, sum2);
+                  };
+  auto maxDeviation = 0.0;
+  for (auto& first : clusters) {
+    for (auto& second : clusters) {
+      if (&first != &second) {
+        // The score of the proposal is identical to the score of the merged cluster
+        Primary merged(first, second);
+        auto observed = first.scoreMergeSingle(second);
+        EXPECT_EQ(observed, merged.score());
+        // and only differs from the score from the data because of rounding
+        auto reference = fromData(first, second);
+        EXPECT_NEAR(observed, reference, 1E-9 * std::abs(reference));
+        maxDeviation = std::max(maxDeviation, std::abs(observed - reference) / std::abs(reference));
+      }
+    }
+  }
+  RecordProperty("MaxDeviation", testing::PrintToString(maxDeviation));
+}
+
+TEST_F(PrimaryClusterTest, ClusterSecondary) {
+  // Cluster with statistics updated by random moves
+  // and the same cluster with statistics from scratch
+  Primary cluster(*m_data, n, m);
+  std::mt19937_64 moveGenerator(3);
+  std::uniform_int_distribution<uint16_t> varDist(0, n - 1);
+  for (auto i = 0u; i < numMoves; ++i) {
+    auto v = varDist(moveGenerator);
+    if (!cluster.elements().contains(v)) {
+      cluster.insert(v);
+    }
+    else if (cluster.size() > 1) {
+      cluster.erase(v);
+    }
+  }
+  Primary expected(*m_data, cluster.elements(), m);
+  // Learn the secondary clusters of both with the same seed
+  trng::mrg3s generator;
+  generator.seed(4ul);
+  auto expectedGenerator = generator;
+  cluster.randomSecondary(generator, 10u);
+  cluster.clusterSecondary(generator, nullptr, 10u);
+  expected.randomSecondary(expectedGenerator, 10u);
+  expected.clusterSecondary(expectedGenerator, nullptr, 10u);
+  // The learned clusters do not depend on the rounding errors
+  // of the incremental updates before clustering
+  ASSERT_EQ(cluster.secondaryClusters().size(), expected.secondaryClusters().size());
+  auto eIt = expected.secondaryClusters().begin();
+  for (const auto& secondary : cluster.secondaryClusters()) {
+    EXPECT_EQ(secondary.elements(), eIt->elements());
+    ++eIt;
+  }
+  EXPECT_EQ(cluster.score(), expected.score());
+  // Score of a secondary cluster from the data, in the order of the
+  // primary variables and then of the secondary variables
+  auto fromData = [this, &cluster] (const Set& secondary) {
+                    auto sum = 0.0;
+                    auto sum2 = 0.0;
+                    auto count = 0u;
+                    for (const auto p : cluster.elements()) {
+                      for (const auto s : secondary) {
+                        auto d = m_raw[p * m + s];
+                        if (!std::isnan(d)) {
+                          sum += d;
+                          sum2 += d * d;
+                          ++count;
+                        }
+                      }
+                    }
+                    return computeLogLikelihood(count, sum, sum2);
+                  };
+  // The scores of the learned clusters, which are updated incrementally
+  // while clustering, only differ from the data because of rounding
+  auto referenceScore = 0.0;
+  for (const auto& secondary : cluster.secondaryClusters()) {
+    referenceScore += fromData(secondary.elements());
+  }
+  auto clusterScore = cluster.score();
+  EXPECT_NEAR(clusterScore, referenceScore, 1E-9 * std::abs(referenceScore));
+  RecordProperty("MaxDeviation", testing::PrintToString(std::abs(clusterScore - referenceScore) / std::abs(referenceScore)));
+  // The recomputed scores only differ from the data because
+  // of the order of the summation of the column statistics
+  cluster.recomputeStatistics();
+  referenceScore = 0.0;
+  for (const auto& secondary : cluster.secondaryClusters()) {
+    referenceScore += fromData(secondary.elements());
+  }
+  clusterScore = cluster.score();
+#ifdef RESCAN_STATISTICS
+  EXPECT_EQ(clusterScore, referenceScore);
+#else
+  EXPECT_NEAR(clusterScore, referenceScore, 1E-9 * std::abs(referenceScore));
+#endif
+}
+
+#endif // TEST_PRIMARYCLUSTER_HPP_
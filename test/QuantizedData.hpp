@@ -0,0 +1,141 @@
+/**
+ * @file QuantizedData.hpp
+ * @brief Tests for the data which is stored as 16-bit fixed-point values.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TEST_QUANTIZEDDATA_HPP_
+#define TEST_QUANTIZEDDATA_HPP_
+
+#include "parsimone/QuantizedData.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+class QuantizedDataTest : public testing::Test {
+protected:
+  using Data = QuantizedData<uint16_t, uint32_t>;
+
+  static constexpr double NA = std::numeric_limits<double>::quiet_NaN();
+  static constexpr uint16_t n = 6u;
+  static constexpr uint32_t m = 5000u;
+
+  QuantizedDataTest(
+  ) : m_raw(static_cast<size_t>(n) * m),
+      m_varNames(n)
+  {
+    // Variables with different offsets and ranges, with some missing values,
+    // a constant variable, and a variable with only missing values
+    std::mt19937_64 generator(0);
+    std::uniform_real_distribution<double> valueDist(0.0, 1.0);
+    std::uniform_int_distribution<int> missingDist(0, 19);
+    const std::vector<std::pair<double, double>> ranges{{0.0, 1.0}, {-1e3, 1e3}, {1e4, 1e4 + 1e-2},
+                                                        {-5e-6, 0.0}, {3.25, 3.25}, {NA, NA}};
+    for (auto i = 0u; i < n; ++i) {
+      m_varNames[i] = "V" + std::to_string(i);
+      for (auto j = 0u; j < m; ++j) {
+        auto x = ranges[i].first + (ranges[i].second - ranges[i].first) * valueDist(generator);
+        m_raw[i * m + j] = (missingDist(generator) == 0) ? NA : x;
+      }
+    }
+  }
+
+  std::vector<double> m_raw;
+  std::vector<std::string> m_varNames;
+};
+
+TEST_F(QuantizedDataTest, RoundTrip) {
+  Data data(m_raw.data(), m_varNames, n, m);
+  auto maxError = 0.0;
+  for (uint16_t i = 0u; i < n; ++i) {
+    auto first = m_raw.begin() + i * m;
+    auto min = std::numeric_limits<double>::infinity();
+    auto max = -std::numeric_limits<double>::infinity();
+    std::for_each(first, first + m, [&min, &max] (const double x) {
+      if (!std::isnan(x)) {
+        min = std::min(min, x);
+        max = std::max(max, x);
+      }
+    });
+    // Every value is within half a step of the codes of its variable,
+    // up to the rounding of the offset and the scale to single precision
+    auto scale = (min < max) ? (max - min) / (std::numeric_limits<uint16_t>::max() - 1) : 0.0;
+    auto magnitude = (min <= max) ? std::max(std::abs(min), std::abs(max)) : 0.0;
+    auto bound = scale / 2 + 4 * std::numeric_limits<float>::epsilon() * magnitude;
+    auto row = data.row(i);
+    auto varError = 0.0;
+    std::tuple<double, double, uint32_t> stats(0.0, 0.0, 0u);
+    std::vector<uint32_t> all(m);
+    for (auto j = 0u; j < m; ++j) {
+      all[j] = j;
+      auto x = first[j];
+      if (std::isnan(x)) {
+        // The missing values are stored using the sentinel
+        EXPECT_TRUE(std::isnan(data(i, j)));
+        EXPECT_TRUE(std::isnan(row[j]));
+        continue;
+      }
+      EXPECT_EQ(row[j], data(i, j));
+      auto error = std::abs(static_cast<double>(data(i, j)) - x);
+      EXPECT_LE(error, bound) << "at (" << i << ", " << j << ")";
+      varError = std::max(varError, error);
+      std::get<0>(stats) += data(i, j);
+      std::get<1>(stats) += static_cast<double>(data(i, j)) * data(i, j);
+      ++std::get<2>(stats);
+    }
+    if (min == max) {
+      // The values of a constant variable are exact
+      EXPECT_EQ(varError, 0.0);
+    }
+    std::tuple<double, double, uint32_t> dataStats(0.0, 0.0, 0u);
+    data.statistics(i, all, dataStats);
+    EXPECT_DOUBLE_EQ(std::get<0>(dataStats), std::get<0>(stats));
+    EXPECT_DOUBLE_EQ(std::get<1>(dataStats), std::get<1>(stats));
+    EXPECT_EQ(std::get<2>(dataStats), std::get<2>(stats));
+    auto j = 0u;
+    data.forEachStored(i, [&data, &i, &j] (const uint32_t o, const float value) {
+      EXPECT_EQ(o, j);
+      EXPECT_TRUE((value == data(i, o)) || (std::isnan(value) && std::isnan(data(i, o))));
+      ++j;
+    });
+    EXPECT_EQ(j, m);
+    maxError = std::max(maxError, varError);
+  }
+  // The reported error is the largest error over all the variables
+  EXPECT_EQ(data.maxError().second, maxError);
+  EXPECT_EQ(data.maxError().first, 1u);
+  RecordProperty("MaxError", testing::PrintToString(maxError));
+}
+
+TEST_F(QuantizedDataTest, Infinite) {
+  // Infinite values can not be quantized
+  for (const auto x : {std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()}) {
+    auto raw = m_raw;
+    raw[3 * m + 7] = x;
+    EXPECT_THROW(Data(raw.data(), m_varNames, n, m), std::runtime_error);
+  }
+}
+
+#endif // TEST_QUANTIZEDDATA_HPP_
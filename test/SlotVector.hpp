@@ -0,0 +1,164 @@
+/**
+ * @file SlotVector.hpp
+ * @brief Tests for the container of the clusters.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TEST_SLOTVECTOR_HPP_
+#define TEST_SLOTVECTOR_HPP_
+
+#include "parsimone/detail/SlotVector.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+class SlotVectorTest : public testing::Test {
+protected:
+  using Slots = SlotVector<int>;
+
+  // Checks the elements, their ids, and the positional accesses
+  // through a const reference against the expected elements
+  static
+  void
+  expectElements(
+    const Slots& slots,
+    const std::list<std::pair<Slots::Id, int>>& expected
+  )
+  {
+    ASSERT_EQ(slots.size(), expected.size());
+    auto it = slots.begin();
+    auto pos = 0;
+    for (const auto& e : expected) {
+      ASSERT_NE(it, slots.end());
+      EXPECT_EQ(it.id(), e.first);
+      EXPECT_EQ(*it, e.second);
+      EXPECT_EQ(slots[e.first], e.second);
+      EXPECT_EQ(std::next(slots.begin(), pos), it);
+      EXPECT_EQ(it - slots.begin(), pos);
+      EXPECT_EQ(slots.end() - it, static_cast<int>(expected.size()) - pos);
+      EXPECT_EQ(slots.find(e.first), it);
+      ++it;
+      ++pos;
+    }
+    EXPECT_EQ(it, slots.end());
+  }
+};
+
+TEST_F(SlotVectorTest, EraseById) {
+  Slots slots;
+  for (auto i = 0; i < 6; ++i) {
+    EXPECT_EQ(slots.emplace_back(i), i);
+  }
+  slots.erase(1u);
+  slots.erase(4u);
+  // The erased elements are skipped before the order is compacted
+  const auto& constSlots = slots;
+  expectElements(constSlots, {{0u, 0}, {2u, 2}, {3u, 3}, {5u, 5}});
+  EXPECT_EQ(constSlots.find(1u), constSlots.end());
+  EXPECT_EQ(*std::prev(constSlots.end()), 5);
+  EXPECT_EQ(constSlots.front(), 0);
+  slots.erase(0u);
+  EXPECT_EQ(constSlots.front(), 2);
+  slots.compact();
+  expectElements(constSlots, {{2u, 2}, {3u, 3}, {5u, 5}});
+}
+
+TEST_F(SlotVectorTest, EraseByIterator) {
+  Slots slots;
+  for (auto i = 0; i < 8; ++i) {
+    slots.emplace_back(i);
+  }
+  // Erase every element with an even value while iterating, as in the
+  // merges of the clusters, which also compacts the order halfway
+  for (auto it = slots.begin(); it != slots.end(); ) {
+    if (*it % 2 == 0) {
+      it = slots.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+  expectElements(slots, {{1u, 1}, {3u, 3}, {5u, 5}, {7u, 7}});
+  // Erasing the last element returns the end
+  EXPECT_EQ(slots.erase(std::prev(slots.end())), slots.end());
+  expectElements(slots, {{1u, 1}, {3u, 3}, {5u, 5}});
+}
+
+TEST_F(SlotVectorTest, ReuseSlots) {
+  Slots slots;
+  for (auto i = 0; i < 4; ++i) {
+    slots.emplace_back(i);
+  }
+  slots.erase(2u);
+  slots.erase(0u);
+  // The slots of the erased elements are reused, most recently erased first,
+  // and the new elements are iterated after the existing elements
+  slots.emplace_back(10);
+  slots.emplace_back(12);
+  slots.emplace_back(14);
+  expectElements(slots, {{1u, 1}, {3u, 3}, {0u, 10}, {2u, 12}, {4u, 14}});
+}
+
+TEST_F(SlotVectorTest, Order) {
+  // Random insertions and erasures compared with a std::list
+  Slots slots;
+  std::list<std::pair<Slots::Id, int>> expected;
+  std::mt19937_64 generator(0);
+  std::uniform_int_distribution<int> opDist(0, 9);
+  for (auto i = 0; i < 20000; ++i) {
+    auto op = opDist(generator);
+    if (expected.empty() || (op < 4)) {
+      slots.emplace_back(i);
+      expected.emplace_back(std::prev(slots.end()).id(), i);
+    }
+    else {
+      std::uniform_int_distribution<size_t> posDist(0, expected.size() - 1);
+      auto eIt = std::next(expected.begin(), posDist(generator));
+      if (op < 7) {
+        slots.erase(eIt->first);
+      }
+      else if (op < 9) {
+        auto next = std::next(eIt);
+        auto it = slots.erase(slots.find(eIt->first));
+        if (next != expected.end()) {
+          ASSERT_EQ(it.id(), next->first);
+        }
+        else {
+          ASSERT_EQ(it, slots.end());
+        }
+      }
+      else {
+        slots.compact();
+        continue;
+      }
+      expected.erase(eIt);
+    }
+    if (i % 1000 == 0) {
+      expectElements(slots, expected);
+    }
+  }
+  expectElements(slots, expected);
+  slots.compact();
+  expectElements(slots, expected);
+}
+
+#endif // TEST_SLOTVECTOR_HPP_
@@ -0,0 +1,153 @@
+/**
+ * @file SparseData.hpp
+ * @brief Tests for the data which is stored in the sparse format.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TEST_SPARSEDATA_HPP_
+#define TEST_SPARSEDATA_HPP_
+
+#include "parsimone/RawData.hpp"
+#include "parsimone/SparseData.hpp"
+#include "parsimone/detail/IndexSet.hpp"
+#include "parsimone/detail/TreeNode.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+class SparseDataTest : public testing::Test {
+protected:
+  using Raw = RawData<double, uint16_t, uint32_t>;
+  using Sparse = SparseData<double, uint16_t, uint32_t>;
+  using Set = IndexSet<uint32_t>;
+
+  static constexpr uint32_t m = 1000u;
+
+  SparseDataTest(
+  ) : m_raw(),
+      m_varNames(),
+      m_rawData(),
+      m_sparseData(),
+      m_generator(0)
+  {
+    // Variables with different densities of the stored values,
+    // about one in ten of which are missing
+    const std::vector<double> densities{0.0, 0.005, 0.05, 0.5, 1.0};
+    const uint16_t n = densities.size();
+    std::normal_distribution<double> valueDist(0.0, 2.0);
+    std::bernoulli_distribution missingDist(0.1);
+    std::vector<double> values;
+    std::vector<uint32_t> indices;
+    std::vector<uint64_t> offsets{0u};
+    for (auto i = 0u; i < n; ++i) {
+      m_varNames.push_back("V" + std::to_string(i));
+      std::bernoulli_distribution storedDist(densities[i]);
+      for (auto j = 0u; j < m; ++j) {
+        auto x = 0.0;
+        if (storedDist(m_generator)) {
+          x = missingDist(m_generator) ? std::numeric_limits<double>::quiet_NaN() : valueDist(m_generator);
+          values.push_back(x);
+          indices.push_back(j);
+        }
+        m_raw.push_back(x);
+      }
+      offsets.push_back(values.size());
+    }
+    m_rawData.reset(new Raw(m_raw, m_varNames, n, m));
+    m_sparseData.reset(new Sparse(std::move(values), std::move(indices), std::move(offsets), m_varNames, n, m));
+  }
+
+  // Returns a random set of observations, each of which is included with the given probability
+  Set
+  observations(
+    const double p
+  )
+  {
+    std::bernoulli_distribution includeDist(p);
+    Set set(m);
+    for (auto j = 0u; j < m; ++j) {
+      if (includeDist(m_generator)) {
+        set.insert(j);
+      }
+    }
+    return set;
+  }
+
+  std::vector<double> m_raw;
+  std::vector<std::string> m_varNames;
+  std::unique_ptr<Raw> m_rawData;
+  std::unique_ptr<Sparse> m_sparseData;
+  std::mt19937_64 m_generator;
+};
+
+TEST_F(SparseDataTest, Statistics) {
+  // The sets with more observations than the stored values of a variable are
+  // looked up for every stored value, and the observations of the smaller sets
+  // are searched in the stored values; the zeros are only counted in both cases
+  for (const auto p : {0.0, 0.003, 0.02, 0.3, 0.9, 1.0}) {
+    auto set = this->observations(p);
+    for (uint16_t i = 0u; i < m_varNames.size(); ++i) {
+      std::tuple<double, double, uint32_t> rawStats(1.0, 2.0, 3u);
+      std::tuple<double, double, uint32_t> sparseStats(1.0, 2.0, 3u);
+      m_rawData->statistics(i, set, rawStats);
+      m_sparseData->statistics(i, set, sparseStats);
+      EXPECT_EQ(sparseStats, rawStats) << "p = " << p << ", i = " << i;
+    }
+  }
+}
+
+TEST_F(SparseDataTest, Assignment) {
+  // The values of a candidate parent in the children of a node, which are
+  // merged with the stored values, are the same as the values looked up in
+  // the rows; therefore, the split values and the scores are identical
+  using RawNode = TreeNode<Raw, uint16_t, Set, uint32_t, Set>;
+  using SparseNode = TreeNode<Sparse, uint16_t, Set, uint32_t, Set>;
+  Set variables(m_varNames.size());
+  variables.insert(0u);
+  for (const auto p : {0.01, 0.5, 1.0}) {
+    auto all = this->observations(p);
+    Set first(m), second(m);
+    std::bernoulli_distribution firstDist(0.4);
+    for (const auto o : all) {
+      (firstDist(m_generator) ? first : second).insert(o);
+    }
+    RawNode rawNode(std::make_shared<RawNode>(*m_rawData, variables, first),
+                    std::make_shared<RawNode>(*m_rawData, variables, second));
+    SparseNode sparseNode(std::make_shared<SparseNode>(*m_sparseData, variables, first),
+                          std::make_shared<SparseNode>(*m_sparseData, variables, second));
+    for (uint16_t i = 0u; i < m_varNames.size(); ++i) {
+      Assignment<Raw, uint16_t, Set, uint32_t, Set> rawAssignment(*m_rawData, i, &rawNode);
+      Assignment<Sparse, uint16_t, Set, uint32_t, Set> sparseAssignment(*m_sparseData, i, &sparseNode);
+      for (const auto sv : {-1.0, 0.0, 0.5}) {
+        EXPECT_EQ(sparseAssignment.sign(sv), rawAssignment.sign(sv));
+        for (const auto beta : {0.0, 1.0, 10.0}) {
+          EXPECT_EQ(sparseAssignment.evaluate(sv, 1, beta), rawAssignment.evaluate(sv, 1, beta));
+          EXPECT_EQ(sparseAssignment.score(sv, 1, beta), rawAssignment.score(sv, 1, beta));
+        }
+      }
+    }
+  }
+}
+
+#endif // TEST_SPARSEDATA_HPP_
@@ -0,0 +1,149 @@
+/**
+ * @file SplitSampler.hpp
+ * @brief Tests for the streaming sampling of parent splits.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TEST_SPLITSAMPLER_HPP_
+#define TEST_SPLITSAMPLER_HPP_
+
+#include "parsimone/detail/Random.hpp"
+#include "parsimone/detail/SplitSampler.hpp"
+
+#include <gtest/gtest.h>
+#include <trng/mrg3s.hpp>
+#include <trng/uniform_int_dist.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+
+class SplitSamplerTest : public testing::Test {
+protected:
+  using Sampler = SplitSampler<uint16_t, uint16_t>;
+  using Split = std::tuple<uint16_t, uint16_t, double>;
+
+  static constexpr uint32_t numSplits = 4u;
+  // Number of nodes for which the splits are sampled
+  static constexpr uint32_t numNodes = 20000u;
+
+  SplitSamplerTest(
+  ) : m_candidates()
+  {
+    // Candidates with a wide range of scores, including a score
+    // much smaller than the others, for the parent with index p
+    const std::vector<double> scores{0.0, -0.5, -1.0, -2.0, 0.3, -3.0, 1.0, -0.2, -40.0};
+    for (uint16_t p = 0u; p < scores.size(); ++p) {
+      m_candidates.emplace_back(p, static_cast<uint16_t>(2 * p + 1), scores[p]);
+    }
+  }
+
+  // Returns the index of the candidate with the parent of the given split
+  uint16_t
+  index(
+    const Split& split
+  ) const
+  {
+    EXPECT_EQ(std::get<1>(split), 2 * std::get<0>(split) + 1);
+    EXPECT_EQ(std::get<2>(split), std::get<2>(m_candidates[std::get<0>(split)]));
+    return std::get<0>(split);
+  }
+
+  std::vector<Split> m_candidates;
+};
+
+TEST_F(SplitSamplerTest, Distribution) {
+  const auto numCandidates = m_candidates.size();
+  // Counts of the candidates drawn by the sampler and, for the same
+  // seed, drawn as TreeNode::chooseSplits draws them
+  std::vector<double> sampledWeight(numCandidates, 0.0), sampledRandom(numCandidates, 0.0);
+  std::vector<double> chosenWeight(numCandidates, 0.0), chosenRandom(numCandidates, 0.0);
+  trng::mrg3s generator;
+  generator.seed(0ul);
+  auto chooseGenerator = generator;
+  auto maxScore = std::get<2>(m_candidates[6]);
+  std::vector<double> weights(numCandidates);
+  for (auto c = 0u; c < numCandidates; ++c) {
+    weights[c] = relativeWeight(std::get<2>(m_candidates[c]), maxScore);
+  }
+  std::vector<Split> weightSplits(numSplits), randomSplits(numSplits);
+  for (auto n = 0u; n < numNodes; ++n) {
+    Sampler sampler(numSplits, generator());
+    ::advance(generator, 2 * numSplits - 1);
+    for (const auto& split : m_candidates) {
+      sampler.insert(split);
+    }
+    EXPECT_EQ(sampler.count(), numCandidates);
+    sampler.chosen(weightSplits.begin(), randomSplits.begin());
+    for (auto i = 0u; i < numSplits; ++i) {
+      ++sampledWeight[this->index(weightSplits[i])];
+      ++sampledRandom[this->index(randomSplits[i])];
+    }
+    discrete_distribution_safe<uint64_t> splitWeight(weights.cbegin(), weights.cend());
+    trng::uniform_int_dist splitRand(0, numCandidates);
+    for (auto i = 0u; i < numSplits; ++i) {
+      ++chosenWeight[splitWeight(chooseGenerator)];
+      ++chosenRandom[splitRand(chooseGenerator)];
+    }
+  }
+  // Both the samples are consistent with the probabilities of the candidates,
+  // and with each other, within five standard deviations of the counts
+  const auto numDraws = static_cast<double>(numSplits * numNodes);
+  auto sumWeights = 0.0;
+  for (const auto w : weights) {
+    sumWeights += w;
+  }
+  auto maxDeviation = 0.0;
+  for (auto c = 0u; c < numCandidates; ++c) {
+    auto pWeight = weights[c] / sumWeights;
+    auto sdWeight = std::sqrt(numDraws * pWeight * (1.0 - pWeight));
+    EXPECT_NEAR(sampledWeight[c], numDraws * pWeight, 5.0 * sdWeight + 1.0);
+    EXPECT_NEAR(chosenWeight[c], numDraws * pWeight, 5.0 * sdWeight + 1.0);
+    EXPECT_NEAR(sampledWeight[c], chosenWeight[c], 5.0 * std::sqrt(2.0) * sdWeight + 1.0);
+    auto pRandom = 1.0 / numCandidates;
+    auto sdRandom = std::sqrt(numDraws * pRandom * (1.0 - pRandom));
+    EXPECT_NEAR(sampledRandom[c], numDraws * pRandom, 5.0 * sdRandom);
+    EXPECT_NEAR(chosenRandom[c], numDraws * pRandom, 5.0 * sdRandom);
+    EXPECT_NEAR(sampledRandom[c], chosenRandom[c], 5.0 * std::sqrt(2.0) * sdRandom);
+    maxDeviation = std::max(maxDeviation, std::abs(sampledWeight[c] - chosenWeight[c]) / numDraws);
+    maxDeviation = std::max(maxDeviation, std::abs(sampledRandom[c] - chosenRandom[c]) / numDraws);
+  }
+  RecordProperty("MaxDeviation", testing::PrintToString(maxDeviation));
+}
+
+TEST_F(SplitSamplerTest, Merge) {
+  // The splits sampled from all the candidates are the same as the splits
+  // merged from the samplers for disjoint subsets of the candidates,
+  // inserted in any order
+  for (uint64_t salt = 0u; salt < 100u; ++salt) {
+    Sampler all(numSplits, salt);
+    for (const auto& split : m_candidates) {
+      all.insert(split);
+    }
+    Sampler first(numSplits, salt);
+    Sampler second(numSplits, salt);
+    for (auto c = m_candidates.size(); c > 0; --c) {
+      ((c % 3 == 0) ? first : second).insert(m_candidates[c - 1]);
+    }
+    second.merge(first);
+    EXPECT_EQ(second.count(), all.count());
+    EXPECT_EQ(second.entries(), all.entries());
+  }
+}
+
+#endif // TEST_SPLITSAMPLER_HPP_
@@ -0,0 +1,335 @@
+/**
+ * @file TextReader.hpp
+ * @brief Tests for the reading of the data sets from delimited files.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TEST_TEXTREADER_HPP_
+#define TEST_TEXTREADER_HPP_
+
+#include "parsimone/TextReader.hpp"
+
+#include <gtest/gtest.h>
+#include <mxx/comm.hpp>
+#include <mxx/distribution.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+class TextReaderTest : public testing::Test {
+protected:
+  static constexpr double NA = std::numeric_limits<double>::quiet_NaN();
+
+  TextReaderTest(
+  ) : m_comm(),
+      m_fileName(testing::TempDir() + "parsimone_text_reader_test.txt")
+  {
+  }
+
+  ~TextReaderTest(
+  ) override
+  {
+    m_comm.barrier();
+    if (m_comm.is_first()) {
+      std::remove(m_fileName.c_str());
+    }
+  }
+
+  // Writes the given contents to the file, from the first processor,
+  // after all the processors are done with reading the previous contents
+  void
+  write(
+    const std::string& contents
+  ) const
+  {
+    m_comm.barrier();
+    if (m_comm.is_first()) {
+      std::ofstream file(m_fileName, std::ios::binary);
+      file << contents;
+    }
+    m_comm.barrier();
+  }
+
+  // Returns the contents of a file with the given cells, in variable-major
+  // order, in the format specified by the given options; if irregular is set,
+  // some of the lines end with CRLF and some are followed by empty lines
+  static
+  std::string
+  format(
+    const std::vector<std::string>& cells,
+    const std::vector<std::string>& names,
+    const uint32_t m,
+    const char sep,
+    const bool colObs,
+    const bool varNames,
+    const bool obsIndices,
+    const bool irregular = false
+  )
+  {
+    const uint32_t n = names.size();
+    std::string contents;
+    auto endLine = [&contents, irregular] (const uint32_t l) {
+      contents.append(((l % 3 == 1) && irregular) ? "\r\n" : "\n");
+      if ((l % 7 == 3) && irregular) {
+        contents.append((l % 2 == 0) ? "\n" : "\r\n");
+      }
+    };
+    if (colObs ? obsIndices : varNames) {
+      std::vector<std::string> header;
+      if (colObs ? varNames : obsIndices) {
+        header.emplace_back(colObs ? "Variable" : "Observation");
+      }
+      for (auto h = 0u; h < (colObs ? m : n); ++h) {
+        header.push_back(colObs ? std::to_string(h) : names[h]);
+      }
+      for (auto h = 0u; h < header.size(); ++h) {
+        contents.append(header[h]);
+        if (h + 1 < header.size()) {
+          contents.push_back(sep);
+        }
+      }
+      endLine(0);
+    }
+    for (auto l = 0u; l < (colObs ? n : m); ++l) {
+      if (colObs ? varNames : obsIndices) {
+        contents.append(colObs ? names[l] : std::to_string(l)).push_back(sep);
+      }
+      for (auto f = 0u; f < (colObs ? m : n); ++f) {
+        contents.append(colObs ? cells[l * m + f] : cells[f * m + l]);
+        if (f + 1 < (colObs ? m : n)) {
+          contents.push_back(sep);
+        }
+      }
+      endLine(l + 1);
+    }
+    return contents;
+  }
+
+  // Checks that the file is read with the expected values, in variable-major
+  // order, and names, on one processor and in parallel, with and without
+  // distributing the variables across the processors
+  template <typename DataType>
+  void
+  expectRead(
+    const std::vector<double>& values,
+    const std::vector<std::string>& names,
+    const uint32_t m,
+    const char sep,
+    const bool colObs,
+    const bool varNames,
+    const bool obsIndices
+  ) const
+  {
+    const uint32_t n = names.size();
+    for (const auto parallelRead : {false, true}) {
+      for (const auto distributeVars : {false, true}) {
+        SCOPED_TRACE(testing::Message() << "parallelRead=" << parallelRead << ", distributeVars=" << distributeVars);
+        TextReader<DataType> reader(m_comm, m_fileName, n, m, sep, colObs, varNames, obsIndices,
+                                    parallelRead, distributeVars);
+        mxx::blk_dist block(n, m_comm.size(), m_comm.rank());
+        auto distributed = parallelRead && distributeVars;
+        size_t first = distributed ? block.eprefix_size() : 0;
+        size_t numVars = distributed ? block.local_size() : n;
+        const auto& data = reader.data();
+        ASSERT_EQ(data.size(), numVars * m);
+        for (auto i = 0u; i < numVars; ++i) {
+          for (auto j = 0u; j < m; ++j) {
+            auto expected = values[(first + i) * m + j];
+            auto actual = data[i * m + j];
+            if (std::isnan(expected)) {
+              EXPECT_TRUE(std::isnan(actual)) << "at (" << first + i << ", " << j << ")";
+            }
+            else {
+              EXPECT_EQ(actual, static_cast<DataType>(expected)) << "at (" << first + i << ", " << j << ")";
+            }
+          }
+        }
+        if (varNames) {
+          EXPECT_EQ(reader.varNames(), names);
+        }
+        else {
+          ASSERT_EQ(reader.varNames().size(), n);
+          EXPECT_EQ(reader.varNames().back(), "V" + std::to_string(n - 1));
+        }
+      }
+    }
+  }
+
+  // Checks that reading the file fails on all the processors,
+  // both on one processor and in parallel
+  template <typename DataType>
+  void
+  expectError(
+    const uint32_t n,
+    const uint32_t m,
+    const bool colObs = false,
+    const bool varNames = false
+  ) const
+  {
+    for (const auto parallelRead : {false, true}) {
+      EXPECT_THROW(TextReader<DataType>(m_comm, m_fileName, n, m, ',', colObs, varNames, false, parallelRead),
+                   std::runtime_error) << "parallelRead=" << parallelRead;
+    }
+  }
+
+  const mxx::comm m_comm;
+  const std::string m_fileName;
+};
+
+TEST_F(TextReaderTest, Formats) {
+  // Every combination of the options, as specified by -c, -v, -i, and -s
+  const uint32_t n = 3u, m = 4u;
+  const std::vector<std::string> names{"A", "B", "C"};
+  std::vector<double> values(n * m);
+  std::vector<std::string> cells(n * m);
+  for (auto i = 0u; i < n; ++i) {
+    for (auto j = 0u; j < m; ++j) {
+      values[i * m + j] = 10.0 * i + 0.25 * j - 5.0;
+      cells[i * m + j] = testing::PrintToString(values[i * m + j]);
+    }
+  }
+  for (const auto sep : {',', '\t', ' '}) {
+    for (const auto colObs : {false, true}) {
+      for (const auto varNames : {false, true}) {
+        for (const auto obsIndices : {false, true}) {
+          SCOPED_TRACE(testing::Message() << "sep=" << static_cast<int>(sep) << ", colObs=" << colObs <<
+                       ", varNames=" << varNames << ", obsIndices=" << obsIndices);
+          write(format(cells, names, m, sep, colObs, varNames, obsIndices));
+          expectRead<double>(values, names, m, sep, colObs, varNames, obsIndices);
+          expectRead<float>(values, names, m, sep, colObs, varNames, obsIndices);
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TextReaderTest, MissingValues) {
+  // NA and empty cells are read as NaN, surrounding whitespace, CRLF line
+  // endings, trailing delimiters, and empty lines are ignored
+  const std::vector<std::string> names{"A", "B", "C"};
+  const std::vector<double> values{1.0, NA, NA, 5.0, 8.0,
+                                   NA, 2.0, NA, 6.0, NA,
+                                   1.5, -3.0, 4.0, 7.0, 9.0};
+  write("A,B,C\r\n"
+        "1,NA,+1.5\r\n"
+        "\r\n"
+        ",2, -3 ,\r\n"
+        "NA,,4\n"
+        "\n"
+        "  5\t,6,7,\n"
+        "8, NA ,9");
+  expectRead<double>(values, names, 5u, ',', false, true, false);
+  write("1,2,3,4,5\r\n"
+        "A,1,NA,,5,8,\r\n"
+        "B,NA,2,NA,6, \r\n"
+        "\r\n"
+        "C,+1.5,-3,4,7,9\r\n"
+        "\r\n");
+  expectRead<double>(values, names, 5u, ',', true, true, true);
+}
+
+TEST_F(TextReaderTest, Values) {
+  // The forms accepted by std::from_chars, and a leading plus sign
+  const std::vector<std::pair<std::string, double>> accepted{
+    {"+1", 1.0}, {"-0.5", -0.5}, {".5", 0.5}, {"5.", 5.0}, {"+2.5e+3", 2500.0},
+    {"-1E-2", -0.01}, {"1e-310", 1e-310}, {"1e308", 1e308}
+  };
+  std::vector<std::string> cells;
+  std::vector<double> values;
+  for (const auto& a : accepted) {
+    cells.push_back(a.first);
+    values.push_back(a.second);
+  }
+  write(format(cells, {"A"}, cells.size(), ',', false, false, false));
+  expectRead<double>(values, {"A"}, cells.size(), ',', false, false, false);
+  // Subnormal values are accepted for float as well
+  write(format({"1e-40", "-1e-44"}, {"A"}, 2u, ',', false, false, false));
+  expectRead<float>({1e-40, -1e-44}, {"A"}, 2u, ',', false, false, false);
+
+  // The values which can not be parsed, or are out of range, fail on all the processors
+  for (const std::string value : {"+", "++1", "+-1", "-+1", "+ 1", "1e400", "1e-400", "0x10",
+                                  "1.5.2", "1 2", "abc", "NAN A"}) {
+    SCOPED_TRACE(value);
+    write("1\n" + value + "\n2\n");
+    expectError<double>(1u, 3u);
+  }
+  write("1\n1e39\n2\n");
+  expectError<float>(1u, 3u);
+}
+
+TEST_F(TextReaderTest, Counts) {
+  // Mismatches between the dimensions of the data and the expected dimensions
+  write("1,2\n3,4\n");
+  expectError<double>(2u, 3u);
+  expectError<double>(3u, 2u);
+  write("1,2\n3,4,5\n");
+  expectError<double>(2u, 2u);
+  write("1,2\n3\n");
+  expectError<double>(2u, 2u);
+  write("A,1,2\nB,3,4\n");
+  expectError<double>(2u, 3u, true, true);
+  write("A,B,C\n1,2\n3,4\n");
+  expectError<double>(2u, 2u, false, true);
+}
+
+TEST_F(TextReaderTest, ChunksAndRanks) {
+  // A file large enough to be split into multiple chunks on every processor,
+  // with lines of different lengths, so that the boundaries of the chunks and
+  // of the blocks of the processors fall at different positions in the lines
+  const uint32_t n = 64u, m = 3000u * static_cast<uint32_t>(m_comm.size());
+  std::vector<std::string> names(n);
+  for (auto i = 0u; i < n; ++i) {
+    names[i] = "Gene" + std::to_string(i);
+  }
+  std::vector<double> values(static_cast<size_t>(n) * m);
+  std::vector<std::string> cells(values.size());
+  std::mt19937_64 generator(0);
+  std::normal_distribution<double> valueDist(0.0, 100.0);
+  std::uniform_int_distribution<int> formDist(0, 9);
+  char buffer[32];
+  for (auto c = 0u; c < values.size(); ++c) {
+    auto form = formDist(generator);
+    if (form == 0) {
+      values[c] = NA;
+      cells[c] = (c % 2 == 0) ? "NA" : "";
+    }
+    else if (form < 4) {
+      values[c] = static_cast<int>(valueDist(generator));
+      cells[c] = std::to_string(static_cast<int>(values[c]));
+    }
+    else {
+      values[c] = valueDist(generator);
+      std::snprintf(buffer, sizeof(buffer), "%.17g", values[c]);
+      cells[c] = buffer;
+    }
+  }
+  for (const auto colObs : {false, true}) {
+    SCOPED_TRACE(testing::Message() << "colObs=" << colObs);
+    auto contents = format(cells, names, m, '\t', colObs, true, true, true);
+    EXPECT_GT(contents.size(), static_cast<size_t>(m_comm.size()) * (2u << 20));
+    write(contents);
+    expectRead<double>(values, names, m, '\t', colObs, true, true);
+  }
+}
+
+#endif // TEST_TEXTREADER_HPP_
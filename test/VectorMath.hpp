@@ -0,0 +1,302 @@
+/**
+ * @file VectorMath.hpp
+ * @brief Tests for the vectorized math functions and the kernels using them.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TEST_VECTORMATH_HPP_
+#define TEST_VECTORMATH_HPP_
+
+#include "parsimone/RawData.hpp"
+#include "parsimone/detail/IndexSet.hpp"
+#include "parsimone/detail/TreeNode.hpp"
+#include "parsimone/detail/VectorMath.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+
+class VectorMathTest : public testing::Test {
+protected:
+  // Maximum errors, in units in the last place, of the vectorized functions
+  static constexpr double maxUlpsExp = 2.0;
+  static constexpr double maxUlpsLog = 2.0;
+  static constexpr double maxUlpsLog1p = 2.0;
+
+  // Returns the special values, the numbers (1 + j / 8) * 2^k of either sign
+  // for all the exponents k, including those of the subnormal numbers,
+  // and random numbers in [-1000, 1000] and in [-2, 2], padded with zeros
+  // to a multiple of the given width
+  template <typename Value>
+  static
+  std::vector<Value>
+  sweep(
+    const size_t width
+  )
+  {
+    using Limits = std::numeric_limits<Value>;
+    std::vector<Value> x{0, -0.0, 1, -1, Limits::infinity(), -Limits::infinity(), Limits::quiet_NaN(),
+                         Limits::denorm_min(), -Limits::denorm_min(), Limits::min(), -Limits::min(),
+                         Limits::max(), -Limits::max(), Limits::epsilon(), -Limits::epsilon()};
+    for (auto k = Limits::min_exponent - Limits::digits; k < Limits::max_exponent; ++k) {
+      for (auto j = 0; j < 8; ++j) {
+        auto y = std::ldexp(static_cast<Value>(1 + j / 8.0), k);
+        x.push_back(y);
+        x.push_back(-y);
+      }
+    }
+    std::mt19937_64 generator(0);
+    std::uniform_real_distribution<Value> wideDist(-1000, 1000);
+    std::uniform_real_distribution<Value> narrowDist(-2, 2);
+    for (auto i = 0; i < (1 << 16); ++i) {
+      x.push_back(wideDist(generator));
+      x.push_back(narrowDist(generator));
+    }
+    x.resize(((x.size() + width - 1) / width) * width, 0);
+    return x;
+  }
+
+  // Returns the error of the computed value in the units in the last place
+  // of the expected value, after checking that both are NaN, both are the same
+  // infinity, or both are finite
+  template <typename Value>
+  static
+  double
+  ulps(
+    const Value x,
+    const Value computed,
+    const Value expected
+  )
+  {
+    if (std::isnan(expected) || std::isinf(expected) || !std::isfinite(computed)) {
+      EXPECT_TRUE((std::isnan(computed) && std::isnan(expected)) || (computed == expected))
+        << "x = " << x << ", computed " << computed << ", expected " << expected;
+      return 0.0;
+    }
+    const auto ulp = std::max(std::nextafter(std::abs(expected), std::numeric_limits<Value>::infinity()) - std::abs(expected),
+                              std::numeric_limits<Value>::denorm_min());
+    return std::abs(static_cast<double>(computed) - static_cast<double>(expected)) / ulp;
+  }
+
+  // Returns the maximum error of the vectorized function, applied to
+  // the given number of values at a time, over the sweep; the expected
+  // values are computed in double precision and rounded
+  template <typename Value, typename Vectorized, typename Reference>
+  static
+  double
+  maxUlps(
+    const size_t width,
+    Vectorized&& vectorized,
+    Reference&& reference
+  )
+  {
+    const auto x = sweep<Value>(width);
+    std::vector<Value> y(x.size());
+    for (auto i = 0u; i < x.size(); i += width) {
+      vectorized(x.data() + i, y.data() + i);
+    }
+    auto maxError = 0.0;
+    for (auto i = 0u; i < x.size(); ++i) {
+      const auto expected = static_cast<Value>(reference(static_cast<double>(x[i])));
+      maxError = std::max(maxError, ulps(x[i], y[i], expected));
+    }
+    return maxError;
+  }
+};
+
+#if defined(HAVE_AVX512BW_INSTRUCTIONS) && defined(__AVX512F__)
+TEST_F(VectorMathTest, ExpAVX512) {
+  auto maxDouble = maxUlps<double>(8, [] (const double* x, double* y) { _mm512_storeu_pd(y, exp_avx512(_mm512_loadu_pd(x))); },
+                                   [] (const double x) { return std::exp(x); });
+  auto maxFloat = maxUlps<float>(16, [] (const float* x, float* y) { _mm512_storeu_ps(y, exp_avx512(_mm512_loadu_ps(x))); },
+                                 [] (const double x) { return std::exp(x); });
+  EXPECT_LE(maxDouble, maxUlpsExp);
+  EXPECT_LE(maxFloat, maxUlpsExp);
+  RecordProperty("MaxUlpsDouble", testing::PrintToString(maxDouble));
+  RecordProperty("MaxUlpsFloat", testing::PrintToString(maxFloat));
+}
+
+TEST_F(VectorMathTest, LogAVX512) {
+  auto maxDouble = maxUlps<double>(8, [] (const double* x, double* y) { _mm512_storeu_pd(y, log_avx512(_mm512_loadu_pd(x))); },
+                                   [] (const double x) { return std::log(x); });
+  auto maxFloat = maxUlps<float>(16, [] (const float* x, float* y) { _mm512_storeu_ps(y, log_avx512(_mm512_loadu_ps(x))); },
+                                 [] (const double x) { return std::log(x); });
+  EXPECT_LE(maxDouble, maxUlpsLog);
+  EXPECT_LE(maxFloat, maxUlpsLog);
+  RecordProperty("MaxUlpsDouble", testing::PrintToString(maxDouble));
+  RecordProperty("MaxUlpsFloat", testing::PrintToString(maxFloat));
+}
+
+TEST_F(VectorMathTest, Log1pAVX512) {
+  auto maxDouble = maxUlps<double>(8, [] (const double* x, double* y) { _mm512_storeu_pd(y, log1p_avx512(_mm512_loadu_pd(x))); },
+                                   [] (const double x) { return std::log1p(x); });
+  auto maxFloat = maxUlps<float>(16, [] (const float* x, float* y) { _mm512_storeu_ps(y, log1p_avx512(_mm512_loadu_ps(x))); },
+                                 [] (const double x) { return std::log1p(x); });
+  EXPECT_LE(maxDouble, maxUlpsLog1p);
+  EXPECT_LE(maxFloat, maxUlpsLog1p);
+  RecordProperty("MaxUlpsDouble", testing::PrintToString(maxDouble));
+  RecordProperty("MaxUlpsFloat", testing::PrintToString(maxFloat));
+}
+#endif
+
+#if defined(HAVE_AVX2_INSTRUCTIONS) && defined(__AVX2__)
+TEST_F(VectorMathTest, ExpAVX2) {
+  auto maxDouble = maxUlps<double>(4, [] (const double* x, double* y) { _mm256_storeu_pd(y, exp_avx2(_mm256_loadu_pd(x))); },
+                                   [] (const double x) { return std::exp(x); });
+  auto maxFloat = maxUlps<float>(8, [] (const float* x, float* y) { _mm256_storeu_ps(y, exp_avx2(_mm256_loadu_ps(x))); },
+                                 [] (const double x) { return std::exp(x); });
+  EXPECT_LE(maxDouble, maxUlpsExp);
+  EXPECT_LE(maxFloat, maxUlpsExp);
+  RecordProperty("MaxUlpsDouble", testing::PrintToString(maxDouble));
+  RecordProperty("MaxUlpsFloat", testing::PrintToString(maxFloat));
+}
+
+TEST_F(VectorMathTest, LogAVX2) {
+  auto maxDouble = maxUlps<double>(4, [] (const double* x, double* y) { _mm256_storeu_pd(y, log_avx2(_mm256_loadu_pd(x))); },
+                                   [] (const double x) { return std::log(x); });
+  auto maxFloat = maxUlps<float>(8, [] (const float* x, float* y) { _mm256_storeu_ps(y, log_avx2(_mm256_loadu_ps(x))); },
+                                 [] (const double x) { return std::log(x); });
+  EXPECT_LE(maxDouble, maxUlpsLog);
+  EXPECT_LE(maxFloat, maxUlpsLog);
+  RecordProperty("MaxUlpsDouble", testing::PrintToString(maxDouble));
+  RecordProperty("MaxUlpsFloat", testing::PrintToString(maxFloat));
+}
+
+TEST_F(VectorMathTest, Log1pAVX2) {
+  auto maxDouble = maxUlps<double>(4, [] (const double* x, double* y) { _mm256_storeu_pd(y, log1p_avx2(_mm256_loadu_pd(x))); },
+                                   [] (const double x) { return std::log1p(x); });
+  auto maxFloat = maxUlps<float>(8, [] (const float* x, float* y) { _mm256_storeu_ps(y, log1p_avx2(_mm256_loadu_ps(x))); },
+                                 [] (const double x) { return std::log1p(x); });
+  EXPECT_LE(maxDouble, maxUlpsLog1p);
+  EXPECT_LE(maxFloat, maxUlpsLog1p);
+  RecordProperty("MaxUlpsDouble", testing::PrintToString(maxDouble));
+  RecordProperty("MaxUlpsFloat", testing::PrintToString(maxFloat));
+}
+#endif
+
+template <typename Value>
+class AssignmentKernelTest : public testing::Test {
+protected:
+  using Data = RawData<Value, uint16_t, uint16_t>;
+  using Set = IndexSet<uint16_t>;
+  using Node = TreeNode<Data, uint16_t, Set, uint16_t, Set>;
+  using Assign = Assignment<Data, uint16_t, Set, uint16_t, Set>;
+
+  // Numbers of observations in the two children, which are
+  // not multiples of the vector widths so that the tails are used
+  static constexpr uint16_t m1 = 53u;
+  static constexpr uint16_t m2 = 70u;
+
+  AssignmentKernelTest(
+  ) : m_raw(m1 + m2),
+      m_data(),
+      m_node()
+  {
+    // Data points with about one in ten of them missing
+    std::mt19937_64 generator(0);
+    std::normal_distribution<double> normalDist(0.0, 2.0);
+    std::bernoulli_distribution missingDist(0.1);
+    for (auto& d : m_raw) {
+      d = missingDist(generator) ? std::numeric_limits<Value>::quiet_NaN() : static_cast<Value>(normalDist(generator));
+    }
+    m_data.reset(new Data(m_raw, {"V0"}, 1u, m1 + m2));
+    Set variables(1u);
+    variables.insert(0u);
+    Set first(m1 + m2), second(m1 + m2);
+    for (uint16_t o = 0u; o < m1 + m2; ++o) {
+      (o < m1 ? first : second).insert(o);
+    }
+    m_node = std::make_shared<Node>(std::make_shared<Node>(*m_data, variables, first),
+                                    std::make_shared<Node>(*m_data, variables, second));
+  }
+
+  // Checks the results of the vectorized kernels against the results
+  // computed in extended precision, relative to the sums of the magnitudes
+  // of the terms, for split values and betas that include very steep splits
+  void
+  expectKernels(
+    const double relError
+  )
+  {
+    Assign fast(*m_data, 0u, m_node.get(), true);
+    auto maxError = 0.0;
+    for (const auto sv : {-3.0, -0.5, 0.0, 0.25, 2.0}) {
+      for (const auto beta : {0.0, 0.1, 1.0, 7.5, 1E3, 1E6}) {
+        for (const auto sign : {-1, 1}) {
+          // The sums of the terms and of their magnitudes, for c * (x - sv)
+          // computed in the precision of the data as the kernels do
+          long double sum[2] = {0.0, 0.0}, slope[2] = {0.0, 0.0}, softplus[2] = {0.0, 0.0};
+          long double sumMag = 0.0, slopeMag = 0.0, softplusMag = 0.0;
+          for (uint16_t o = 0u; o < m1 + m2; ++o) {
+            const auto x = m_raw[o];
+            if (std::isnan(x)) {
+              softplus[o < m1 ? 0 : 1] += std::log(2.0L);
+              continue;
+            }
+            const auto k = (o < m1) ? 0 : 1;
+            const auto d = static_cast<Value>(x - static_cast<Value>(sv));
+            const auto c = static_cast<Value>((k == 0 ? -1 : 1) * sign * beta);
+            const auto t = static_cast<long double>(static_cast<Value>(c * d));
+            const auto r = 1.0L / (1.0L + std::exp(t));
+            sum[k] += d * r;
+            slope[k] += d * d * r * (1.0L - r);
+            // The scores are the sums of log(1 + exp(-c * (x - sv)))
+            softplus[k] += std::max(-t, 0.0L) + std::log1p(std::exp(-std::abs(t)));
+            sumMag += std::abs(d);
+            slopeMag += d * d;
+            softplusMag += std::abs(t) + std::log(2.0L);
+          }
+          const auto value = fast.evaluate(sv, sign, beta);
+          const auto derivative = fast.evaluateWithDerivative(sv, sign, beta);
+          const auto score = fast.score(sv, sign, beta);
+          const auto expectedValue = static_cast<double>(sum[1] - sum[0]);
+          const auto expectedSlope = static_cast<double>(-sign * (slope[0] + slope[1]));
+          const auto expectedScore = static_cast<double>(-softplus[0] - softplus[1]);
+          EXPECT_NEAR(value, expectedValue, relError * sumMag) << "sv = " << sv << ", beta = " << beta;
+          EXPECT_NEAR(derivative.first, expectedValue, relError * sumMag) << "sv = " << sv << ", beta = " << beta;
+          EXPECT_NEAR(derivative.second, expectedSlope, relError * slopeMag) << "sv = " << sv << ", beta = " << beta;
+          EXPECT_NEAR(score, expectedScore, relError * softplusMag) << "sv = " << sv << ", beta = " << beta;
+          maxError = std::max(maxError, std::abs(value - expectedValue) / static_cast<double>(sumMag));
+          maxError = std::max(maxError, std::abs(derivative.second - expectedSlope) / static_cast<double>(slopeMag));
+          maxError = std::max(maxError, std::abs(score - expectedScore) / static_cast<double>(softplusMag));
+        }
+      }
+    }
+    this->RecordProperty("MaxRelativeError", testing::PrintToString(maxError));
+  }
+
+  std::vector<Value> m_raw;
+  std::unique_ptr<Data> m_data;
+  std::shared_ptr<Node> m_node;
+};
+
+using KernelValueTypes = testing::Types<double, float>;
+TYPED_TEST_SUITE(AssignmentKernelTest, KernelValueTypes);
+
+TYPED_TEST(AssignmentKernelTest, Kernels) {
+  // The terms are computed in the precision of the data
+  // and are summed in double precision
+  this->expectKernels(16 * std::numeric_limits<TypeParam>::epsilon());
+}
+
+#endif // TEST_VECTORMATH_HPP_
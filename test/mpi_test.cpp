@@ -0,0 +1,46 @@
+/**
+ * @file mpi_test.cpp
+ * @brief Collects all the tests of the project which require MPI,
+ *        and initializes MPI before running them.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "DistributedData.hpp"
+#include "TextReader.hpp"
+
+#include "parsimone/ThreadedEnv.hpp"
+
+#include <gtest/gtest.h>
+#include <mxx/env.hpp>
+
+
+int
+main(
+  int argc,
+  char** argv
+)
+{
+  ThreadedEnv e(argc, argv, MPI_THREAD_MULTIPLE);
+  mxx::env::set_exception_on_error();
+  testing::InitGoogleTest(&argc, argv);
+  // Only print the results from the first processor
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if (rank != 0) {
+    auto& listeners = testing::UnitTest::GetInstance()->listeners();
+    delete listeners.Release(listeners.default_result_printer());
+  }
+  return RUN_ALL_TESTS();
+}
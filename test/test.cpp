@@ -0,0 +1,25 @@
+/**
+ * @file test.cpp
+ * @brief Collects all the tests of the project.
+ *
+ * Copyright 2020 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "LogLikelihood.hpp"
+#include "PrimaryCluster.hpp"
+#include "QuantizedData.hpp"
+#include "SlotVector.hpp"
+#include "SparseData.hpp"
+#include "SplitSampler.hpp"
+#include "VectorMath.hpp"